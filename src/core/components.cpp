@@ -0,0 +1,95 @@
+#include <core/components.hpp>
+
+#include <anton/math/math.hpp>
+
+namespace nebula {
+  constexpr u32 unvisited = static_cast<u32>(-1);
+
+  struct Search_Frame {
+    u32 vertex;
+    // The next edge of the vertex to follow.
+    u32 edge;
+  };
+
+  void find_strong_components(Slice<u32 const> const edge_offsets,
+                              Slice<u32 const> const edges,
+                              Strong_Components& components)
+  {
+    i64 const count = edge_offsets.size() - 1;
+    // Components are found in reverse topological order, a component only
+    // after every component reachable from it, and reversed at the end.
+    Array<u32> vertices{anton::reserve, count};
+    Array<u32> ends;
+    Array<u32> indices{count, unvisited};
+    Array<u32> lowlinks{count, 0};
+    Array<u8> on_stack{count, 0};
+    Array<u32> stack;
+    Array<Search_Frame> frames;
+    u32 next_index = 0;
+    for(i64 root = 0; root < count; ++root) {
+      if(indices[root] != unvisited) {
+        continue;
+      }
+
+      indices[root] = next_index;
+      lowlinks[root] = next_index;
+      next_index += 1;
+      stack.push_back(root);
+      on_stack[root] = 1;
+      frames.push_back(
+        Search_Frame{static_cast<u32>(root), edge_offsets[root]});
+      while(frames.size() > 0) {
+        Search_Frame& frame = frames.back();
+        u32 const vertex = frame.vertex;
+        if(frame.edge < edge_offsets[vertex + 1]) {
+          u32 const target = edges[frame.edge];
+          frame.edge += 1;
+          if(indices[target] == unvisited) {
+            indices[target] = next_index;
+            lowlinks[target] = next_index;
+            next_index += 1;
+            stack.push_back(target);
+            on_stack[target] = 1;
+            frames.push_back(Search_Frame{target, edge_offsets[target]});
+          } else if(on_stack[target]) {
+            lowlinks[vertex] = math::min(lowlinks[vertex], indices[target]);
+          }
+          continue;
+        }
+
+        frames.pop_back();
+        if(frames.size() > 0) {
+          u32 const parent = frames.back().vertex;
+          lowlinks[parent] = math::min(lowlinks[parent], lowlinks[vertex]);
+        }
+        if(lowlinks[vertex] != indices[vertex]) {
+          continue;
+        }
+
+        // The vertex is the root of a component, which holds the vertices
+        // above it on the stack in the order of their discovery.
+        i64 first = stack.size() - 1;
+        while(stack[first] != vertex) {
+          first -= 1;
+        }
+        for(i64 i = first; i < stack.size(); ++i) {
+          on_stack[stack[i]] = 0;
+          vertices.push_back(stack[i]);
+        }
+        stack.erase(stack.begin() + first, stack.end());
+        ends.push_back(vertices.size());
+      }
+    }
+
+    components.vertices.clear();
+    components.offsets.clear();
+    for(i64 i = ends.size() - 1; i >= 0; --i) {
+      u32 const begin = i > 0 ? ends[i - 1] : 0;
+      components.offsets.push_back(components.vertices.size());
+      for(u32 j = begin; j < ends[i]; ++j) {
+        components.vertices.push_back(vertices[j]);
+      }
+    }
+    components.offsets.push_back(components.vertices.size());
+  }
+} // namespace nebula
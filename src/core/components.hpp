@@ -0,0 +1,38 @@
+#pragma once
+
+#include <anton/slice.hpp>
+
+#include <core/types.hpp>
+
+namespace nebula {
+  /**
+   * @brief Strongly connected components of a directed graph.
+   *
+   * The vertices of component i are those from offsets[i] to offsets[i + 1]
+   * in vertices. Every edge between two components goes from an earlier
+   * component to a later one, hence the components are in topological order.
+   * The vertices of a component are in the order the search discovered them.
+   */
+  struct Strong_Components {
+    Array<u32> vertices;
+    Array<u32> offsets;
+  };
+
+  /**
+   * @brief Finds the strongly connected components of a directed graph with
+   * Tarjan's algorithm.
+   *
+   * The search keeps its own stack, hence long paths do not exhaust the call
+   * stack.
+   *
+   * @param edge_offsets The edges of vertex i are those from edge_offsets[i]
+   * to edge_offsets[i + 1] in edges. Holds one entry more than there are
+   * vertices.
+   * @param edges The targets of the edges.
+   * @param components Receives the components. Previous contents are
+   * discarded.
+   */
+  void find_strong_components(Slice<u32 const> edge_offsets,
+                              Slice<u32 const> edges,
+                              Strong_Components& components);
+} // namespace nebula
@@ -7,7 +7,13 @@ namespace nebula {
     mouse_3,
     mouse_4,
     mouse_5,
+    key_c = 67,
     key_r = 82,
+    key_v = 86,
+    key_y = 89,
+    key_z = 90,
+    key_delete = 261,
+    key_lshift = 340,
     key_lctrl = 341,
     key_rctrl = 345,
   };
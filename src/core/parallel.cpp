@@ -0,0 +1,143 @@
+#include <core/parallel.hpp>
+
+#include <anton/array.hpp>
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace nebula {
+  i64 get_hardware_thread_count()
+  {
+    i64 const count = std::thread::hardware_concurrency();
+    return count > 0 ? count : 1;
+  }
+
+  // Batch
+  //
+  // The blocks of a single run_blocks call. Lives on the stack of the caller.
+  // All members except the constant ones are guarded by the mutex of the pool.
+  //
+  struct Batch {
+    Block_Function function;
+    void const* context;
+    i64 count;
+    i64 block;
+    i64 blocks;
+    // Index of the next block to be taken.
+    i64 next;
+    // Number of taken blocks that have not been finished yet excluding the
+    // first block processed by the caller.
+    i64 remaining;
+    std::condition_variable finished;
+  };
+
+  struct Worker_Pool {
+    std::mutex mutex;
+    std::condition_variable available;
+    // Batches with blocks that have not been taken yet in the order of
+    // submission.
+    Array<Batch*> batches;
+  };
+
+  // take_block
+  //
+  // Take the next block of a batch and withdraw the batch from the pool once
+  // all of its blocks have been taken. The mutex of the pool must be held.
+  //
+  // Returns:
+  // The index of the taken block.
+  //
+  [[nodiscard]] static i64 take_block(Worker_Pool& pool, Batch& batch)
+  {
+    i64 const index = batch.next;
+    batch.next += 1;
+    if(batch.next == batch.blocks) {
+      for(auto iter = pool.batches.begin(); iter != pool.batches.end();
+          ++iter) {
+        if(*iter == &batch) {
+          pool.batches.erase(iter, iter + 1);
+          break;
+        }
+      }
+    }
+    return index;
+  }
+
+  // run_block
+  //
+  // Process a taken block with the mutex of the pool released and mark it
+  // finished.
+  //
+  static void run_block(std::unique_lock<std::mutex>& lock, Batch& batch,
+                        i64 const index)
+  {
+    lock.unlock();
+    i64 const begin = index * batch.block;
+    i64 const end = math::min(batch.count, begin + batch.block);
+    batch.function(batch.context, begin, end);
+    lock.lock();
+    batch.remaining -= 1;
+    if(batch.remaining == 0) {
+      batch.finished.notify_one();
+    }
+  }
+
+  static void run_worker(Worker_Pool& pool)
+  {
+    std::unique_lock<std::mutex> lock(pool.mutex);
+    while(true) {
+      pool.available.wait(lock, [&pool] { return pool.batches.size() > 0; });
+      Batch& batch = *pool.batches[0];
+      i64 const index = take_block(pool, batch);
+      run_block(lock, batch, index);
+    }
+  }
+
+  // get_worker_pool
+  //
+  // The pool is never destroyed because its threads are detached and wait for
+  // work until the process exits.
+  //
+  [[nodiscard]] static Worker_Pool& get_worker_pool()
+  {
+    static Worker_Pool* const pool = [] {
+      Worker_Pool* const pool = new Worker_Pool;
+      i64 const workers = get_hardware_thread_count() - 1;
+      for(i64 i = 0; i < workers; ++i) {
+        std::thread(run_worker, std::ref(*pool)).detach();
+      }
+      return pool;
+    }();
+    return *pool;
+  }
+
+  void run_blocks(i64 const count, i64 const block,
+                  Block_Function const function, void const* const context)
+  {
+    i64 const blocks = (count + block - 1) / block;
+    if(blocks <= 1) {
+      function(context, 0, count);
+      return;
+    }
+
+    Worker_Pool& pool = get_worker_pool();
+    Batch batch{function, context, count, block, blocks, 1, blocks - 1};
+    {
+      std::lock_guard<std::mutex> lock(pool.mutex);
+      pool.batches.push_back(&batch);
+    }
+    pool.available.notify_all();
+
+    function(context, 0, block);
+    std::unique_lock<std::mutex> lock(pool.mutex);
+    // Take the blocks the workers have not reached yet. Blocks of other
+    // batches are left to the workers so that the caller returns as soon as
+    // possible.
+    while(batch.next < batch.blocks) {
+      i64 const index = take_block(pool, batch);
+      run_block(lock, batch, index);
+    }
+    batch.finished.wait(lock, [&batch] { return batch.remaining == 0; });
+  }
+} // namespace nebula
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <anton/math/math.hpp>
+
+#include <core/types.hpp>
+
+namespace nebula {
+  // get_hardware_thread_count
+  //
+  // Returns:
+  // The number of hardware threads, at least 1.
+  //
+  [[nodiscard]] i64 get_hardware_thread_count();
+
+  using Block_Function = void (*)(void const* context, i64 begin, i64 end);
+
+  // run_blocks
+  //
+  // Split the range [0, count) into blocks and process them on a pool of
+  // worker threads shared by all callers. The pool is started on the first
+  // call and has one thread less than the hardware. The calling thread
+  // processes the first block and then helps with the remaining blocks.
+  // Returns after all blocks have been processed.
+  //
+  // Parameters:
+  //    count - the size of the range.
+  //    block - the size of a block.
+  // function - invoked once per block with the context and the block bounds.
+  //  context - passed to the function.
+  //
+  void run_blocks(i64 count, i64 block, Block_Function function,
+                  void const* context);
+
+  // parallel_for
+  //
+  // Split the range [0, count) into contiguous blocks and invoke the callback
+  // once per block on the worker pool. Returns after all blocks have been
+  // processed. The calling thread processes the first block.
+  //
+  // Parameters:
+  //    count - the size of the range.
+  //  threads - the maximum number of threads. 0 selects the hardware count.
+  // callback - invocable with (i64 begin, i64 end).
+  //
+  template<typename Callback>
+  void parallel_for(i64 const count, i64 threads, Callback const& callback)
+  {
+    if(threads <= 0) {
+      threads = get_hardware_thread_count();
+    }
+    // Avoid involving other threads in ranges that are not worth it.
+    constexpr i64 minimum_block = 256;
+    threads = math::max(static_cast<i64>(1),
+                       math::min(threads, count / minimum_block));
+    i64 const block = (count + threads - 1) / threads;
+    if(threads == 1) {
+      callback(0, count);
+      return;
+    }
+
+    run_blocks(
+      count, block,
+      [](void const* const context, i64 const begin, i64 const end) {
+        (*static_cast<Callback const*>(context))(begin, end);
+      },
+      &callback);
+  }
+} // namespace nebula
@@ -0,0 +1,232 @@
+#include <core/spatial_index.hpp>
+
+#include <anton/math/math.hpp>
+
+namespace nebula {
+  constexpr u32 invalid_entry = static_cast<u32>(-1);
+
+  [[nodiscard]] static u64 get_bucket_key(i32 const x, i32 const y)
+  {
+    return (static_cast<u64>(static_cast<u32>(x)) << 32) |
+           static_cast<u64>(static_cast<u32>(y));
+  }
+
+  [[nodiscard]] static bool overlaps(AABB const& a, AABB const& b)
+  {
+    return a.min.x <= b.max.x && a.max.x >= b.min.x && a.min.y <= b.max.y &&
+           a.max.y >= b.min.y;
+  }
+
+  // is_removed
+  //
+  // Removed boxes have inverted bounds. They are in no bucket and are skipped
+  // when scanning all boxes.
+  //
+  [[nodiscard]] static bool is_removed(AABB const& box)
+  {
+    return box.min.x > box.max.x;
+  }
+
+  Spatial_Index::Spatial_Index(f32 const bucket_size)
+    : free_entry(invalid_entry), bucket_size(bucket_size)
+  {
+  }
+
+  i32 Spatial_Index::get_bucket(f32 const coordinate) const
+  {
+    return static_cast<i32>(math::floor(coordinate / bucket_size));
+  }
+
+  Spatial_Index::Bucket_Range
+  Spatial_Index::get_buckets(AABB const& box) const
+  {
+    return Bucket_Range{get_bucket(box.min.x), get_bucket(box.min.y),
+                        get_bucket(box.max.x), get_bucket(box.max.y)};
+  }
+
+  void Spatial_Index::link(u32 const index, i32 const x, i32 const y)
+  {
+    u32 entry = free_entry;
+    if(entry != invalid_entry) {
+      free_entry = entries[entry].next;
+    } else {
+      entry = entries.size();
+      entries.push_back(Bucket_Entry{});
+    }
+
+    u64 const key = get_bucket_key(x, y);
+    auto iter = heads.find(key);
+    if(iter == heads.end()) {
+      entries[entry] = Bucket_Entry{index, invalid_entry};
+      heads.emplace(key, entry);
+    } else {
+      entries[entry] = Bucket_Entry{index, iter->value};
+      iter->value = entry;
+    }
+  }
+
+  void Spatial_Index::unlink(u32 const index, i32 const x, i32 const y)
+  {
+    auto iter = heads.find(get_bucket_key(x, y));
+    if(iter == heads.end()) {
+      return;
+    }
+
+    // Emptied buckets keep their key with no entries.
+    u32* next = &iter->value;
+    while(*next != invalid_entry) {
+      u32 const entry = *next;
+      if(entries[entry].box == index) {
+        *next = entries[entry].next;
+        entries[entry].next = free_entry;
+        free_entry = entry;
+        return;
+      }
+      next = &entries[entry].next;
+    }
+  }
+
+  u32 Spatial_Index::add(AABB const& box)
+  {
+    u32 index;
+    if(free_boxes.size() > 0) {
+      index = free_boxes.back();
+      free_boxes.pop_back();
+      boxes[index] = box;
+    } else {
+      index = boxes.size();
+      boxes.push_back(box);
+    }
+
+    Bucket_Range const range = get_buckets(box);
+    for(i32 x = range.x_begin; x <= range.x_end; ++x) {
+      for(i32 y = range.y_begin; y <= range.y_end; ++y) {
+        link(index, x, y);
+      }
+    }
+    return index;
+  }
+
+  void Spatial_Index::update(u32 const index, AABB const& box)
+  {
+    auto contains = [](Bucket_Range const& range, i32 const x, i32 const y) {
+      return x >= range.x_begin && x <= range.x_end && y >= range.y_begin &&
+             y <= range.y_end;
+    };
+
+    Bucket_Range const from = get_buckets(boxes[index]);
+    Bucket_Range const to = get_buckets(box);
+    boxes[index] = box;
+    for(i32 x = from.x_begin; x <= from.x_end; ++x) {
+      for(i32 y = from.y_begin; y <= from.y_end; ++y) {
+        if(!contains(to, x, y)) {
+          unlink(index, x, y);
+        }
+      }
+    }
+
+    for(i32 x = to.x_begin; x <= to.x_end; ++x) {
+      for(i32 y = to.y_begin; y <= to.y_end; ++y) {
+        if(!contains(from, x, y)) {
+          link(index, x, y);
+        }
+      }
+    }
+  }
+
+  void Spatial_Index::remove(u32 const index)
+  {
+    Bucket_Range const range = get_buckets(boxes[index]);
+    for(i32 x = range.x_begin; x <= range.x_end; ++x) {
+      for(i32 y = range.y_begin; y <= range.y_end; ++y) {
+        unlink(index, x, y);
+      }
+    }
+    boxes[index] = AABB{Vec2{1.0f, 0.0f}, Vec2{0.0f, 0.0f}};
+    free_boxes.push_back(index);
+  }
+
+  bool Spatial_Index::overlaps_any(AABB const& query) const
+  {
+    i32 const x_begin = get_bucket(query.min.x);
+    i32 const y_begin = get_bucket(query.min.y);
+    i32 const x_end = get_bucket(query.max.x);
+    i32 const y_end = get_bucket(query.max.y);
+    i64 const buckets =
+      static_cast<i64>(x_end - x_begin + 1) * (y_end - y_begin + 1);
+    // Scanning all boxes is cheaper than visiting mostly empty buckets.
+    if(buckets > boxes.size()) {
+      for(AABB const& box: boxes) {
+        if(!is_removed(box) && overlaps(box, query)) {
+          return true;
+        }
+      }
+      return false;
+    }
+
+    for(i32 x = x_begin; x <= x_end; ++x) {
+      for(i32 y = y_begin; y <= y_end; ++y) {
+        auto iter = heads.find(get_bucket_key(x, y));
+        if(iter == heads.end()) {
+          continue;
+        }
+
+        for(u32 entry = iter->value; entry != invalid_entry;
+            entry = entries[entry].next) {
+          if(overlaps(boxes[entries[entry].box], query)) {
+            return true;
+          }
+        }
+      }
+    }
+    return false;
+  }
+
+  void Spatial_Index::query(AABB const& query, Array<u32>& result) const
+  {
+    i32 const x_begin = get_bucket(query.min.x);
+    i32 const y_begin = get_bucket(query.min.y);
+    i32 const x_end = get_bucket(query.max.x);
+    i32 const y_end = get_bucket(query.max.y);
+    i64 const buckets =
+      static_cast<i64>(x_end - x_begin + 1) * (y_end - y_begin + 1);
+    if(buckets > boxes.size()) {
+      for(i64 i = 0; i < boxes.size(); ++i) {
+        if(!is_removed(boxes[i]) && overlaps(boxes[i], query)) {
+          result.push_back(i);
+        }
+      }
+      return;
+    }
+
+    for(i32 x = x_begin; x <= x_end; ++x) {
+      for(i32 y = y_begin; y <= y_end; ++y) {
+        auto iter = heads.find(get_bucket_key(x, y));
+        if(iter == heads.end()) {
+          continue;
+        }
+
+        for(u32 entry = iter->value; entry != invalid_entry;
+            entry = entries[entry].next) {
+          AABB const& box = boxes[entries[entry].box];
+          if(!overlaps(box, query)) {
+            continue;
+          }
+
+          // A box spanning several buckets is reported only from the bucket
+          // containing the corner of its overlap with the query.
+          i32 const corner_x = get_bucket(math::max(box.min.x, query.min.x));
+          i32 const corner_y = get_bucket(math::max(box.min.y, query.min.y));
+          if(corner_x == x && corner_y == y) {
+            result.push_back(entries[entry].box);
+          }
+        }
+      }
+    }
+  }
+
+  i64 Spatial_Index::size() const
+  {
+    return boxes.size();
+  }
+} // namespace nebula
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <anton/flat_hash_map.hpp>
+
+#include <core/types.hpp>
+
+namespace nebula {
+  /**
+   * @brief Axis-aligned bounding box.
+   */
+  struct AABB {
+    Vec2 min;
+    Vec2 max;
+  };
+
+  /**
+   * @brief Spatial hash of axis-aligned boxes.
+   *
+   * The plane is divided into square buckets. Every bucket holds a singly
+   * linked list of the boxes overlapping it. Boxes are identified by the order
+   * in which they have been added. The indices of removed boxes are reused by
+   * later additions.
+   */
+  struct Spatial_Index {
+  private:
+    struct Bucket_Entry {
+      u32 box;
+      u32 next;
+    };
+
+    // Inclusive range of the buckets overlapped by a box.
+    struct Bucket_Range {
+      i32 x_begin;
+      i32 y_begin;
+      i32 x_end;
+      i32 y_end;
+    };
+
+    Flat_Hash_Map<u64, u32> heads;
+    Array<Bucket_Entry> entries;
+    Array<AABB> boxes;
+    // Head of the list of unused entries linked by their next.
+    u32 free_entry;
+    // Indices of the removed boxes.
+    Array<u32> free_boxes;
+    f32 bucket_size;
+
+  public:
+    /**
+     * @param bucket_size The size of a bucket. Should be comparable to the
+     * size of the boxes.
+     */
+    explicit Spatial_Index(f32 bucket_size = 1.0f);
+
+    /**
+     * @brief Adds a box to the index.
+     *
+     * @return The index of the box.
+     */
+    u32 add(AABB const& box);
+
+    /**
+     * @brief Moves a box to new bounds. Only the buckets the box leaves or
+     * enters are updated.
+     *
+     * @param index The index of the box.
+     * @param box The new bounds of the box.
+     */
+    void update(u32 index, AABB const& box);
+
+    /**
+     * @brief Removes a box from the index.
+     *
+     * @param index The index of the box.
+     */
+    void remove(u32 index);
+
+    /**
+     * @brief Tests whether any box overlaps a query box.
+     *
+     * Boxes touching the query box are considered overlapping. Points and
+     * segments may be tested as degenerate boxes.
+     */
+    [[nodiscard]] bool overlaps_any(AABB const& query) const;
+
+    /**
+     * @brief Finds all boxes overlapping a query box.
+     *
+     * @param query The box to test against.
+     * @param result The array the indices of the overlapping boxes are appended
+     * to. Every box is appended once.
+     */
+    void query(AABB const& query, Array<u32>& result) const;
+
+    [[nodiscard]] i64 size() const;
+
+  private:
+    [[nodiscard]] i32 get_bucket(f32 coordinate) const;
+    [[nodiscard]] Bucket_Range get_buckets(AABB const& box) const;
+    void link(u32 index, i32 x, i32 y);
+    void unlink(u32 index, i32 x, i32 y);
+  };
+} // namespace nebula
@@ -0,0 +1,12 @@
+#include <core/time.hpp>
+
+#include <time.h>
+
+namespace nebula {
+  f64 get_time()
+  {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<f64>(ts.tv_sec) + static_cast<f64>(ts.tv_nsec) * 1e-9;
+  }
+} // namespace nebula
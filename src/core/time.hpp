@@ -0,0 +1,15 @@
+#pragma once
+
+#include <core/types.hpp>
+
+namespace nebula {
+  // get_time
+  //
+  // Query a monotonic clock. The epoch is unspecified, therefore the value is
+  // only meaningful when compared with other values returned by get_time.
+  //
+  // Returns:
+  // Time in seconds.
+  //
+  [[nodiscard]] f64 get_time();
+} // namespace nebula
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <anton/assert.hpp>
+
+#include <core/types.hpp>
+
+namespace nebula {
+  template<typename T>
+  struct Timed_Event {
+    i64 time;
+    T value;
+  };
+
+  /**
+   * @brief Calendar queue of events keyed on simulated time.
+   *
+   * Every tick of a window of bucket_count ticks has a bucket. Events beyond
+   * the window share the bucket of their time modulo the window and are
+   * skipped until the wheel has turned to their time. A turn that finds no
+   * due event jumps to the earliest event, hence sparse events do not cost
+   * scanning the empty ticks between them. The buckets keep their memory,
+   * hence scheduling does not allocate once the buckets have grown.
+   */
+  template<typename T>
+  struct Time_Wheel {
+    Array<Array<Timed_Event<T>>> buckets;
+    // Time of the bucket the next take starts at. No event is earlier.
+    i64 time = 0;
+    i64 count = 0;
+  };
+
+  /**
+   * @brief Empties the wheel and moves it to a time.
+   *
+   * @param bucket_count The number of ticks of the window. Must be a power
+   * of 2.
+   * @param time The time of the earliest event that may be scheduled.
+   */
+  template<typename T>
+  void reset_time_wheel(Time_Wheel<T>& wheel, i64 const bucket_count,
+                        i64 const time)
+  {
+    ANTON_ASSERT((bucket_count & (bucket_count - 1)) == 0,
+                 "bucket count is not a power of 2");
+    if(wheel.buckets.size() != bucket_count) {
+      wheel.buckets.clear();
+      wheel.buckets.resize(bucket_count);
+    } else {
+      for(Array<Timed_Event<T>>& bucket: wheel.buckets) {
+        bucket.clear();
+      }
+    }
+    wheel.time = time;
+    wheel.count = 0;
+  }
+
+  /**
+   * @brief Adds an event.
+   *
+   * @param time The time of the event. Must not be earlier than the time of
+   * the wheel.
+   */
+  template<typename T>
+  void schedule_event(Time_Wheel<T>& wheel, i64 const time, T const& value)
+  {
+    ANTON_ASSERT(time >= wheel.time, "event is earlier than the wheel");
+    i64 const mask = wheel.buckets.size() - 1;
+    wheel.buckets[time & mask].push_back(Timed_Event<T>{time, value});
+    wheel.count += 1;
+  }
+
+  /**
+   * @brief Removes the earliest events unless they are later than a time.
+   *
+   * Events of the same time are taken in the order they were scheduled in.
+   * Events scheduled at the returned time afterwards are taken by the next
+   * call.
+   *
+   * @param events Receives the values of the events.
+   * @param end The latest time of the events to take.
+   * @return The time of the events or -1 if there are no events until end.
+   */
+  template<typename T>
+  [[nodiscard]] i64 take_events(Time_Wheel<T>& wheel, Array<T>& events,
+                                i64 const end)
+  {
+    if(wheel.count == 0) {
+      return -1;
+    }
+
+    i64 const bucket_count = wheel.buckets.size();
+    i64 const mask = bucket_count - 1;
+    for(i64 turn = 0; turn <= bucket_count; ++turn) {
+      if(turn == bucket_count) {
+        // The whole window is empty, hence the earliest event is at least a
+        // turn away.
+        i64 earliest = -1;
+        for(Array<Timed_Event<T>> const& bucket: wheel.buckets) {
+          for(Timed_Event<T> const& event: bucket) {
+            if(earliest < 0 || event.time < earliest) {
+              earliest = event.time;
+            }
+          }
+        }
+        wheel.time = earliest;
+      }
+
+      if(wheel.time > end) {
+        wheel.time = end + 1;
+        return -1;
+      }
+
+      Array<Timed_Event<T>>& bucket = wheel.buckets[wheel.time & mask];
+      i64 remaining = 0;
+      for(Timed_Event<T> const& event: bucket) {
+        if(event.time == wheel.time) {
+          events.push_back(event.value);
+        } else {
+          bucket[remaining] = event;
+          remaining += 1;
+        }
+      }
+
+      i64 const taken = bucket.size() - remaining;
+      if(taken > 0) {
+        bucket.erase(bucket.begin() + remaining, bucket.end());
+        wheel.count -= taken;
+        return wheel.time;
+      }
+      wheel.time += 1;
+    }
+    ANTON_UNREACHABLE("the wheel lost its events");
+  }
+
+  /**
+   * @brief Removes the earliest events.
+   *
+   * @return The time of the events or -1 if the wheel is empty.
+   */
+  template<typename T>
+  [[nodiscard]] i64 take_events(Time_Wheel<T>& wheel, Array<T>& events)
+  {
+    i64 const last = static_cast<i64>(~static_cast<u64>(0) >> 1);
+    return take_events(wheel, events, last);
+  }
+} // namespace nebula
@@ -0,0 +1,285 @@
+#include <evaluator/batch.hpp>
+
+#include <anton/flat_hash_map.hpp>
+#include <anton/format.hpp>
+
+#include <model/port.hpp>
+#include <ui/scene.hpp>
+
+namespace nebula {
+  [[nodiscard]] static u64 get_key(Gate const* const gate)
+  {
+    return reinterpret_cast<u64>(gate);
+  }
+
+  [[nodiscard]] static Port const* get_driver(Port const* const port)
+  {
+    if(port->connections.size() == 1) {
+      return *port->connections.begin();
+    } else {
+      return nullptr;
+    }
+  }
+
+  [[nodiscard]] static String get_gate_name(Gate const& gate)
+  {
+    if(gate.name.size_bytes() > 0) {
+      return gate.name;
+    } else {
+      return format("g{}"_sv, gate.id);
+    }
+  }
+
+  // order_gates
+  //
+  // Order the combinational gates topologically with Kahn's algorithm.
+  //
+  // Returns:
+  // A gate in or behind a combinational loop if some gates could not be
+  // ordered, nullptr otherwise.
+  //
+  [[nodiscard]] static Gate* order_gates(Scene& scene, Array<Gate*>& order)
+  {
+    // Maps the address of a gate to the number of its combinational drivers
+    // that have not been ordered yet.
+    Flat_Hash_Map<u64, i64> pending;
+    for(Gate& gate: scene.gates) {
+      if(!is_combinational(gate.kind)) {
+        continue;
+      }
+
+      i64 count = 0;
+      for(Port const* const port: gate.in_ports) {
+        Port const* const driver = get_driver(port);
+        if(driver != nullptr && is_combinational(driver->gate->kind)) {
+          count += 1;
+        }
+      }
+      if(count == 0) {
+        order.push_back(&gate);
+      } else {
+        pending.emplace(get_key(&gate), count);
+      }
+    }
+
+    for(i64 head = 0; head < order.size(); ++head) {
+      for(Port const* const reader: order[head]->out_ports[0]->connections) {
+        auto iter = pending.find(get_key(reader->gate));
+        if(iter == pending.end()) {
+          continue;
+        }
+
+        iter->value -= 1;
+        if(iter->value == 0) {
+          order.push_back(reader->gate);
+        }
+      }
+    }
+
+    for(Gate& gate: scene.gates) {
+      auto iter = pending.find(get_key(&gate));
+      if(iter != pending.end() && iter->value > 0) {
+        return &gate;
+      }
+    }
+    return nullptr;
+  }
+
+  Expected<Batch_Program, Error> compile_batch(Scene& scene,
+                                               Slice<Gate* const> const inputs)
+  {
+    Batch_Program program;
+    // Slot 0 holds the value of unconnected inputs.
+    program.slot_count = 1;
+    Flat_Hash_Map<u64, u32>& slots = program.gate_slots;
+    for(Gate* const gate: inputs) {
+      slots.emplace(get_key(gate), program.slot_count);
+      program.input_slots.push_back(program.slot_count);
+      program.slot_count += 1;
+    }
+
+    for(Gate& gate: scene.gates) {
+      if(gate.kind == Gate_Kind::e_input || gate.kind == Gate_Kind::e_clock) {
+        if(slots.find(get_key(&gate)) == slots.end()) {
+          slots.emplace(get_key(&gate), program.slot_count);
+          program.constant_slots.push_back(program.slot_count);
+          program.constant_values.push_back(gate.evaluation.value);
+          program.slot_count += 1;
+        }
+      } else if(is_combinational(gate.kind)) {
+        slots.emplace(get_key(&gate), program.slot_count);
+        program.slot_count += 1;
+      } else {
+        return {expected_error,
+                format("'{}' is not combinational, hence the design cannot "
+                       "be evaluated in batches"_sv,
+                       get_gate_name(gate))};
+      }
+    }
+
+    Array<Gate*> order;
+    if(Gate const* const looped = order_gates(scene, order)) {
+      return {expected_error, format("'{}' is in or behind a combinational "
+                                     "loop"_sv,
+                                     get_gate_name(*looped))};
+    }
+
+    for(Gate const* const gate: order) {
+      Batch_Instruction instruction;
+      instruction.kind = gate->kind;
+      instruction.output = slots.find(get_key(gate))->value;
+      instruction.table = gate->table;
+      for(i64 i = 0; i < lut_input_count; ++i) {
+        instruction.inputs[i] = 0;
+      }
+      for(i64 i = 0; i < gate->in_ports.size(); ++i) {
+        Port const* const driver = get_driver(gate->in_ports[i]);
+        if(driver != nullptr) {
+          instruction.inputs[i] = slots.find(get_key(driver->gate))->value;
+        }
+      }
+      program.instructions.push_back(instruction);
+    }
+    return {expected_value, ANTON_MOV(program)};
+  }
+
+  u32 get_batch_slot(Batch_Program const& program, Gate const* const gate)
+  {
+    return program.gate_slots.find(get_key(gate))->value;
+  }
+
+  // evaluate_lut
+  //
+  // Select the bits of the table by the inputs with a tree of multiplexers,
+  // one level per input.
+  //
+  [[nodiscard]] static u64 evaluate_lut(u64 const table,
+                                        u64 const* const inputs)
+  {
+    u64 words[64];
+    for(i64 i = 0; i < 64; ++i) {
+      words[i] = (table >> i) & 1 ? ~static_cast<u64>(0) : 0;
+    }
+
+    i64 count = 64;
+    for(i64 level = 0; level < lut_input_count; ++level) {
+      u64 const select = inputs[level];
+      count /= 2;
+      for(i64 i = 0; i < count; ++i) {
+        words[i] = (select & words[2 * i + 1]) | (~select & words[2 * i]);
+      }
+    }
+    return words[0];
+  }
+
+  void evaluate_batch(Batch_Program const& program, Slice<u64> const slots)
+  {
+    slots[0] = 0;
+    for(i64 i = 0; i < program.constant_slots.size(); ++i) {
+      slots[program.constant_slots[i]] =
+        program.constant_values[i] ? ~static_cast<u64>(0) : 0;
+    }
+
+    for(Batch_Instruction const& instruction: program.instructions) {
+      u32 const* const inputs = instruction.inputs;
+      u64 value;
+      switch(instruction.kind) {
+      case Gate_Kind::e_and:
+        value = slots[inputs[0]] & slots[inputs[1]];
+        break;
+      case Gate_Kind::e_or:
+        value = slots[inputs[0]] | slots[inputs[1]];
+        break;
+      case Gate_Kind::e_xor:
+        value = slots[inputs[0]] ^ slots[inputs[1]];
+        break;
+      case Gate_Kind::e_nand:
+        value = ~(slots[inputs[0]] & slots[inputs[1]]);
+        break;
+      case Gate_Kind::e_nor:
+        value = ~(slots[inputs[0]] | slots[inputs[1]]);
+        break;
+      case Gate_Kind::e_xnor:
+        value = ~(slots[inputs[0]] ^ slots[inputs[1]]);
+        break;
+      case Gate_Kind::e_not:
+        value = ~slots[inputs[0]];
+        break;
+      case Gate_Kind::e_lut: {
+        u64 words[lut_input_count];
+        for(i64 i = 0; i < lut_input_count; ++i) {
+          words[i] = slots[inputs[i]];
+        }
+        value = evaluate_lut(instruction.table, words);
+      } break;
+      default:
+        ANTON_UNREACHABLE("instruction is not combinational");
+      }
+      slots[instruction.output] = value;
+    }
+  }
+
+  // evaluate_lut_logic
+  //
+  // Select the bits of the table with a tree of four-valued multiplexers. A
+  // multiplexer with an unknown select is known only if both of its inputs
+  // are known and equal.
+  //
+  [[nodiscard]] static Logic_Word
+  evaluate_lut_logic(u64 const table, Logic_Word const* const inputs)
+  {
+    Logic_Word words[64];
+    for(i64 i = 0; i < 64; ++i) {
+      words[i] = {(table >> i) & 1 ? ~static_cast<u64>(0) : 0, 0};
+    }
+
+    i64 count = 64;
+    for(i64 level = 0; level < lut_input_count; ++level) {
+      Logic_Word const select = inputs[level];
+      u64 const one = select.value & ~select.unknown;
+      u64 const zero = ~select.value & ~select.unknown;
+      count /= 2;
+      for(i64 i = 0; i < count; ++i) {
+        Logic_Word const low = words[2 * i];
+        Logic_Word const high = words[2 * i + 1];
+        u64 const agree =
+          ~low.unknown & ~high.unknown & ~(low.value ^ high.value);
+        u64 const unknown = (one & high.unknown) | (zero & low.unknown) |
+                            (select.unknown & ~agree);
+        u64 const value = (one & high.value) | (zero & low.value) |
+                          (select.unknown & low.value);
+        words[i] = {value & ~unknown, unknown};
+      }
+    }
+    return words[0];
+  }
+
+  void evaluate_batch_logic(Batch_Program const& program,
+                            Slice<u64> const values, Slice<u64> const unknowns)
+  {
+    values[0] = logic_z.value;
+    unknowns[0] = logic_z.unknown;
+    for(i64 i = 0; i < program.constant_slots.size(); ++i) {
+      u32 const slot = program.constant_slots[i];
+      values[slot] = program.constant_values[i] ? ~static_cast<u64>(0) : 0;
+      unknowns[slot] = 0;
+    }
+
+    for(Batch_Instruction const& instruction: program.instructions) {
+      Logic_Word words[lut_input_count];
+      i64 const count =
+        instruction.kind == Gate_Kind::e_lut ? lut_input_count : 2;
+      for(i64 i = 0; i < count; ++i) {
+        u32 const slot = instruction.inputs[i];
+        words[i] = {values[slot], unknowns[slot]};
+      }
+
+      Logic_Word const word =
+        instruction.kind == Gate_Kind::e_lut
+          ? evaluate_lut_logic(instruction.table, words)
+          : compute_logic(instruction.kind, words[0], words[1]);
+      values[instruction.output] = word.value;
+      unknowns[instruction.output] = word.unknown;
+    }
+  }
+} // namespace nebula
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <anton/expected.hpp>
+#include <anton/flat_hash_map.hpp>
+#include <anton/slice.hpp>
+
+#include <core/error.hpp>
+#include <core/types.hpp>
+#include <evaluator/logic.hpp>
+#include <model/gate.hpp>
+
+namespace nebula {
+  struct Scene;
+
+  /**
+   * @brief Number of input vectors evaluated by a single batch evaluation,
+   * one per bit of a word.
+   */
+  constexpr i64 batch_width = 64;
+
+  struct Batch_Instruction {
+    Gate_Kind kind;
+    // Slot written by the instruction.
+    u32 output;
+    // Slots read by the instruction. Unconnected inputs read slot 0, which
+    // holds 0, or Z in the four-valued logic.
+    u32 inputs[lut_input_count];
+    u64 table;
+  };
+
+  /**
+   * @brief Combinational logic of a scene compiled for bit-parallel
+   * evaluation.
+   *
+   * Every net is a slot holding one word, bit i of which is the value of the
+   * net for the input vector i of the batch. The instructions are ordered
+   * topologically, hence a single pass evaluates batch_width vectors.
+   */
+  struct Batch_Program {
+    Array<Batch_Instruction> instructions;
+    // Slots of the inputs given to compile_batch in the same order. Filled
+    // by the caller before every evaluation.
+    Array<u32> input_slots;
+    // Maps the address of a gate to the slot of its output.
+    Flat_Hash_Map<u64, u32> gate_slots;
+    // Slots of input and clock gates not given to compile_batch and the
+    // values they hold, which are their values when the program was
+    // compiled.
+    Array<u32> constant_slots;
+    Array<u8> constant_values;
+    i64 slot_count = 0;
+  };
+
+  /**
+   * @brief Compiles the combinational logic of a scene.
+   *
+   * @param scene The scene. May contain only inputs, clocks and
+   * combinational gates without loops.
+   * @param inputs The input gates whose values vary between the vectors.
+   * @return The program or an error if the scene contains sequential gates,
+   * memories, module instances or combinational loops.
+   */
+  [[nodiscard]] Expected<Batch_Program, Error>
+  compile_batch(Scene& scene, Slice<Gate* const> inputs);
+
+  /**
+   * @brief Gets the slot holding the values of the output of a gate.
+   *
+   * @param gate A gate of the scene the program has been compiled from.
+   */
+  [[nodiscard]] u32 get_batch_slot(Batch_Program const& program,
+                                   Gate const* gate);
+
+  /**
+   * @brief Evaluates batch_width input vectors.
+   *
+   * @param program The compiled program.
+   * @param slots The values of the nets. Must hold slot_count words with the
+   * input slots filled. The other slots are overwritten.
+   */
+  void evaluate_batch(Batch_Program const& program, Slice<u64> slots);
+
+  /**
+   * @brief Evaluates batch_width input vectors in the four-valued logic.
+   *
+   * The slots are the two planes of Logic_Word kept apart, hence the inputs
+   * are filled the same way as for evaluate_batch. Unconnected inputs read
+   * Z.
+   *
+   * @param program The compiled program.
+   * @param values The value planes of the nets. Must hold slot_count words
+   * with the input slots filled. The other slots are overwritten.
+   * @param unknowns The unknown planes of the nets. Must hold slot_count
+   * words with the input slots filled. The other slots are overwritten.
+   */
+  void evaluate_batch_logic(Batch_Program const& program, Slice<u64> values,
+                            Slice<u64> unknowns);
+} // namespace nebula
@@ -0,0 +1,181 @@
+#include <evaluator/domains.hpp>
+
+#include <anton/algorithm/sort.hpp>
+#include <anton/flat_hash_map.hpp>
+#include <anton/math/math.hpp>
+
+#include <model/memory.hpp>
+#include <model/port.hpp>
+
+namespace nebula {
+  // Number of ticks of the window of the wheel. Clocks toggling at least
+  // once per window never make the wheel search for the earliest edge.
+  constexpr i64 clock_wheel_size = 1024;
+
+  i64 get_next_toggle(u32 const period, u32 const phase, i64 const time)
+  {
+    i64 const half = math::max(static_cast<i64>(period / 2), i64(1));
+    if(time <= phase) {
+      return phase;
+    }
+    return phase + (time - phase + half - 1) / half * half;
+  }
+
+  void schedule_clocks(Clock_Schedule& clocks)
+  {
+    i64 const time = clocks.time + 1;
+    reset_time_wheel(clocks.wheel, clock_wheel_size, time);
+    clocks.periods.clear();
+    clocks.phases.clear();
+    for(i64 i = 0; i < clocks.clocks.size(); ++i) {
+      Gate const* const clock = clocks.clocks[i];
+      clocks.periods.push_back(clock->clock_period);
+      clocks.phases.push_back(clock->clock_phase);
+      i64 const edge =
+        get_next_toggle(clock->clock_period, clock->clock_phase, time);
+      schedule_event(clocks.wheel, edge, static_cast<u32>(i));
+    }
+  }
+
+  bool is_sampled(Port const* const port)
+  {
+    Gate const& gate = *port->gate;
+    switch(gate.kind) {
+    case Gate_Kind::e_dff:
+      return port != gate.in_ports[1];
+
+    case Gate_Kind::e_register:
+      return port != gate.in_ports[gate.width];
+
+    case Gate_Kind::e_ram: {
+      i64 const last = gate.in_ports.size() - 1;
+      return port->index >= gate.memory->address_width && port->index < last;
+    }
+
+    default:
+      return false;
+    }
+  }
+
+  // mark_fanout
+  //
+  // Append the positions of the gates reachable from the gates on the stack
+  // to the domain. Gates are marked with the stamp of the domain, hence
+  // every gate is appended once.
+  //
+  static void mark_fanout(Clock_Schedule const& clocks, Array<u32>& stamps,
+                          u32 const stamp, Array<u32>& stack,
+                          Array<u32>& domain)
+  {
+    while(stack.size() > 0) {
+      u32 const position = stack.back();
+      stack.pop_back();
+      domain.push_back(position);
+      u32 const end = clocks.fanout_offsets[position + 1];
+      for(u32 i = clocks.fanout_offsets[position]; i < end; ++i) {
+        u32 const reader = clocks.fanouts[i];
+        if(stamps[reader] != stamp) {
+          stamps[reader] = stamp;
+          stack.push_back(reader);
+        }
+      }
+    }
+  }
+
+  void build_clock_domains(Clock_Schedule& clocks,
+                           Evaluation_Schedule const& schedule)
+  {
+    clocks.clocks.clear();
+    clocks.offsets.clear();
+    clocks.positions.clear();
+    clocks.static_positions.clear();
+    clocks.fanout_offsets.clear();
+    clocks.fanouts.clear();
+    clocks.reader_offsets.clear();
+    clocks.readers.clear();
+    clocks.inputs.clear();
+    clocks.input_values.clear();
+    clocks.revision = schedule.revision;
+    clocks.gate_count = schedule.order.size();
+    clocks.full = true;
+
+    Flat_Hash_Map<u64, u32> positions;
+    Array<u32> modules;
+    for(i64 i = 0; i < schedule.order.size(); ++i) {
+      Gate* const gate = schedule.order[i];
+      positions.emplace(reinterpret_cast<u64>(gate), i);
+      if(gate->kind == Gate_Kind::e_clock) {
+        clocks.clocks.push_back(gate);
+        continue;
+      }
+
+      clocks.static_positions.push_back(i);
+      if(gate->kind == Gate_Kind::e_input) {
+        // Inputs keep their values of the last edge as their previous
+        // values, hence changes since then are reported by the next edge.
+        clocks.inputs.push_back(gate);
+        clocks.input_values.push_back(static_cast<u8>(
+          gate->evaluation.prev_value | (gate->evaluation.prev_unknown << 1)));
+      } else if(gate->kind == Gate_Kind::e_module) {
+        modules.push_back(i);
+      }
+    }
+
+    for(Gate const* const gate: schedule.order) {
+      clocks.fanout_offsets.push_back(clocks.fanouts.size());
+      clocks.reader_offsets.push_back(clocks.readers.size());
+      for(Port const* const out: gate->out_ports) {
+        for(Port const* const in: out->connections) {
+          if(is_sampled(in)) {
+            continue;
+          }
+
+          u32 const reader =
+            positions.find(reinterpret_cast<u64>(in->gate))->value;
+          clocks.fanouts.push_back(reader);
+          // Clocks change their previous values as well, hence the boundary
+          // gates see their edges in the same evaluation.
+          if(reader < schedule.boundary_count &&
+             in->gate->kind != Gate_Kind::e_module &&
+             gate->kind != Gate_Kind::e_clock) {
+            clocks.readers.push_back(reader);
+          }
+        }
+      }
+    }
+    clocks.fanout_offsets.push_back(clocks.fanouts.size());
+    clocks.reader_offsets.push_back(clocks.readers.size());
+
+    // Stamp 0 marks no domain.
+    Array<u32>& stamps = clocks.stamps;
+    stamps.clear();
+    stamps.resize(schedule.order.size(), 0);
+    Array<u32> stack;
+    Array<u32> domain;
+    for(i64 i = 0; i < clocks.clocks.size(); ++i) {
+      u32 const stamp = i + 1;
+      u32 const clock =
+        positions.find(reinterpret_cast<u64>(clocks.clocks[i]))->value;
+      stamps[clock] = stamp;
+      stack.push_back(clock);
+      for(u32 const module: modules) {
+        if(stamps[module] != stamp) {
+          stamps[module] = stamp;
+          stack.push_back(module);
+        }
+      }
+
+      domain.clear();
+      mark_fanout(clocks, stamps, stamp, stack, domain);
+      anton::quick_sort(domain.begin(), domain.end(),
+                        [](u32 const a, u32 const b) { return a < b; });
+      clocks.offsets.push_back(clocks.positions.size());
+      for(u32 const position: domain) {
+        clocks.positions.push_back(position);
+      }
+    }
+    clocks.offsets.push_back(clocks.positions.size());
+    clocks.stamp = clocks.clocks.size();
+    schedule_clocks(clocks);
+  }
+} // namespace nebula
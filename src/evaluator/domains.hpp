@@ -0,0 +1,35 @@
+#pragma once
+
+#include <evaluator/evaluator.hpp>
+
+// Internal interface of the evaluation by clock domains.
+
+namespace nebula {
+  /**
+   * @brief Gets the time of the first toggle of a clock at or after a time.
+   */
+  [[nodiscard]] i64 get_next_toggle(u32 period, u32 phase, i64 time);
+
+  /**
+   * @brief Checks whether an input is read only on the edges of the CLK of
+   * its gate.
+   *
+   * The address of a RAM is not sampled since the outputs follow it.
+   */
+  [[nodiscard]] bool is_sampled(Port const* port);
+
+  /**
+   * @brief Schedules the next edge of every clock after the time of the
+   * clock schedule with the current periods and phases of the clocks.
+   */
+  void schedule_clocks(Clock_Schedule& clocks);
+
+  /**
+   * @brief Builds the domains of the clocks of a schedule and schedules the
+   * clocks.
+   *
+   * The order and the boundary gates of the schedule must have been built.
+   */
+  void build_clock_domains(Clock_Schedule& clocks,
+                           Evaluation_Schedule const& schedule);
+} // namespace nebula
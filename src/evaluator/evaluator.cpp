@@ -1,84 +1,1585 @@
 #include <evaluator/evaluator.hpp>
 
+#include <anton/algorithm/sort.hpp>
+#include <anton/flat_hash_map.hpp>
+
+#include <core/components.hpp>
+#include <evaluator/domains.hpp>
+#include <evaluator/fusion.hpp>
+#include <evaluator/logic.hpp>
+#include <evaluator/timing.hpp>
+#include <model/memory.hpp>
+#include <model/module.hpp>
+#include <model/port.hpp>
+
 namespace nebula {
+  // has_state_outputs
+  //
+  // Whether gates of a kind keep the values of their outputs in their state.
+  // Gate::evaluation of such gates holds only the first output.
+  //
+  [[nodiscard]] static bool has_state_outputs(Gate_Kind const kind)
+  {
+    return kind == Gate_Kind::e_register || kind == Gate_Kind::e_ram ||
+           kind == Gate_Kind::e_rom;
+  }
+
+  // get_state_output
+  //
+  // Get an output of a register or a memory as a pair of the value and the
+  // unknown flag. Gates that have not been evaluated yet read 0.
+  //
+  template<bool current>
+  [[nodiscard]] static Logic_Word get_state_output(Gate const& gate,
+                                                   i64 const output)
+  {
+    if(gate.state.size() == 0) {
+      return logic_zero;
+    }
+
+    u8 const value = gate.state[output] >> (current ? 0 : 1);
+    return {static_cast<u64>(value & 1), static_cast<u64>((value >> 2) & 1)};
+  }
+
+  // get_input_value
+  //
+  // Get the value of an input. Inputs read the previous values of their
+  // drivers unless current is set, which the levelized evaluation uses for
+  // drivers that have already been evaluated within the cycle.
+  //
+  template<bool current>
   [[nodiscard]] static bool get_input_value(Port* const port)
   {
     if(port->connections.size() == 1) {
       Port* const other = *port->connections.begin();
-      return other->gate->evaluation.prev_value;
+      Gate const* const gate = other->gate;
+      if(gate->kind == Gate_Kind::e_module) {
+        i64 const output = other->index;
+        return get_module_output(*gate, output);
+      } else if(has_state_outputs(gate->kind)) {
+        i64 const output = other->index;
+        return get_state_output<current>(*gate, output).value;
+      }
+      return current ? gate->evaluation.value : gate->evaluation.prev_value;
     } else {
       return false;
     }
   }
 
-  void evaluate(List<Gate>& gates)
+  // get_input_logic
+  //
+  // Get the four-valued value of an input. Unconnected inputs float, hence
+  // read Z.
+  //
+  template<bool current>
+  [[nodiscard]] static Logic_Word get_input_logic(Port* const port)
+  {
+    if(port->connections.size() == 1) {
+      Port* const other = *port->connections.begin();
+      Gate const* const gate = other->gate;
+      if(gate->kind == Gate_Kind::e_module) {
+        i64 const output = other->index;
+        return {get_module_output(*gate, output),
+                get_module_output_unknown(*gate, output)};
+      } else if(has_state_outputs(gate->kind)) {
+        i64 const output = other->index;
+        return get_state_output<current>(*gate, output);
+      }
+      if constexpr(current) {
+        return {gate->evaluation.value, gate->evaluation.unknown};
+      } else {
+        return {gate->evaluation.prev_value, gate->evaluation.prev_unknown};
+      }
+    } else {
+      return logic_z;
+    }
+  }
+
+  // get_control_logic
+  //
+  // Get the value of a control input of a sequential gate. Unconnected
+  // control inputs read their inactive level rather than Z, which would make
+  // the whole state unknown.
+  //
+  template<bool four_valued>
+  [[nodiscard]] static Logic_Word get_control_logic(Port* const port,
+                                                    bool const inactive)
+  {
+    if(port->connections.size() == 0) {
+      return {inactive, 0};
+    } else if constexpr(four_valued) {
+      return get_input_logic<false>(port);
+    } else {
+      return {get_input_value<false>(port), 0};
+    }
+  }
+
+  // compute_value
+  //
+  // Compute the output of a primitive gate.
+  //
+  // Parameters:
+  // kind - kind of the gate. Must be a gate with inputs.
+  // in1 - value of the first input.
+  // in2 - value of the second input. Ignored by one input gates.
+  //
+  [[nodiscard]] static bool compute_value(Gate_Kind const kind, bool const in1,
+                                          bool const in2)
+  {
+    switch(kind) {
+    case Gate_Kind::e_and:
+      return in1 && in2;
+    case Gate_Kind::e_or:
+      return in1 || in2;
+    case Gate_Kind::e_xor:
+      return (in1 && !in2) || (!in1 && in2);
+    case Gate_Kind::e_nand:
+      return !(in1 && in2);
+    case Gate_Kind::e_nor:
+      return !(in1 || in2);
+    case Gate_Kind::e_xnor:
+      return !(in1 && !in2) && !(!in1 && in2);
+    case Gate_Kind::e_not:
+      return !in1;
+    default:
+      ANTON_UNREACHABLE("gate has no inputs");
+    }
+    return false;
+  }
+
+  [[nodiscard]] static bool get_state_value(Array<u8> const& state,
+                                            u32 const reference)
+  {
+    if(reference != invalid_signal) {
+      return (state[reference] & 2) != 0;
+    } else {
+      return false;
+    }
+  }
+
+  [[nodiscard]] static Logic_Word get_state_logic(Array<u8> const& state,
+                                                  u32 const reference)
+  {
+    if(reference != invalid_signal) {
+      u8 const value = state[reference];
+      return {static_cast<u64>((value >> 1) & 1),
+              static_cast<u64>((value >> 3) & 1)};
+    } else {
+      return logic_z;
+    }
+  }
+
+  // allocate_state
+  //
+  // Allocate the state of a module instance, a sequential gate or a memory.
+  // The values start unknown in the four-valued mode and 0 otherwise. RAM
+  // instances also copy the contents of their definition unless they already
+  // have contents.
+  //
+  static void allocate_state(Gate& gate, bool const unknown)
+  {
+    Array<u8>& state = gate.state;
+    if(is_memory(gate.kind)) {
+      state.resize(get_memory_state_size(gate.kind, *gate.memory),
+                   unknown ? 12 : 0);
+      if(gate.kind == Gate_Kind::e_ram && gate.contents.size() == 0) {
+        gate.contents = gate.memory->contents;
+      }
+      return;
+    } else if(gate.kind != Gate_Kind::e_module) {
+      state.resize(get_state_size(gate), unknown ? 12 : 0);
+      return;
+    }
+
+    Flat_Module const& flat = get_flat_module(*gate.definition);
+    state.resize(flat.input_count + flat.gates.size(), 0);
+    for(i64 i = 0; i < flat.gates.size(); ++i) {
+      Gate_Kind const kind = flat.gates[i].kind;
+      if(kind == Gate_Kind::e_clock) {
+        // Clocks start high like their scene counterparts.
+        state[flat.input_count + i] = 3;
+      } else if(unknown && kind != Gate_Kind::e_input) {
+        state[flat.input_count + i] = 12;
+      }
+    }
+  }
+
+  // evaluate_module
+  //
+  // Evaluate the flattened definition of a module instance. Bit 0 of the
+  // state is the current value, bit 1 the previous value. Bits 2 and 3 are
+  // the matching unknown flags of the four-valued mode. Gates within the
+  // module read the previous values, which matches the evaluation of the same
+  // gates placed directly in the scene.
+  //
+  template<bool four_valued>
+  static void evaluate_module(Gate& gate)
+  {
+    Flat_Module const& flat = get_flat_module(*gate.definition);
+    Array<u8>& state = gate.state;
+    if(state.size() == 0) {
+      allocate_state(gate, four_valued);
+    }
+
+    // The inputs hold the previous values of their drivers, hence both bits
+    // are set.
+    for(i64 i = 0; i < flat.input_count; ++i) {
+      if constexpr(four_valued) {
+        Logic_Word const input = get_input_logic<false>(gate.in_ports[i]);
+        state[i] = static_cast<u8>((input.value & 1) * 3 |
+                                   (input.unknown & 1) * 12);
+      } else {
+        state[i] = get_input_value<false>(gate.in_ports[i]) ? 3 : 0;
+      }
+    }
+
+    for(i64 i = 0; i < flat.gates.size(); ++i) {
+      Flat_Gate const& flat_gate = flat.gates[i];
+      u8& value = state[flat.input_count + i];
+      if(flat_gate.kind == Gate_Kind::e_clock) {
+        value ^= 3;
+      } else if(flat_gate.kind != Gate_Kind::e_input) {
+        if constexpr(four_valued) {
+          Logic_Word const in1 = get_state_logic(state, flat_gate.inputs[0]);
+          Logic_Word const in2 = get_state_logic(state, flat_gate.inputs[1]);
+          Logic_Word const result = compute_logic(flat_gate.kind, in1, in2);
+          value = (value & 10) | static_cast<u8>(result.value & 1) |
+                  static_cast<u8>((result.unknown & 1) << 2);
+        } else {
+          bool const in1 = get_state_value(state, flat_gate.inputs[0]);
+          bool const in2 = get_state_value(state, flat_gate.inputs[1]);
+          bool const result = compute_value(flat_gate.kind, in1, in2);
+          value = (value & 2) | static_cast<u8>(result);
+        }
+      }
+    }
+
+    // Instances are drawn with the value of their first output.
+    if(flat.outputs.size() > 0 && flat.outputs[0] != invalid_signal) {
+      u8 const output = state[flat.outputs[0]];
+      gate.evaluation.value = (output & 1) != 0;
+      if constexpr(four_valued) {
+        gate.evaluation.unknown = (output & 4) != 0;
+      }
+    }
+  }
+
+  // sync_toggle_counters
+  //
+  // Reassign the slots of the counters to the positions of the gates after
+  // the list of gates has changed. Counters of deleted gates are dropped,
+  // added gates start with no transitions.
+  //
+  static void sync_toggle_counters(Toggle_Counters& toggles,
+                                   List<Gate>& gates)
+  {
+    Flat_Hash_Map<u64, i64> slots;
+    for(i64 slot = 0; slot < toggles.gates.size(); ++slot) {
+      slots.emplace(toggles.gates[slot], slot);
+    }
+
+    Toggle_Counters synced;
+    synced.cycles = toggles.cycles;
+    for(Gate const& gate: gates) {
+      auto iter = slots.find(gate.id);
+      synced.gates.push_back(gate.id);
+      if(iter != slots.end()) {
+        synced.values.push_back(toggles.values[iter->value]);
+        synced.rises.push_back(toggles.rises[iter->value]);
+        synced.falls.push_back(toggles.falls[iter->value]);
+        synced.internal.push_back(toggles.internal[iter->value]);
+      } else {
+        synced.values.push_back(gate.evaluation.value);
+        synced.rises.push_back(0);
+        synced.falls.push_back(0);
+        synced.internal.push_back(0);
+      }
+    }
+    toggles = ANTON_MOV(synced);
+  }
+
+  // read_input
+  //
+  // Get the previous value of the driver of an input as a Logic_Word in
+  // either mode.
+  //
+  template<bool four_valued>
+  [[nodiscard]] static Logic_Word read_input(Port* const port)
   {
+    if constexpr(four_valued) {
+      return get_input_logic<false>(port);
+    } else {
+      return {get_input_value<false>(port), 0};
+    }
+  }
+
+  // get_clock_edge
+  //
+  // Detect a rising edge of CLK since the last evaluation of a flip-flop or a
+  // register. The level of CLK is kept in the last byte of the state.
+  //
+  template<bool four_valued>
+  [[nodiscard]] static Logic_Word get_clock_edge(Gate& gate, Port* const port)
+  {
+    u8& level = gate.state[gate.state.size() - 1];
+    Logic_Word const last{static_cast<u64>(level & 1),
+                          static_cast<u64>((level >> 2) & 1)};
+    Logic_Word clock = read_input<four_valued>(port);
+    if constexpr(four_valued) {
+      // A floating clock is unknown rather than high.
+      clock.value &= ~clock.unknown;
+      level = static_cast<u8>((level & 10) | (clock.value & 1) |
+                              ((clock.unknown & 1) << 2));
+      return logic_and(clock, logic_not(last));
+    } else {
+      level = static_cast<u8>((level & 2) | clock.value);
+      return {clock.value & ~last.value, 0};
+    }
+  }
+
+  // get_next_bit
+  //
+  // Compute the bit stored by a flip-flop. On an edge the bit becomes 0 if
+  // reset is high, d if enable is high, and remains q otherwise.
+  //
+  template<bool four_valued>
+  [[nodiscard]] static Logic_Word
+  get_next_bit(Logic_Word const q, Logic_Word const d, Logic_Word const enable,
+               Logic_Word const reset, Logic_Word const edge)
+  {
+    if constexpr(four_valued) {
+      Logic_Word const loaded =
+        logic_or(logic_and(enable, d), logic_and(logic_not(enable), q));
+      Logic_Word const next = logic_and(logic_not(reset), loaded);
+      return logic_or(logic_and(edge, next), logic_and(logic_not(edge), q));
+    } else {
+      if(!edge.value) {
+        return q;
+      } else if(reset.value) {
+        return logic_zero;
+      } else {
+        return enable.value ? d : q;
+      }
+    }
+  }
+
+  template<bool four_valued>
+  static void set_evaluation(Gate& gate, Logic_Word const value)
+  {
+    gate.evaluation.value = value.value & 1;
+    if constexpr(four_valued) {
+      gate.evaluation.unknown = value.unknown & 1;
+    }
+  }
+
+  // evaluate_sequential
+  //
+  // Evaluate a flip-flop, a latch or a register. Sequential gates read the
+  // previous values of their inputs in both orders of evaluation, hence they
+  // capture the values settled by the previous cycle.
+  //
+  template<bool four_valued>
+  static void evaluate_sequential(Gate& gate)
+  {
+    if(gate.state.size() == 0) {
+      allocate_state(gate, four_valued);
+    }
+
+    Logic_Word const q{gate.evaluation.prev_value,
+                       gate.evaluation.prev_unknown};
+    switch(gate.kind) {
+    case Gate_Kind::e_sr_latch: {
+      Logic_Word const set =
+        get_control_logic<four_valued>(gate.in_ports[0], false);
+      Logic_Word const reset =
+        get_control_logic<four_valued>(gate.in_ports[1], false);
+      set_evaluation<four_valued>(
+        gate, logic_and(logic_not(reset), logic_or(set, q)));
+    } break;
+
+    case Gate_Kind::e_dff: {
+      Logic_Word const edge =
+        get_clock_edge<four_valued>(gate, gate.in_ports[1]);
+      Logic_Word const enable =
+        get_control_logic<four_valued>(gate.in_ports[2], true);
+      Logic_Word const reset =
+        get_control_logic<four_valued>(gate.in_ports[3], false);
+      Logic_Word const d = read_input<four_valued>(gate.in_ports[0]);
+      set_evaluation<four_valued>(
+        gate, get_next_bit<four_valued>(q, d, enable, reset, edge));
+    } break;
+
+    case Gate_Kind::e_register: {
+      i64 const width = gate.width;
+      Logic_Word const edge =
+        get_clock_edge<four_valued>(gate, gate.in_ports[width]);
+      Logic_Word const enable =
+        get_control_logic<four_valued>(gate.in_ports[width + 1], true);
+      Logic_Word const reset =
+        get_control_logic<four_valued>(gate.in_ports[width + 2], false);
+      for(i64 i = 0; i < width; ++i) {
+        u8& bit = gate.state[i];
+        Logic_Word const previous = get_state_output<false>(gate, i);
+        Logic_Word const d = read_input<four_valued>(gate.in_ports[i]);
+        Logic_Word const next =
+          get_next_bit<four_valued>(previous, d, enable, reset, edge);
+        bit = static_cast<u8>((bit & 10) | (next.value & 1) |
+                              ((next.unknown & 1) << 2));
+      }
+      // Registers are drawn with the value of their first bit.
+      set_evaluation<four_valued>(gate,
+                                  get_state_output<true>(gate, 0));
+    } break;
+
+    default:
+      ANTON_UNREACHABLE("gate is not sequential");
+    }
+  }
+
+  // evaluate_memory
+  //
+  // Evaluate a RAM or a ROM block. Memories read the previous values of their
+  // inputs like sequential gates. A write takes place before the read, hence
+  // the outputs show the written word. The contents are two-valued. In the
+  // four-valued mode an unknown address makes the outputs unknown and drops
+  // a write, and unknown data bits are written as 0.
+  //
+  template<bool four_valued>
+  static void evaluate_memory(Gate& gate)
+  {
+    Memory_Definition const& memory = *gate.memory;
+    if(gate.state.size() == 0) {
+      allocate_state(gate, four_valued);
+    }
+
+    u64 address = 0;
+    bool address_unknown = false;
+    for(i64 i = 0; i < memory.address_width; ++i) {
+      Logic_Word const bit = read_input<four_valued>(gate.in_ports[i]);
+      address |= (bit.value & 1) << i;
+      address_unknown = address_unknown || (bit.unknown & 1);
+    }
+
+    u8 const* contents = memory.contents.data();
+    if(gate.kind == Gate_Kind::e_ram) {
+      i64 const first_data = memory.address_width;
+      i64 const write_enable = first_data + memory.data_width;
+      Logic_Word const edge =
+        get_clock_edge<four_valued>(gate, gate.in_ports[write_enable + 1]);
+      Logic_Word const enable =
+        get_control_logic<four_valued>(gate.in_ports[write_enable], false);
+      Logic_Word const write = logic_and(edge, enable);
+      if((write.value & ~write.unknown & 1) && !address_unknown) {
+        u64 word = 0;
+        for(i64 i = 0; i < memory.data_width; ++i) {
+          Logic_Word const bit =
+            read_input<four_valued>(gate.in_ports[first_data + i]);
+          word |= (bit.value & ~bit.unknown & 1) << i;
+        }
+        write_word(memory, gate.contents.data(), address, word);
+      }
+      contents = gate.contents.data();
+    }
+
+    u64 const word = address_unknown ? 0 : read_word(memory, contents, address);
+    u8 const unknown = address_unknown ? 4 : 0;
+    for(i64 i = 0; i < memory.data_width; ++i) {
+      u8& output = gate.state[i];
+      output = static_cast<u8>((output & 10) | ((word >> i) & 1) | unknown);
+    }
+    // Memories are drawn with the value of their first output.
+    set_evaluation<four_valued>(gate, get_state_output<true>(gate, 0));
+  }
+
+  // evaluate_lut
+  //
+  // Look up the output of a LUT. Unconnected inputs read 0 in both modes.
+  // In the four-valued mode the output is known only if every combination
+  // of the unknown inputs selects the same bit of the table.
+  //
+  template<bool four_valued, bool current>
+  static void evaluate_lut(Gate& gate)
+  {
+    ANTON_ASSERT(gate.in_ports.size() == lut_input_count,
+                 "LUT ports not equal lut_input_count");
+    u32 index = 0;
+    u32 unknown = 0;
+    for(i64 i = 0; i < lut_input_count; ++i) {
+      Port* const port = gate.in_ports[i];
+      if(port->connections.size() != 1) {
+        continue;
+      }
+
+      if constexpr(four_valued) {
+        Logic_Word const input = get_input_logic<current>(port);
+        index |= static_cast<u32>(input.value & ~input.unknown & 1) << i;
+        unknown |= static_cast<u32>(input.unknown & 1) << i;
+      } else {
+        index |= static_cast<u32>(get_input_value<current>(port)) << i;
+      }
+    }
+
+    u64 const value = (gate.table >> index) & 1;
+    if constexpr(four_valued) {
+      bool differs = false;
+      for(u32 subset = unknown; subset != 0 && !differs;
+          subset = (subset - 1) & unknown) {
+        differs = ((gate.table >> (index | subset)) & 1) != value;
+      }
+      set_evaluation<true>(gate, differs ? logic_x : Logic_Word{value, 0});
+    } else {
+      gate.evaluation.value = value;
+    }
+  }
+
+  // is_boundary
+  //
+  // Whether gates of a kind read only the previous values of their inputs,
+  // which makes them the sources of the levelized order. Module instances
+  // keep the unit delay of their gates.
+  //
+  [[nodiscard]] static bool is_boundary(Gate_Kind const kind)
+  {
+    return kind == Gate_Kind::e_input || kind == Gate_Kind::e_clock ||
+           kind == Gate_Kind::e_module || is_sequential(kind) ||
+           is_memory(kind);
+  }
+
+  // build_schedule
+  //
+  // Order the combinational gates after the boundary gates by their strongly
+  // connected components, which come in topological order. A component of
+  // several gates or of a gate reading itself is a combinational loop.
+  //
+  static void build_schedule(Evaluation_Schedule& schedule, List<Gate>& gates)
+  {
+    schedule.gates.clear();
+    schedule.order.clear();
+    schedule.slots.clear();
+    schedule.loops.clear();
+    schedule.revision = get_connection_revision();
+    schedule.loop_count = 0;
+    schedule.unsettled_count = 0;
+    schedule.fused = false;
+    schedule.nodes.clear();
+    schedule.leaves.clear();
+    schedule.members.clear();
+    schedule.tables.clear();
+    schedule.member_slots.clear();
+
+    // Maps the address of a gate to its position in the list.
+    Flat_Hash_Map<u64, u32> positions;
+    Array<Gate*> list{anton::reserve, gates.size()};
     for(Gate& gate: gates) {
-      gate.evaluation.prev_value = gate.evaluation.value;
+      positions.emplace(reinterpret_cast<u64>(&gate), list.size());
+      schedule.gates.push_back(gate.id);
+      list.push_back(&gate);
     }
 
+    // Edges between the combinational gates. Boundary gates have none and
+    // form a component each.
+    Array<u32> edge_offsets{anton::reserve, list.size() + 1};
+    Array<u32> edges;
+    for(i64 i = 0; i < list.size(); ++i) {
+      Gate const& gate = *list[i];
+      edge_offsets.push_back(edges.size());
+      if(is_boundary(gate.kind)) {
+        schedule.order.push_back(list[i]);
+        schedule.slots.push_back(i);
+        continue;
+      }
+
+      for(Port const* const out: gate.out_ports) {
+        for(Port const* const in: out->connections) {
+          auto iter = positions.find(reinterpret_cast<u64>(in->gate));
+          if(iter != positions.end() && !is_boundary(in->gate->kind)) {
+            edges.push_back(iter->value);
+          }
+        }
+      }
+    }
+    edge_offsets.push_back(edges.size());
+    schedule.boundary_count = schedule.order.size();
+
+    Strong_Components components;
+    find_strong_components(
+      Slice<u32 const>(edge_offsets.data(), edge_offsets.size()),
+      Slice<u32 const>(edges.data(), edges.size()), components);
+    for(i64 i = 0; i + 1 < components.offsets.size(); ++i) {
+      u32 const first = components.offsets[i];
+      u32 const end = components.offsets[i + 1];
+      u32 const vertex = components.vertices[first];
+      if(is_boundary(list[vertex]->kind)) {
+        continue;
+      }
+
+      bool looped = end - first > 1;
+      for(u32 j = edge_offsets[vertex]; j < edge_offsets[vertex + 1]; ++j) {
+        looped = looped || edges[j] == vertex;
+      }
+      if(looped) {
+        schedule.loops.push_back(
+          Schedule_Loop{static_cast<u32>(schedule.order.size()), end - first});
+        schedule.loop_count += end - first;
+      }
+      for(u32 j = first; j < end; ++j) {
+        u32 const index = components.vertices[j];
+        schedule.order.push_back(list[index]);
+        schedule.slots.push_back(index);
+      }
+    }
+
+    // The nodes are evaluated once, which does not settle loops.
+    if(schedule.fuse && schedule.loops.size() == 0) {
+      fuse_schedule(schedule);
+    }
+  }
+
+  // evaluate_gate
+  //
+  // Evaluate a single gate. Combinational gates read the current values of
+  // their drivers if current is set and the previous values otherwise.
+  //
+  template<bool four_valued, bool current>
+  static void evaluate_gate(Gate& gate)
+  {
+    switch(gate.kind) {
+    case Gate_Kind::e_and:
+    case Gate_Kind::e_or:
+    case Gate_Kind::e_xor:
+    case Gate_Kind::e_nand:
+    case Gate_Kind::e_nor:
+    case Gate_Kind::e_xnor: {
+      ANTON_ASSERT(gate.in_ports.size() == 2, "gate ports not equal 2");
+      if constexpr(four_valued) {
+        Logic_Word const in1 = get_input_logic<current>(gate.in_ports[0]);
+        Logic_Word const in2 = get_input_logic<current>(gate.in_ports[1]);
+        set_evaluation<true>(gate, compute_logic(gate.kind, in1, in2));
+      } else {
+        bool const in1 = get_input_value<current>(gate.in_ports[0]);
+        bool const in2 = get_input_value<current>(gate.in_ports[1]);
+        gate.evaluation.value = compute_value(gate.kind, in1, in2);
+      }
+    } break;
+
+    case Gate_Kind::e_not: {
+      ANTON_ASSERT(gate.in_ports.size() == 1, "NOT gate ports not equal 1");
+      if constexpr(four_valued) {
+        Logic_Word const in1 = get_input_logic<current>(gate.in_ports[0]);
+        set_evaluation<true>(gate, logic_not(in1));
+      } else {
+        bool const in1 = get_input_value<current>(gate.in_ports[0]);
+        gate.evaluation.value = compute_value(gate.kind, in1, false);
+      }
+    } break;
+
+    case Gate_Kind::e_lut: {
+      evaluate_lut<four_valued, current>(gate);
+    } break;
+
+    case Gate_Kind::e_input: {
+      // Nothing to do.
+    } break;
+
+    case Gate_Kind::e_clock: {
+      gate.evaluation.value = !gate.evaluation.value;
+      gate.evaluation.prev_value = !gate.evaluation.prev_value;
+    } break;
+
+    case Gate_Kind::e_module: {
+      evaluate_module<four_valued>(gate);
+    } break;
+
+    case Gate_Kind::e_dff:
+    case Gate_Kind::e_sr_latch:
+    case Gate_Kind::e_register: {
+      evaluate_sequential<four_valued>(gate);
+    } break;
+
+    case Gate_Kind::e_ram:
+    case Gate_Kind::e_rom: {
+      evaluate_memory<four_valued>(gate);
+    } break;
+
+    case Gate_Kind::e_count:
+      ANTON_UNREACHABLE("count is invalid");
+    }
+  }
+
+  // finish_gate
+  //
+  // Report the change of a gate and count its toggles.
+  //
+  template<bool record_changes, bool count_toggles>
+  static void finish_gate(Gate& gate, bool const previous,
+                          bool const previous_unknown,
+                          Array<Gate*>* const changed,
+                          Toggle_Counters* const toggles, i64 const slot)
+  {
+    if constexpr(record_changes) {
+      if(gate.evaluation.value != previous ||
+         gate.evaluation.unknown != previous_unknown ||
+         gate.kind == Gate_Kind::e_module || has_state_outputs(gate.kind)) {
+        changed->push_back(&gate);
+      }
+    }
+
+    if constexpr(count_toggles) {
+      // Compared with the last counted value rather than previous to count
+      // the values assigned to inputs between cycles.
+      u8 const value = gate.evaluation.value;
+      u8& last = toggles->values[slot];
+      toggles->rises[slot] += value & ~last;
+      toggles->falls[slot] += last & ~value;
+      last = value;
+      if(gate.state.size() > 0) {
+        // Bit 1 of the state of a signal is its value before the cycle.
+        // Clocks within modules flip both bits, hence they are not counted.
+        u64 count = 0;
+        for(u8 const byte: gate.state) {
+          count += (byte ^ (byte >> 1)) & 1;
+        }
+        toggles->internal[slot] += count;
+      }
+    }
+  }
+
+  // settle_loop
+  //
+  // Evaluate the gates of a combinational loop until none of them changes,
+  // at most loop_pass_limit times. The gates of a loop that has not settled
+  // become unknown in the four-valued mode.
+  //
+  template<bool four_valued>
+  static void settle_loop(Evaluation_Schedule& schedule,
+                          Schedule_Loop const loop)
+  {
+    u32 const end = loop.first + loop.count;
+    for(i64 pass = 0; pass < loop_pass_limit; ++pass) {
+      bool changed = false;
+      for(u32 i = loop.first; i < end; ++i) {
+        Gate& gate = *schedule.order[i];
+        bool const previous = gate.evaluation.value;
+        bool const previous_unknown = gate.evaluation.unknown;
+        evaluate_gate<four_valued, true>(gate);
+        changed = changed || gate.evaluation.value != previous ||
+                  gate.evaluation.unknown != previous_unknown;
+      }
+      if(!changed) {
+        return;
+      }
+    }
+
+    schedule.unsettled_count += 1;
+    if constexpr(four_valued) {
+      for(u32 i = loop.first; i < end; ++i) {
+        set_evaluation<true>(*schedule.order[i], logic_x);
+      }
+    }
+  }
+
+  // evaluate_nodes
+  //
+  // Evaluate the fused cones of a schedule. The leaves of a node are
+  // gathered once, then every member of the node reads its value from its
+  // truth table. Two-valued only.
+  //
+  template<bool record_changes, bool count_toggles>
+  static void evaluate_nodes(Evaluation_Schedule& schedule,
+                             Array<Gate*>* const changed,
+                             Toggle_Counters* const toggles)
+  {
+    for(Lut_Node const& node: schedule.nodes) {
+      u32 index = 0;
+      for(u32 i = 0; i < node.leaf_count; ++i) {
+        Port* const leaf = schedule.leaves[node.first_leaf + i];
+        index |= static_cast<u32>(get_input_value<true>(leaf)) << i;
+      }
+
+      u32 const end = node.first_member + node.member_count;
+      for(u32 i = node.first_member; i < end; ++i) {
+        Gate& gate = *schedule.members[i];
+        bool const previous = gate.evaluation.value;
+        gate.evaluation.value = (schedule.tables[i] >> index) & 1;
+        finish_gate<record_changes, count_toggles>(
+          gate, previous, false, changed, toggles, schedule.member_slots[i]);
+      }
+    }
+  }
+
+  // begin_cycle
+  //
+  // Make the current values of a gate its previous values.
+  //
+  template<bool four_valued>
+  static void begin_cycle(Gate& gate)
+  {
+    gate.evaluation.prev_value = gate.evaluation.value;
+    if constexpr(four_valued) {
+      gate.evaluation.prev_unknown = gate.evaluation.unknown;
+      for(u8& value: gate.state) {
+        value = (value & 5) | ((value & 5) << 1);
+      }
+    } else {
+      for(u8& value: gate.state) {
+        value = (value & 1) | ((value & 1) << 1);
+      }
+    }
+  }
+
+  template<bool four_valued, bool levelized, bool record_changes,
+           bool count_toggles>
+  static void evaluate_gates(List<Gate>& gates, Array<Gate*>* const changed,
+                             Toggle_Counters* const toggles,
+                             Evaluation_Schedule* const schedule)
+  {
+    // The slots and the schedule are validated while preparing the gates
+    // rather than in a separate pass.
+    bool synced = !count_toggles || toggles->gates.size() == gates.size();
+    bool scheduled =
+      !levelized ||
+      (schedule->gates.size() == gates.size() &&
+       schedule->revision == get_connection_revision() &&
+       schedule->fused == (schedule->fuse && schedule->loops.size() == 0));
+    i64 slot = 0;
     for(Gate& gate: gates) {
-      switch(gate.kind) {
-      case Gate_Kind::e_and: {
-        ANTON_ASSERT(gate.in_ports.size() == 2, "AND gate ports not equal 2");
-        bool const in1 = get_input_value(gate.in_ports[0]);
-        bool const in2 = get_input_value(gate.in_ports[1]);
-        gate.evaluation.value = in1 && in2;
-      } break;
-
-      case Gate_Kind::e_or: {
-        ANTON_ASSERT(gate.in_ports.size() == 2, "OR gate ports not equal 2");
-        bool const in1 = get_input_value(gate.in_ports[0]);
-        bool const in2 = get_input_value(gate.in_ports[1]);
-        gate.evaluation.value = in1 || in2;
-      } break;
-
-      case Gate_Kind::e_xor: {
-        ANTON_ASSERT(gate.in_ports.size() == 2, "XOR gate ports not equal 2");
-        bool const in1 = get_input_value(gate.in_ports[0]);
-        bool const in2 = get_input_value(gate.in_ports[1]);
-        gate.evaluation.value = (in1 && !in2) || (!in1 && in2);
-      } break;
-
-      case Gate_Kind::e_nand: {
-        ANTON_ASSERT(gate.in_ports.size() == 2, "NAND gate ports not equal 2");
-        bool const in1 = get_input_value(gate.in_ports[0]);
-        bool const in2 = get_input_value(gate.in_ports[1]);
-        gate.evaluation.value = !(in1 && in2);
-      } break;
-
-      case Gate_Kind::e_nor: {
-        ANTON_ASSERT(gate.in_ports.size() == 2, "NOR gate ports not equal 2");
-        bool const in1 = get_input_value(gate.in_ports[0]);
-        bool const in2 = get_input_value(gate.in_ports[1]);
-        gate.evaluation.value = !(in1 || in2);
-      } break;
-
-      case Gate_Kind::e_xnor: {
-        ANTON_ASSERT(gate.in_ports.size() == 2, "XNOR gate ports not equal 2");
-        bool const in1 = get_input_value(gate.in_ports[0]);
-        bool const in2 = get_input_value(gate.in_ports[1]);
-        gate.evaluation.value = !(in1 && !in2) && !(!in1 && in2);
-      } break;
-
-      case Gate_Kind::e_not: {
-        ANTON_ASSERT(gate.in_ports.size() == 1, "NOT gate ports not equal 1");
-        bool const in1 = get_input_value(gate.in_ports[0]);
-        gate.evaluation.value = !in1;
-      } break;
-
-      case Gate_Kind::e_input: {
-        // Nothing to do.
-      } break;
-
-      case Gate_Kind::e_clock: {
-        gate.evaluation.value = !gate.evaluation.value;
-        gate.evaluation.prev_value = !gate.evaluation.prev_value;
-      } break;
-
-      case Gate_Kind::e_count:
-        ANTON_UNREACHABLE("count is invalid");
+      if constexpr(record_changes) {
+        // The previous values of inputs are their values in the previous
+        // cycle until the cycle begins.
+        if(gate.kind == Gate_Kind::e_input &&
+           (gate.evaluation.value != gate.evaluation.prev_value ||
+            gate.evaluation.unknown != gate.evaluation.prev_unknown)) {
+          changed->push_back(&gate);
+        }
+      }
+      begin_cycle<four_valued>(gate);
+      if constexpr(count_toggles) {
+        synced = synced && toggles->gates[slot] == gate.id;
+      }
+      if constexpr(levelized) {
+        scheduled = scheduled && schedule->gates[slot] == gate.id;
       }
+      if constexpr(count_toggles || levelized) {
+        slot += 1;
+      }
+    }
+
+    if constexpr(count_toggles) {
+      if(!synced) {
+        sync_toggle_counters(*toggles, gates);
+      }
+      toggles->cycles += 1;
+    }
+
+    if constexpr(levelized) {
+      if(!scheduled) {
+        build_schedule(*schedule, gates);
+      }
+
+      // Boundary gates capture the values settled by the previous cycle,
+      // then the combinational gates settle in a single pass. Fused
+      // schedules evaluate the combinational gates through their nodes.
+      bool const fused = !four_valued && schedule->fused;
+      i64 const count =
+        fused ? schedule->boundary_count : schedule->order.size();
+      i64 loop = 0;
+      for(i64 i = 0; i < count; ++i) {
+        Gate& gate = *schedule->order[i];
+        // Gates of a loop are evaluated when the loop is reached, hence they
+        // report their changes since the start of the cycle.
+        if(loop < schedule->loops.size() &&
+           schedule->loops[loop].first + schedule->loops[loop].count <= i) {
+          loop += 1;
+        }
+        if(loop < schedule->loops.size() && schedule->loops[loop].first == i) {
+          settle_loop<four_valued>(*schedule, schedule->loops[loop]);
+        }
+        bool const looped =
+          loop < schedule->loops.size() && schedule->loops[loop].first <= i;
+        bool const previous =
+          looped ? gate.evaluation.prev_value : gate.evaluation.value;
+        bool const previous_unknown = looped && four_valued
+                                        ? gate.evaluation.prev_unknown
+                                        : gate.evaluation.unknown;
+        if(i < schedule->boundary_count) {
+          evaluate_gate<four_valued, false>(gate);
+        } else if(!looped) {
+          evaluate_gate<four_valued, true>(gate);
+        }
+        finish_gate<record_changes, count_toggles>(
+          gate, previous, previous_unknown, changed, toggles,
+          schedule->slots[i]);
+      }
+
+      if constexpr(!four_valued) {
+        if(fused) {
+          evaluate_nodes<record_changes, count_toggles>(*schedule, changed,
+                                                        toggles);
+        }
+      }
+    } else {
+      slot = 0;
+      for(Gate& gate: gates) {
+        bool const previous = gate.evaluation.value;
+        bool const previous_unknown = gate.evaluation.unknown;
+        evaluate_gate<four_valued, false>(gate);
+        finish_gate<record_changes, count_toggles>(
+          gate, previous, previous_unknown, changed, toggles, slot);
+        slot += 1;
+      }
+    }
+  }
+
+  template<bool four_valued, bool levelized>
+  static void dispatch_evaluate(List<Gate>& gates, Array<Gate*>* const changed,
+                                Toggle_Counters* const toggles,
+                                Evaluation_Schedule* const schedule)
+  {
+    if(toggles != nullptr) {
+      if(changed != nullptr) {
+        evaluate_gates<four_valued, levelized, true, true>(gates, changed,
+                                                           toggles, schedule);
+      } else {
+        evaluate_gates<four_valued, levelized, false, true>(gates, changed,
+                                                            toggles, schedule);
+      }
+    } else if(changed != nullptr) {
+      evaluate_gates<four_valued, levelized, true, false>(gates, changed,
+                                                          toggles, schedule);
+    } else {
+      evaluate_gates<four_valued, levelized, false, false>(gates, changed,
+                                                           toggles, schedule);
+    }
+  }
+
+  void evaluate(List<Gate>& gates, Array<Gate*>* const changed,
+                Toggle_Counters* const toggles, Logic_Mode const mode,
+                Evaluation_Schedule* const schedule)
+  {
+    bool const four_valued = mode == Logic_Mode::e_four_valued;
+    if(schedule != nullptr) {
+      if(four_valued) {
+        dispatch_evaluate<true, true>(gates, changed, toggles, schedule);
+      } else {
+        dispatch_evaluate<false, true>(gates, changed, toggles, schedule);
+      }
+    } else if(four_valued) {
+      dispatch_evaluate<true, false>(gates, changed, toggles, schedule);
+    } else {
+      dispatch_evaluate<false, false>(gates, changed, toggles, schedule);
+    }
+  }
+
+  // has_changed
+  //
+  // Whether any output of a gate has changed during its evaluation.
+  //
+  [[nodiscard]] static bool has_changed(Gate const& gate, bool const previous,
+                                        bool const previous_unknown)
+  {
+    if(gate.evaluation.value != previous ||
+       gate.evaluation.unknown != previous_unknown) {
+      return true;
+    }
+
+    if(has_state_outputs(gate.kind)) {
+      // Bit 1 of the state holds the output before the evaluation.
+      for(i64 i = 0; i < gate.out_ports.size(); ++i) {
+        u8 const output = gate.state[i];
+        if(((output ^ (output >> 1)) & 5) != 0) {
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  // evaluate_positions
+  //
+  // Evaluate the gates at the sorted positions of the order of a schedule.
+  // The gates are settled afterwards, that is their current values become
+  // their previous values, since gates evaluated at later edges read the
+  // previous values of their drivers. The boundary gates reading the gates
+  // that have changed are appended to the seeds of the next delta
+  // evaluation.
+  //
+  template<bool four_valued, bool record_changes, bool count_toggles>
+  static void evaluate_positions(Evaluation_Schedule& schedule,
+                                 Clock_Schedule& clocks,
+                                 Slice<u32 const> const positions,
+                                 Array<Gate*>* const changed,
+                                 Toggle_Counters* const toggles)
+  {
+    // Inputs may have been assigned since they were settled.
+    for(u32 const position: positions) {
+      begin_cycle<four_valued>(*schedule.order[position]);
+    }
+
+    // Every gate of a loop is in the fanout of the others, hence the
+    // positions hold either all or none of its gates.
+    i64 loop = 0;
+    for(u32 const position: positions) {
+      Gate& gate = *schedule.order[position];
+      while(loop < schedule.loops.size() &&
+            schedule.loops[loop].first + schedule.loops[loop].count <=
+              position) {
+        loop += 1;
+      }
+      if(loop < schedule.loops.size() &&
+         schedule.loops[loop].first == position) {
+        settle_loop<four_valued>(schedule, schedule.loops[loop]);
+      }
+      bool const looped = loop < schedule.loops.size() &&
+                          schedule.loops[loop].first <= position;
+      bool const previous =
+        looped ? gate.evaluation.prev_value : gate.evaluation.value;
+      bool const previous_unknown = looped && four_valued
+                                      ? gate.evaluation.prev_unknown
+                                      : gate.evaluation.unknown;
+      if(position < schedule.boundary_count) {
+        evaluate_gate<four_valued, false>(gate);
+      } else if(!looped) {
+        evaluate_gate<four_valued, true>(gate);
+      }
+      finish_gate<record_changes, count_toggles>(
+        gate, previous, previous_unknown, changed, toggles,
+        schedule.slots[position]);
+
+      u32 const first = clocks.reader_offsets[position];
+      u32 const end = clocks.reader_offsets[position + 1];
+      if(first == end || !has_changed(gate, previous, previous_unknown)) {
+        continue;
+      }
+
+      for(u32 i = first; i < end; ++i) {
+        u32 const reader = clocks.readers[i];
+        if(clocks.stamps[reader] != clocks.stamp) {
+          clocks.stamps[reader] = clocks.stamp;
+          clocks.seeds.push_back(reader);
+        }
+      }
+    }
+
+    for(u32 const position: positions) {
+      begin_cycle<four_valued>(*schedule.order[position]);
+    }
+  }
+
+  template<bool four_valued>
+  static void dispatch_positions(Evaluation_Schedule& schedule,
+                                 Clock_Schedule& clocks,
+                                 Slice<u32 const> const positions,
+                                 Array<Gate*>* const changed,
+                                 Toggle_Counters* const toggles)
+  {
+    if(toggles != nullptr) {
+      if(changed != nullptr) {
+        evaluate_positions<four_valued, true, true>(schedule, clocks,
+                                                    positions, changed,
+                                                    toggles);
+      } else {
+        evaluate_positions<four_valued, false, true>(schedule, clocks,
+                                                     positions, changed,
+                                                     toggles);
+      }
+    } else if(changed != nullptr) {
+      evaluate_positions<four_valued, true, false>(schedule, clocks,
+                                                   positions, changed,
+                                                   toggles);
+    } else {
+      evaluate_positions<four_valued, false, false>(schedule, clocks,
+                                                    positions, changed,
+                                                    toggles);
+    }
+  }
+
+  // collect_delta
+  //
+  // Collect the seeds and their fanout into step, sorted. The seeds and the
+  // gates already collected carry the current stamp.
+  //
+  static void collect_delta(Clock_Schedule& clocks)
+  {
+    Array<u32>& step = clocks.step;
+    step.clear();
+    for(u32 const seed: clocks.seeds) {
+      step.push_back(seed);
+    }
+
+    for(i64 head = 0; head < step.size(); ++head) {
+      u32 const position = step[head];
+      u32 const end = clocks.fanout_offsets[position + 1];
+      for(u32 i = clocks.fanout_offsets[position]; i < end; ++i) {
+        u32 const reader = clocks.fanouts[i];
+        if(clocks.stamps[reader] != clocks.stamp) {
+          clocks.stamps[reader] = clocks.stamp;
+          step.push_back(reader);
+        }
+      }
+    }
+    anton::quick_sort(step.begin(), step.end(),
+                      [](u32 const a, u32 const b) { return a < b; });
+  }
+
+  // merge_positions
+  //
+  // Merge two sorted ranges of positions into merged. Positions in both
+  // ranges are merged once.
+  //
+  static void merge_positions(Slice<u32 const> const first,
+                              Slice<u32 const> const second,
+                              Array<u32>& merged)
+  {
+    merged.clear();
+    i64 i = 0;
+    i64 j = 0;
+    while(i < first.size() && j < second.size()) {
+      if(first[i] < second[j]) {
+        merged.push_back(first[i]);
+        i += 1;
+      } else if(second[j] < first[i]) {
+        merged.push_back(second[j]);
+        j += 1;
+      } else {
+        merged.push_back(first[i]);
+        i += 1;
+        j += 1;
+      }
+    }
+    for(; i < first.size(); ++i) {
+      merged.push_back(first[i]);
+    }
+    for(; j < second.size(); ++j) {
+      merged.push_back(second[j]);
+    }
+  }
+
+  [[nodiscard]] static Slice<u32 const> get_domain(Clock_Schedule const& clocks,
+                                                   u32 const clock)
+  {
+    u32 const first = clocks.offsets[clock];
+    return Slice<u32 const>(clocks.positions.data() + first,
+                            clocks.offsets[clock + 1] - first);
+  }
+
+  // update_inputs
+  //
+  // Report the inputs that have changed since the last call.
+  //
+  // Returns:
+  // Whether any input has changed since the last call.
+  //
+  [[nodiscard]] static bool update_inputs(Clock_Schedule& clocks,
+                                          Array<Gate*>* const changed)
+  {
+    bool updated = false;
+    for(i64 i = 0; i < clocks.inputs.size(); ++i) {
+      Gate* const input = clocks.inputs[i];
+      u8 const value = static_cast<u8>(input->evaluation.value |
+                                       (input->evaluation.unknown << 1));
+      if(clocks.input_values[i] == value) {
+        continue;
+      }
+
+      updated = true;
+      clocks.input_values[i] = value;
+      if(changed != nullptr) {
+        changed->push_back(input);
+      }
+    }
+    return updated;
+  }
+
+  i64 evaluate_next_edge(List<Gate>& gates, Clock_Schedule& clocks,
+                         Evaluation_Schedule& schedule,
+                         Array<Gate*>* const changed,
+                         Toggle_Counters* const toggles, Logic_Mode const mode)
+  {
+    // Adding a gate changes the revision as well, hence the gates need not
+    // be compared one by one.
+    bool const stale = clocks.revision != get_connection_revision() ||
+                       clocks.gate_count != gates.size() ||
+                       schedule.revision != clocks.revision ||
+                       schedule.order.size() != clocks.gate_count;
+    if(stale) {
+      build_schedule(schedule, gates);
+      build_clock_domains(clocks, schedule);
+    } else {
+      for(i64 i = 0; i < clocks.clocks.size(); ++i) {
+        Gate const* const clock = clocks.clocks[i];
+        if(clock->clock_period != clocks.periods[i] ||
+           clock->clock_phase != clocks.phases[i]) {
+          schedule_clocks(clocks);
+          break;
+        }
+      }
+    }
+
+    if(toggles != nullptr &&
+       (stale || toggles->gates.size() != gates.size())) {
+      sync_toggle_counters(*toggles, gates);
+    }
+
+    bool const full = update_inputs(clocks, changed) || clocks.full;
+    clocks.full = false;
+    clocks.due.clear();
+    i64 const time = take_events(clocks.wheel, clocks.due);
+    if(time >= 0) {
+      clocks.time = time;
+      for(u32 const clock: clocks.due) {
+        i64 const edge = get_next_toggle(clocks.periods[clock],
+                                         clocks.phases[clock], time + 1);
+        schedule_event(clocks.wheel, edge, clock);
+      }
+    }
+
+    // A single domain is evaluated in place, several are merged.
+    Slice<u32 const> step;
+    bool empty = true;
+    if(full) {
+      step = Slice<u32 const>(clocks.static_positions.data(),
+                              clocks.static_positions.size());
+      empty = false;
+    }
+    for(u32 const clock: clocks.due) {
+      Slice<u32 const> const domain = get_domain(clocks, clock);
+      if(empty) {
+        step = domain;
+        empty = false;
+        continue;
+      }
+
+      Array<u32>& target =
+        step.data() == clocks.step.data() ? clocks.merged : clocks.step;
+      merge_positions(step, domain, target);
+      step = Slice<u32 const>(target.data(), target.size());
     }
+
+    if(step.size() == 0) {
+      return clocks.time;
+    }
+
+    if(toggles != nullptr) {
+      toggles->cycles += 1;
+    }
+
+    // The seeds of every delta evaluation carry a new stamp, hence the gates
+    // of the previous evaluations may be collected again.
+    bool const four_valued = mode == Logic_Mode::e_four_valued;
+    for(i64 delta = 0;; ++delta) {
+      clocks.stamp += 1;
+      clocks.seeds.clear();
+      if(four_valued) {
+        dispatch_positions<true>(schedule, clocks, step, changed, toggles);
+      } else {
+        dispatch_positions<false>(schedule, clocks, step, changed, toggles);
+      }
+      clocks.evaluated += step.size();
+      if(clocks.seeds.size() == 0) {
+        break;
+      } else if(delta == delta_limit) {
+        clocks.unsettled += 1;
+        break;
+      }
+
+      collect_delta(clocks);
+      step = Slice<u32 const>(clocks.step.data(), clocks.step.size());
+      clocks.deltas += 1;
+    }
+    clocks.evaluations += 1;
+    return clocks.time;
+  }
+
+  void restart_clock_schedule(Clock_Schedule& clocks, i64 const time)
+  {
+    clocks.time = time;
+    clocks.full = true;
+    // The clocks are scheduled from the time once the domains are rebuilt.
+    // The gates may have been replaced since they were built.
+    clocks.gate_count = -1;
+  }
+
+  // record_change
+  //
+  // Record a change of the output of a gate at a tick. Checks the width of
+  // the pulse the change ends unless the gate is an input, a clock or has
+  // several outputs.
+  //
+  static void record_change(Timed_Schedule& timing, u32 const position,
+                            i64 const time, Array<Gate*>* const changed,
+                            Toggle_Counters* const toggles)
+  {
+    Gate* const gate = timing.gates[position];
+    i64 const width = time - timing.changes[position];
+    timing.changes[position] = time;
+    if(width < timing.glitch_width && gate->kind != Gate_Kind::e_input &&
+       gate->kind != Gate_Kind::e_clock && gate->kind != Gate_Kind::e_module &&
+       !has_state_outputs(gate->kind)) {
+      timing.glitches.push_back(Glitch{gate, time, width});
+      timing.glitch_count += 1;
+    }
+
+    if(changed != nullptr) {
+      changed->push_back(gate);
+    }
+
+    if(toggles != nullptr) {
+      u8 const value = gate->evaluation.value;
+      u8& last = toggles->values[position];
+      toggles->rises[position] += value & ~last;
+      toggles->falls[position] += last & ~value;
+      last = value;
+    }
+  }
+
+  // mark_readers
+  //
+  // Add the readers of a gate to the gates evaluated at the current tick.
+  //
+  static void mark_readers(Timed_Schedule& timing, u32 const position)
+  {
+    u32 const end = timing.fanout_offsets[position + 1];
+    for(u32 i = timing.fanout_offsets[position]; i < end; ++i) {
+      u32 const reader = timing.fanouts[i];
+      if(timing.stamps[reader] != timing.stamp) {
+        timing.stamps[reader] = timing.stamp;
+        timing.pending.push_back(reader);
+      }
+    }
+  }
+
+  static void schedule_readers(Timed_Schedule& timing, u32 const position,
+                               i64 const time)
+  {
+    u32 const end = timing.fanout_offsets[position + 1];
+    for(u32 i = timing.fanout_offsets[position]; i < end; ++i) {
+      schedule_event(timing.wheel, time,
+                     Gate_Event{timing.fanouts[i],
+                                Gate_Event_Kind::e_evaluate, 0});
+    }
+  }
+
+  // evaluate_timed_gate
+  //
+  // Evaluate a gate at a tick and schedule the commit of its output after
+  // its delay. The output is not changed by the evaluation, hence the gates
+  // evaluated at the same tick read the same values regardless of their
+  // order. A commit is scheduled only if the output differs from the last
+  // scheduled one. Gates with several outputs change them at once and
+  // schedule the evaluation of their readers instead.
+  //
+  template<bool four_valued>
+  static void evaluate_timed_gate(Timed_Schedule& timing, u32 const position,
+                                  i64 const time, Array<Gate*>* const changed,
+                                  Toggle_Counters* const toggles)
+  {
+    Gate& gate = *timing.gates[position];
+    i64 const ready = time + get_gate_delay(timing, gate);
+    timing.evaluated += 1;
+    if(gate.kind == Gate_Kind::e_module || has_state_outputs(gate.kind)) {
+      bool const previous = gate.evaluation.value;
+      bool const previous_unknown = gate.evaluation.unknown;
+      evaluate_gate<four_valued, true>(gate);
+      // The gates within a module have not settled while any of them
+      // changes.
+      bool settled = true;
+      if(gate.kind == Gate_Kind::e_module) {
+        for(u8 const byte: gate.state) {
+          settled = settled && ((byte ^ (byte >> 1)) & 5) == 0;
+        }
+      }
+      bool const outputs_changed =
+        !settled || has_changed(gate, previous, previous_unknown);
+      begin_cycle<four_valued>(gate);
+      if(outputs_changed) {
+        record_change(timing, position, time, changed, toggles);
+        schedule_readers(timing, position, ready);
+      }
+      if(!settled) {
+        schedule_event(timing.wheel, time + 1,
+                       Gate_Event{position, Gate_Event_Kind::e_evaluate, 0});
+      }
+      return;
+    }
+
+    Evaluation_State const committed = gate.evaluation;
+    evaluate_gate<four_valued, true>(gate);
+    u8 const value = static_cast<u8>(gate.evaluation.value |
+                                     (gate.evaluation.unknown << 1));
+    // Sequential gates keep the level of CLK they have read in their state.
+    gate.evaluation = committed;
+    if(value != timing.outputs[position]) {
+      timing.outputs[position] = value;
+      schedule_event(timing.wheel, ready,
+                     Gate_Event{position, Gate_Event_Kind::e_commit, value});
+    }
+  }
+
+  // process_event
+  //
+  // Apply an event of a tick. Gates to evaluate at the tick are marked and
+  // evaluated after all events of the tick have been applied.
+  //
+  static void process_event(Timed_Schedule& timing, Gate_Event const event,
+                            i64 const time, Array<Gate*>* const changed,
+                            Toggle_Counters* const toggles)
+  {
+    u32 const position = event.position;
+    Gate& gate = *timing.gates[position];
+    switch(event.kind) {
+    case Gate_Event_Kind::e_commit: {
+      bool const value = event.value & 1;
+      bool const unknown = (event.value >> 1) & 1;
+      if(gate.evaluation.value == value && gate.evaluation.unknown == unknown) {
+        return;
+      }
+
+      gate.evaluation = Evaluation_State{value, value, unknown, unknown};
+      record_change(timing, position, time, changed, toggles);
+      mark_readers(timing, position);
+    } break;
+
+    case Gate_Event_Kind::e_evaluate: {
+      if(timing.stamps[position] != timing.stamp) {
+        timing.stamps[position] = timing.stamp;
+        timing.pending.push_back(position);
+      }
+    } break;
+
+    case Gate_Event_Kind::e_toggle: {
+      bool const value = !gate.evaluation.value;
+      gate.evaluation.value = value;
+      gate.evaluation.prev_value = value;
+      record_change(timing, position, time, changed, toggles);
+      mark_readers(timing, position);
+      i64 const toggle =
+        get_next_toggle(gate.clock_period, gate.clock_phase, time + 1);
+      schedule_event(timing.wheel, toggle,
+                     Gate_Event{position, Gate_Event_Kind::e_toggle, 0});
+    } break;
+    }
+  }
+
+  template<bool four_valued>
+  static void evaluate_ticks(Timed_Schedule& timing, i64 const end,
+                             Array<Gate*>* const changed,
+                             Toggle_Counters* const toggles)
+  {
+    while(true) {
+      timing.due.clear();
+      i64 const time = take_events(timing.wheel, timing.due, end);
+      if(time < 0) {
+        break;
+      }
+
+      timing.stamp += 1;
+      timing.pending.clear();
+      for(Gate_Event const event: timing.due) {
+        process_event(timing, event, time, changed, toggles);
+      }
+      for(u32 const position: timing.pending) {
+        evaluate_timed_gate<four_valued>(timing, position, time, changed,
+                                         toggles);
+      }
+      timing.events += timing.due.size();
+    }
+  }
+
+  void evaluate_until(List<Gate>& gates, Timed_Schedule& timing,
+                      i64 const time, Array<Gate*>* const changed,
+                      Toggle_Counters* const toggles, Logic_Mode const mode)
+  {
+    ANTON_ASSERT(time >= timing.time, "time is earlier than the schedule");
+    bool const four_valued = mode == Logic_Mode::e_four_valued;
+    bool const stale = timing.revision != get_connection_revision() ||
+                       timing.gate_count != gates.size();
+    if(stale) {
+      build_timing(timing, gates);
+    }
+
+    if(toggles != nullptr &&
+       (stale || toggles->gates.size() != gates.size())) {
+      sync_toggle_counters(*toggles, gates);
+    }
+
+    if(timing.full) {
+      // Gates evaluated by cycles may have previous values of their own.
+      for(Gate* const gate: timing.gates) {
+        if(four_valued) {
+          begin_cycle<true>(*gate);
+        } else {
+          begin_cycle<false>(*gate);
+        }
+      }
+      restart_timing(timing);
+      timing.full = false;
+    }
+
+    // Inputs change at the first tick that has not been processed.
+    i64 const next = timing.time + 1;
+    for(i64 i = 0; i < timing.inputs.size(); ++i) {
+      u32 const position = timing.inputs[i];
+      Evaluation_State& evaluation = timing.gates[position]->evaluation;
+      u8 const value =
+        static_cast<u8>(evaluation.value | (evaluation.unknown << 1));
+      if(timing.input_values[i] == value) {
+        continue;
+      }
+
+      timing.input_values[i] = value;
+      evaluation.prev_value = evaluation.value;
+      evaluation.prev_unknown = evaluation.unknown;
+      record_change(timing, position, next, changed, toggles);
+      schedule_readers(timing, position, next);
+    }
+
+    if(toggles != nullptr) {
+      toggles->cycles += time - timing.time;
+    }
+
+    if(four_valued) {
+      evaluate_ticks<true>(timing, time, changed, toggles);
+    } else {
+      evaluate_ticks<false>(timing, time, changed, toggles);
+    }
+    timing.time = time;
+  }
+
+  void restart_timed_schedule(Timed_Schedule& timing, i64 const time)
+  {
+    timing.time = time;
+    timing.full = true;
+  }
+
+  void reset_unknown(List<Gate>& gates)
+  {
+    for(Gate& gate: gates) {
+      if(gate.kind == Gate_Kind::e_input || gate.kind == Gate_Kind::e_clock) {
+        continue;
+      }
+
+      gate.evaluation = Evaluation_State{false, false, true, true};
+      if(gate.kind == Gate_Kind::e_module || is_sequential(gate.kind) ||
+         is_memory(gate.kind)) {
+        gate.state.clear();
+        allocate_state(gate, true);
+      }
+    }
+  }
+
+  void clear_unknown(List<Gate>& gates)
+  {
+    for(Gate& gate: gates) {
+      gate.evaluation.prev_unknown = false;
+      gate.evaluation.unknown = false;
+      for(u8& value: gate.state) {
+        value &= 3;
+      }
+    }
+  }
+
+  void reset_toggle_counters(Toggle_Counters& toggles)
+  {
+    toggles = Toggle_Counters();
   }
 } // namespace nebula
@@ -1,8 +1,421 @@
 #pragma once
 
+#include <core/time_wheel.hpp>
 #include <core/types.hpp>
 #include <model/gate.hpp>
 
 namespace nebula {
-  void evaluate(List<Gate>& gates);
-}
+  /**
+   * @brief Per-gate toggle counters kept apart from the gates.
+   *
+   * The counters are stored as separate arrays indexed by the position of a
+   * gate in the list of gates, hence counting does not enlarge the gates
+   * touched by the evaluation. Slots are reassigned by identifier whenever
+   * the list of gates changes.
+   */
+  struct Toggle_Counters {
+    // Identifier of the gate of every slot.
+    Array<u64> gates;
+    // Value of the gate after the last counted cycle.
+    Array<u8> values;
+    // Number of 0 -> 1 transitions.
+    Array<u64> rises;
+    // Number of 1 -> 0 transitions.
+    Array<u64> falls;
+    // Number of transitions of the signals within module instances. Zero for
+    // primitive gates.
+    Array<u64> internal;
+    // Number of counted cycles.
+    i64 cycles = 0;
+  };
+
+  /**
+   * @brief Logic used by the evaluation.
+   */
+  enum struct Logic_Mode : u8 {
+    // Nets are 0 or 1. Unconnected inputs read 0.
+    e_two_valued,
+    // Nets may also be unknown (X). Unconnected inputs float (Z) and gates
+    // read Z as X. Unknown values propagate unless the other input of a gate
+    // decides the output, e.g. 0 AND X is 0.
+    e_four_valued,
+  };
+
+  /**
+   * @brief A cone of combinational gates evaluated with a single lookup.
+   *
+   * The leaves are the values the cone reads from outside of it. Every member
+   * of the cone has a truth table over the leaves, hence the values of all
+   * the members follow from the leaves gathered once.
+   */
+  struct Lut_Node {
+    // Range of the leaves in Evaluation_Schedule::leaves.
+    u32 first_leaf;
+    u32 leaf_count;
+    // Range of the members in Evaluation_Schedule::members.
+    u32 first_member;
+    u32 member_count;
+  };
+
+  /**
+   * @brief Number of passes over the gates of a combinational loop after
+   * which the evaluation gives up settling the loop.
+   */
+  constexpr i64 loop_pass_limit = 32;
+
+  /**
+   * @brief A combinational loop of a schedule.
+   */
+  struct Schedule_Loop {
+    // Range of the gates of the loop in Evaluation_Schedule::order.
+    u32 first;
+    u32 count;
+  };
+
+  /**
+   * @brief Order of the levelized evaluation.
+   *
+   * Boundary gates, that is inputs, clocks, sequential gates, memories and
+   * module instances, come first and read the previous values of their
+   * inputs. The combinational gates follow in topological order and read the
+   * current values, hence the logic between the boundaries settles within a
+   * single cycle. The gates of a combinational loop are adjacent in the
+   * order and are evaluated repeatedly until none of them changes, at most
+   * loop_pass_limit times. A loop that does not settle, e.g. a ring
+   * oscillator, keeps the values of its last pass in the two-valued mode and
+   * becomes unknown in the four-valued mode.
+   *
+   * The schedule is rebuilt by the evaluation whenever the gates or their
+   * connections have changed.
+   */
+  struct Evaluation_Schedule {
+    // Identifiers of the gates in list order when the schedule was built.
+    Array<u64> gates;
+    // Connection revision when the schedule was built.
+    u64 revision = 0;
+    // Gates in the order of evaluation.
+    Array<Gate*> order;
+    // Position in the list of every gate of order. Slots of the toggle
+    // counters.
+    Array<u32> slots;
+    // Number of boundary gates at the start of order.
+    i64 boundary_count = 0;
+    // Combinational loops ordered by their positions.
+    Array<Schedule_Loop> loops;
+    // Number of gates in combinational loops.
+    i64 loop_count = 0;
+    // Number of evaluations of loops that did not settle since the schedule
+    // was built.
+    i64 unsettled_count = 0;
+
+    // Whether to fuse the combinational gates into cones evaluated as lookup
+    // tables. Applies to the two-valued mode only. The four-valued mode
+    // evaluates the gates one by one, which propagates X like the gates.
+    // Schedules with combinational loops are not fused.
+    bool fuse = false;
+    // Whether the nodes have been built.
+    bool fused = false;
+    Array<Lut_Node> nodes;
+    // Inputs of the members reading the leaves of the nodes.
+    Array<Port*> leaves;
+    // The combinational gates grouped by node in topological order with
+    // their truth tables and their positions in the list of gates.
+    Array<Gate*> members;
+    Array<u64> tables;
+    Array<u32> member_slots;
+  };
+
+  /**
+   * @brief Evaluates one cycle of the gates.
+   *
+   * Evaluation is specialized for every combination of the optional outputs,
+   * hence outputs that are not requested cost nothing.
+   *
+   * @param gates The gates to evaluate.
+   * @param changed If not null, receives the gates whose value has changed
+   * during the cycle. Module instances, registers and memories are always
+   * appended since any of their outputs may have changed. Inputs are
+   * appended if a different value has been assigned to them since the
+   * previous cycle.
+   * @param toggles If not null, counts the transitions of the values of the
+   * gates including values assigned to inputs between cycles. Unknown values
+   * count as 0.
+   * @param mode The logic to evaluate the gates with.
+   * @param schedule If not null, the gates are evaluated in the levelized
+   * order kept in the schedule. Otherwise every gate reads the previous
+   * values of its inputs, which delays every gate by one cycle.
+   */
+  void evaluate(List<Gate>& gates, Array<Gate*>* changed = nullptr,
+                Toggle_Counters* toggles = nullptr,
+                Logic_Mode mode = Logic_Mode::e_two_valued,
+                Evaluation_Schedule* schedule = nullptr);
+
+  /**
+   * @brief Clock domains of the gates and the times of the next edges of the
+   * clocks.
+   *
+   * The domain of a clock holds the gates an edge of the clock may change:
+   * the clock, the flip-flops, registers and RAMs whose CLK it drives and
+   * everything their changes reach. Clocked gates are entered through their
+   * CLK only since they sample their other inputs on edges. Module instances
+   * and their fanout belong to every domain since their gates keep the unit
+   * delay. An edge evaluates the domains of the clocks toggling at its time,
+   * hence the gates of slow clocks are not evaluated on the edges of fast
+   * ones. All gates are evaluated when an input has changed since the
+   * previous edge.
+   *
+   * Boundary gates read the values settled by the previous edge. Those
+   * reading a gate that has changed during an edge, such as flip-flops on
+   * derived clocks, latches and memories addressed by the logic, are
+   * evaluated again with their fanout within the same edge until no such
+   * gate changes, at most delta_limit times.
+   *
+   * The domains are rebuilt whenever the gates or their connections change,
+   * the clocks are rescheduled whenever a period or a phase changes.
+   */
+  struct Clock_Schedule {
+    // Time of the last edge, -1 before the first one.
+    i64 time = -1;
+    // Connection revision and number of gates when the domains were built.
+    u64 revision = 0;
+    i64 gate_count = -1;
+    // Whether the next edge evaluates all gates. Set whenever the values of
+    // the gates may have changed outside of the evaluation by domains.
+    bool full = true;
+    Array<Gate*> clocks;
+    // Period and phase of every clock when it was scheduled.
+    Array<u32> periods;
+    Array<u32> phases;
+    // Positions in Evaluation_Schedule::order of the gates of every domain,
+    // sorted. The domain of clock i is the range from offsets[i] to
+    // offsets[i + 1].
+    Array<u32> offsets;
+    Array<u32> positions;
+    // Positions of all gates except the clocks.
+    Array<u32> static_positions;
+    // Positions of the gates reading the gate at every position through an
+    // input that is not sampled, laid out like the domains.
+    Array<u32> fanout_offsets;
+    Array<u32> fanouts;
+    // The boundary gates among them, except module instances. Empty for
+    // clocks.
+    Array<u32> reader_offsets;
+    Array<u32> readers;
+    // Inputs and their values after the last edge.
+    Array<Gate*> inputs;
+    Array<u8> input_values;
+    // Next edge of every clock by the index of the clock.
+    Time_Wheel<u32> wheel;
+    // Number of evaluations, the number of gates they evaluated, the number
+    // of delta evaluations and the number of edges that did not settle.
+    i64 evaluations = 0;
+    i64 evaluated = 0;
+    i64 deltas = 0;
+    i64 unsettled = 0;
+    // Scratch of the evaluation. Every position is marked with the stamp of
+    // the last delta evaluation it has been added to.
+    Array<u32> stamps;
+    u32 stamp = 0;
+    Array<u32> due;
+    Array<u32> seeds;
+    Array<u32> step;
+    Array<u32> merged;
+  };
+
+  /**
+   * @brief Maximum number of delta evaluations of a single edge.
+   */
+  constexpr i64 delta_limit = 64;
+
+  /**
+   * @brief Advances the simulated time to the next edge of any clock and
+   * evaluates the domains of the clocks toggling at that time.
+   *
+   * The gates of a domain are evaluated in the levelized order of the
+   * schedule, which is rebuilt along with the domains. Every edge counts as
+   * a cycle of the toggle counters.
+   *
+   * @param changed If not null, receives the gates whose value has changed,
+   * see evaluate. Gates changing in several delta evaluations are appended
+   * once per evaluation.
+   * @param toggles If not null, counts the transitions of the evaluated
+   * gates, see evaluate.
+   * @return The time of the edge. If there are no clocks, the time remains
+   * and only a change of the inputs is evaluated.
+   */
+  i64 evaluate_next_edge(List<Gate>& gates, Clock_Schedule& clocks,
+                         Evaluation_Schedule& schedule,
+                         Array<Gate*>* changed = nullptr,
+                         Toggle_Counters* toggles = nullptr,
+                         Logic_Mode mode = Logic_Mode::e_two_valued);
+
+  /**
+   * @brief Continues the evaluation by clock domains after a time.
+   *
+   * Used once the state of the gates has been restored. The clocks are
+   * scheduled anew from the tick following the time and the next edge
+   * evaluates all gates.
+   */
+  void restart_clock_schedule(Clock_Schedule& clocks, i64 time);
+
+  /**
+   * @brief Kind of an event of the timed evaluation.
+   */
+  enum struct Gate_Event_Kind : u8 {
+    // The output of the gate takes the value of the event.
+    e_commit,
+    // The gate reads its inputs.
+    e_evaluate,
+    // The clock toggles and schedules its next toggle.
+    e_toggle,
+  };
+
+  struct Gate_Event {
+    // Position of the gate in Timed_Schedule::gates.
+    u32 position;
+    Gate_Event_Kind kind;
+    // Value committed by e_commit. Bit 0 is the value, bit 1 the unknown
+    // flag.
+    u8 value;
+  };
+
+  /**
+   * @brief A pulse of a net narrower than the glitch width.
+   */
+  struct Glitch {
+    Gate* gate;
+    // Time the pulse has ended at.
+    i64 time;
+    i64 width;
+  };
+
+  /**
+   * @brief State of the timed evaluation.
+   *
+   * Every gate takes its delay in ticks of simulated time to propagate a
+   * change of its inputs to its output. A gate reads its inputs at the tick
+   * they change and its new output is committed delay ticks later. Outputs
+   * are committed even if another change is pending, that is the delay is a
+   * transport delay, hence pulses narrower than the delay reach the readers
+   * as they would in a real circuit and hazards of the logic are visible.
+   * Clocks toggle on the ticks given by their periods and phases.
+   *
+   * Module instances, registers and memories change their outputs at the
+   * tick they read their inputs and delay the reading of their readers
+   * instead. The gates within module instances keep their unit delay, that
+   * is an instance is evaluated on every tick until it settles.
+   *
+   * The events are kept in a time wheel, hence scheduling does not allocate
+   * once the buckets have grown and taking the events of a tick does not
+   * search. The tables are rebuilt whenever the gates or their connections
+   * change.
+   */
+  struct Timed_Schedule {
+    // Last tick whose events have been processed, -1 before the first one.
+    i64 time = -1;
+    // Connection revision and number of gates when the tables were built.
+    u64 revision = 0;
+    i64 gate_count = -1;
+    // Whether the next tick evaluates all gates. Set whenever the values of
+    // the gates may have changed outside of the timed evaluation.
+    bool full = true;
+    // Delay of the gates of every kind that do not have a delay of their
+    // own. 0 is a delay of 1 tick.
+    u32 kind_delays[static_cast<i64>(Gate_Kind::e_count)] = {};
+    // Pulses narrower than this many ticks are recorded as glitches. 0
+    // disables the detection. Inputs and clocks are not checked.
+    i64 glitch_width = 0;
+    // Gates in list order, which are the slots of the toggle counters.
+    Array<Gate*> gates;
+    // Positions of the gates reading the gate at every position through an
+    // input that is not sampled. The readers of position i are the range
+    // from fanout_offsets[i] to fanout_offsets[i + 1].
+    Array<u32> fanout_offsets;
+    Array<u32> fanouts;
+    // Positions of the inputs and their values after the last tick.
+    Array<u32> inputs;
+    Array<u8> input_values;
+    // Tick of the last change of the gate at every position.
+    Array<i64> changes;
+    // Value of the last commit scheduled for the gate at every position, or
+    // its value if no commit is pending. Bit 0 is the value, bit 1 the
+    // unknown flag.
+    Array<u8> outputs;
+    Time_Wheel<Gate_Event> wheel;
+    // Glitches detected since the caller has last cleared them. Cleared
+    // when the tables are rebuilt.
+    Array<Glitch> glitches;
+    // Number of processed events, of gate evaluations and of glitches.
+    i64 events = 0;
+    i64 evaluated = 0;
+    i64 glitch_count = 0;
+    // Scratch of the evaluation. Every position is marked with the stamp of
+    // the last tick it has been evaluated at.
+    Array<u32> stamps;
+    u32 stamp = 0;
+    Array<Gate_Event> due;
+    Array<u32> pending;
+  };
+
+  /**
+   * @brief Gets the delay of a gate in ticks.
+   *
+   * @return The delay of the gate if it has one, otherwise the delay of its
+   * kind in the schedule. At least 1.
+   */
+  [[nodiscard]] u32 get_gate_delay(Timed_Schedule const& timing,
+                                   Gate const& gate);
+
+  /**
+   * @brief Processes the events of the ticks up to a time.
+   *
+   * Inputs that have changed since the last call change at the first
+   * unprocessed tick. Every tick counts as a cycle of the toggle counters.
+   *
+   * @param time The last tick to process. Must not be earlier than the time
+   * of the schedule.
+   * @param changed If not null, receives the gates whose value has changed,
+   * see evaluate. Gates changing on several ticks are appended once per
+   * tick.
+   * @param toggles If not null, counts every committed transition including
+   * glitches, see evaluate.
+   */
+  void evaluate_until(List<Gate>& gates, Timed_Schedule& timing, i64 time,
+                      Array<Gate*>* changed = nullptr,
+                      Toggle_Counters* toggles = nullptr,
+                      Logic_Mode mode = Logic_Mode::e_two_valued);
+
+  /**
+   * @brief Continues the timed evaluation after a time.
+   *
+   * Used once the state of the gates has been restored. The pending events
+   * are dropped and the next call to evaluate_until evaluates all gates at
+   * the tick following the time.
+   */
+  void restart_timed_schedule(Timed_Schedule& timing, i64 time);
+
+  /**
+   * @brief Makes the state of all gates except inputs and clocks unknown.
+   *
+   * Starts the four-valued simulation from an uninitialized state, hence
+   * nets that no input determines remain X.
+   */
+  void reset_unknown(List<Gate>& gates);
+
+  /**
+   * @brief Makes the state of all gates known. Unknown values become 0.
+   *
+   * Must be called before continuing with the two-valued evaluation after a
+   * four-valued one.
+   */
+  void clear_unknown(List<Gate>& gates);
+
+  /**
+   * @brief Clears the counters.
+   *
+   * Counting starts with the next cycle. The values of the gates at the start
+   * of that cycle, including values just assigned to inputs, are the baseline
+   * of the counts.
+   */
+  void reset_toggle_counters(Toggle_Counters& toggles);
+} // namespace nebula
@@ -0,0 +1,200 @@
+#include <evaluator/fusion.hpp>
+
+#include <anton/flat_hash_map.hpp>
+
+#include <model/port.hpp>
+
+namespace nebula {
+  constexpr u32 no_parent = static_cast<u32>(-1);
+
+  // Cut
+  //
+  // The drivers of the leaves of a cone.
+  //
+  struct Cut {
+    Port const* drivers[lut_input_count];
+    i64 count = 0;
+  };
+
+  [[nodiscard]] static Port const* get_driver(Port const* const port)
+  {
+    if(port->connections.size() == 1) {
+      return *port->connections.begin();
+    } else {
+      return nullptr;
+    }
+  }
+
+  [[nodiscard]] static i64 find_driver(Cut const& cut, Port const* const driver)
+  {
+    for(i64 i = 0; i < cut.count; ++i) {
+      if(cut.drivers[i] == driver) {
+        return i;
+      }
+    }
+    return -1;
+  }
+
+  // merge_cut
+  //
+  // Replace the leaf driven by a fanin with the leaves of the cone of the
+  // fanin.
+  //
+  // Returns:
+  // false if the merged cut has too many leaves, in which case cut is left
+  // unchanged.
+  //
+  [[nodiscard]] static bool merge_cut(Cut& cut, Port const* const fanin,
+                                      Cut const& fanin_cut)
+  {
+    Cut merged;
+    for(i64 i = 0; i < cut.count; ++i) {
+      if(cut.drivers[i] != fanin) {
+        merged.drivers[merged.count] = cut.drivers[i];
+        merged.count += 1;
+      }
+    }
+
+    for(i64 i = 0; i < fanin_cut.count; ++i) {
+      Port const* const driver = fanin_cut.drivers[i];
+      if(find_driver(merged, driver) >= 0) {
+        continue;
+      } else if(merged.count == lut_input_count) {
+        return false;
+      }
+      merged.drivers[merged.count] = driver;
+      merged.count += 1;
+    }
+    cut = merged;
+    return true;
+  }
+
+  void fuse_schedule(Evaluation_Schedule& schedule)
+  {
+    i64 const first = schedule.boundary_count;
+    i64 const count = schedule.order.size() - first;
+    // Maps the address of a combinational gate to its position among the
+    // combinational gates of the order.
+    Flat_Hash_Map<u64, u32> positions;
+    for(i64 i = 0; i < count; ++i) {
+      positions.emplace(reinterpret_cast<u64>(schedule.order[first + i]), i);
+    }
+
+    Array<Cut> cuts{count, Cut{}};
+    Array<u32> parents{count, no_parent};
+    for(i64 i = 0; i < count; ++i) {
+      Gate const& gate = *schedule.order[first + i];
+      Cut& cut = cuts[i];
+      for(Port const* const port: gate.in_ports) {
+        Port const* const driver = get_driver(port);
+        if(driver == nullptr) {
+          continue;
+        }
+
+        if(find_driver(cut, driver) < 0) {
+          cut.drivers[cut.count] = driver;
+          cut.count += 1;
+        }
+      }
+
+      for(Port const* const port: gate.in_ports) {
+        Port const* const driver = get_driver(port);
+        if(driver == nullptr || driver->connections.size() != 1) {
+          continue;
+        }
+
+        auto iter = positions.find(reinterpret_cast<u64>(driver->gate));
+        if(iter == positions.end()) {
+          continue;
+        }
+
+        if(merge_cut(cut, driver, cuts[iter->value])) {
+          parents[iter->value] = i;
+        }
+      }
+    }
+
+    // Parents follow their children in the order, hence the roots are
+    // resolved backwards.
+    Array<u32> roots{count, 0};
+    for(i64 i = count - 1; i >= 0; --i) {
+      roots[i] = parents[i] == no_parent ? i : roots[parents[i]];
+    }
+
+    // Nodes are ordered by their roots and their members keep the order.
+    Array<u32> node_indices{count, 0};
+    Array<u32> node_roots;
+    for(i64 i = 0; i < count; ++i) {
+      if(roots[i] == i) {
+        node_indices[i] = schedule.nodes.size();
+        node_roots.push_back(i);
+        schedule.nodes.push_back(Lut_Node{0, 0, 0, 0});
+      }
+    }
+    for(i64 i = 0; i < count; ++i) {
+      schedule.nodes[node_indices[roots[i]]].member_count += 1;
+    }
+    u32 offset = 0;
+    for(Lut_Node& node: schedule.nodes) {
+      node.first_member = offset;
+      offset += node.member_count;
+      node.member_count = 0;
+    }
+
+    schedule.members.resize(count, nullptr);
+    schedule.tables.resize(count, 0);
+    schedule.member_slots.resize(count, 0);
+    // Tables of the combinational gates by position.
+    Array<u64> tables{count, 0};
+    for(i64 i = 0; i < count; ++i) {
+      Gate const& gate = *schedule.order[first + i];
+      Cut const& cut = cuts[roots[i]];
+      u64 inputs[lut_input_count] = {};
+      for(i64 j = 0; j < gate.in_ports.size(); ++j) {
+        Port const* const driver = get_driver(gate.in_ports[j]);
+        if(driver == nullptr) {
+          continue;
+        }
+
+        i64 const leaf = find_driver(cut, driver);
+        if(leaf >= 0) {
+          inputs[j] = input_truth_tables[leaf];
+        } else {
+          // Drivers that are not leaves are absorbed into the node.
+          auto iter = positions.find(reinterpret_cast<u64>(driver->gate));
+          inputs[j] = tables[iter->value];
+        }
+      }
+      tables[i] = compose_truth_table(gate, inputs);
+
+      Lut_Node& node = schedule.nodes[node_indices[roots[i]]];
+      u32 const member = node.first_member + node.member_count;
+      node.member_count += 1;
+      schedule.members[member] = schedule.order[first + i];
+      schedule.tables[member] = tables[i];
+      schedule.member_slots[member] = schedule.slots[first + i];
+    }
+
+    // Every leaf is read through an input of a member connected to it.
+    for(i64 n = 0; n < schedule.nodes.size(); ++n) {
+      Lut_Node& node = schedule.nodes[n];
+      Cut const& cut = cuts[node_roots[n]];
+      node.first_leaf = schedule.leaves.size();
+      node.leaf_count = cut.count;
+      u32 const end = node.first_member + node.member_count;
+      for(i64 i = 0; i < cut.count; ++i) {
+        Port* leaf = nullptr;
+        for(u32 m = node.first_member; m < end && leaf == nullptr; ++m) {
+          for(Port* const port: schedule.members[m]->in_ports) {
+            if(get_driver(port) == cut.drivers[i]) {
+              leaf = port;
+              break;
+            }
+          }
+        }
+        schedule.leaves.push_back(leaf);
+      }
+    }
+    schedule.fused = true;
+  }
+} // namespace nebula
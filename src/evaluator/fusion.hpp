@@ -0,0 +1,21 @@
+#pragma once
+
+#include <evaluator/evaluator.hpp>
+
+// Internal interface of the levelized evaluation.
+
+namespace nebula {
+  /**
+   * @brief Fuses the combinational gates of a schedule into cones evaluated
+   * as lookup tables.
+   *
+   * A gate absorbs the cone of a combinational fanin that drives only the
+   * gate as long as the cone keeps at most lut_input_count leaves, hence the
+   * cones are fanout-free and every gate driving several inputs is the root
+   * of its cone.
+   *
+   * The order and the boundary gates of the schedule must have been built
+   * and the schedule must not have combinational loops.
+   */
+  void fuse_schedule(Evaluation_Schedule& schedule);
+} // namespace nebula
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <anton/assert.hpp>
+
+#include <core/types.hpp>
+#include <model/gate.hpp>
+
+namespace nebula {
+  /**
+   * @brief Four-valued logic values of 64 nets stored as two bit-planes.
+   *
+   * Every bit position is a separate net. value holds the known ones and
+   * unknown marks the nets whose value is not known:
+   *   value 0, unknown 0 - 0
+   *   value 1, unknown 0 - 1
+   *   value 0, unknown 1 - X, an unknown value
+   *   value 1, unknown 1 - Z, an undriven net
+   * Gates read Z as X and never drive Z. Since X has no bit set in the value
+   * plane, consumers that ignore the unknown plane read X as 0.
+   */
+  struct Logic_Word {
+    u64 value;
+    u64 unknown;
+  };
+
+  constexpr Logic_Word logic_zero{0, 0};
+  constexpr Logic_Word logic_x{0, ~static_cast<u64>(0)};
+  constexpr Logic_Word logic_z{~static_cast<u64>(0),
+                                   ~static_cast<u64>(0)};
+
+  [[nodiscard]] constexpr Logic_Word logic_not(Logic_Word const a)
+  {
+    return {~(a.value | a.unknown), a.unknown};
+  }
+
+  /**
+   * @brief Known 0 on either input forces a known 0, otherwise any unknown
+   * input makes the result unknown.
+   */
+  [[nodiscard]] constexpr Logic_Word logic_and(Logic_Word const a,
+                                               Logic_Word const b)
+  {
+    u64 const one = a.value & ~a.unknown & b.value & ~b.unknown;
+    u64 const unknown =
+      (a.unknown | b.unknown) & (a.value | a.unknown) & (b.value | b.unknown);
+    return {one, unknown};
+  }
+
+  /**
+   * @brief Known 1 on either input forces a known 1, otherwise any unknown
+   * input makes the result unknown.
+   */
+  [[nodiscard]] constexpr Logic_Word logic_or(Logic_Word const a,
+                                              Logic_Word const b)
+  {
+    u64 const one = (a.value & ~a.unknown) | (b.value & ~b.unknown);
+    return {one, (a.unknown | b.unknown) & ~one};
+  }
+
+  [[nodiscard]] constexpr Logic_Word logic_xor(Logic_Word const a,
+                                               Logic_Word const b)
+  {
+    u64 const unknown = a.unknown | b.unknown;
+    return {(a.value ^ b.value) & ~unknown, unknown};
+  }
+
+  /**
+   * @brief Computes the output of a primitive gate for every bit of the
+   * words.
+   *
+   * @param kind A gate kind with at most two inputs.
+   * @param in2 Ignored by a not gate.
+   */
+  [[nodiscard]] inline Logic_Word compute_logic(Gate_Kind const kind,
+                                                Logic_Word const in1,
+                                                Logic_Word const in2)
+  {
+    switch(kind) {
+    case Gate_Kind::e_and:
+      return logic_and(in1, in2);
+    case Gate_Kind::e_or:
+      return logic_or(in1, in2);
+    case Gate_Kind::e_xor:
+      return logic_xor(in1, in2);
+    case Gate_Kind::e_nand:
+      return logic_not(logic_and(in1, in2));
+    case Gate_Kind::e_nor:
+      return logic_not(logic_or(in1, in2));
+    case Gate_Kind::e_xnor:
+      return logic_not(logic_xor(in1, in2));
+    case Gate_Kind::e_not:
+      return logic_not(in1);
+    default:
+      ANTON_UNREACHABLE("gate has no inputs");
+    }
+    return logic_x;
+  }
+} // namespace nebula
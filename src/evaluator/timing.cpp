@@ -0,0 +1,98 @@
+#include <evaluator/timing.hpp>
+
+#include <anton/flat_hash_map.hpp>
+
+#include <evaluator/domains.hpp>
+#include <model/port.hpp>
+
+namespace nebula {
+  // Number of ticks of the window of the wheel. Delays and half periods
+  // shorter than the window never make the wheel search for the earliest
+  // event.
+  constexpr i64 timing_wheel_size = 1024;
+
+  u32 get_gate_delay(Timed_Schedule const& timing, Gate const& gate)
+  {
+    if(gate.delay != 0) {
+      return gate.delay;
+    }
+
+    u32 const delay = timing.kind_delays[static_cast<i64>(gate.kind)];
+    return delay != 0 ? delay : 1;
+  }
+
+  void build_timing(Timed_Schedule& timing, List<Gate>& gates)
+  {
+    timing.gates.clear();
+    timing.fanout_offsets.clear();
+    timing.fanouts.clear();
+    timing.inputs.clear();
+    timing.input_values.clear();
+    // The gates of the glitches may have been deleted.
+    timing.glitches.clear();
+    timing.revision = get_connection_revision();
+    timing.gate_count = gates.size();
+    timing.full = true;
+
+    Flat_Hash_Map<u64, u32> positions;
+    for(Gate& gate: gates) {
+      u32 const position = static_cast<u32>(timing.gates.size());
+      positions.emplace(reinterpret_cast<u64>(&gate), position);
+      if(gate.kind == Gate_Kind::e_input) {
+        timing.inputs.push_back(position);
+        timing.input_values.push_back(0);
+      }
+      timing.gates.push_back(&gate);
+    }
+
+    for(Gate const* const gate: timing.gates) {
+      timing.fanout_offsets.push_back(timing.fanouts.size());
+      for(Port const* const out: gate->out_ports) {
+        for(Port const* const in: out->connections) {
+          if(!is_sampled(in)) {
+            timing.fanouts.push_back(
+              positions.find(reinterpret_cast<u64>(in->gate))->value);
+          }
+        }
+      }
+    }
+    timing.fanout_offsets.push_back(timing.fanouts.size());
+
+    i64 const count = timing.gates.size();
+    timing.changes.clear();
+    timing.changes.resize(count, no_change);
+    timing.outputs.clear();
+    timing.outputs.resize(count, 0);
+    timing.stamps.clear();
+    timing.stamps.resize(count, 0);
+    timing.stamp = 0;
+  }
+
+  void restart_timing(Timed_Schedule& timing)
+  {
+    i64 const time = timing.time + 1;
+    reset_time_wheel(timing.wheel, timing_wheel_size, time);
+    for(i64 i = 0; i < timing.gates.size(); ++i) {
+      Gate const& gate = *timing.gates[i];
+      u32 const position = static_cast<u32>(i);
+      timing.outputs[i] = static_cast<u8>(gate.evaluation.value |
+                                          (gate.evaluation.unknown << 1));
+      if(gate.kind == Gate_Kind::e_clock) {
+        i64 const toggle =
+          get_next_toggle(gate.clock_period, gate.clock_phase, time);
+        schedule_event(timing.wheel, toggle,
+                       Gate_Event{position, Gate_Event_Kind::e_toggle, 0});
+      } else if(gate.kind != Gate_Kind::e_input) {
+        schedule_event(timing.wheel, time,
+                       Gate_Event{position, Gate_Event_Kind::e_evaluate, 0});
+      }
+    }
+
+    for(i64 i = 0; i < timing.inputs.size(); ++i) {
+      Evaluation_State const& evaluation =
+        timing.gates[timing.inputs[i]]->evaluation;
+      timing.input_values[i] =
+        static_cast<u8>(evaluation.value | (evaluation.unknown << 1));
+    }
+  }
+} // namespace nebula
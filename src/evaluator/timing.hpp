@@ -0,0 +1,28 @@
+#pragma once
+
+#include <evaluator/evaluator.hpp>
+
+// Internal interface of the timed evaluation.
+
+namespace nebula {
+  /**
+   * @brief Time of the last change of gates that have not changed yet. Far
+   * enough in the past for any pulse to be wider than the glitch width.
+   */
+  constexpr i64 no_change = -(static_cast<i64>(1) << 62);
+
+  /**
+   * @brief Builds the tables of a timed schedule from the gates.
+   *
+   * Marks the schedule full. The events are scheduled by the next
+   * evaluation.
+   */
+  void build_timing(Timed_Schedule& timing, List<Gate>& gates);
+
+  /**
+   * @brief Drops the pending events, schedules the next toggle of every
+   * clock after the time of the schedule and the evaluation of every other
+   * gate except inputs at the next tick.
+   */
+  void restart_timing(Timed_Schedule& timing);
+} // namespace nebula
@@ -0,0 +1,422 @@
+#include <importer/builder.hpp>
+
+#include <logging/logging.hpp>
+
+// Reader of the Berkeley Logic Interchange Format. Only flat models are
+// supported, that is .inputs, .outputs, .clock, .names and edge-triggered
+// .latch.
+
+namespace nebula {
+  // Cover
+  //
+  // The single-output cover of the .names currently being read. Rows are
+  // stored back to back, each row being inputs.size() characters long.
+  //
+  struct Cover {
+    Array<u32> inputs;
+    Array<char> rows;
+    u32 out = invalid_net;
+    i64 row_count = 0;
+    // The output column of the rows. BLIF requires all rows of a cover to have
+    // the same output value.
+    char phase = '1';
+    bool active = false;
+  };
+
+  // Two-input truth tables indexed by (in1 | in2 << 1) and the gate that
+  // implements them directly.
+  struct Table_Entry {
+    u8 table;
+    Gate_Kind kind;
+  };
+
+  static constexpr Table_Entry two_input_tables[] = {
+    {0b1000, Gate_Kind::e_and},  {0b1110, Gate_Kind::e_or},
+    {0b0110, Gate_Kind::e_xor},  {0b0111, Gate_Kind::e_nand},
+    {0b0001, Gate_Kind::e_nor},  {0b1001, Gate_Kind::e_xnor},
+  };
+
+  [[nodiscard]] static bool row_matches(char const* const row, i64 const width,
+                                        u32 const minterm)
+  {
+    for(i64 i = 0; i < width; ++i) {
+      bool const bit = (minterm >> i) & 1;
+      if((row[i] == '1' && !bit) || (row[i] == '0' && bit)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  [[nodiscard]] static Expected<void, Error>
+  propagate(Expected<u32, Error> result)
+  {
+    if(result) {
+      return expected_value;
+    }
+    return {expected_error, ANTON_MOV(result.error())};
+  }
+
+  // emit_small_cover
+  //
+  // Attempt to implement a cover of at most two inputs with a single gate or a
+  // constant.
+  //
+  // Returns:
+  // true if the cover has been emitted.
+  //
+  [[nodiscard]] static Expected<bool, Error>
+  emit_small_cover(Netlist_Builder& builder, Cover const& cover)
+  {
+    i64 const width = cover.inputs.size();
+    u32 const minterms = 1u << width;
+    u32 table = 0;
+    for(u32 minterm = 0; minterm < minterms; ++minterm) {
+      for(i64 row = 0; row < cover.row_count; ++row) {
+        if(row_matches(cover.rows.data() + row * width, width, minterm)) {
+          table |= 1u << minterm;
+          break;
+        }
+      }
+    }
+
+    u32 const mask = (1u << minterms) - 1;
+    if(cover.phase == '0') {
+      table = ~table & mask;
+    }
+
+    if(table == 0 || table == mask) {
+      Expected<u32, Error> result = builder.add_constant(table != 0, cover.out);
+      if(!result) {
+        return {expected_error, ANTON_MOV(result.error())};
+      }
+      return {expected_value, true};
+    }
+
+    if(width == 1 && table == 0b01) {
+      u32 const inputs[] = {cover.inputs[0]};
+      Expected<u32, Error> result =
+        builder.add_gate(Gate_Kind::e_not, inputs, cover.out);
+      if(!result) {
+        return {expected_error, ANTON_MOV(result.error())};
+      }
+      return {expected_value, true};
+    }
+
+    if(width == 2) {
+      for(Table_Entry const& entry: two_input_tables) {
+        if(entry.table != table) {
+          continue;
+        }
+
+        u32 const inputs[] = {cover.inputs[0], cover.inputs[1]};
+        Expected<u32, Error> result =
+          builder.add_gate(entry.kind, inputs, cover.out);
+        if(!result) {
+          return {expected_error, ANTON_MOV(result.error())};
+        }
+        return {expected_value, true};
+      }
+    }
+
+    return {expected_value, false};
+  }
+
+  // emit_cover
+  //
+  // Implement a cover as a sum of products. Each row becomes an AND of its
+  // literals and the rows are combined with an OR, or a NOR for covers of the
+  // off-set.
+  //
+  [[nodiscard]] static Expected<void, Error> emit_cover(Netlist_Builder& builder,
+                                                       Cover const& cover)
+  {
+    i64 const width = cover.inputs.size();
+    if(width <= 2) {
+      Expected<bool, Error> result = emit_small_cover(builder, cover);
+      if(!result) {
+        return {expected_error, ANTON_MOV(result.error())};
+      }
+
+      if(result.value()) {
+        return expected_value;
+      }
+    }
+
+    if(cover.row_count == 0) {
+      return propagate(builder.add_constant(cover.phase == '0', cover.out));
+    }
+
+    Array<u32> terms;
+    Array<u32> literals;
+    for(i64 row = 0; row < cover.row_count; ++row) {
+      char const* const cube = cover.rows.data() + row * width;
+      literals.clear();
+      for(i64 i = 0; i < width; ++i) {
+        if(cube[i] == '1') {
+          literals.push_back(cover.inputs[i]);
+        } else if(cube[i] == '0') {
+          Expected<u32, Error> result = builder.get_inverted(cover.inputs[i]);
+          if(!result) {
+            return {expected_error, ANTON_MOV(result.error())};
+          }
+          literals.push_back(result.value());
+        }
+      }
+
+      if(literals.size() == 0) {
+        // The row covers every minterm.
+        return propagate(builder.add_constant(cover.phase == '1', cover.out));
+      }
+
+      if(literals.size() == 1) {
+        terms.push_back(literals[0]);
+      } else {
+        Expected<u32, Error> result = builder.reduce(
+          Gate_Kind::e_and, Gate_Kind::e_and, literals, invalid_net);
+        if(!result) {
+          return {expected_error, ANTON_MOV(result.error())};
+        }
+        terms.push_back(result.value());
+      }
+    }
+
+    Gate_Kind const root =
+      cover.phase == '1' ? Gate_Kind::e_or : Gate_Kind::e_nor;
+    return propagate(builder.reduce(Gate_Kind::e_or, root, terms, cover.out));
+  }
+
+  [[nodiscard]] static Expected<void, Error> flush_cover(Netlist_Builder& builder,
+                                                        Cover& cover)
+  {
+    if(!cover.active) {
+      return expected_value;
+    }
+
+    cover.active = false;
+    return emit_cover(builder, cover);
+  }
+
+  [[nodiscard]] static Expected<void, Error>
+  read_cover_row(Cover& cover, Slice<String_View const> const tokens)
+  {
+    if(!cover.active) {
+      return {expected_error, Error("cover row outside of .names")};
+    }
+
+    i64 const width = cover.inputs.size();
+    String_View output;
+    if(width == 0) {
+      if(tokens.size() != 1) {
+        return {expected_error, Error("malformed constant cover row")};
+      }
+      output = tokens[0];
+    } else {
+      if(tokens.size() != 2 || tokens[0].size_bytes() != width) {
+        return {expected_error,
+                format("cover row must have {} input columns", width)};
+      }
+
+      char const* const row = tokens[0].data();
+      for(i64 i = 0; i < width; ++i) {
+        if(row[i] != '0' && row[i] != '1' && row[i] != '-') {
+          return {expected_error, Error("invalid character in cover row")};
+        }
+      }
+
+      i64 const offset = cover.rows.size();
+      cover.rows.resize(offset + width);
+      memcpy(cover.rows.data() + offset, tokens[0].data(), width);
+      output = tokens[1];
+    }
+
+    if(output.size_bytes() != 1 ||
+       (output.data()[0] != '0' && output.data()[0] != '1')) {
+      return {expected_error, Error("invalid output column in cover row")};
+    }
+
+    char const phase = output.data()[0];
+    if(cover.row_count > 0 && phase != cover.phase) {
+      return {expected_error, Error("cover mixes on-set and off-set rows")};
+    }
+
+    cover.phase = phase;
+    cover.row_count += 1;
+    return expected_value;
+  }
+
+  // read_latch
+  //
+  // Read '.latch <input> <output> [<type> <control>] [<init>]' as a D
+  // flip-flop. Rising and falling edge triggered latches are supported, the
+  // latter by clocking the flip-flop with the inverted control. A latch
+  // without a control or with the control NIL is clocked by the first
+  // .clock. Initial values other than 1 start at 0.
+  //
+  [[nodiscard]] static Expected<void, Error>
+  read_latch(Netlist_Builder& builder, u32 const default_clock,
+             Slice<String_View const> const tokens)
+  {
+    if(tokens.size() < 3 || tokens.size() > 6) {
+      return {expected_error, Error(".latch requires an input and an output")};
+    }
+
+    u32 const d = builder.intern(tokens[1]);
+    u32 const out = builder.intern(tokens[2]);
+    bool const has_control = tokens.size() >= 5;
+    String_View const type = has_control ? tokens[3] : "re"_sv;
+    bool const value =
+      (tokens.size() == 4 || tokens.size() == 6) &&
+      tokens[tokens.size() - 1] == "1"_sv;
+    if(type != "re"_sv && type != "fe"_sv) {
+      return {expected_error, format("'{}' latches are not supported", type)};
+    }
+
+    u32 clock = default_clock;
+    if(has_control && tokens[4] != "NIL"_sv) {
+      clock = builder.intern(tokens[4]);
+    }
+    if(clock == invalid_net) {
+      return {expected_error,
+              Error(".latch without a control requires a .clock")};
+    }
+
+    if(type == "fe"_sv) {
+      Expected<u32, Error> inverted = builder.get_inverted(clock);
+      if(!inverted) {
+        return {expected_error, ANTON_MOV(inverted.error())};
+      }
+      clock = inverted.value();
+    }
+    return propagate(builder.add_flip_flop(d, clock, value, out));
+  }
+
+  [[nodiscard]] static Expected<void, Error>
+  read_directive(Netlist_Builder& builder, Cover& cover, u32& default_clock,
+                 bool& model_seen, bool& ended,
+                 Slice<String_View const> const tokens)
+  {
+    String_View const directive = tokens[0];
+    if(directive == ".model"_sv) {
+      if(model_seen) {
+        return {expected_error,
+                Error("multiple models are not supported, flatten the design")};
+      }
+      model_seen = true;
+    } else if(directive == ".inputs"_sv) {
+      for(i64 i = 1; i < tokens.size(); ++i) {
+        u32 const net = builder.intern(tokens[i]);
+        Expected<u32, Error> result =
+          builder.add_source(Gate_Kind::e_input, net);
+        if(!result) {
+          return {expected_error, ANTON_MOV(result.error())};
+        }
+      }
+    } else if(directive == ".clock"_sv) {
+      for(i64 i = 1; i < tokens.size(); ++i) {
+        u32 const net = builder.intern(tokens[i]);
+        Expected<u32, Error> result = builder.add_clock(net);
+        if(!result) {
+          return {expected_error, ANTON_MOV(result.error())};
+        }
+        if(default_clock == invalid_net) {
+          default_clock = net;
+        }
+      }
+    } else if(directive == ".outputs"_sv) {
+      // Outputs are ordinary nets driven by gates.
+    } else if(directive == ".names"_sv) {
+      if(tokens.size() < 2) {
+        return {expected_error, Error(".names requires an output")};
+      }
+
+      cover.inputs.clear();
+      cover.rows.clear();
+      cover.row_count = 0;
+      cover.phase = '1';
+      cover.active = true;
+      for(i64 i = 1; i < tokens.size() - 1; ++i) {
+        cover.inputs.push_back(builder.intern(tokens[i]));
+      }
+      cover.out = builder.intern(tokens[tokens.size() - 1]);
+    } else if(directive == ".end"_sv || directive == ".exdc"_sv) {
+      // The external don't care network that might follow .exdc does not
+      // contribute to the circuit.
+      ended = true;
+    } else if(directive == ".latch"_sv) {
+      return read_latch(builder, default_clock, tokens);
+    } else if(directive == ".mlatch"_sv ||
+              directive == ".subckt"_sv || directive == ".gate"_sv ||
+              directive == ".search"_sv) {
+      return {expected_error, format("'{}' is not supported", directive)};
+    } else {
+      LOG_WARNING("ignoring unknown BLIF directive '{}'", directive);
+    }
+    return expected_value;
+  }
+
+  Expected<void, Error> import_blif(Netlist_Builder& builder,
+                                    Line_Reader& reader)
+  {
+    Cover cover;
+    Array<String_View> tokens;
+    // Logical line assembled from physical lines joined by a backslash.
+    Array<char> logical;
+    // Clock of the latches without a control.
+    u32 default_clock = invalid_net;
+    bool model_seen = false;
+    bool ended = false;
+    String_View line;
+    while(!ended && reader.next_line(line)) {
+      // Strip comments.
+      char const* end = line.data();
+      char const* const line_end = line.data() + line.size_bytes();
+      while(end != line_end && *end != '#') {
+        ++end;
+      }
+
+      // Join continued lines.
+      bool const continued = end != line.data() && *(end - 1) == '\\';
+      if(continued || logical.size() > 0) {
+        char const* const copy_end = continued ? end - 1 : end;
+        i64 const offset = logical.size();
+        logical.resize(offset + (copy_end - line.data()));
+        memcpy(logical.data() + offset, line.data(), copy_end - line.data());
+        // Keep the tokens on both sides of the join separate.
+        logical.push_back(' ');
+        if(continued) {
+          continue;
+        }
+        split_whitespace(String_View(logical.data(), logical.size()), tokens);
+        logical.clear();
+      } else {
+        split_whitespace(String_View(line.data(), end), tokens);
+      }
+
+      if(tokens.size() == 0) {
+        continue;
+      }
+
+      if(tokens[0].data()[0] == '.') {
+        Expected<void, Error> flush_result = flush_cover(builder, cover);
+        if(!flush_result) {
+          return flush_result;
+        }
+
+        Expected<void, Error> result =
+          read_directive(builder, cover, default_clock, model_seen, ended,
+                         tokens);
+        if(!result) {
+          return result;
+        }
+      } else {
+        Expected<void, Error> result = read_cover_row(cover, tokens);
+        if(!result) {
+          return result;
+        }
+      }
+    }
+
+    return flush_cover(builder, cover);
+  }
+} // namespace nebula
@@ -0,0 +1,236 @@
+#pragma once
+
+#include <anton/array.hpp>
+#include <anton/expected.hpp>
+#include <anton/filesystem.hpp>
+#include <anton/flat_hash_map.hpp>
+#include <anton/slice.hpp>
+#include <anton/string_view.hpp>
+
+#include <core/error.hpp>
+#include <core/types.hpp>
+#include <model/gate.hpp>
+
+// Internal interface shared by the format specific parsers of the importer.
+
+namespace nebula {
+  struct Scene;
+
+  /**
+   * @brief Reads a file line by line through a fixed-size buffer.
+   *
+   * Lines are returned as views that remain valid until the next call to
+   * next_line. Lines that straddle two chunks are stitched together in a
+   * separate carry buffer, hence a line may be arbitrarily long without
+   * growing the chunk buffer.
+   */
+  struct Line_Reader {
+  public:
+    explicit Line_Reader(String const& path);
+
+    /**
+     * @brief Checks whether the file has been opened successfully.
+     */
+    [[nodiscard]] bool is_open() const;
+
+    /**
+     * @brief Retrieves the next line without the line terminator.
+     *
+     * @param line Receives the line.
+     * @return false if the end of the file has been reached.
+     */
+    [[nodiscard]] bool next_line(String_View& line);
+
+    /**
+     * @brief Number of lines returned so far.
+     */
+    [[nodiscard]] i64 get_line_number() const;
+
+  private:
+    void refill();
+
+    fs::Input_File_Stream file;
+    Array<char> chunk;
+    Array<char> carry;
+    i64 remaining = 0;
+    i64 head = 0;
+    i64 end = 0;
+    i64 line_number = 0;
+  };
+
+  // invalid_net
+  //
+  // Sentinel net identifier.
+  //
+  constexpr u32 invalid_net = static_cast<u32>(-1);
+
+  /**
+   * @brief Interns net names.
+   *
+   * Names are stored back to back in a single arena. The map stores the hash
+   * of a name and the first net with that hash. Nets with colliding hashes are
+   * chained through next_same_hash.
+   */
+  struct Net_Table {
+  public:
+    /**
+     * @brief Retrieves the net of a name, creating it if necessary.
+     */
+    [[nodiscard]] u32 intern(String_View name);
+
+    /**
+     * @brief Creates a new net without a name.
+     */
+    [[nodiscard]] u32 create_anonymous();
+
+    [[nodiscard]] String_View get_name(u32 net) const;
+    [[nodiscard]] i64 size() const;
+
+  private:
+    struct Net {
+      i64 name_offset;
+      i64 name_size;
+      u32 next_same_hash;
+    };
+
+    Flat_Hash_Map<u64, u32> buckets;
+    Array<Net> nets;
+    Array<char> names;
+  };
+
+  /**
+   * @brief Records the gates of a netlist and builds them in a scene.
+   *
+   * Gates may reference nets before their drivers are known, therefore
+   * parsing only records gates in a compact form. The scene is modified in
+   * build after the whole file has been parsed successfully, which leaves the
+   * scene untouched when the import fails.
+   */
+  struct Netlist_Builder {
+  public:
+    [[nodiscard]] u32 intern(String_View name);
+
+    /**
+     * @brief Adds a gate that drives out and reads the given nets.
+     *
+     * @param kind The kind of the gate. Must be a one- or two-input kind and
+     * the number of inputs must match.
+     * @param inputs The nets connected to the in ports of the gate.
+     * @param out The net driven by the gate. If invalid_net, a new anonymous
+     * net is created.
+     * @return The net driven by the gate or an error if out already has a
+     * driver.
+     */
+    [[nodiscard]] Expected<u32, Error>
+    add_gate(Gate_Kind kind, Slice<u32 const> inputs, u32 out);
+
+    /**
+     * @brief Adds an input gate that drives out.
+     *
+     * @param kind e_input or e_clock.
+     */
+    [[nodiscard]] Expected<u32, Error> add_source(Gate_Kind kind, u32 out);
+
+    /**
+     * @brief Makes out a clock.
+     *
+     * Netlists may declare a clock as an input as well. If out is already
+     * driven by an input gate, the gate becomes a clock, otherwise a new clock
+     * gate is added.
+     */
+    [[nodiscard]] Expected<u32, Error> add_clock(u32 out);
+
+    /**
+     * @brief Adds a constant driver of the given value.
+     *
+     * Constants are input gates with their value preset.
+     */
+    [[nodiscard]] Expected<u32, Error> add_constant(bool value, u32 out);
+
+    /**
+     * @brief Adds a gate that copies in to out.
+     *
+     * The gate set has no buffer, therefore buffers are AND gates with both
+     * inputs tied together.
+     */
+    [[nodiscard]] Expected<u32, Error> add_buffer(u32 in, u32 out);
+
+    /**
+     * @brief Adds a D flip-flop that stores d on the rising edge of clock.
+     *
+     * The enable and reset inputs of the flip-flop are left unconnected.
+     *
+     * @param value The initial value of the flip-flop.
+     */
+    [[nodiscard]] Expected<u32, Error> add_flip_flop(u32 d, u32 clock,
+                                                     bool value, u32 out);
+
+    /**
+     * @brief Retrieves the inverse of a net, creating a NOT gate on the first
+     * request. Subsequent requests for the same net share the gate.
+     */
+    [[nodiscard]] Expected<u32, Error> get_inverted(u32 net);
+
+    /**
+     * @brief Reduces nets with a tree of two-input gates.
+     *
+     * The inputs are combined pairwise in a balanced tree by base. The root of
+     * the tree is a root gate, which allows building n-input NAND from AND and
+     * NAND. A single input is copied with a buffer, or a NOT gate when the root
+     * inverts.
+     *
+     * @param base The kind of the inner gates.
+     * @param root The kind of the root gate.
+     * @param inputs Nets to reduce. Must not be empty.
+     * @param out The net driven by the root or invalid_net.
+     */
+    [[nodiscard]] Expected<u32, Error> reduce(Gate_Kind base, Gate_Kind root,
+                                              Slice<u32 const> inputs,
+                                              u32 out);
+
+    /**
+     * @brief Creates the recorded gates in a scene and connects them.
+     *
+     * Gates are laid out in columns starting at the origin. Sinks of nets
+     * without a driver are left unconnected and reported as a warning. Only
+     * the first two inputs of a gate are recorded, the remaining inputs are
+     * left unconnected.
+     *
+     * @param scene The scene to add the gates to.
+     * @param gate_dimensions The dimensions of the created gates.
+     */
+    void build(Scene& scene, Vec2 gate_dimensions);
+
+    [[nodiscard]] i64 get_gate_count() const;
+    [[nodiscard]] i64 get_net_count() const;
+
+  private:
+    struct Gate_Record {
+      u32 inputs[2];
+      u32 out;
+      Gate_Kind kind;
+      // Value of a constant or the initial value of a flip-flop.
+      bool value;
+    };
+
+    [[nodiscard]] Expected<u32, Error> record(Gate_Record const& gate);
+
+    Net_Table nets;
+    Array<Gate_Record> gates;
+    // Index of the record driving a net. Indexed by net.
+    Array<u32> drivers;
+    Flat_Hash_Map<u64, u32> inverted;
+  };
+
+  /**
+   * @brief Splits a line into whitespace separated tokens.
+   *
+   * @param tokens Cleared, then receives the tokens.
+   */
+  void split_whitespace(String_View line, Array<String_View>& tokens);
+
+  [[nodiscard]] Expected<void, Error> import_blif(Netlist_Builder& builder,
+                                                  Line_Reader& reader);
+  [[nodiscard]] Expected<void, Error> import_verilog(Netlist_Builder& builder,
+                                                     Line_Reader& reader);
+} // namespace nebula
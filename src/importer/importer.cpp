@@ -0,0 +1,446 @@
+#include <importer/importer.hpp>
+
+#include <anton/math/math.hpp>
+
+#include <core/time.hpp>
+#include <importer/builder.hpp>
+#include <logging/logging.hpp>
+#include <ui/scene.hpp>
+
+namespace nebula {
+  // Size of the chunks the file is read in.
+  constexpr i64 chunk_size = 64 * 1024;
+  // Number of gates in a single column of the initial layout.
+  constexpr i64 gates_per_column = 64;
+
+  Line_Reader::Line_Reader(String const& path): file(path)
+  {
+    if(!file.is_open()) {
+      return;
+    }
+
+    file.seek(Seek_Dir::end, 0);
+    remaining = file.tell();
+    file.seek(Seek_Dir::beg, 0);
+    chunk.resize(chunk_size);
+  }
+
+  bool Line_Reader::is_open() const
+  {
+    return file.is_open();
+  }
+
+  void Line_Reader::refill()
+  {
+    i64 const size = math::min(remaining, chunk_size);
+    file.read(chunk.data(), size);
+    remaining -= size;
+    head = 0;
+    end = size;
+  }
+
+  [[nodiscard]] static String_View trim_carriage_return(String_View const line)
+  {
+    char const* const begin = line.data();
+    char const* last = line.data() + line.size_bytes();
+    if(last != begin && *(last - 1) == '\r') {
+      last -= 1;
+    }
+    return String_View(begin, last);
+  }
+
+  bool Line_Reader::next_line(String_View& line)
+  {
+    carry.clear();
+    bool carried = false;
+    while(true) {
+      if(head == end) {
+        if(remaining == 0) {
+          if(!carried) {
+            return false;
+          }
+
+          line = trim_carriage_return(
+            String_View(carry.data(), carry.data() + carry.size()));
+          line_number += 1;
+          return true;
+        }
+        refill();
+      }
+
+      char* const begin = chunk.data() + head;
+      char* const last = chunk.data() + end;
+      char* newline = begin;
+      while(newline != last && *newline != '\n') {
+        ++newline;
+      }
+
+      i64 const length = newline - begin;
+      if(carried || newline == last) {
+        i64 const offset = carry.size();
+        carry.resize(offset + length);
+        memcpy(carry.data() + offset, begin, length);
+      }
+
+      if(newline == last) {
+        carried = true;
+        head = end;
+        continue;
+      }
+
+      head += length + 1;
+      line_number += 1;
+      if(carried) {
+        line = trim_carriage_return(
+          String_View(carry.data(), carry.data() + carry.size()));
+      } else {
+        line = trim_carriage_return(String_View(begin, newline));
+      }
+      return true;
+    }
+  }
+
+  i64 Line_Reader::get_line_number() const
+  {
+    return line_number;
+  }
+
+  u32 Net_Table::intern(String_View const name)
+  {
+    u64 const h = anton::hash(name);
+    auto bucket = buckets.find(h);
+    u32 head = invalid_net;
+    if(bucket != buckets.end()) {
+      head = bucket->value;
+      for(u32 net = head; net != invalid_net; net = nets[net].next_same_hash) {
+        if(get_name(net) == name) {
+          return net;
+        }
+      }
+    }
+
+    u32 const net = nets.size();
+    i64 const offset = names.size();
+    names.resize(offset + name.size_bytes());
+    memcpy(names.data() + offset, name.data(), name.size_bytes());
+    nets.push_back(Net{offset, name.size_bytes(), head});
+    if(bucket != buckets.end()) {
+      bucket->value = net;
+    } else {
+      buckets.emplace(h, net);
+    }
+    return net;
+  }
+
+  u32 Net_Table::create_anonymous()
+  {
+    u32 const net = nets.size();
+    nets.push_back(Net{0, 0, invalid_net});
+    return net;
+  }
+
+  String_View Net_Table::get_name(u32 const net) const
+  {
+    Net const& n = nets[net];
+    return String_View(names.data() + n.name_offset, n.name_size);
+  }
+
+  i64 Net_Table::size() const
+  {
+    return nets.size();
+  }
+
+  u32 Netlist_Builder::intern(String_View const name)
+  {
+    return nets.intern(name);
+  }
+
+  Expected<u32, Error> Netlist_Builder::record(Gate_Record const& gate)
+  {
+    u32 const out = gate.out == invalid_net ? nets.create_anonymous() : gate.out;
+    if(drivers.size() <= out) {
+      drivers.resize(nets.size(), invalid_net);
+    }
+
+    if(drivers[out] != invalid_net) {
+      return {expected_error,
+              format("net '{}' has multiple drivers", nets.get_name(out))};
+    }
+
+    drivers[out] = gates.size();
+    Gate_Record r = gate;
+    r.out = out;
+    gates.push_back(r);
+    return {expected_value, out};
+  }
+
+  Expected<u32, Error> Netlist_Builder::add_gate(Gate_Kind const kind,
+                                                 Slice<u32 const> const inputs,
+                                                 u32 const out)
+  {
+    Gate_Record gate{{invalid_net, invalid_net}, out, kind, false};
+    if(kind == Gate_Kind::e_not) {
+      ANTON_ASSERT(inputs.size() == 1, "NOT gate takes 1 input");
+      gate.inputs[0] = inputs[0];
+    } else {
+      ANTON_ASSERT(inputs.size() == 2, "gate takes 2 inputs");
+      gate.inputs[0] = inputs[0];
+      gate.inputs[1] = inputs[1];
+    }
+    return record(gate);
+  }
+
+  Expected<u32, Error> Netlist_Builder::add_source(Gate_Kind const kind,
+                                                   u32 const out)
+  {
+    ANTON_ASSERT(kind == Gate_Kind::e_input || kind == Gate_Kind::e_clock,
+                 "source must be an input or a clock");
+    return record(Gate_Record{{invalid_net, invalid_net}, out, kind, true});
+  }
+
+  Expected<u32, Error> Netlist_Builder::add_clock(u32 const out)
+  {
+    if(out < drivers.size() && drivers[out] != invalid_net) {
+      Gate_Record& driver = gates[drivers[out]];
+      if(driver.kind == Gate_Kind::e_input) {
+        driver.kind = Gate_Kind::e_clock;
+        return {expected_value, out};
+      }
+    }
+    return add_source(Gate_Kind::e_clock, out);
+  }
+
+  Expected<u32, Error> Netlist_Builder::add_constant(bool const value,
+                                                     u32 const out)
+  {
+    return record(
+      Gate_Record{{invalid_net, invalid_net}, out, Gate_Kind::e_input, value});
+  }
+
+  Expected<u32, Error> Netlist_Builder::add_buffer(u32 const in, u32 const out)
+  {
+    u32 const inputs[] = {in, in};
+    return add_gate(Gate_Kind::e_and, inputs, out);
+  }
+
+  Expected<u32, Error> Netlist_Builder::add_flip_flop(u32 const d,
+                                                      u32 const clock,
+                                                      bool const value,
+                                                      u32 const out)
+  {
+    return record(Gate_Record{{d, clock}, out, Gate_Kind::e_dff, value});
+  }
+
+  Expected<u32, Error> Netlist_Builder::get_inverted(u32 const net)
+  {
+    auto iter = inverted.find(net);
+    if(iter != inverted.end()) {
+      return {expected_value, iter->value};
+    }
+
+    u32 const inputs[] = {net};
+    Expected<u32, Error> result = add_gate(Gate_Kind::e_not, inputs, invalid_net);
+    if(result) {
+      inverted.emplace(net, result.value());
+    }
+    return result;
+  }
+
+  [[nodiscard]] static bool is_inverting(Gate_Kind const kind)
+  {
+    return kind == Gate_Kind::e_nand || kind == Gate_Kind::e_nor ||
+           kind == Gate_Kind::e_xnor || kind == Gate_Kind::e_not;
+  }
+
+  Expected<u32, Error> Netlist_Builder::reduce(Gate_Kind const base,
+                                               Gate_Kind const root,
+                                               Slice<u32 const> const inputs,
+                                               u32 const out)
+  {
+    ANTON_ASSERT(inputs.size() > 0, "cannot reduce empty set of nets");
+    if(inputs.size() == 1) {
+      if(is_inverting(root)) {
+        u32 const operand[] = {inputs[0]};
+        return add_gate(Gate_Kind::e_not, operand, out);
+      } else {
+        return add_buffer(inputs[0], out);
+      }
+    }
+
+    Array<u32> level{anton::reserve, inputs.size()};
+    for(u32 const net: inputs) {
+      level.push_back(net);
+    }
+
+    // Combine pairwise until two nets remain, which are combined by the root.
+    while(level.size() > 2) {
+      i64 write = 0;
+      i64 read = 0;
+      for(; read + 1 < level.size(); read += 2) {
+        u32 const operands[] = {level[read], level[read + 1]};
+        Expected<u32, Error> result = add_gate(base, operands, invalid_net);
+        if(!result) {
+          return result;
+        }
+        level[write] = result.value();
+        write += 1;
+      }
+
+      if(read < level.size()) {
+        level[write] = level[read];
+        write += 1;
+      }
+      level.resize(write);
+    }
+
+    u32 const operands[] = {level[0], level[1]};
+    return add_gate(root, operands, out);
+  }
+
+  void Netlist_Builder::build(Scene& scene, Vec2 const gate_dimensions)
+  {
+    f32 const column_width = gate_dimensions.x * 2.0f;
+    f32 const row_height = gate_dimensions.y * 1.5f;
+    Array<Gate*> created{anton::reserve, gates.size()};
+    for(i64 i = 0; i < gates.size(); ++i) {
+      Gate_Record const& record = gates[i];
+      Vec2 const coordinates{
+        static_cast<f32>(i / gates_per_column) * column_width,
+        static_cast<f32>(i % gates_per_column) * row_height};
+      Gate& gate = scene.add_gate(gate_dimensions, coordinates, record.kind);
+      if(record.kind == Gate_Kind::e_input ||
+         record.kind == Gate_Kind::e_dff) {
+        gate.evaluation = {record.value, record.value};
+      }
+      gate.name = String(nets.get_name(record.out));
+      created.push_back(&gate);
+    }
+
+    i64 undriven = 0;
+    for(i64 i = 0; i < gates.size(); ++i) {
+      Gate_Record const& record = gates[i];
+      Gate& gate = *created[i];
+      i64 const port_count =
+        math::min(gate.in_ports.size(), static_cast<i64>(2));
+      for(i64 port = 0; port < port_count; ++port) {
+        u32 const net = record.inputs[port];
+        u32 const driver =
+          net < drivers.size() ? drivers[net] : static_cast<u32>(invalid_net);
+        if(driver == invalid_net) {
+          undriven += 1;
+          continue;
+        }
+
+        scene.connect_ports(created[driver]->out_ports[0], gate.in_ports[port]);
+      }
+    }
+
+    if(undriven > 0) {
+      LOG_WARNING("{} gate inputs read undriven nets and were left unconnected",
+                  undriven);
+    }
+  }
+
+  i64 Netlist_Builder::get_gate_count() const
+  {
+    return gates.size();
+  }
+
+  i64 Netlist_Builder::get_net_count() const
+  {
+    return nets.size();
+  }
+
+  [[nodiscard]] static bool is_whitespace(char const c)
+  {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\f' ||
+           c == '\v';
+  }
+
+  void split_whitespace(String_View const line, Array<String_View>& tokens)
+  {
+    tokens.clear();
+    char const* i = line.data();
+    char const* const end = line.data() + line.size_bytes();
+    while(i != end) {
+      while(i != end && is_whitespace(*i)) {
+        ++i;
+      }
+
+      char const* const begin = i;
+      while(i != end && !is_whitespace(*i)) {
+        ++i;
+      }
+
+      if(begin != i) {
+        tokens.push_back(String_View(begin, i));
+      }
+    }
+  }
+
+  [[nodiscard]] static bool ends_with(String_View const string,
+                                      String_View const suffix)
+  {
+    if(string.size_bytes() < suffix.size_bytes()) {
+      return false;
+    }
+
+    String_View const tail(string.data() + string.size_bytes() -
+                             suffix.size_bytes(),
+                           suffix.size_bytes());
+    return tail == suffix;
+  }
+
+  Expected<Import_Statistics, Error> import_netlist(Scene& scene,
+                                                    String_View const path,
+                                                    Vec2 const gate_dimensions)
+  {
+    if(ends_with(path, ".blif"_sv)) {
+      return import_netlist(scene, path, Netlist_Format::blif,
+                            gate_dimensions);
+    } else if(ends_with(path, ".v"_sv)) {
+      return import_netlist(scene, path, Netlist_Format::verilog,
+                            gate_dimensions);
+    } else {
+      return {expected_error,
+              format("'{}' has an unknown netlist extension", path)};
+    }
+  }
+
+  Expected<Import_Statistics, Error>
+  import_netlist(Scene& scene, String_View const path,
+                 Netlist_Format const format, Vec2 const gate_dimensions)
+  {
+    f64 const start = get_time();
+    Line_Reader reader{String(path)};
+    if(!reader.is_open()) {
+      return {expected_error, anton::format("could not open '{}'", path)};
+    }
+
+    Netlist_Builder builder;
+    Expected<void, Error> result = format == Netlist_Format::blif
+                                     ? import_blif(builder, reader)
+                                     : import_verilog(builder, reader);
+    if(!result) {
+      return {expected_error, anton::format("{}:{}: {}", path,
+                                            reader.get_line_number(),
+                                            result.error())};
+    }
+
+    builder.build(scene, gate_dimensions);
+
+    Import_Statistics statistics;
+    statistics.lines = reader.get_line_number();
+    statistics.gates = builder.get_gate_count();
+    statistics.nets = builder.get_net_count();
+    statistics.seconds = get_time() - start;
+    if(statistics.seconds > 0.0) {
+      statistics.lines_per_second =
+        static_cast<f64>(statistics.lines) / statistics.seconds;
+    }
+    LOG_INFO("imported '{}': {} lines, {} gates, {} nets in {}s ({} lines/s)",
+             path, statistics.lines, statistics.gates, statistics.nets,
+             statistics.seconds, statistics.lines_per_second);
+    return {expected_value, statistics};
+  }
+} // namespace nebula
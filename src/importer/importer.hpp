@@ -0,0 +1,68 @@
+#pragma once
+
+#include <anton/expected.hpp>
+#include <anton/string_view.hpp>
+
+#include <core/error.hpp>
+#include <core/types.hpp>
+
+namespace nebula {
+  struct Scene;
+
+  /**
+   * @brief Enumeration of the supported netlist formats.
+   */
+  enum struct Netlist_Format {
+    blif,
+    verilog,
+  };
+
+  /**
+   * @brief Summary of a finished import.
+   */
+  struct Import_Statistics {
+    // Number of physical lines read from the file.
+    i64 lines = 0;
+    // Number of gates added to the scene.
+    i64 gates = 0;
+    // Number of distinct nets, including nets synthesised while decomposing
+    // covers and wide primitives.
+    i64 nets = 0;
+    // Wall time of the import in seconds.
+    f64 seconds = 0.0;
+    f64 lines_per_second = 0.0;
+  };
+
+  /**
+   * @brief Imports a netlist file into a scene.
+   *
+   * The format is deduced from the extension of the file. Files ending in
+   * .blif are read as BLIF, files ending in .v as structural Verilog.
+   *
+   * The file is parsed in a single pass over fixed-size chunks, hence memory
+   * use is proportional to the size of the resulting circuit and not to the
+   * size of the file. Gates are laid out on a coarse grid starting at the
+   * origin.
+   *
+   * @param scene The scene to add the gates to.
+   * @param path The path to the netlist file.
+   * @param gate_dimensions The dimensions of the created gates.
+   * @return Import_Statistics on success, otherwise an error message that
+   * contains the offending line.
+   */
+  [[nodiscard]] Expected<Import_Statistics, Error>
+  import_netlist(Scene& scene, String_View path, Vec2 gate_dimensions);
+
+  /**
+   * @brief Imports a netlist file of the given format into a scene.
+   *
+   * @param scene The scene to add the gates to.
+   * @param path The path to the netlist file.
+   * @param format The format of the file.
+   * @param gate_dimensions The dimensions of the created gates.
+   * @return Import_Statistics on success, otherwise an error message.
+   */
+  [[nodiscard]] Expected<Import_Statistics, Error>
+  import_netlist(Scene& scene, String_View path, Netlist_Format format,
+                 Vec2 gate_dimensions);
+} // namespace nebula
@@ -0,0 +1,794 @@
+#include <importer/builder.hpp>
+
+#include <logging/logging.hpp>
+
+// Reader of a gate-level subset of structural Verilog. A file must contain a
+// single module built from the primitives and, or, xor, nand, nor, xnor, not
+// and buf, and from continuous assignments of nets or constants. Inputs marked
+// with the (* clock *) attribute become clocks.
+
+namespace nebula {
+  enum struct Token_Kind : u8 {
+    identifier,
+    number,
+    punctuation,
+    attribute_begin,
+    attribute_end,
+  };
+
+  struct Token {
+    i64 offset;
+    i64 size;
+    Token_Kind kind;
+  };
+
+  // Statement
+  //
+  // Tokens of a statement terminated by a semicolon. The text of the tokens is
+  // copied into a single buffer, therefore a statement may span any number of
+  // lines and chunks.
+  //
+  struct Statement {
+    Array<char> text;
+    Array<Token> tokens;
+
+    void clear()
+    {
+      text.clear();
+      tokens.clear();
+    }
+
+    void push(char const* const begin, char const* const end,
+              Token_Kind const kind)
+    {
+      i64 const offset = text.size();
+      text.resize(offset + (end - begin));
+      memcpy(text.data() + offset, begin, end - begin);
+      tokens.push_back(Token{offset, end - begin, kind});
+    }
+
+    [[nodiscard]] String_View get(i64 const index) const
+    {
+      Token const& token = tokens[index];
+      return String_View(text.data() + token.offset, token.size);
+    }
+  };
+
+  struct Verilog_State {
+    Statement statement;
+    // Nets of the constants 0 and 1 used as terminals.
+    u32 constants[2] = {invalid_net, invalid_net};
+    bool in_block_comment = false;
+    bool module_seen = false;
+    bool module_ended = false;
+  };
+
+  // Cursor
+  //
+  // Sequential access to the tokens of a statement.
+  //
+  struct Cursor {
+    Statement const& statement;
+    i64 index = 0;
+
+    [[nodiscard]] bool done() const
+    {
+      return index >= statement.tokens.size();
+    }
+
+    [[nodiscard]] Token_Kind kind() const
+    {
+      return statement.tokens[index].kind;
+    }
+
+    [[nodiscard]] String_View peek() const
+    {
+      if(done()) {
+        return String_View();
+      }
+      return statement.get(index);
+    }
+
+    [[nodiscard]] bool accept(String_View const text)
+    {
+      if(!done() && statement.get(index) == text) {
+        index += 1;
+        return true;
+      }
+      return false;
+    }
+  };
+
+  [[nodiscard]] static bool is_identifier_begin(char const c)
+  {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+  }
+
+  [[nodiscard]] static bool is_digit(char const c)
+  {
+    return c >= '0' && c <= '9';
+  }
+
+  [[nodiscard]] static bool is_identifier_char(char const c)
+  {
+    return is_identifier_begin(c) || is_digit(c) || c == '$';
+  }
+
+  [[nodiscard]] static bool is_space(char const c)
+  {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v';
+  }
+
+  [[nodiscard]] static bool is_number_char(char const c)
+  {
+    return is_digit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F') ||
+           c == '_' || c == '\'' || c == 'x' || c == 'X' || c == 'z' ||
+           c == 'Z' || c == 'o' || c == 'O' || c == 'h' || c == 'H' ||
+           c == 's' || c == 'S' || c == '?';
+  }
+
+  [[nodiscard]] static Expected<i64, Error> parse_integer(String_View const text)
+  {
+    i64 value = 0;
+    char const* const end = text.data() + text.size_bytes();
+    for(char const* i = text.data(); i != end; ++i) {
+      if(*i == '_') {
+        continue;
+      }
+
+      if(!is_digit(*i)) {
+        return {expected_error, format("'{}' is not an integer", text)};
+      }
+      value = value * 10 + (*i - '0');
+    }
+    return {expected_value, value};
+  }
+
+  // parse_bit
+  //
+  // Parse a single bit constant such as 0, 1, 1'b0 or 1'h1.
+  //
+  [[nodiscard]] static Expected<bool, Error> parse_bit(String_View const text)
+  {
+    char const* const begin = text.data();
+    char const* const end = text.data() + text.size_bytes();
+    char const* digits = begin;
+    for(char const* i = begin; i != end; ++i) {
+      if(*i == '\'') {
+        digits = i + 1;
+        if(digits != end && (*digits == 's' || *digits == 'S')) {
+          ++digits;
+        }
+        // Skip the base.
+        if(digits != end) {
+          ++digits;
+        }
+        break;
+      }
+    }
+
+    bool value = false;
+    bool seen_one = false;
+    for(char const* i = digits; i != end; ++i) {
+      if(*i == '_' || *i == '0') {
+        continue;
+      }
+
+      if(*i == '1' && !seen_one) {
+        seen_one = true;
+        value = true;
+        continue;
+      }
+
+      return {expected_error,
+              format("'{}' is not a single bit constant", text)};
+    }
+    return {expected_value, value};
+  }
+
+  // parse_range
+  //
+  // Parse an optional [msb:lsb] range. is_vector is set to false when the range
+  // is absent, which denotes a scalar.
+  //
+  [[nodiscard]] static Expected<void, Error>
+  parse_range(Cursor& cursor, i64& msb, i64& lsb, bool& is_vector)
+  {
+    is_vector = false;
+    if(!cursor.accept("["_sv)) {
+      return expected_value;
+    }
+
+    Expected<i64, Error> first = parse_integer(cursor.peek());
+    if(!first) {
+      return {expected_error, ANTON_MOV(first.error())};
+    }
+    cursor.index += 1;
+    if(!cursor.accept(":"_sv)) {
+      return {expected_error, Error("expected ':' in range")};
+    }
+
+    Expected<i64, Error> second = parse_integer(cursor.peek());
+    if(!second) {
+      return {expected_error, ANTON_MOV(second.error())};
+    }
+    cursor.index += 1;
+    if(!cursor.accept("]"_sv)) {
+      return {expected_error, Error("expected ']' after range")};
+    }
+
+    msb = first.value();
+    lsb = second.value();
+    is_vector = true;
+    return expected_value;
+  }
+
+  // parse_terminal
+  //
+  // Parse a net reference, i.e. an identifier, a bit-select of a vector or a
+  // single bit constant.
+  //
+  [[nodiscard]] static Expected<u32, Error> parse_terminal(
+    Netlist_Builder& builder, Verilog_State& state, Cursor& cursor)
+  {
+    if(cursor.done()) {
+      return {expected_error, Error("expected a net")};
+    }
+
+    String_View const name = cursor.peek();
+    if(cursor.kind() == Token_Kind::number) {
+      cursor.index += 1;
+      Expected<bool, Error> bit = parse_bit(name);
+      if(!bit) {
+        return {expected_error, ANTON_MOV(bit.error())};
+      }
+
+      u32& constant = state.constants[bit.value()];
+      if(constant == invalid_net) {
+        Expected<u32, Error> result =
+          builder.add_constant(bit.value(), invalid_net);
+        if(!result) {
+          return result;
+        }
+        constant = result.value();
+      }
+      return {expected_value, constant};
+    }
+
+    if(cursor.kind() != Token_Kind::identifier) {
+      return {expected_error, format("expected a net, found '{}'", name)};
+    }
+
+    cursor.index += 1;
+    if(!cursor.accept("["_sv)) {
+      return {expected_value, builder.intern(name)};
+    }
+
+    Expected<i64, Error> bit = parse_integer(cursor.peek());
+    if(!bit) {
+      return {expected_error, ANTON_MOV(bit.error())};
+    }
+    cursor.index += 1;
+    if(!cursor.accept("]"_sv)) {
+      return {expected_error, Error("part-selects are not supported")};
+    }
+
+    String const bit_name = format("{}[{}]", name, bit.value());
+    return {expected_value, builder.intern(bit_name)};
+  }
+
+  [[nodiscard]] static Expected<void, Error>
+  read_declaration(Netlist_Builder& builder, Cursor& cursor,
+                   String_View const direction, bool const clock)
+  {
+    if(direction == "inout"_sv) {
+      return {expected_error, Error("inout ports are not supported")};
+    }
+
+    // Net types carry no information for gate-level netlists.
+    (void)(cursor.accept("wire"_sv) || cursor.accept("reg"_sv));
+
+    i64 msb = 0;
+    i64 lsb = 0;
+    bool is_vector = false;
+    Expected<void, Error> range = parse_range(cursor, msb, lsb, is_vector);
+    if(!range) {
+      return range;
+    }
+
+    bool const is_input = direction == "input"_sv;
+    while(!cursor.done() && cursor.kind() == Token_Kind::identifier) {
+      String_View const name = cursor.peek();
+      // Stop at the direction of the next ANSI port declaration.
+      if(name == "input"_sv || name == "output"_sv || name == "inout"_sv) {
+        break;
+      }
+
+      cursor.index += 1;
+      if(is_input) {
+        Gate_Kind const kind = clock ? Gate_Kind::e_clock : Gate_Kind::e_input;
+        if(!is_vector) {
+          Expected<u32, Error> result =
+            builder.add_source(kind, builder.intern(name));
+          if(!result) {
+            return {expected_error, ANTON_MOV(result.error())};
+          }
+        } else {
+          i64 const step = msb >= lsb ? -1 : 1;
+          for(i64 bit = msb;; bit += step) {
+            String const bit_name = format("{}[{}]", name, bit);
+            Expected<u32, Error> result =
+              builder.add_source(kind, builder.intern(bit_name));
+            if(!result) {
+              return {expected_error, ANTON_MOV(result.error())};
+            }
+
+            if(bit == lsb) {
+              break;
+            }
+          }
+        }
+      }
+
+      if(!cursor.accept(","_sv)) {
+        break;
+      }
+    }
+    return expected_value;
+  }
+
+  [[nodiscard]] static Expected<void, Error>
+  read_module_header(Netlist_Builder& builder, Verilog_State& state,
+                     Cursor& cursor)
+  {
+    if(state.module_seen) {
+      return {expected_error,
+              Error("multiple modules are not supported, flatten the design")};
+    }
+    state.module_seen = true;
+
+    // Module name.
+    cursor.index += 1;
+    if(!cursor.accept("("_sv)) {
+      return expected_value;
+    }
+
+    bool clock = false;
+    while(!cursor.done() && !cursor.accept(")"_sv)) {
+      if(cursor.kind() == Token_Kind::attribute_begin) {
+        while(!cursor.done() && cursor.kind() != Token_Kind::attribute_end) {
+          clock = clock || cursor.peek() == "clock"_sv;
+          cursor.index += 1;
+        }
+        cursor.index += 1;
+        continue;
+      }
+
+      String_View const token = cursor.peek();
+      if(token == "input"_sv || token == "output"_sv || token == "inout"_sv) {
+        cursor.index += 1;
+        Expected<void, Error> result =
+          read_declaration(builder, cursor, token, clock);
+        if(!result) {
+          return result;
+        }
+        clock = false;
+      } else {
+        // Non-ANSI port list. Directions are declared in the module body.
+        cursor.index += 1;
+        (void)cursor.accept(","_sv);
+      }
+    }
+    return expected_value;
+  }
+
+  // read_assigned
+  //
+  // Parse the right-hand side of an assignment, a net or a single bit
+  // constant, and drive the net on the left-hand side with it.
+  //
+  [[nodiscard]] static Expected<void, Error>
+  read_assigned(Netlist_Builder& builder, Verilog_State& state, Cursor& cursor,
+                u32 const lhs)
+  {
+    if(!cursor.done() && cursor.kind() == Token_Kind::number) {
+      Expected<bool, Error> bit = parse_bit(cursor.peek());
+      if(!bit) {
+        return {expected_error, ANTON_MOV(bit.error())};
+      }
+      cursor.index += 1;
+      Expected<u32, Error> result = builder.add_constant(bit.value(), lhs);
+      if(!result) {
+        return {expected_error, ANTON_MOV(result.error())};
+      }
+    } else {
+      Expected<u32, Error> rhs = parse_terminal(builder, state, cursor);
+      if(!rhs) {
+        return {expected_error, ANTON_MOV(rhs.error())};
+      }
+      Expected<u32, Error> result = builder.add_buffer(rhs.value(), lhs);
+      if(!result) {
+        return {expected_error, ANTON_MOV(result.error())};
+      }
+    }
+    return expected_value;
+  }
+
+  [[nodiscard]] static Expected<void, Error>
+  read_assign(Netlist_Builder& builder, Verilog_State& state, Cursor& cursor)
+  {
+    while(!cursor.done()) {
+      Expected<u32, Error> lhs = parse_terminal(builder, state, cursor);
+      if(!lhs) {
+        return {expected_error, ANTON_MOV(lhs.error())};
+      }
+
+      if(!cursor.accept("="_sv)) {
+        return {expected_error, Error("expected '=' in assignment")};
+      }
+
+      Expected<void, Error> result =
+        read_assigned(builder, state, cursor, lhs.value());
+      if(!result) {
+        return result;
+      }
+
+      if(!cursor.accept(","_sv)) {
+        break;
+      }
+    }
+
+    if(!cursor.done()) {
+      return {expected_error,
+              Error("only assignments of nets and constants are supported")};
+    }
+    return expected_value;
+  }
+
+  // read_net_declaration
+  //
+  // Read a wire, supply0 or supply1 statement. Wires are created on first
+  // use, hence only their assignments are read. Supply nets are driven by
+  // constants.
+  //
+  [[nodiscard]] static Expected<void, Error>
+  read_net_declaration(Netlist_Builder& builder, Verilog_State& state,
+                       Cursor& cursor, String_View const keyword)
+  {
+    i64 msb = 0;
+    i64 lsb = 0;
+    bool is_vector = false;
+    Expected<void, Error> range = parse_range(cursor, msb, lsb, is_vector);
+    if(!range) {
+      return range;
+    }
+
+    bool const supply = keyword != "wire"_sv;
+    bool const value = keyword == "supply1"_sv;
+    while(!cursor.done() && cursor.kind() == Token_Kind::identifier) {
+      String_View const name = cursor.peek();
+      cursor.index += 1;
+      if(supply && !is_vector) {
+        Expected<u32, Error> result =
+          builder.add_constant(value, builder.intern(name));
+        if(!result) {
+          return {expected_error, ANTON_MOV(result.error())};
+        }
+      } else if(supply) {
+        i64 const step = msb >= lsb ? -1 : 1;
+        for(i64 bit = msb;; bit += step) {
+          String const bit_name = format("{}[{}]", name, bit);
+          Expected<u32, Error> result =
+            builder.add_constant(value, builder.intern(bit_name));
+          if(!result) {
+            return {expected_error, ANTON_MOV(result.error())};
+          }
+
+          if(bit == lsb) {
+            break;
+          }
+        }
+      }
+
+      if(cursor.accept("="_sv)) {
+        if(supply || is_vector) {
+          return {expected_error,
+                  format("assignments in declarations of {} are not "
+                         "supported",
+                         supply ? keyword : "vectors"_sv)};
+        }
+
+        Expected<void, Error> result =
+          read_assigned(builder, state, cursor, builder.intern(name));
+        if(!result) {
+          return result;
+        }
+      }
+
+      if(!cursor.accept(","_sv)) {
+        break;
+      }
+    }
+
+    if(!cursor.done()) {
+      return {expected_error,
+              format("unexpected '{}' in {} declaration", cursor.peek(),
+                     keyword)};
+    }
+    return expected_value;
+  }
+
+  struct Primitive {
+    String_View name;
+    // The kind of the inner gates of a reduction tree.
+    Gate_Kind base;
+    // The kind of the root of a reduction tree.
+    Gate_Kind root;
+  };
+
+  // buf and not have any number of outputs followed by a single input. The
+  // remaining primitives have a single output followed by the inputs.
+  static Primitive const primitives[] = {
+    {"and"_sv, Gate_Kind::e_and, Gate_Kind::e_and},
+    {"or"_sv, Gate_Kind::e_or, Gate_Kind::e_or},
+    {"xor"_sv, Gate_Kind::e_xor, Gate_Kind::e_xor},
+    {"nand"_sv, Gate_Kind::e_and, Gate_Kind::e_nand},
+    {"nor"_sv, Gate_Kind::e_or, Gate_Kind::e_nor},
+    {"xnor"_sv, Gate_Kind::e_xor, Gate_Kind::e_xnor},
+    {"not"_sv, Gate_Kind::e_not, Gate_Kind::e_not},
+    {"buf"_sv, Gate_Kind::e_and, Gate_Kind::e_and},
+  };
+
+  [[nodiscard]] static Expected<void, Error>
+  read_primitive(Netlist_Builder& builder, Verilog_State& state,
+                 Cursor& cursor, Primitive const& primitive)
+  {
+    // Delays are irrelevant to the zero-delay evaluator.
+    if(cursor.accept("#"_sv)) {
+      if(cursor.accept("("_sv)) {
+        while(!cursor.done() && !cursor.accept(")"_sv)) {
+          cursor.index += 1;
+        }
+      } else {
+        cursor.index += 1;
+      }
+    }
+
+    Array<u32> terminals;
+    while(!cursor.done()) {
+      // Optional instance name.
+      if(cursor.kind() == Token_Kind::identifier) {
+        cursor.index += 1;
+      }
+
+      if(!cursor.accept("("_sv)) {
+        return {expected_error, format("expected '(' after {}", primitive.name)};
+      }
+
+      terminals.clear();
+      while(true) {
+        Expected<u32, Error> terminal = parse_terminal(builder, state, cursor);
+        if(!terminal) {
+          return {expected_error, ANTON_MOV(terminal.error())};
+        }
+        terminals.push_back(terminal.value());
+        if(cursor.accept(")"_sv)) {
+          break;
+        }
+
+        if(!cursor.accept(","_sv)) {
+          return {expected_error, Error("expected ',' or ')' in terminal list")};
+        }
+      }
+
+      if(terminals.size() < 2) {
+        return {expected_error,
+                format("{} requires at least 2 terminals", primitive.name)};
+      }
+
+      bool const multiple_outputs =
+        primitive.name == "not"_sv || primitive.name == "buf"_sv;
+      if(multiple_outputs) {
+        u32 const in = terminals[terminals.size() - 1];
+        for(i64 i = 0; i < terminals.size() - 1; ++i) {
+          u32 const operand[] = {in};
+          Expected<u32, Error> result =
+            builder.reduce(primitive.base, primitive.root, operand, terminals[i]);
+          if(!result) {
+            return {expected_error, ANTON_MOV(result.error())};
+          }
+        }
+      } else {
+        Slice<u32 const> const inputs(terminals.data() + 1,
+                                      terminals.data() + terminals.size());
+        Expected<u32, Error> result =
+          builder.reduce(primitive.base, primitive.root, inputs, terminals[0]);
+        if(!result) {
+          return {expected_error, ANTON_MOV(result.error())};
+        }
+      }
+
+      if(!cursor.accept(","_sv)) {
+        break;
+      }
+    }
+    return expected_value;
+  }
+
+  [[nodiscard]] static Expected<void, Error>
+  read_statement(Netlist_Builder& builder, Verilog_State& state)
+  {
+    Cursor cursor{state.statement};
+    bool clock = false;
+    while(!cursor.done() && cursor.kind() == Token_Kind::attribute_begin) {
+      while(!cursor.done() && cursor.kind() != Token_Kind::attribute_end) {
+        clock = clock || cursor.peek() == "clock"_sv;
+        cursor.index += 1;
+      }
+      cursor.index += 1;
+    }
+
+    if(cursor.done()) {
+      return expected_value;
+    }
+
+    String_View const keyword = cursor.peek();
+    if(keyword == "module"_sv) {
+      cursor.index += 1;
+      return read_module_header(builder, state, cursor);
+    }
+
+    if(keyword == "endmodule"_sv) {
+      state.module_ended = true;
+      return expected_value;
+    }
+
+    if(!state.module_seen || state.module_ended) {
+      return {expected_error, format("'{}' outside of a module", keyword)};
+    }
+
+    cursor.index += 1;
+    if(keyword == "input"_sv || keyword == "output"_sv ||
+       keyword == "inout"_sv) {
+      return read_declaration(builder, cursor, keyword, clock);
+    }
+
+    if(keyword == "wire"_sv || keyword == "supply0"_sv ||
+       keyword == "supply1"_sv) {
+      return read_net_declaration(builder, state, cursor, keyword);
+    }
+
+    if(keyword == "assign"_sv) {
+      return read_assign(builder, state, cursor);
+    }
+
+    for(Primitive const& primitive: primitives) {
+      if(primitive.name == keyword) {
+        return read_primitive(builder, state, cursor, primitive);
+      }
+    }
+
+    return {expected_error,
+            format("unsupported statement '{}', module instances and "
+                   "behavioural code must be flattened",
+                   keyword)};
+  }
+
+  // lex_line
+  //
+  // Append the tokens of a line to the current statement and read the
+  // statement whenever a semicolon or endmodule completes it.
+  //
+  [[nodiscard]] static Expected<void, Error>
+  lex_line(Netlist_Builder& builder, Verilog_State& state,
+           String_View const line)
+  {
+    char const* i = line.data();
+    char const* const end = line.data() + line.size_bytes();
+    // Compiler directives such as `timescale occupy whole lines.
+    while(i != end && is_space(*i)) {
+      ++i;
+    }
+    if(!state.in_block_comment && i != end && *i == '`') {
+      return expected_value;
+    }
+
+    while(i != end) {
+      if(state.in_block_comment) {
+        while(i != end && !(*i == '*' && i + 1 != end && *(i + 1) == '/')) {
+          ++i;
+        }
+
+        if(i == end) {
+          break;
+        }
+        i += 2;
+        state.in_block_comment = false;
+        continue;
+      }
+
+      char const c = *i;
+      char const next = i + 1 != end ? *(i + 1) : '\0';
+      if(is_space(c)) {
+        ++i;
+      } else if(c == '/' && next == '/') {
+        break;
+      } else if(c == '/' && next == '*') {
+        state.in_block_comment = true;
+        i += 2;
+      } else if(c == '(' && next == '*') {
+        state.statement.push(i, i + 2, Token_Kind::attribute_begin);
+        i += 2;
+      } else if(c == '*' && next == ')') {
+        state.statement.push(i, i + 2, Token_Kind::attribute_end);
+        i += 2;
+      } else if(c == '\\') {
+        // Escaped identifiers extend to the next whitespace.
+        char const* const begin = i + 1;
+        i = begin;
+        while(i != end && !is_space(*i)) {
+          ++i;
+        }
+        state.statement.push(begin, i, Token_Kind::identifier);
+      } else if(is_identifier_begin(c)) {
+        char const* const begin = i;
+        while(i != end && is_identifier_char(*i)) {
+          ++i;
+        }
+        state.statement.push(begin, i, Token_Kind::identifier);
+        if(state.statement.tokens.size() == 1 &&
+           String_View(begin, i) == "endmodule"_sv) {
+          Expected<void, Error> result = read_statement(builder, state);
+          state.statement.clear();
+          if(!result) {
+            return result;
+          }
+        }
+      } else if(is_digit(c) || c == '\'') {
+        char const* const begin = i;
+        while(i != end && is_number_char(*i)) {
+          ++i;
+        }
+        state.statement.push(begin, i, Token_Kind::number);
+      } else if(c == ';') {
+        ++i;
+        Expected<void, Error> result = read_statement(builder, state);
+        state.statement.clear();
+        if(!result) {
+          return result;
+        }
+      } else if(c == '(' || c == ')' || c == ',' || c == '[' || c == ']' ||
+                c == ':' || c == '=' || c == '#' || c == '.' || c == '{' ||
+                c == '}') {
+        state.statement.push(i, i + 1, Token_Kind::punctuation);
+        ++i;
+      } else {
+        return {expected_error, format("unexpected character '{}'",
+                                       String_View(i, i + 1))};
+      }
+    }
+    return expected_value;
+  }
+
+  Expected<void, Error> import_verilog(Netlist_Builder& builder,
+                                       Line_Reader& reader)
+  {
+    Verilog_State state;
+    String_View line;
+    while(reader.next_line(line)) {
+      Expected<void, Error> result = lex_line(builder, state, line);
+      if(!result) {
+        return result;
+      }
+    }
+
+    if(state.statement.tokens.size() > 0) {
+      return {expected_error, Error("unterminated statement at end of file")};
+    }
+
+    if(!state.module_seen) {
+      return {expected_error, Error("no module found")};
+    }
+    return expected_value;
+  }
+} // namespace nebula
@@ -10,13 +10,37 @@
 #include <core/input.hpp>
 #include <core/types.hpp>
 #include <evaluator/evaluator.hpp>
+#include <importer/importer.hpp>
 #include <logging/logging.hpp>
+#include <model/loops.hpp>
+#include <placement/placement.hpp>
 #include <rendering/framebuffer.hpp>
 #include <rendering/rendering.hpp>
 #include <rendering/shader.hpp>
+#include <routing/router.hpp>
 #include <shaders/compiler.hpp>
+#include <simulation/breakpoint.hpp>
+#include <simulation/checkpoint.hpp>
+#include <simulation/coverage.hpp>
+#include <simulation/history.hpp>
+#include <simulation/power.hpp>
+#include <simulation/timeline.hpp>
+#include <ui/breakpoint_panel.hpp>
+#include <ui/checkpoint_panel.hpp>
+#include <ui/coverage_panel.hpp>
+#include <ui/draw.hpp>
+#include <ui/equivalence_panel.hpp>
+#include <ui/journal.hpp>
+#include <ui/memory_panel.hpp>
+#include <ui/module_panel.hpp>
+#include <ui/power_panel.hpp>
 #include <ui/scene.hpp>
+#include <ui/selection.hpp>
+#include <ui/stimulus_panel.hpp>
+#include <ui/time_travel_panel.hpp>
+#include <ui/timing_panel.hpp>
 #include <ui/viewport.hpp>
+#include <ui/waveform_panel.hpp>
 #include <windowing/window.hpp>
 
 #include <imgui.h>
@@ -29,13 +53,79 @@ using namespace nebula;
 namespace {
   bool is_draged_from_menu = false;
   Gate_Kind last_menu_gate_choice = Gate_Kind::e_count;
+  // The definition dragged from the menu when last_menu_gate_choice is
+  // e_module.
+  Module_Definition* last_menu_module = nullptr;
+  Module_Panel module_panel;
+  // The definition dragged from the menu when last_menu_gate_choice is e_ram
+  // or e_rom.
+  Memory_Definition* last_menu_memory = nullptr;
+  Memory_Panel memory_panel;
+  // Truth table in hexadecimal assigned to LUTs placed from the menu. The
+  // default is the parity of the inputs.
+  char lut_table[17] = "6996966996696996";
   bool run_evaluation = false;
   bool single_step_evaluation = false;
+  // Evaluate with unknown values, which exposes floating inputs and state
+  // that is never initialized.
+  bool four_valued = false;
+  // Evaluate combinational logic in topological order so that it settles
+  // within a single cycle.
+  bool levelized = false;
+  Evaluation_Schedule schedule;
+  // Advance from edge to edge of the clocks and evaluate only the domains of
+  // the toggling clocks, in the levelized order.
+  bool clock_domains = false;
+  Clock_Schedule clock_schedule;
+  // Period and phase in ticks assigned to clocks placed from the menu.
+  int clock_period = 2;
+  int clock_phase = 0;
+  // Number of bits of registers placed from the menu.
+  int register_width = default_register_width;
+  // Evaluate with the delays of the gates, one tick per evaluation.
+  bool timed = false;
+  Timed_Schedule timing;
+  // Delay in ticks assigned to the selected gates, 0 for the delay of their
+  // kind.
+  int gate_delay = 1;
+  // Number of glitches kept for display. Older ones are dropped.
+  constexpr i64 glitch_history = 256;
   i64 evaluation_frequency = 1; // TODO: Frequency switching button (1,2,4,8,16)
   i64 frame_counter = 0;
   Vec2 const gate_default_size{0.6f, 0.5f};
   Vec2 viewport_position;
   Vec2 viewport_size;
+  char import_path[512] = {};
+  String import_status;
+  // The placement running in the background, if any.
+  Placement_Job* placement_job = nullptr;
+  Journal journal;
+  Clipboard clipboard;
+  // Number of cycles evaluated since the start of the application.
+  i64 simulation_cycle = 0;
+  // History of the recorded gates shown in the waveform panel.
+  History history;
+  bool recording = false;
+  Array<Gate*> changed_gates;
+  Waveform_Panel waveform_panel;
+  // Snapshots of the simulation state for seeking to past cycles.
+  Timeline timeline;
+  bool time_travel = false;
+  Checkpoint_Panel checkpoint_panel;
+  Breakpoints breakpoints;
+  Breakpoint_Panel breakpoint_panel;
+  // Identifier of the gate that triggered the last hit breakpoint or 0.
+  u64 highlighted_gate = 0;
+  // Toggle counters of all gates while coverage is enabled.
+  Toggle_Counters toggle_counters;
+  bool coverage = false;
+  Coverage_Panel coverage_panel;
+  // Power estimated from the toggle counters. The heatmap colors the gates by
+  // the estimate of the previous frame.
+  Power_Panel power_panel;
+  Equivalence_Panel equivalence_panel;
+  // Test vectors driving the inputs.
+  Stimulus_Panel stimulus_panel;
 } // namespace
 
 [[nodiscard]] static bool is_within_viewport(Vec2 const point)
@@ -71,14 +161,54 @@ static void compile_shaders()
                                String("shaders/port.frag"), String("port"));
 }
 
+static void undo_edit(Scene& scene)
+{
+  // Edits are only undone between interactions so that no interaction refers
+  // to gates or ports removed by the undo. The netlist is not edited while
+  // the evaluation runs, like with the other editing actions.
+  if(scene.mode == Window_Mode::none && !run_evaluation) {
+    undo(journal, scene);
+  }
+}
+
+static void redo_edit(Scene& scene)
+{
+  if(scene.mode == Window_Mode::none && !run_evaluation) {
+    redo(journal, scene);
+  }
+}
+
 static void keyboard_callback(windowing::Window* const window, Key const key,
                               Input_Action const state, void* data)
 {
   auto& scene = *reinterpret_cast<Scene*>(data);
   ANTON_UNUSED(window);
   ANTON_UNUSED(data);
+  Input_Action const lctrl = windowing::get_key(window, Key::key_lctrl);
+  Input_Action const lshift = windowing::get_key(window, Key::key_lshift);
   if(key == Key::key_r && state == Input_Action::release) {
     compile_shaders();
+  } else if(key == Key::key_z && state == Input_Action::press &&
+            lctrl == Input_Action::press) {
+    // LCTRL + Z undoes, LCTRL + LSHIFT + Z redoes.
+    if(lshift == Input_Action::press) {
+      redo_edit(scene);
+    } else {
+      undo_edit(scene);
+    }
+  } else if(key == Key::key_y && state == Input_Action::press &&
+            lctrl == Input_Action::press) {
+    redo_edit(scene);
+  } else if(scene.mode == Window_Mode::none && !run_evaluation &&
+            state == Input_Action::press &&
+            (key == Key::key_delete || key == Key::key_c || key == Key::key_v)) {
+    if(key == Key::key_delete) {
+      delete_selection(scene, journal);
+    } else if(key == Key::key_c && lctrl == Input_Action::press) {
+      copy_selection(scene, clipboard);
+    } else if(key == Key::key_v && lctrl == Input_Action::press) {
+      paste(scene, journal, clipboard, scene.last_mouse_position);
+    }
   } else if((key == Key::key_lctrl || key == Key::key_rctrl) &&
             state == Input_Action::press) {
     if(scene.mode == Window_Mode::none) {
@@ -140,6 +270,7 @@ static void mouse_button_callback(windowing::Window* const window,
           Input_Action const lctrl = windowing::get_key(window, Key::key_lctrl);
           // LCTRL + LMB deletes connections.
           if(lctrl == Input_Action::press) {
+            record_disconnection(journal, port);
             port->remove_all_connections();
             return;
           }
@@ -162,17 +293,33 @@ static void mouse_button_callback(windowing::Window* const window,
           return;
         }
 
+        // Dragging a selected gate moves the whole selection.
+        if(is_selected(scene, gate)) {
+          scene.set_window_mode(Window_Mode::selection_moving);
+          return;
+        }
+
+        clear_selection(scene);
         scene.currently_moved_gate = gate;
         scene.set_window_mode(Window_Mode::gate_moving);
         return;
       }
 
+      clear_selection(scene);
+      // LSHIFT + LMB starts a rectangle selection.
+      Input_Action const lshift = windowing::get_key(window, Key::key_lshift);
+      if(lshift == Input_Action::press && !run_evaluation) {
+        scene.selection_start = scene_position;
+        scene.set_window_mode(Window_Mode::selecting);
+        return;
+      }
+
       // Move camera regardless of where we click.
       scene.set_window_mode(Window_Mode::camera_moving);
     } else if(action == Input_Action::press && key == Key::mouse_right) {
       Gate* const g = test_hit_gates(scene, scene_position);
       if(g != nullptr && g->kind == Gate_Kind::e_input) {
-        g->evaluation = {!g->evaluation.prev_value, !g->evaluation.value};
+        g->evaluation.value = !g->evaluation.value;
         return;
       }
     }
@@ -186,6 +333,8 @@ static void mouse_button_callback(windowing::Window* const window,
     if(p == nullptr || p->kind == scene.connected_port->kind) {
       scene.remove_tmp_port(scene.connected_port);
     } else {
+      scene.remove_tmp_port(scene.connected_port);
+      record_connection(journal, scene.connected_port, p);
       scene.connect_ports(scene.connected_port, p);
     }
     // Quit connecting mode
@@ -193,9 +342,19 @@ static void mouse_button_callback(windowing::Window* const window,
     scene.set_window_mode(Window_Mode::none);
   } break;
 
+  case Window_Mode::selecting: {
+    if(action == Input_Action::release) {
+      select_gates(scene, scene.selection_start, scene.last_mouse_position);
+      scene.set_window_mode(Window_Mode::none);
+    }
+  } break;
+
+  case Window_Mode::selection_moving:
   case Window_Mode::gate_moving:
   case Window_Mode::camera_moving: {
     if(action == Input_Action::release) {
+      // Finish the drag as a single entry.
+      seal(journal);
       scene.currently_moved_gate = nullptr;
       scene.connected_port = nullptr;
       scene.set_window_mode(Window_Mode::none);
@@ -218,7 +377,11 @@ static void cursor_position_callback(windowing::Window* const window,
     Camera& camera = get_primary_camera();
     camera.move(offset);
   } else if(scene.mode == Window_Mode::gate_moving) {
-    scene.currently_moved_gate->move(offset);
+    scene.move_gate(*scene.currently_moved_gate, offset);
+    record_move(journal, Slice<Gate* const>(&scene.currently_moved_gate, 1),
+                offset);
+  } else if(scene.mode == Window_Mode::selection_moving) {
+    move_selection(scene, journal, offset);
   }
 
   scene.last_mouse_position = scene_position;
@@ -288,19 +451,75 @@ static void render_scene(Scene& scene, Vec2 const viewport_size)
   // 2. connections.
   // 3. ports.
 
+  // Outline the gate that hit a breakpoint with a wider frame.
+  if(Gate const* const gate = scene.find_gate(highlighted_gate)) {
+    Vec2 const padding{0.15f, 0.15f};
+    rendering::Draw_Elements_Command cmd =
+      prepare_draw_frame(gate->coordinates - padding,
+                         gate->coordinates + gate->dimensions + padding);
+    rendering::add_draw_command(cmd);
+  }
+
+  // Outline the gates of combinational loops.
+  update_loops(scene.loops, scene.gates);
+  for(Gate const* const gate: scene.loops.gates) {
+    Vec2 const padding{0.1f, 0.1f};
+    rendering::Draw_Elements_Command cmd = prepare_draw_frame(
+      gate->coordinates - padding,
+      gate->coordinates + gate->dimensions + padding,
+      math::Vec3{1.0f, 0.45f, 0.1f});
+    rendering::add_draw_command(cmd);
+  }
+
+  // Outline selected gates behind the gates.
+  for(Gate const* const gate: scene.selected_gates) {
+    Vec2 const padding{0.05f, 0.05f};
+    rendering::Draw_Elements_Command cmd =
+      prepare_draw_frame(gate->coordinates - padding,
+                         gate->coordinates + gate->dimensions + padding);
+    rendering::add_draw_command(cmd);
+  }
+
+  Power_Estimate const& estimate = power_panel.estimate;
+  i64 index = 0;
   for(Gate const& gate: scene.gates) {
-    rendering::Draw_Elements_Command cmd = prepare_draw(gate);
+    if(power_panel.heatmap && index < estimate.power.size() &&
+       estimate.maximum > 0.0f) {
+      f32 const heat = estimate.power[index] / estimate.maximum;
+      rendering::Draw_Elements_Command cmd =
+        prepare_draw(gate, Color_Mode::e_heatmap, heat);
+      rendering::add_draw_command(cmd);
+    } else {
+      rendering::Draw_Elements_Command cmd = prepare_draw(gate);
+      rendering::add_draw_command(cmd);
+    }
+    index += 1;
+  }
+
+  if(scene.mode == Window_Mode::selecting) {
+    Vec2 const a = scene.selection_start;
+    Vec2 const b = scene.last_mouse_position;
+    rendering::Draw_Elements_Command cmd =
+      prepare_draw_frame(Vec2{math::min(a.x, b.x), math::min(a.y, b.y)},
+                         Vec2{math::max(a.x, b.x), math::max(a.y, b.y)});
     rendering::add_draw_command(cmd);
   }
 
+  update_routes(scene, Routing_Options{});
   for(Port const* const port: scene.ports) {
-    if(port->kind != Port_Kind::out) {
+    if(port->kind != Port_Kind::in || port->connections.size() == 0) {
       continue;
     }
 
-    for(Port const* const conn: port->connections) {
+    if(port->route.size() > 0) {
       rendering::Draw_Elements_Command cmd =
-        prepare_draw_connection(port->coordinates, conn->coordinates);
+        prepare_draw_connection(port->route);
+      rendering::add_draw_command(cmd);
+    } else {
+      // Connections to the temporary linking port are not routed.
+      Port const* const conn = *port->connections.begin();
+      Vec2 const points[] = {conn->coordinates, port->coordinates};
+      rendering::Draw_Elements_Command cmd = prepare_draw_connection(points);
       rendering::add_draw_command(cmd);
     }
   }
@@ -370,6 +589,20 @@ static void display_viewport(Scene& scene)
     return "INPUT";
   case Gate_Kind::e_clock:
     return "CLOCK";
+  case Gate_Kind::e_module:
+    return "MODULE";
+  case Gate_Kind::e_dff:
+    return "DFF";
+  case Gate_Kind::e_sr_latch:
+    return "SR LATCH";
+  case Gate_Kind::e_register:
+    return "REGISTER";
+  case Gate_Kind::e_ram:
+    return "RAM";
+  case Gate_Kind::e_rom:
+    return "ROM";
+  case Gate_Kind::e_lut:
+    return "LUT";
   case Gate_Kind::e_count:
     ANTON_UNREACHABLE("count is not a valid enumeration");
   }
@@ -378,24 +611,350 @@ static void display_viewport(Scene& scene)
   return "INVALID";
 }
 
-void display_toolbar()
+// parse_lut_table
+//
+// Parse a truth table of up to 16 hexadecimal digits.
+//
+[[nodiscard]] static Expected<u64, Error>
+parse_lut_table(String_View const text)
+{
+  u64 table = 0;
+  char const* const end = text.data() + text.size_bytes();
+  for(char const* i = text.data(); i != end; ++i) {
+    u64 digit;
+    if(*i >= '0' && *i <= '9') {
+      digit = *i - '0';
+    } else if(*i >= 'a' && *i <= 'f') {
+      digit = *i - 'a' + 10;
+    } else if(*i >= 'A' && *i <= 'F') {
+      digit = *i - 'A' + 10;
+    } else {
+      return {expected_error, format("'{}' is not a LUT table"_sv, text)};
+    }
+    table = (table << 4) | digit;
+  }
+  return {expected_value, table};
+}
+
+static void start_auto_placement(Scene const& scene)
+{
+  if(placement_job != nullptr) {
+    cancel_placement(placement_job);
+  }
+  clear_history(history);
+  placement_job = start_placement(scene, Placement_Options{});
+}
+
+static void finish_auto_placement(Scene& scene)
+{
+  Array<Gate*> gates;
+  Array<Vec2> offsets;
+  for(Gate& gate: scene.gates) {
+    gates.push_back(&gate);
+    offsets.push_back(gate.coordinates);
+  }
+
+  apply_placement(placement_job, scene);
+  placement_job = nullptr;
+  for(i64 i = 0; i < gates.size(); ++i) {
+    offsets[i] = gates[i]->coordinates - offsets[i];
+  }
+  record_moves(journal, gates, offsets);
+}
+
+static void display_import(Scene& scene)
+{
+  ImGui::InputText("Netlist", import_path, sizeof(import_path));
+  if(ImGui::Button("Import BLIF/Verilog")) {
+    i64 const previous_count = scene.gates.size();
+    Expected<Import_Statistics, Error> result =
+      import_netlist(scene, import_path, gate_default_size);
+    if(result) {
+      // Imported gates are appended to the scene.
+      Array<Gate*> imported;
+      i64 index = 0;
+      for(Gate& gate: scene.gates) {
+        if(index >= previous_count) {
+          imported.push_back(&gate);
+        }
+        index += 1;
+      }
+      record_added_gates(journal, imported);
+
+      Import_Statistics const& statistics = result.value();
+      import_status = format("{} gates, {} lines/s", statistics.gates,
+                             static_cast<i64>(statistics.lines_per_second));
+      start_auto_placement(scene);
+    } else {
+      LOG_ERROR("import failed: {}", result.error());
+      import_status = ANTON_MOV(result.error());
+    }
+  }
+
+  if(import_status.size_bytes() > 0) {
+    ImGui::TextWrapped("%s", import_status.data());
+  }
+
+  if(placement_job != nullptr) {
+    ImGui::TextUnformatted("Placing...");
+  } else if(ImGui::Button("Auto place")) {
+    start_auto_placement(scene);
+  }
+
+  if(ImGui::Button("Reroute wires")) {
+    invalidate_routes(scene);
+  }
+}
+
+// step_evaluation
+//
+// Evaluate a cycle, the next edge of the clocks in the clock domain mode or
+// the next tick in the timed mode.
+//
+static void step_evaluation(Scene& scene, Array<Gate*>* const changed,
+                            Toggle_Counters* const toggles,
+                            Logic_Mode const mode)
+{
+  if(timed) {
+    evaluate_until(scene.gates, timing, timing.time + 1, changed, toggles,
+                   mode);
+    Array<Glitch>& glitches = timing.glitches;
+    if(glitches.size() > glitch_history) {
+      glitches.erase(glitches.begin(),
+                     glitches.begin() + (glitches.size() - glitch_history));
+    }
+  } else if(clock_domains) {
+    evaluate_next_edge(scene.gates, clock_schedule, schedule, changed, toggles,
+                       mode);
+  } else {
+    Evaluation_Schedule* const order = levelized ? &schedule : nullptr;
+    evaluate(scene.gates, changed, toggles, mode, order);
+  }
+}
+
+static void evaluate_cycle(Scene& scene)
+{
+  apply_stimulus(stimulus_panel, scene, run_evaluation);
+
+  bool const watching = breakpoints.breakpoints.size() > 0;
+  Toggle_Counters* const toggles = coverage ? &toggle_counters : nullptr;
+  Logic_Mode const mode =
+    four_valued ? Logic_Mode::e_four_valued : Logic_Mode::e_two_valued;
+  if(recording || time_travel || watching) {
+    changed_gates.clear();
+    step_evaluation(scene, &changed_gates, toggles, mode);
+    if(recording) {
+      record_history(history, scene, simulation_cycle, changed_gates);
+    }
+    if(time_travel) {
+      record_timeline(timeline, scene, simulation_cycle, changed_gates);
+    }
+    if(watching && check_breakpoints(breakpoints, changed_gates)) {
+      Breakpoint const& breakpoint =
+        breakpoints.breakpoints[breakpoints.hit_breakpoint];
+      run_evaluation = false;
+      highlighted_gate = breakpoints.hit_gate;
+      breakpoint_panel.status = format("Hit '{}' at cycle {}"_sv,
+                                       breakpoint.text, simulation_cycle);
+    }
+  } else {
+    step_evaluation(scene, nullptr, toggles, mode);
+  }
+  simulation_cycle += 1;
+
+  check_stimulus(stimulus_panel, run_evaluation);
+}
+
+static void seek_cycle(Scene& scene, i64 const cycle)
+{
+  if(!seek_timeline(timeline, scene, cycle)) {
+    return;
+  }
+
+  run_evaluation = false;
+  simulation_cycle = cycle + 1;
+  clock_schedule.full = true;
+  timing.full = true;
+  reset_breakpoints(breakpoints, scene);
+  // The history records increasing cycles only, hence recording stops at the
+  // cycle that has been left.
+  if(recording) {
+    recording = false;
+    LOG_INFO("waveform recording stopped at cycle {}", history.last_cycle);
+  }
+}
+
+// restart_from_checkpoint
+//
+// Continue the simulation after the cycle a checkpoint has been restored at.
+//
+static void restart_from_checkpoint(Scene& scene, Checkpoint_Time const& time)
+{
+  // Checkpoints saved in the four-valued logic may hold unknown bits.
+  if(!four_valued) {
+    clear_unknown(scene.gates);
+  }
+  run_evaluation = false;
+  simulation_cycle = time.cycle + 1;
+  restart_clock_schedule(clock_schedule, time.clock_time);
+  restart_timed_schedule(timing, time.timed_time);
+  reset_breakpoints(breakpoints, scene);
+  // Neither the history nor the timeline may skip cycles, hence both start
+  // over from the restored cycle.
+  if(recording) {
+    recording = false;
+    LOG_INFO("waveform recording stopped at cycle {}", history.last_cycle);
+  }
+  if(time_travel) {
+    start_timeline(timeline, Timeline_Options{});
+  }
+}
+
+void display_toolbar(Scene& scene)
 {
   ImGui::Begin("Toolbar", nullptr,
                ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoMove |
                  ImGuiWindowFlags_NoTitleBar);
   if(ImGui::Button("Toggle evaluation")) {
     run_evaluation = !run_evaluation;
+    highlighted_gate = 0;
   }
   if(ImGui::Button("Single step evaluation")) {
     single_step_evaluation = true;
   }
+  if(ImGui::Checkbox("Four-valued logic", &four_valued)) {
+    if(four_valued) {
+      reset_unknown(scene.gates);
+    } else {
+      clear_unknown(scene.gates);
+    }
+    clock_schedule.full = true;
+    timing.full = true;
+  }
+  update_loops(scene.loops, scene.gates);
+  if(get_loop_count(scene.loops) > 0) {
+    ImGui::Text("%lld gates in %lld combinational loops",
+                static_cast<long long>(scene.loops.gates.size()),
+                static_cast<long long>(get_loop_count(scene.loops)));
+  }
+  ImGui::Checkbox("Levelized evaluation", &levelized);
+  if(levelized && schedule.unsettled_count > 0) {
+    ImGui::Text("%lld loop evaluations did not settle",
+                static_cast<long long>(schedule.unsettled_count));
+  }
+  if(levelized) {
+    ImGui::Checkbox("Fuse into LUTs", &schedule.fuse);
+    if(schedule.fused && !four_valued) {
+      ImGui::Text("%lld gates in %lld lookup tables",
+                  static_cast<long long>(schedule.members.size()),
+                  static_cast<long long>(schedule.nodes.size()));
+    }
+  }
+  // The gates may have been evaluated cycle by cycle since the last edge.
+  if(ImGui::Checkbox("Clock domains", &clock_domains)) {
+    clock_schedule.full = true;
+  }
+  if(clock_domains) {
+    i64 const evaluations =
+      math::max(clock_schedule.evaluations, static_cast<i64>(1));
+    String const status = format(
+      "Time {}, {} clocks, {} gates per edge"_sv, clock_schedule.time,
+      clock_schedule.clocks.size(), clock_schedule.evaluated / evaluations);
+    ImGui::TextUnformatted(status.data());
+  }
+  if(ImGui::Checkbox("Timed evaluation", &timed)) {
+    timing.full = true;
+  }
+  if(timed) {
+    display_timing(timing, scene);
+  }
+  i64 const seek =
+    display_time_travel(timeline, time_travel, simulation_cycle - 1);
+  if(seek >= 0) {
+    seek_cycle(scene, seek);
+  }
 
   ImGui::Separator();
 
+  Checkpoint_Time const restored = display_checkpoints(
+    checkpoint_panel, scene,
+    Checkpoint_Time{simulation_cycle - 1, clock_schedule.time, timing.time});
+  if(restored.cycle >= 0) {
+    restart_from_checkpoint(scene, restored);
+  }
+
+  ImGui::Separator();
+
+  display_breakpoints(breakpoint_panel, breakpoints, scene, highlighted_gate);
+
+  ImGui::Separator();
+
+  if(ImGui::Button("Undo")) {
+    undo_edit(scene);
+  }
+  ImGui::SameLine();
+  if(ImGui::Button("Redo")) {
+    redo_edit(scene);
+  }
+
+  ImGui::Separator();
+
+  display_import(scene);
+
+  ImGui::Separator();
+
+  display_equivalence(equivalence_panel, scene, gate_default_size);
+
+  ImGui::Separator();
+
+  if(Module_Definition* const definition =
+       display_modules(module_panel, scene)) {
+    last_menu_gate_choice = Gate_Kind::e_module;
+    last_menu_module = definition;
+    is_draged_from_menu = true;
+  }
+
+  ImGui::Separator();
+
+  if(Memory_Definition* const definition =
+       display_memories(memory_panel, scene, last_menu_gate_choice)) {
+    last_menu_memory = definition;
+    is_draged_from_menu = true;
+  }
+
+  ImGui::Separator();
+
+  ImGui::InputText("LUT table", lut_table, sizeof(lut_table));
+  ImGui::InputInt("Register width", &register_width);
+  register_width = math::max(register_width, 1);
+  ImGui::InputInt("Clock period", &clock_period);
+  ImGui::InputInt("Clock phase", &clock_phase);
+  clock_period = math::max(clock_period, 2);
+  clock_phase = math::max(clock_phase, 0);
+  if(ImGui::Button("Apply to selected clocks")) {
+    for(Gate* const gate: scene.selected_gates) {
+      if(gate->kind == Gate_Kind::e_clock) {
+        gate->clock_period = static_cast<u32>(clock_period);
+        gate->clock_phase = static_cast<u32>(clock_phase);
+      }
+    }
+  }
+  ImGui::InputInt("Gate delay", &gate_delay);
+  gate_delay = math::max(gate_delay, 0);
+  if(ImGui::Button("Apply to selected gates")) {
+    for(Gate* const gate: scene.selected_gates) {
+      gate->delay = static_cast<u32>(gate_delay);
+    }
+  }
+
   ImGui::BeginChild("Gates");
   u8 number_of_gate_types = static_cast<int>(Gate_Kind::e_count);
   for(int i = 0; i < number_of_gate_types; ++i) {
     Gate_Kind gate = static_cast<Gate_Kind>(i);
+    // Modules and memories are listed separately with their definitions.
+    if(gate == Gate_Kind::e_module || is_memory(gate)) {
+      continue;
+    }
     const char* gateString = gate_to_string(gate);
 
     ImGui::Selectable(gateString);
@@ -482,14 +1041,18 @@ int main(int argc, char* argv[])
 
     if(run_evaluation) {
       if(frame_counter % evaluation_frequency == 0) {
-        evaluate(scene.gates);
+        evaluate_cycle(scene);
       }
     } else if(single_step_evaluation) {
-      evaluate(scene.gates);
+      evaluate_cycle(scene);
     }
 
     single_step_evaluation = false;
 
+    if(placement_job != nullptr && is_placement_finished(placement_job)) {
+      finish_auto_placement(scene);
+    }
+
     Vec2 const window_size = windowing::get_framebuffer_size(window);
 
     ImGuiViewport* viewport = ImGui::GetMainViewport();
@@ -526,14 +1089,27 @@ int main(int argc, char* argv[])
       ImGuiID node_b;
       ImGui::DockBuilderSplitNode(dockspace_id, ImGuiDir_Left, 0.2f, &node_a,
                                   &node_b);
+      ImGuiID node_c;
+      ImGui::DockBuilderSplitNode(node_b, ImGuiDir_Down, 0.25f, &node_c,
+                                  &node_b);
       ImGui::DockBuilderDockWindow("Toolbar", node_a);
       ImGui::DockBuilderDockWindow("Viewport", node_b);
+      ImGui::DockBuilderDockWindow("Waveforms", node_c);
+      ImGui::DockBuilderDockWindow("Coverage", node_c);
+      ImGui::DockBuilderDockWindow("Power", node_c);
+      ImGui::DockBuilderDockWindow("Stimulus", node_c);
     } else {
       ImGui::DockSpace(dockspace_id, ImVec2(0.0f, 0.0f), dockspace_flags);
     }
 
     display_viewport(scene);
-    display_toolbar();
+    display_toolbar(scene);
+    display_waveforms(waveform_panel, scene, history, recording);
+    display_coverage(coverage_panel, toggle_counters, coverage, scene,
+                     highlighted_gate);
+    display_power(power_panel, toggle_counters, coverage, scene);
+    display_stimulus(stimulus_panel, scene, four_valued, levelized,
+                     run_evaluation);
 
     // Close the dock window.
     ImGui::End();
@@ -550,15 +1126,59 @@ int main(int argc, char* argv[])
     If mouse is dragged from the manu and released then add gate
     */
     if(ImGui::IsMouseReleased(left_button) && is_draged_from_menu) {
-      //later change to gate that was pressed
-      scene.add_gate(gate_default_size, scene.last_mouse_position,
-                     last_menu_gate_choice);
+      Gate* gate = nullptr;
+      if(last_menu_gate_choice == Gate_Kind::e_module) {
+        gate = &scene.add_gate(get_instance_dimensions(*last_menu_module),
+                               scene.last_mouse_position, Gate_Kind::e_module,
+                               scene.next_gate_id, last_menu_module);
+      } else if(is_memory(last_menu_gate_choice)) {
+        Vec2 const size =
+          get_memory_dimensions(last_menu_gate_choice, *last_menu_memory);
+        gate = &scene.add_gate(size, scene.last_mouse_position,
+                               last_menu_gate_choice, scene.next_gate_id,
+                               nullptr, last_menu_memory);
+      } else if(last_menu_gate_choice == Gate_Kind::e_lut) {
+        Expected<u64, Error> table = parse_lut_table(lut_table);
+        Vec2 const size{gate_default_size.x,
+                        0.25f * static_cast<f32>(lut_input_count + 1)};
+        gate = &scene.add_gate(size, scene.last_mouse_position,
+                               last_menu_gate_choice);
+        if(table) {
+          gate->table = table.value();
+        } else {
+          LOG_WARNING("{}", table.error());
+        }
+      } else if(last_menu_gate_choice == Gate_Kind::e_register) {
+        // Registers are tall enough to space their inputs like other gates.
+        Vec2 const size{gate_default_size.x,
+                        0.25f * static_cast<f32>(register_width + 3)};
+        gate = &scene.add_gate(size, scene.last_mouse_position,
+                               last_menu_gate_choice, scene.next_gate_id,
+                               nullptr, nullptr,
+                               static_cast<u32>(register_width));
+      } else {
+        gate = &scene.add_gate(gate_default_size, scene.last_mouse_position,
+                               last_menu_gate_choice);
+        if(last_menu_gate_choice == Gate_Kind::e_clock) {
+          gate->clock_period = static_cast<u32>(clock_period);
+          gate->clock_phase = static_cast<u32>(clock_phase);
+        }
+      }
+      record_added_gates(journal, Slice<Gate* const>(&gate, 1));
       is_draged_from_menu = 0;
     }
 
     windowing::swap_buffers(window);
   }
 
+  if(placement_job != nullptr) {
+    cancel_placement(placement_job);
+  }
+  if(checkpoint_panel.job != nullptr) {
+    (void)finish_checkpoint(checkpoint_panel.job);
+  }
+  clear_history(history);
+
   ImGui_ImplGlfw_Shutdown();
   ImGui_ImplOpenGL3_Shutdown();
   ImGui::DestroyContext();
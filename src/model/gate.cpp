@@ -1,39 +1,131 @@
 #include <model/gate.hpp>
 
+#include <model/memory.hpp>
+#include <model/module.hpp>
+
 namespace nebula {
+  i64 get_input_count(Gate_Kind const kind)
+  {
+    if(kind == Gate_Kind::e_input || kind == Gate_Kind::e_clock) {
+      return 0;
+    } else if(kind == Gate_Kind::e_not) {
+      return 1;
+    } else if(kind == Gate_Kind::e_lut) {
+      return lut_input_count;
+    } else if(kind == Gate_Kind::e_dff) {
+      return 4;
+    } else {
+      return 2;
+    }
+  }
+
+  bool is_sequential(Gate_Kind const kind)
+  {
+    return kind == Gate_Kind::e_dff || kind == Gate_Kind::e_sr_latch ||
+           kind == Gate_Kind::e_register;
+  }
+
+  i64 get_state_size(Gate const& gate)
+  {
+    if(gate.kind == Gate_Kind::e_dff) {
+      return 1;
+    } else if(gate.kind == Gate_Kind::e_register) {
+      // The bits followed by the level of CLK.
+      return gate.width + 1;
+    } else {
+      return 0;
+    }
+  }
+
+  bool is_combinational(Gate_Kind const kind)
+  {
+    return kind == Gate_Kind::e_and || kind == Gate_Kind::e_or ||
+           kind == Gate_Kind::e_xor || kind == Gate_Kind::e_nand ||
+           kind == Gate_Kind::e_nor || kind == Gate_Kind::e_xnor ||
+           kind == Gate_Kind::e_not || kind == Gate_Kind::e_lut;
+  }
+
+  u64 compose_truth_table(Gate const& gate, u64 const* const inputs)
+  {
+    switch(gate.kind) {
+    case Gate_Kind::e_and:
+      return inputs[0] & inputs[1];
+    case Gate_Kind::e_or:
+      return inputs[0] | inputs[1];
+    case Gate_Kind::e_xor:
+      return inputs[0] ^ inputs[1];
+    case Gate_Kind::e_nand:
+      return ~(inputs[0] & inputs[1]);
+    case Gate_Kind::e_nor:
+      return ~(inputs[0] | inputs[1]);
+    case Gate_Kind::e_xnor:
+      return ~(inputs[0] ^ inputs[1]);
+    case Gate_Kind::e_not:
+      return ~inputs[0];
+    case Gate_Kind::e_lut: {
+      u64 table = 0;
+      for(u64 bit = 0; bit < 64; ++bit) {
+        u64 index = 0;
+        for(i64 i = 0; i < lut_input_count; ++i) {
+          index |= ((inputs[i] >> bit) & 1) << i;
+        }
+        table |= ((gate.table >> index) & 1) << bit;
+      }
+      return table;
+    }
+    default:
+      ANTON_UNREACHABLE("gate is not combinational");
+    }
+  }
+
   Gate::Gate(math::Vec2 const _dimensions, math::Vec2 const _coordinates,
-             Gate_Kind const _kind)
-    : coordinates(_coordinates), dimensions(_dimensions), kind(_kind)
+             Gate_Kind const _kind, Module_Definition* const _definition,
+             Memory_Definition* const _memory, u32 const _width)
+    : coordinates(_coordinates), dimensions(_dimensions), kind(_kind),
+      definition(_definition), memory(_memory),
+      width(_kind == Gate_Kind::e_register ? _width : 0)
   {
-    i32 const out_count = 1;
+    i32 out_count;
     i32 in_count;
+    if(kind == Gate_Kind::e_module) {
+      in_count = definition->input_names.size();
+      out_count = definition->output_names.size();
+    } else if(kind == Gate_Kind::e_register) {
+      // The D inputs are followed by CLK, EN and RST.
+      in_count = width + 3;
+      out_count = width;
+    } else if(is_memory(kind)) {
+      in_count = get_memory_input_count(kind, *memory);
+      out_count = memory->data_width;
+    } else {
+      in_count = get_input_count(kind);
+      out_count = 1;
+    }
+
     if(kind == Gate_Kind::e_input || kind == Gate_Kind::e_clock) {
-      in_count = 0;
       evaluation.prev_value = true;
       evaluation.value = true;
-    } else if(kind == Gate_Kind::e_not) {
-      in_count = 1;
-    } else {
-      in_count = 2;
     }
 
     // Distance between IN ports
     f32 const in_space = dimensions.y / static_cast<f32>(in_count);
-    for(u8 i = 0; i < in_count; i++) {
+    for(i32 i = 0; i < in_count; i++) {
       // Create IN ports along the left edge of the gate
       f32 const voffset = (i + 0.5f) * in_space;
       Vec2 port_coordinates = {coordinates.x, coordinates.y + voffset};
-      in_ports.emplace_back(new Port(port_coordinates, Port_Kind::in, this));
+      in_ports.emplace_back(
+        new Port(port_coordinates, Port_Kind::in, this, i));
     }
 
     // Distance between OUT ports
     f32 const out_space = dimensions.y / static_cast<f32>(out_count);
-    for(u8 i = 0; i < out_count; i++) {
+    for(i32 i = 0; i < out_count; i++) {
       // Create OUT ports along the right edge of the gate
       f32 const voffset = (i + 0.5f) * out_space;
       Vec2 port_coordinates = {coordinates.x + dimensions.x,
                                coordinates.y + voffset};
-      out_ports.emplace_back(new Port(port_coordinates, Port_Kind::out, this));
+      out_ports.emplace_back(
+        new Port(port_coordinates, Port_Kind::out, this, i));
     }
   }
 
@@ -60,37 +152,4 @@ namespace nebula {
     bool const bottom = point.y <= coordinates.y + dimensions.y;
     return left && right && top && bottom;
   }
-
-  rendering::Draw_Elements_Command prepare_draw(Gate const& gate)
-  {
-    // TODO: green and red in evaluation mode and unique color for each type
-    //       in create mode.
-    math::Vec3 const green{0.498f, 1.0f, 0.0f};
-    math::Vec3 const red{1.0f, 0.0f, 0.2235f};
-    math::Vec3 const color = gate.evaluation.value ? green : red;
-    Vertex vert[] = {
-      Vertex{.position = {gate.coordinates.x + gate.dimensions.x,
-                          gate.coordinates.y + gate.dimensions.y, 0.0f},
-             .normal = color,
-             .uv = {1.0f, 1.0f}},
-      Vertex{.position = {gate.coordinates.x,
-                          gate.coordinates.y + gate.dimensions.y, 0.0f},
-             .normal = color,
-             .uv = {0.0f, 1.0f}},
-      Vertex{.position = {gate.coordinates.x + gate.dimensions.x,
-                          gate.coordinates.y, 0.0f},
-             .normal = color,
-             .uv = {1.0f, 0.0f}},
-      Vertex{.position = {gate.coordinates.x, gate.coordinates.y, 0.0f},
-             .normal = color,
-             .uv = {0.0f, 0.0f}},
-    };
-    u32 indices[] = {
-      0, 1, 2, 1, 3, 2,
-    };
-    rendering::Draw_Elements_Command cmd =
-      rendering::write_geometry(vert, indices);
-    cmd.instance_count = 1;
-    return cmd;
-  }
 } // namespace nebula
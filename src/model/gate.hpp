@@ -3,16 +3,30 @@
 #include <anton/math/vec2.hpp>
 
 #include <model/port.hpp>
-#include <rendering/rendering.hpp>
 
 namespace nebula {
+  struct Memory_Definition;
+  struct Module_Definition;
+
+  /**
+   * @brief Number of bits stored by a register gate unless given otherwise.
+   */
+  constexpr i64 default_register_width = 8;
+
+  /**
+   * @brief Number of inputs of a LUT gate.
+   */
+  constexpr i64 lut_input_count = 6;
+
   /**
    * @brief Enumeration representing different kinds of logic gates.
    *
    * The Gate_Kind enumeration represents various types of logic gates,
    * categorized based on the number of inputs they accept. Two-input gates
    * include AND, OR, XOR, NAND, NOR, and XNOR, while one-input gates include
-   * NOT.
+   * NOT. LUT gates implement any function of up to lut_input_count inputs.
+   * Sequential gates hold state that changes only on edges of their clock,
+   * or for the latch on the levels of its inputs.
    */
   enum struct Gate_Kind : u8 {
     // Two input gates.
@@ -29,14 +43,50 @@ namespace nebula {
     // One output gates.
     e_input,
     e_clock,
+
+    // Instance of a module definition. The number of ports is determined by
+    // the definition.
+    e_module,
+
+    // Sequential gates.
+    // D flip-flop with inputs D, CLK, EN and RST. Stores D on the rising edge
+    // of CLK while EN is high. RST is synchronous and overrides EN. An
+    // unconnected EN enables the flip-flop.
+    e_dff,
+    // SR latch with inputs S and R. R overrides S.
+    e_sr_latch,
+    // Register of Gate::width flip-flops sharing CLK, EN and RST. The D
+    // inputs are followed by CLK, EN and RST, one output per bit.
+    e_register,
+
+    // Memory blocks. The number of ports is determined by the definition.
+    // RAM with address inputs, data inputs, WE and CLK. Writes the data on
+    // the rising edge of CLK while WE is high. The outputs are the word at
+    // the address after the write.
+    e_ram,
+    // ROM with address inputs. The outputs are the word at the address.
+    e_rom,
+
+    // Lookup table with lut_input_count inputs. The output is the bit of
+    // Gate::table selected by the inputs.
+    e_lut,
+
     // TODO: add Led type gate ( 0 out, 1 in ) just showing red or green color
     // Number of enumerations.
     e_count,
   };
 
+  /**
+   * @brief Value of the net driven by a gate.
+   *
+   * unknown marks the value as X in the four-valued simulation mode, in
+   * which case value is false. See Logic_Word.
+   */
   struct Evaluation_State {
     bool prev_value = false;
     bool value = false;
+    bool prev_unknown = false;
+    bool unknown = false;
   };
 
   /**
@@ -64,6 +114,93 @@ namespace nebula {
 
     Evaluation_State evaluation;
 
+    /**
+     * @brief Name of the net driven by the gate.
+     *
+     * Empty for gates placed by hand. Imported gates carry the name of their
+     * output net from the source netlist.
+     */
+    String name;
+
+    /**
+     * @brief Identifier of the gate unique within its scene.
+     *
+     * Unlike the address of the gate, the identifier survives deleting and
+     * restoring the gate, hence it is used to refer to gates in the edit
+     * history.
+     */
+    u64 id = 0;
+
+    /**
+     * @brief Definition of the module the gate is an instance of.
+     *
+     * nullptr unless kind is e_module. Definitions are shared by all their
+     * instances.
+     */
+    Module_Definition* definition = nullptr;
+
+    /**
+     * @brief Definition of the memory the gate is an instance of.
+     *
+     * nullptr unless kind is e_ram or e_rom.
+     */
+    Memory_Definition* memory = nullptr;
+
+    /**
+     * @brief Number of bits of a register gate.
+     *
+     * Determines the number of ports, hence it is fixed at construction. 0
+     * unless kind is e_register.
+     */
+    u32 width = 0;
+
+    /**
+     * @brief Truth table of a LUT gate.
+     *
+     * Bit i is the output for the inputs forming the number i with input 0
+     * as the least significant bit. Unconnected inputs read 0.
+     */
+    u64 table = 0;
+
+    /**
+     * @brief Period and phase of a clock gate in ticks of simulated time.
+     *
+     * The clock toggles every half period from the tick given by the phase
+     * on. Only the evaluation by clock domains follows the period, the cycle
+     * evaluation toggles every clock once per cycle.
+     */
+    u32 clock_period = 2;
+    u32 clock_phase = 0;
+
+    /**
+     * @brief Propagation delay of the gate in ticks of the timed evaluation.
+     *
+     * 0 takes the delay of the kind of the gate.
+     */
+    u32 delay = 0;
+
+    /**
+     * @brief Simulation state of module instances, sequential gates and
+     * memories.
+     *
+     * Module instances store one byte per input and per gate of the flattened
+     * definition. Flip-flops store the level of CLK at the last evaluation,
+     * registers store their bits followed by the level of CLK. Memories store
+     * their outputs followed by the level of CLK for RAM. Bit 0 of a byte
+     * is the current value, bit 1 the previous value. Bits 2 and 3 are the
+     * current and the previous unknown flag of the four-valued simulation
+     * mode. Allocated on the first evaluation.
+     */
+    Array<u8> state;
+
+    /**
+     * @brief Words of a RAM instance.
+     *
+     * Copied from the definition on the first evaluation. Empty for any
+     * other gate.
+     */
+    Array<u8> contents;
+
     /**
      * @brief Constructs a new gate.
      *
@@ -73,8 +210,14 @@ namespace nebula {
      * @param dimensions The dimensions of the gate (width and height).
      * @param coordinates The coordinates of the top-left corner of the gate.
      * @param kind The kind of logic gate.
+     * @param definition The definition of the module if kind is e_module.
+     * @param memory The definition of the memory if kind is e_ram or e_rom.
+     * @param width The number of bits if kind is e_register. At least 1.
      */
-    Gate(math::Vec2 dimensions, math::Vec2 coordinates, Gate_Kind kind);
+    Gate(math::Vec2 dimensions, math::Vec2 coordinates, Gate_Kind kind,
+         Module_Definition* definition = nullptr,
+         Memory_Definition* memory = nullptr,
+         u32 width = default_register_width);
 
     /**
      * @brief Moves the gate to a new location.
@@ -88,6 +231,56 @@ namespace nebula {
     void move(math::Vec2 offset);
   };
 
+  /**
+   * @brief Gets the number of inputs of a primitive gate kind.
+   *
+   * @param kind The kind of gate. Must not be e_module, e_register or a
+   * memory.
+   * @return The number of IN ports of gates of the kind.
+   */
+  [[nodiscard]] i64 get_input_count(Gate_Kind kind);
+
+  /**
+   * @brief Checks whether gates of a kind are flip-flops, latches or
+   * registers.
+   */
+  [[nodiscard]] bool is_sequential(Gate_Kind kind);
+
+  /**
+   * @brief Gets the number of bytes of Gate::state of a primitive gate.
+   *
+   * @param gate The gate. Must not be a module instance or a memory.
+   */
+  [[nodiscard]] i64 get_state_size(Gate const& gate);
+
+  /**
+   * @brief Truth tables of the inputs of a combinational function.
+   *
+   * Bit i of the table of input j is bit j of i, hence bit i of the table of
+   * any function of the inputs is its value for the input number i.
+   */
+  constexpr u64 input_truth_tables[lut_input_count] = {
+    0xAAAAAAAAAAAAAAAA, 0xCCCCCCCCCCCCCCCC, 0xF0F0F0F0F0F0F0F0,
+    0xFF00FF00FF00FF00, 0xFFFF0000FFFF0000, 0xFFFFFFFF00000000,
+  };
+
+  /**
+   * @brief Checks whether gates of a kind are combinational, that is the
+   * primitive gates with inputs and LUTs.
+   */
+  [[nodiscard]] bool is_combinational(Gate_Kind kind);
+
+  /**
+   * @brief Composes the function of a combinational gate with the truth
+   * tables of its inputs.
+   *
+   * @param gate The gate. Must be combinational.
+   * @param inputs The truth tables of the inputs, one per IN port.
+   * @return The truth table of the output. Every bit is computed from the
+   * same bit of the inputs.
+   */
+  [[nodiscard]] u64 compose_truth_table(Gate const& gate, u64 const* inputs);
+
   /**
    * @brief Tests whether a point is within the bounds of a gate.
    *
@@ -100,16 +293,4 @@ namespace nebula {
    * otherwise.
    */
   [[nodiscard]] bool test_hit(Gate const& gate, math::Vec2 point);
-
-  /**
-   * @brief Prepares draw command for rendering a gate.
-   *
-   * This function prepares a draw command for rendering the specified gate. The
-   * draw command includes information necessary to render the gate.
-   *
-   * @param gate The gate to prepare the draw command for.
-   * @return A rendering::Draw_Elements_Command for rendering the gate.
-   */
-  [[nodiscard]] rendering::Draw_Elements_Command prepare_draw(Gate const& gate);
-
 } // namespace nebula
@@ -0,0 +1,237 @@
+#include <model/loops.hpp>
+
+#include <core/components.hpp>
+
+namespace nebula {
+  [[nodiscard]] static u64 get_key(Gate const* const gate)
+  {
+    return reinterpret_cast<u64>(gate);
+  }
+
+  [[nodiscard]] static bool reads_itself(Gate const& gate)
+  {
+    for(Port const* const out: gate.out_ports) {
+      for(Port const* const in: out->connections) {
+        if(in->gate == &gate) {
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  // index_loops
+  //
+  // Rebuild the map from the gates to their loops.
+  //
+  static void index_loops(Combinational_Loops& loops)
+  {
+    loops.loop_of.clear();
+    i64 const count = get_loop_count(loops);
+    for(i64 i = 0; i < count; ++i) {
+      for(u32 j = loops.offsets[i]; j < loops.offsets[i + 1]; ++j) {
+        loops.loop_of.emplace(get_key(loops.gates[j]), i);
+      }
+    }
+  }
+
+  // find_loops
+  //
+  // Find the strongly connected components of the graph of the
+  // combinational gates and keep those that are loops.
+  //
+  static void find_loops(Combinational_Loops& loops, List<Gate>& gates)
+  {
+    // Maps the address of a combinational gate to its vertex.
+    Flat_Hash_Map<u64, u32> vertices;
+    Array<Gate*> list;
+    for(Gate& gate: gates) {
+      if(is_combinational(gate.kind)) {
+        vertices.emplace(get_key(&gate), list.size());
+        list.push_back(&gate);
+      }
+    }
+
+    Array<u32> edge_offsets{anton::reserve, list.size() + 1};
+    Array<u32> edges;
+    for(Gate const* const gate: list) {
+      edge_offsets.push_back(edges.size());
+      for(Port const* const out: gate->out_ports) {
+        for(Port const* const in: out->connections) {
+          auto iter = vertices.find(get_key(in->gate));
+          if(iter != vertices.end()) {
+            edges.push_back(iter->value);
+          }
+        }
+      }
+    }
+    edge_offsets.push_back(edges.size());
+
+    Strong_Components components;
+    find_strong_components(
+      Slice<u32 const>(edge_offsets.data(), edge_offsets.size()),
+      Slice<u32 const>(edges.data(), edges.size()), components);
+    loops.gates.clear();
+    loops.offsets.clear();
+    for(i64 i = 0; i + 1 < components.offsets.size(); ++i) {
+      u32 const first = components.offsets[i];
+      u32 const end = components.offsets[i + 1];
+      if(end - first == 1 && !reads_itself(*list[components.vertices[first]])) {
+        continue;
+      }
+
+      loops.offsets.push_back(loops.gates.size());
+      for(u32 j = first; j < end; ++j) {
+        loops.gates.push_back(list[components.vertices[j]]);
+      }
+    }
+    loops.offsets.push_back(loops.gates.size());
+    index_loops(loops);
+  }
+
+  void update_loops(Combinational_Loops& loops, List<Gate>& gates)
+  {
+    u64 const revision = get_connection_revision();
+    if(loops.revision != revision) {
+      find_loops(loops, gates);
+      loops.revision = revision;
+    }
+  }
+
+  // merge_loop
+  //
+  // Replace the loops of the members by a single loop of the members.
+  //
+  static void merge_loop(Combinational_Loops& loops,
+                         Array<Gate*> const& members)
+  {
+    i64 const count = get_loop_count(loops);
+    Array<u8> absorbed{count, 0};
+    for(Gate const* const gate: members) {
+      i64 const loop = find_loop(loops, gate);
+      if(loop >= 0) {
+        absorbed[loop] = 1;
+      }
+    }
+
+    Array<Gate*> gates;
+    Array<u32> offsets;
+    for(i64 i = 0; i < count; ++i) {
+      if(absorbed[i]) {
+        continue;
+      }
+
+      offsets.push_back(gates.size());
+      for(u32 j = loops.offsets[i]; j < loops.offsets[i + 1]; ++j) {
+        gates.push_back(loops.gates[j]);
+      }
+    }
+    offsets.push_back(gates.size());
+    for(Gate* const gate: members) {
+      gates.push_back(gate);
+    }
+    offsets.push_back(gates.size());
+    loops.gates = ANTON_MOV(gates);
+    loops.offsets = ANTON_MOV(offsets);
+    index_loops(loops);
+  }
+
+  void add_loop_connection(Combinational_Loops& loops,
+                           Port const* const driver, Port const* const reader,
+                           u64 const revision)
+  {
+    if(loops.revision != revision) {
+      return;
+    }
+
+    Gate* const source = driver->gate;
+    Gate* const target = reader->gate;
+    if(source == nullptr || target == nullptr ||
+       !is_combinational(source->kind) || !is_combinational(target->kind)) {
+      loops.revision = get_connection_revision();
+      return;
+    }
+
+    i64 const loop = find_loop(loops, source);
+    if(loop >= 0 && loop == find_loop(loops, target)) {
+      loops.revision = get_connection_revision();
+      return;
+    }
+
+    // Maps the address of a gate reachable from the reader to whether it
+    // reaches the driver as well.
+    Flat_Hash_Map<u64, u8> reached;
+    reached.emplace(get_key(target), 0);
+    Array<Gate*> stack;
+    stack.push_back(target);
+    i64 visited = 1;
+    bool closed = false;
+    while(stack.size() > 0) {
+      Gate const* const gate = stack.back();
+      stack.pop_back();
+      closed = closed || gate == source;
+      for(Port const* const out: gate->out_ports) {
+        for(Port const* const in: out->connections) {
+          Gate* const next = in->gate;
+          if(next == nullptr || !is_combinational(next->kind) ||
+             reached.find(get_key(next)) != reached.end()) {
+            continue;
+          }
+
+          if(visited == loop_search_limit) {
+            // Too costly to search, the loops are found anew when needed.
+            return;
+          }
+          visited += 1;
+          reached.emplace(get_key(next), 0);
+          stack.push_back(next);
+        }
+      }
+    }
+
+    loops.revision = get_connection_revision();
+    if(!closed) {
+      return;
+    }
+
+    // The gates of the loop reach the driver through gates reachable from
+    // the reader.
+    Array<Gate*> members;
+    members.push_back(source);
+    reached.find(get_key(source))->value = 1;
+    for(i64 head = 0; head < members.size(); ++head) {
+      for(Port const* const in: members[head]->in_ports) {
+        for(Port const* const out: in->connections) {
+          auto iter = reached.find(get_key(out->gate));
+          if(iter != reached.end() && iter->value == 0) {
+            iter->value = 1;
+            members.push_back(out->gate);
+          }
+        }
+      }
+    }
+    merge_loop(loops, members);
+  }
+
+  void carry_loops(Combinational_Loops& loops, u64 const revision)
+  {
+    if(loops.revision == revision) {
+      loops.revision = get_connection_revision();
+    }
+  }
+
+  i64 find_loop(Combinational_Loops const& loops, Gate const* const gate)
+  {
+    auto iter = loops.loop_of.find(get_key(gate));
+    if(iter != loops.loop_of.end()) {
+      return iter->value;
+    } else {
+      return -1;
+    }
+  }
+
+  i64 get_loop_count(Combinational_Loops const& loops)
+  {
+    return loops.offsets.size() > 0 ? loops.offsets.size() - 1 : 0;
+  }
+} // namespace nebula
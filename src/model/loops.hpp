@@ -0,0 +1,75 @@
+#pragma once
+
+#include <anton/flat_hash_map.hpp>
+
+#include <core/types.hpp>
+#include <model/gate.hpp>
+
+namespace nebula {
+  /**
+   * @brief Number of gates a search for a new loop may visit after a
+   * connection. Larger searches leave the loops to be found anew.
+   */
+  constexpr i64 loop_search_limit = 4096;
+
+  /**
+   * @brief Combinational loops of a netlist, that is the strongly connected
+   * components of its combinational gates with more than one gate or a gate
+   * reading itself.
+   *
+   * Loops through sequential gates, memories or module instances are not
+   * combinational since those gates read the previous values of their
+   * inputs.
+   */
+  struct Combinational_Loops {
+    // Gates grouped by loop. The gates of loop i are those from offsets[i]
+    // to offsets[i + 1].
+    Array<Gate*> gates;
+    Array<u32> offsets;
+    // Maps the address of a gate in a loop to its loop.
+    Flat_Hash_Map<u64, u32> loop_of;
+    // Connection revision the loops are known at. Unknown initially.
+    u64 revision = static_cast<u64>(-1);
+  };
+
+  /**
+   * @brief Finds the loops of the gates anew unless the connections have not
+   * changed since they were last known.
+   */
+  void update_loops(Combinational_Loops& loops, List<Gate>& gates);
+
+  /**
+   * @brief Updates known loops after a driver has been connected to a
+   * reader.
+   *
+   * A loop is closed by the connection if the reader reaches the driver,
+   * hence only the fanout of the reader is searched. The gates of the new
+   * loop are those both reachable from the reader and reaching the driver,
+   * which absorbs the loops they were in.
+   *
+   * @param driver The out port.
+   * @param reader The in port.
+   * @param revision The connection revision before connecting. The loops are
+   * left unknown unless they were known at it.
+   */
+  void add_loop_connection(Combinational_Loops& loops, Port const* driver,
+                           Port const* reader, u64 revision);
+
+  /**
+   * @brief Keeps known loops known across a change of the connection
+   * revision that cannot close or break a loop, for example adding a gate.
+   *
+   * @param revision The connection revision before the change.
+   */
+  void carry_loops(Combinational_Loops& loops, u64 revision);
+
+  /**
+   * @brief Gets the loop of a gate.
+   *
+   * @return The index of the loop or -1 if the gate is not in a loop.
+   */
+  [[nodiscard]] i64 find_loop(Combinational_Loops const& loops,
+                              Gate const* gate);
+
+  [[nodiscard]] i64 get_loop_count(Combinational_Loops const& loops);
+} // namespace nebula
@@ -0,0 +1,292 @@
+#include <model/memory.hpp>
+
+#include <anton/format.hpp>
+#include <anton/math/math.hpp>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace nebula {
+  // Mapped_File
+  //
+  // A file mapped read-only into memory. Empty files are not mapped, in
+  // which case data is nullptr.
+  //
+  struct Mapped_File {
+    u8 const* data = nullptr;
+    i64 size = 0;
+  };
+
+  [[nodiscard]] static Expected<Mapped_File, Error>
+  map_file(String const& path)
+  {
+    int const descriptor = open(path.data(), O_RDONLY);
+    if(descriptor < 0) {
+      return {expected_error, format("could not open '{}'"_sv, path)};
+    }
+
+    struct stat status;
+    if(fstat(descriptor, &status) != 0) {
+      close(descriptor);
+      return {expected_error, format("could not stat '{}'"_sv, path)};
+    }
+
+    Mapped_File file;
+    file.size = status.st_size;
+    if(file.size > 0) {
+      void* const data =
+        mmap(nullptr, file.size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+      if(data == MAP_FAILED) {
+        close(descriptor);
+        return {expected_error, format("could not map '{}'"_sv, path)};
+      }
+      file.data = static_cast<u8 const*>(data);
+    }
+    // The mapping remains valid after the descriptor is closed.
+    close(descriptor);
+    return {expected_value, file};
+  }
+
+  static void unmap_file(Mapped_File const& file)
+  {
+    if(file.data != nullptr) {
+      munmap(const_cast<u8*>(file.data), file.size);
+    }
+  }
+
+  [[nodiscard]] static bool ends_with(String_View const string,
+                                      String_View const suffix)
+  {
+    if(string.size_bytes() < suffix.size_bytes()) {
+      return false;
+    }
+    return String_View{string.data() + string.size_bytes() -
+                         suffix.size_bytes(),
+                       string.data() + string.size_bytes()} == suffix;
+  }
+
+  [[nodiscard]] static u64 get_word_mask(Memory_Definition const& definition)
+  {
+    if(definition.data_width >= 64) {
+      return ~static_cast<u64>(0);
+    }
+    return (static_cast<u64>(1) << definition.data_width) - 1;
+  }
+
+  [[nodiscard]] static bool is_space(u8 const c)
+  {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\f' ||
+           c == '\v';
+  }
+
+  [[nodiscard]] static i32 get_hex_digit(u8 const c)
+  {
+    if(c >= '0' && c <= '9') {
+      return c - '0';
+    } else if(c >= 'a' && c <= 'f') {
+      return c - 'a' + 10;
+    } else if(c >= 'A' && c <= 'F') {
+      return c - 'A' + 10;
+    } else {
+      return -1;
+    }
+  }
+
+  // parse_hex_image
+  //
+  // Parse an image in the format of $readmemh. Words are written to
+  // consecutive addresses starting at 0 or at the last @<address>.
+  // Underscores within words are ignored.
+  //
+  [[nodiscard]] static Expected<void, Error>
+  parse_hex_image(Memory_Definition const& definition, Array<u8>& contents,
+                  Mapped_File const& file)
+  {
+    u64 const word_count = static_cast<u64>(1) << definition.address_width;
+    u64 const mask = get_word_mask(definition);
+    u8 const* i = file.data;
+    u8 const* const end = file.data + file.size;
+    i64 line = 1;
+    u64 address = 0;
+    while(i != end) {
+      if(*i == '\n') {
+        line += 1;
+        ++i;
+        continue;
+      } else if(is_space(*i)) {
+        ++i;
+        continue;
+      } else if(*i == '/' && i + 1 != end && *(i + 1) == '/') {
+        while(i != end && *i != '\n') {
+          ++i;
+        }
+        continue;
+      }
+
+      bool const is_address = *i == '@';
+      if(is_address) {
+        ++i;
+      }
+
+      u64 value = 0;
+      i64 digits = 0;
+      for(; i != end && !is_space(*i); ++i) {
+        if(*i == '_') {
+          continue;
+        }
+
+        i32 const digit = get_hex_digit(*i);
+        if(digit < 0) {
+          String_View const character{reinterpret_cast<char const*>(i), 1};
+          return {expected_error,
+                  format("line {}: invalid hex digit '{}'"_sv, line,
+                         character)};
+        }
+        value = (value << 4) | static_cast<u64>(digit);
+        digits += 1;
+      }
+
+      if(digits == 0) {
+        return {expected_error, format("line {}: expected a number"_sv, line)};
+      } else if(is_address) {
+        address = value;
+      } else if(address >= word_count) {
+        return {expected_error,
+                format("line {}: address {} is outside of the memory"_sv, line,
+                       address)};
+      } else {
+        write_word(definition, contents.data(), address, value & mask);
+        address += 1;
+      }
+    }
+    return expected_value;
+  }
+
+  // copy_binary_image
+  //
+  // Copy a raw image and clear the bits of every word above data_width.
+  //
+  [[nodiscard]] static Expected<void, Error>
+  copy_binary_image(Memory_Definition const& definition, Array<u8>& contents,
+                    Mapped_File const& file)
+  {
+    if(file.size > contents.size()) {
+      return {expected_error,
+              format("image of {} bytes exceeds the memory of {} bytes"_sv,
+                     file.size, contents.size())};
+    }
+
+    if(file.size > 0) {
+      memcpy(contents.data(), file.data, file.size);
+    }
+    if(definition.data_width % 8 != 0) {
+      i64 const word_size = get_word_size(definition);
+      u8 const mask = static_cast<u8>((1 << (definition.data_width % 8)) - 1);
+      for(i64 i = word_size - 1; i < contents.size(); i += word_size) {
+        contents[i] &= mask;
+      }
+    }
+    return expected_value;
+  }
+
+  Expected<Memory_Definition*, Error>
+  define_memory(List<Memory_Definition>& memories, String name,
+                i64 const address_width, i64 const data_width,
+                String_View const image)
+  {
+    if(address_width < 1 || address_width > max_address_width) {
+      return {expected_error,
+              format("address width must be between 1 and {}"_sv,
+                     max_address_width)};
+    } else if(data_width < 1 || data_width > max_data_width) {
+      return {expected_error, format("data width must be between 1 and {}"_sv,
+                                     max_data_width)};
+    }
+
+    Memory_Definition definition;
+    definition.name = ANTON_MOV(name);
+    definition.address_width = address_width;
+    definition.data_width = data_width;
+    definition.contents.resize(
+      (static_cast<i64>(1) << address_width) * get_word_size(definition), 0);
+    if(image.size_bytes() > 0) {
+      Expected<Mapped_File, Error> mapped = map_file(String(image));
+      if(!mapped) {
+        return {expected_error, ANTON_MOV(mapped.error())};
+      }
+
+      Mapped_File const& file = mapped.value();
+      Expected<void, Error> result =
+        ends_with(image, ".hex"_sv) || ends_with(image, ".mem"_sv)
+          ? parse_hex_image(definition, definition.contents, file)
+          : copy_binary_image(definition, definition.contents, file);
+      unmap_file(file);
+      if(!result) {
+        return {expected_error,
+                format("{}: {}"_sv, image, ANTON_MOV(result.error()))};
+      }
+    }
+
+    Memory_Definition& added = *memories.emplace_back(ANTON_MOV(definition));
+    return {expected_value, &added};
+  }
+
+  bool is_memory(Gate_Kind const kind)
+  {
+    return kind == Gate_Kind::e_ram || kind == Gate_Kind::e_rom;
+  }
+
+  i64 get_word_size(Memory_Definition const& definition)
+  {
+    return (definition.data_width + 7) / 8;
+  }
+
+  i64 get_memory_input_count(Gate_Kind const kind,
+                             Memory_Definition const& definition)
+  {
+    if(kind == Gate_Kind::e_ram) {
+      return definition.address_width + definition.data_width + 2;
+    } else {
+      return definition.address_width;
+    }
+  }
+
+  i64 get_memory_state_size(Gate_Kind const kind,
+                            Memory_Definition const& definition)
+  {
+    if(kind == Gate_Kind::e_ram) {
+      return definition.data_width + 1;
+    } else {
+      return definition.data_width;
+    }
+  }
+
+  Vec2 get_memory_dimensions(Gate_Kind const kind,
+                             Memory_Definition const& definition)
+  {
+    i64 const ports = math::max(get_memory_input_count(kind, definition),
+                                definition.data_width);
+    f32 const height = math::max(0.5f, 0.25f * static_cast<f32>(ports));
+    return Vec2{0.8f, height};
+  }
+
+  u64 read_word(Memory_Definition const& definition, u8 const* const contents,
+                u64 const address)
+  {
+    // Words are little-endian like the host.
+    i64 const word_size = get_word_size(definition);
+    u64 word = 0;
+    memcpy(&word, contents + address * word_size, word_size);
+    return word;
+  }
+
+  void write_word(Memory_Definition const& definition, u8* const contents,
+                  u64 const address, u64 const value)
+  {
+    i64 const word_size = get_word_size(definition);
+    u64 const word = value & get_word_mask(definition);
+    memcpy(contents + address * word_size, &word, word_size);
+  }
+} // namespace nebula
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <anton/expected.hpp>
+#include <anton/string_view.hpp>
+
+#include <core/error.hpp>
+#include <core/types.hpp>
+#include <model/gate.hpp>
+
+namespace nebula {
+  constexpr i64 max_address_width = 24;
+  constexpr i64 max_data_width = 64;
+
+  /**
+   * @brief Shape and initial contents of a RAM or ROM block.
+   *
+   * A memory stores 2^address_width words of data_width bits. Every word
+   * occupies get_word_size bytes of contents in little-endian order. The
+   * definition is shared by all its instances like a module definition. ROM
+   * instances read the contents of the definition, RAM instances copy them
+   * on their first evaluation.
+   */
+  struct Memory_Definition {
+    String name;
+    i64 address_width = 0;
+    i64 data_width = 0;
+    Array<u8> contents;
+  };
+
+  /**
+   * @brief Creates a memory definition.
+   *
+   * The contents are loaded from an image file which is mapped into memory.
+   * Files ending with .hex or .mem are text in the format of $readmemh, that
+   * is hexadecimal words separated by whitespace, @<address> directives and
+   * // comments. Any other file is raw binary with every word occupying
+   * get_word_size bytes in little-endian order. Words that the image does
+   * not cover are 0.
+   *
+   * @param memories The list of definitions to add the definition to.
+   * @param name The name of the definition.
+   * @param address_width The number of address bits. At most
+   * max_address_width.
+   * @param data_width The number of bits of a word. At most max_data_width.
+   * @param image The path of the image file. Empty leaves all words 0.
+   * @return The new definition or an error if the widths are out of range
+   * or the image could not be loaded. The list is not modified on error.
+   */
+  [[nodiscard]] Expected<Memory_Definition*, Error>
+  define_memory(List<Memory_Definition>& memories, String name,
+                i64 address_width, i64 data_width, String_View image);
+
+  /**
+   * @brief Checks whether gates of a kind are RAM or ROM blocks.
+   */
+  [[nodiscard]] bool is_memory(Gate_Kind kind);
+
+  /**
+   * @brief Gets the number of bytes of a word of a memory.
+   */
+  [[nodiscard]] i64 get_word_size(Memory_Definition const& definition);
+
+  /**
+   * @brief Gets the number of inputs of an instance of a memory.
+   *
+   * ROM blocks have the address inputs A0 to An. RAM blocks follow them with
+   * the data inputs D0 to Dm, WE and CLK.
+   *
+   * @param kind e_ram or e_rom.
+   */
+  [[nodiscard]] i64 get_memory_input_count(Gate_Kind kind,
+                                           Memory_Definition const& definition);
+
+  /**
+   * @brief Gets the number of bytes of Gate::state of an instance of a
+   * memory.
+   *
+   * The state holds one byte per output followed by the level of CLK for
+   * RAM blocks.
+   *
+   * @param kind e_ram or e_rom.
+   */
+  [[nodiscard]] i64 get_memory_state_size(Gate_Kind kind,
+                                          Memory_Definition const& definition);
+
+  /**
+   * @brief Gets the dimensions of an instance of a memory.
+   *
+   * @param kind e_ram or e_rom.
+   */
+  [[nodiscard]] Vec2 get_memory_dimensions(Gate_Kind kind,
+                                           Memory_Definition const& definition);
+
+  /**
+   * @brief Reads a word of contents laid out as the contents of a memory.
+   *
+   * @param address The index of the word. Must be within the memory.
+   */
+  [[nodiscard]] u64 read_word(Memory_Definition const& definition,
+                              u8 const* contents, u64 address);
+
+  /**
+   * @brief Writes a word of contents laid out as the contents of a memory.
+   *
+   * Bits above data_width are discarded.
+   *
+   * @param address The index of the word. Must be within the memory.
+   */
+  void write_word(Memory_Definition const& definition, u8* contents,
+                  u64 address, u64 value);
+} // namespace nebula
@@ -0,0 +1,279 @@
+#include <model/module.hpp>
+
+#include <anton/flat_hash_map.hpp>
+#include <anton/format.hpp>
+#include <anton/math/math.hpp>
+
+#include <model/memory.hpp>
+
+namespace nebula {
+  Flat_Module const& get_flat_module(Module_Definition& definition)
+  {
+    if(definition.flattened) {
+      return definition.flat;
+    }
+
+    i64 const input_count = definition.input_names.size();
+    // Offsets of the gates within the flattened gates. A submodule takes as
+    // many flat gates as its own flattened form.
+    Array<u32> offsets{anton::reserve, definition.gates.size()};
+    i64 flat_size = 0;
+    for(Module_Gate const& gate: definition.gates) {
+      offsets.push_back(flat_size);
+      if(gate.kind == Gate_Kind::e_module) {
+        flat_size += get_flat_module(*gate.definition).gates.size();
+      } else {
+        flat_size += 1;
+      }
+    }
+
+    i64 signal_count = input_count;
+    for(Module_Gate const& gate: definition.gates) {
+      if(gate.kind == Gate_Kind::e_module) {
+        signal_count += gate.definition->output_names.size();
+      } else {
+        signal_count += 1;
+      }
+    }
+
+    // Map the signals of the definition to the references of the flattened
+    // module. Outputs of submodules are always driven by their gates, hence
+    // the map can be built in a single pass.
+    Array<u32> signals{signal_count, invalid_signal};
+    for(i64 i = 0; i < input_count; ++i) {
+      signals[i] = i;
+    }
+    for(i64 i = 0; i < definition.gates.size(); ++i) {
+      Module_Gate const& gate = definition.gates[i];
+      u32 const base = input_count + offsets[i];
+      if(gate.kind == Gate_Kind::e_module) {
+        Flat_Module const& sub = gate.definition->flat;
+        for(i64 j = 0; j < sub.outputs.size(); ++j) {
+          u32 const output = sub.outputs[j];
+          if(output != invalid_signal) {
+            ANTON_ASSERT(output >= sub.input_count,
+                         "module output driven by a module input");
+            signals[gate.first_output + j] = base + output - sub.input_count;
+          }
+        }
+      } else {
+        signals[gate.first_output] = base;
+      }
+    }
+
+    auto map_signal = [&signals](u32 const signal) -> u32 {
+      return signal != invalid_signal ? signals[signal] : invalid_signal;
+    };
+
+    Flat_Module& flat = definition.flat;
+    flat.input_count = input_count;
+    flat.gates.ensure_capacity(flat_size);
+    for(Module_Gate const& gate: definition.gates) {
+      if(gate.kind != Gate_Kind::e_module) {
+        ANTON_ASSERT(can_flatten(gate.kind), "gate cannot be flattened");
+        Flat_Gate flat_gate{gate.kind, {invalid_signal, invalid_signal}};
+        i64 const count = get_input_count(gate.kind);
+        for(i64 i = 0; i < count; ++i) {
+          u32 const signal = definition.gate_inputs[gate.first_input + i];
+          flat_gate.inputs[i] = map_signal(signal);
+        }
+        flat.gates.push_back(flat_gate);
+        continue;
+      }
+
+      // Relocate the gates of the submodule. References to the inputs of the
+      // submodule are replaced with the signals driving them.
+      Flat_Module const& sub = gate.definition->flat;
+      u32 const base = input_count + flat.gates.size();
+      for(Flat_Gate flat_gate: sub.gates) {
+        for(u32& input: flat_gate.inputs) {
+          if(input == invalid_signal) {
+            continue;
+          } else if(input < sub.input_count) {
+            u32 const signal = definition.gate_inputs[gate.first_input + input];
+            input = map_signal(signal);
+          } else {
+            input = base + input - sub.input_count;
+          }
+        }
+        flat.gates.push_back(flat_gate);
+      }
+    }
+
+    flat.outputs.ensure_capacity(definition.outputs.size());
+    for(u32 const signal: definition.outputs) {
+      flat.outputs.push_back(map_signal(signal));
+    }
+
+    definition.flattened = true;
+    return flat;
+  }
+
+  bool can_flatten(Gate_Kind const kind)
+  {
+    return !is_sequential(kind) && !is_memory(kind) && kind != Gate_Kind::e_lut;
+  }
+
+  Module_Definition& define_module(List<Module_Definition>& modules,
+                                   String name, Slice<Gate* const> const gates)
+  {
+    Module_Definition& definition = *modules.emplace_back();
+    definition.name = ANTON_MOV(name);
+
+    // Maps the address of a gate to its index.
+    Flat_Hash_Map<u64, u32> indices;
+    for(i64 i = 0; i < gates.size(); ++i) {
+      indices.emplace(reinterpret_cast<u64>(gates[i]), static_cast<u32>(i));
+    }
+
+    // Input gates and ports outside of the set driving gates in the set become
+    // the inputs of the module. Input gates retain their names.
+    // Maps the address of a port outside of the set to its input.
+    Flat_Hash_Map<u64, u32> external_inputs;
+    Array<u32> input_gate_signals{gates.size(), invalid_signal};
+    for(i64 i = 0; i < gates.size(); ++i) {
+      Gate const* const gate = gates[i];
+      if(gate->kind == Gate_Kind::e_input) {
+        input_gate_signals[i] = definition.input_names.size();
+        if(gate->name.size_bytes() > 0) {
+          definition.input_names.push_back(gate->name);
+        } else {
+          definition.input_names.push_back(
+            format("in{}"_sv, definition.input_names.size()));
+        }
+        continue;
+      }
+
+      for(Port const* const port: gate->in_ports) {
+        if(port->connections.size() != 1) {
+          continue;
+        }
+
+        Port const* const other = *port->connections.begin();
+        if(other->gate == nullptr ||
+           indices.find(reinterpret_cast<u64>(other->gate)) != indices.end()) {
+          continue;
+        }
+
+        u64 const key = reinterpret_cast<u64>(other);
+        if(external_inputs.find(key) == external_inputs.end()) {
+          external_inputs.emplace(key, definition.input_names.size());
+          if(other->gate->name.size_bytes() > 0) {
+            definition.input_names.push_back(other->gate->name);
+          } else {
+            definition.input_names.push_back(
+              format("in{}"_sv, definition.input_names.size()));
+          }
+        }
+      }
+    }
+
+    // Number the outputs of the remaining gates.
+    Array<u32> first_outputs{gates.size(), invalid_signal};
+    u32 signal = definition.input_names.size();
+    for(i64 i = 0; i < gates.size(); ++i) {
+      if(gates[i]->kind == Gate_Kind::e_input) {
+        continue;
+      }
+
+      first_outputs[i] = signal;
+      signal += gates[i]->out_ports.size();
+    }
+
+    for(i64 i = 0; i < gates.size(); ++i) {
+      Gate const* const gate = gates[i];
+      if(gate->kind == Gate_Kind::e_input) {
+        continue;
+      }
+
+      definition.gates.push_back(
+        Module_Gate{gate->kind, gate->definition,
+                    static_cast<u32>(definition.gate_inputs.size()),
+                    first_outputs[i]});
+      for(Port const* const port: gate->in_ports) {
+        if(port->connections.size() != 1) {
+          definition.gate_inputs.push_back(invalid_signal);
+          continue;
+        }
+
+        Port const* const other = *port->connections.begin();
+        auto iter = indices.find(reinterpret_cast<u64>(other->gate));
+        if(other->gate == nullptr) {
+          definition.gate_inputs.push_back(invalid_signal);
+        } else if(iter == indices.end()) {
+          u64 const key = reinterpret_cast<u64>(other);
+          definition.gate_inputs.push_back(external_inputs.find(key)->value);
+        } else if(other->gate->kind == Gate_Kind::e_input) {
+          definition.gate_inputs.push_back(input_gate_signals[iter->value]);
+        } else {
+          definition.gate_inputs.push_back(first_outputs[iter->value] +
+                                           other->index);
+        }
+      }
+
+      // Outputs leaving the set or not connected at all become the outputs of
+      // the module.
+      for(i64 j = 0; j < gate->out_ports.size(); ++j) {
+        bool external = gate->out_ports[j]->connections.size() == 0;
+        for(Port const* const other: gate->out_ports[j]->connections) {
+          if(other->gate != nullptr &&
+             indices.find(reinterpret_cast<u64>(other->gate)) ==
+               indices.end()) {
+            external = true;
+          }
+        }
+        if(!external) {
+          continue;
+        }
+
+        definition.outputs.push_back(first_outputs[i] + j);
+        if(gate->name.size_bytes() > 0 && gate->out_ports.size() == 1) {
+          definition.output_names.push_back(gate->name);
+        } else {
+          definition.output_names.push_back(
+            format("out{}"_sv, definition.output_names.size()));
+        }
+      }
+    }
+
+    return definition;
+  }
+
+  Vec2 get_instance_dimensions(Module_Definition const& definition)
+  {
+    i64 const ports = math::max(definition.input_names.size(),
+                                definition.output_names.size());
+    f32 const height = math::max(0.5f, 0.25f * static_cast<f32>(ports));
+    return Vec2{0.8f, height};
+  }
+
+  bool get_module_output(Gate const& gate, i64 const output)
+  {
+    ANTON_ASSERT(gate.kind == Gate_Kind::e_module, "gate is not a module");
+    Flat_Module const& flat = gate.definition->flat;
+    if(gate.state.size() == 0 || !gate.definition->flattened) {
+      return false;
+    }
+
+    u32 const reference = flat.outputs[output];
+    if(reference == invalid_signal) {
+      return false;
+    }
+    return (gate.state[reference] & 2) != 0;
+  }
+
+  bool get_module_output_unknown(Gate const& gate, i64 const output)
+  {
+    ANTON_ASSERT(gate.kind == Gate_Kind::e_module, "gate is not a module");
+    Flat_Module const& flat = gate.definition->flat;
+    if(gate.state.size() == 0 || !gate.definition->flattened) {
+      return true;
+    }
+
+    u32 const reference = flat.outputs[output];
+    if(reference == invalid_signal) {
+      return true;
+    }
+    return (gate.state[reference] & 8) != 0;
+  }
+} // namespace nebula
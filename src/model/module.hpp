@@ -0,0 +1,134 @@
+#pragma once
+
+#include <anton/slice.hpp>
+
+#include <core/types.hpp>
+#include <model/gate.hpp>
+
+namespace nebula {
+  constexpr u32 invalid_signal = static_cast<u32>(-1);
+
+  /**
+   * @brief A gate within a module definition.
+   */
+  struct Module_Gate {
+    Gate_Kind kind;
+    // Definition of the submodule if kind is e_module.
+    Module_Definition* definition;
+    // Index of the signal driving the first input in
+    // Module_Definition::gate_inputs. The inputs of a gate are consecutive.
+    u32 first_input;
+    // Signal driven by the first output. The outputs of a gate are
+    // consecutive signals.
+    u32 first_output;
+  };
+
+  /**
+   * @brief A primitive gate of a flattened module.
+   */
+  struct Flat_Gate {
+    Gate_Kind kind;
+    // References of the values driving the inputs. See Flat_Module.
+    u32 inputs[2];
+  };
+
+  /**
+   * @brief A module definition with all submodules inlined.
+   *
+   * Values are referenced by indices. A reference r below input_count refers to
+   * the input r of the module, any other reference refers to the gate
+   * r - input_count. invalid_signal refers to an unconnected input, which reads
+   * false.
+   */
+  struct Flat_Module {
+    i64 input_count = 0;
+    Array<Flat_Gate> gates;
+    // References of the values driving the outputs of the module.
+    Array<u32> outputs;
+  };
+
+  /**
+   * @brief A reusable subcircuit with named inputs and outputs.
+   *
+   * Signals of a definition are numbered starting with the inputs of the
+   * module followed by the outputs of its gates in order. A definition may
+   * contain instances of other definitions. The definition is shared by all of
+   * its instances, which store only their simulation state.
+   */
+  struct Module_Definition {
+    String name;
+    Array<String> input_names;
+    Array<String> output_names;
+    Array<Module_Gate> gates;
+    // Signals driving the inputs of the gates.
+    Array<u32> gate_inputs;
+    // Signals driving the outputs of the module.
+    Array<u32> outputs;
+    // The definition flattened on first use.
+    Flat_Module flat;
+    bool flattened = false;
+  };
+
+  /**
+   * @brief Gets the flattened form of a definition.
+   *
+   * The definition and all its submodules are flattened on the first call.
+   * The result is cached in the definition.
+   *
+   * @param definition The definition to flatten.
+   * @return The flattened definition.
+   */
+  [[nodiscard]] Flat_Module const&
+  get_flat_module(Module_Definition& definition);
+
+  /**
+   * @brief Checks whether gates of a kind may be part of a module definition.
+   *
+   * Flattened modules hold only gates of at most two inputs whose state is
+   * their value, which excludes sequential gates, memories and LUTs.
+   */
+  [[nodiscard]] bool can_flatten(Gate_Kind kind);
+
+  /**
+   * @brief Creates a module definition from gates.
+   *
+   * Input gates among the gates and connections from gates outside of the set
+   * become the inputs of the module. Outputs connected to gates outside of the
+   * set and unconnected outputs become the outputs of the module. Instances of
+   * other modules among the gates become submodules. Every gate must satisfy
+   * can_flatten.
+   *
+   * @param modules The list of definitions to add the definition to.
+   * @param name The name of the definition.
+   * @param gates The gates forming the subcircuit.
+   * @return The new definition.
+   */
+  Module_Definition& define_module(List<Module_Definition>& modules,
+                                   String name, Slice<Gate* const> gates);
+
+  /**
+   * @brief Gets the dimensions of an instance of a definition.
+   */
+  [[nodiscard]] Vec2
+  get_instance_dimensions(Module_Definition const& definition);
+
+  /**
+   * @brief Gets the previous value of an output of a module instance.
+   *
+   * @param gate The module instance.
+   * @param output The index of the output.
+   */
+  [[nodiscard]] bool get_module_output(Gate const& gate, i64 output);
+
+  /**
+   * @brief Gets whether the previous value of an output of a module instance
+   * is unknown.
+   *
+   * Outputs of instances that have not been evaluated yet and unconnected
+   * outputs are unknown.
+   *
+   * @param gate The module instance.
+   * @param output The index of the output.
+   */
+  [[nodiscard]] bool get_module_output_unknown(Gate const& gate, i64 output);
+} // namespace nebula
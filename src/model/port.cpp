@@ -1,14 +1,28 @@
 #include <model/port.hpp>
-#include <rendering/rendering.hpp>
+
+#include <anton/math/vec2.hpp>
 
 namespace nebula {
+  static u64 connection_revision = 0;
+
   Port_Kind invert_port_kind(Port_Kind const kind)
   {
     return kind == Port_Kind::in ? Port_Kind::out : Port_Kind::in;
   }
 
-  Port::Port(Vec2 const coordinates, Port_Kind const kind, Gate* gate)
-    : coordinates(coordinates), kind(kind), gate(gate)
+  u64 get_connection_revision()
+  {
+    return connection_revision;
+  }
+
+  void bump_connection_revision()
+  {
+    connection_revision += 1;
+  }
+
+  Port::Port(Vec2 const coordinates, Port_Kind const kind, Gate* gate,
+             u32 const index)
+    : coordinates(coordinates), kind(kind), gate(gate), index(index)
   {
     radius = 0.11f; // Adjust this value
   }
@@ -17,6 +31,18 @@ namespace nebula {
   {
     coordinates.x += offset.x;
     coordinates.y += offset.y;
+    invalidate_route();
+  }
+
+  void Port::invalidate_route()
+  {
+    if(kind == Port_Kind::in) {
+      route.clear();
+    } else {
+      for(Port* port: connections) {
+        port->route.clear();
+      }
+    }
   }
 
   void Port::remove_connection(Port* old_port)
@@ -28,6 +54,8 @@ namespace nebula {
         break;
       }
     }
+    route.clear();
+    connection_revision += 1;
   }
 
   void Port::add_connection(Port* new_port)
@@ -40,6 +68,8 @@ namespace nebula {
       connections.erase_front();
     }
     connections.emplace_front(new_port);
+    route.clear();
+    connection_revision += 1;
   }
 
   void Port::remove_all_connections()
@@ -48,6 +78,8 @@ namespace nebula {
       port->remove_connection(this);
     }
     connections = {};
+    route.clear();
+    connection_revision += 1;
   }
 
   Vec2 Port::get_coordinates() const
@@ -60,79 +92,4 @@ namespace nebula {
     f32 const r2 = port.radius * port.radius;
     return math::length_squared(point - port.coordinates) <= r2;
   }
-
-  rendering::Draw_Elements_Command prepare_draw(Port const& port)
-  {
-    math::Vec3 color;
-    if(port.kind == Port_Kind::in) {
-      color = {0.99f, 0.3f, 0.3f};
-    } else {
-      color = {0.6f, 0.9f, 0.2f};
-    }
-    Vertex vert[] = {
-      Vertex{.position = {port.coordinates.x + port.radius,
-                          port.coordinates.y + port.radius, 0.0f},
-             .normal = color,
-             .uv = {1.0f, 1.0f}},
-      Vertex{.position = {port.coordinates.x - port.radius,
-                          port.coordinates.y + port.radius, 0.0f},
-             .normal = color,
-             .uv = {0.0f, 1.0f}},
-      Vertex{.position = {port.coordinates.x + port.radius,
-                          port.coordinates.y - port.radius, 0.0f},
-             .normal = color,
-             .uv = {1.0f, 0.0f}},
-      Vertex{.position = {port.coordinates.x - port.radius,
-                          port.coordinates.y - port.radius, 0.0f},
-             .normal = color,
-             .uv = {0.0f, 0.0f}},
-    };
-    u32 indices[] = {
-      0, 1, 2, 1, 3, 2,
-    };
-    rendering::Draw_Elements_Command cmd =
-      rendering::write_geometry(vert, indices);
-    cmd.instance_count = 1;
-    return cmd;
-  }
-
-  rendering::Draw_Elements_Command prepare_draw_connection(Vec2 const cords_1,
-                                                           Vec2 const cords_2)
-  {
-    // TODO: make it 'greener' when port output is true
-    // Calculate normalized direction vector
-    math::Vec2 direction = {cords_2.x - cords_1.x, cords_2.y - cords_1.y};
-    f32 const length =
-      math::sqrt(direction.x * direction.x + direction.y * direction.y);
-    direction /= length;
-    math::Vec2 const perpendicular = {-direction.y, direction.x};
-    f32 const thickness = 0.04f;
-
-    // Transform vertices using the normalized direction
-    Vertex vert[] = {
-      Vertex{.position = {cords_1.x + thickness * perpendicular.x,
-                          cords_1.y + thickness * perpendicular.y, 0.0f},
-             .normal = {0.5f, 0.8f, 0.5f},
-             .uv = {1.0f, 1.0f}},
-      Vertex{.position = {cords_1.x - thickness * perpendicular.x,
-                          cords_1.y - thickness * perpendicular.y, 0.0f},
-             .normal = {0.5f, 0.8f, 0.5f},
-             .uv = {0.0f, 1.0f}},
-      Vertex{.position = {cords_2.x + thickness * perpendicular.x,
-                          cords_2.y + thickness * perpendicular.y, 0.0f},
-             .normal = {0.5f, 0.8f, 0.5f},
-             .uv = {1.0f, 0.0f}},
-      Vertex{.position = {cords_2.x - thickness * perpendicular.x,
-                          cords_2.y - thickness * perpendicular.y, 0.0f},
-             .normal = {0.5f, 0.8f, 0.5f},
-             .uv = {0.0f, 0.0f}},
-    };
-    u32 indices[] = {
-      0, 1, 2, 1, 3, 2,
-    };
-    rendering::Draw_Elements_Command cmd =
-      rendering::write_geometry(vert, indices);
-    cmd.instance_count = 1;
-    return cmd;
-  }
 } // namespace nebula
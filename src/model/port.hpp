@@ -1,7 +1,6 @@
 #pragma once
 
 #include <core/types.hpp>
-#include <rendering/rendering.hpp>
 
 namespace nebula {
   struct Gate;
@@ -16,6 +15,24 @@ namespace nebula {
 
   [[nodiscard]] Port_Kind invert_port_kind(Port_Kind kind);
 
+  /**
+   * @brief Gets the number of changes of connections made so far.
+   *
+   * Every change of the connections of any port increments the revision,
+   * which lets caches derived from the connectivity detect that they are
+   * stale.
+   */
+  [[nodiscard]] u64 get_connection_revision();
+
+  /**
+   * @brief Increments the connection revision without changing any
+   * connection.
+   *
+   * Called when gates are added, which changes the netlist even if the gates
+   * are not connected yet.
+   */
+  void bump_connection_revision();
+
   /**
    * @brief Port structure.
    *
@@ -29,23 +46,43 @@ namespace nebula {
     f32 radius;
     Port_Kind kind;
     Gate* gate = nullptr;
+    // Position of the port within the IN or OUT ports of its gate.
+    u32 index = 0;
+    /**
+     * @brief Cached route of the connection ending at this port.
+     *
+     * Only used by IN ports. The route is a polyline from the OUT port to this
+     * port. An empty route means the connection has to be routed again. Moving
+     * either end of the connection or changing the connection clears the
+     * route.
+     */
+    Array<Vec2> route;
 
     /**
      * @brief Initializes a circle-shaped port with specified coordinates and type.
      *
      * @param coordinates The x and y coordinates of the center of the port.
      * @param type The type of the port (IN or OUT).
+     * @param index The position of the port within the ports of the gate of
+     * the same type.
      */
-    Port(Vec2 coordinates, Port_Kind type, Gate* gate);
+    Port(Vec2 coordinates, Port_Kind type, Gate* gate, u32 index);
 
     /**
      * @brief Moves the port by the given offset.
      *
+     * Invalidates the routes of the connections of the port.
+     *
      * @param offset The vector representing the offset from the previous gate
      * position.
      */
     void move(Vec2 offset);
 
+    /**
+     * @brief Clears the cached routes of all connections of the port.
+     */
+    void invalidate_route();
+
     /**
      * @brief Connects the port to another specified port.
      *
@@ -80,28 +117,4 @@ namespace nebula {
    * @return True if the port is under the mouse, false otherwise.
    */
   [[nodiscard]] bool test_hit(Port const& port, Vec2 point);
-  /**
-   * @brief Prepares draw command for rendering a port.
-   *
-   * This function prepares a draw command for rendering the specified port. The
-   * draw command includes information necessary to render the port.
-   *
-   * @param port The port to prepare the draw command for.
-   * @return A rendering::Draw_Elements_Command for rendering the port.
-   */
-  [[nodiscard]] rendering::Draw_Elements_Command prepare_draw(Port const& port);
-
-  /**
-   * @brief Prepares draw command for rendering a connection between two points.
-   *
-   * This function prepares a draw command for rendering a connection between
-   * two points. The draw command includes information necessary to render the
-   * connection.
-   *
-   * @param cords_1 The coordinates of the first point.
-   * @param cords_2 The coordinates of the second point.
-   * @return A rendering::Draw_Elements_Command for rendering the connection.
-   */
-  [[nodiscard]] rendering::Draw_Elements_Command
-  prepare_draw_connection(Vec2 cords_1, Vec2 cords_2);
 } // namespace nebula
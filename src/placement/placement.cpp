@@ -0,0 +1,616 @@
+#include <placement/placement.hpp>
+
+#include <anton/algorithm/sort.hpp>
+#include <anton/array.hpp>
+#include <anton/flat_hash_map.hpp>
+#include <anton/math/math.hpp>
+
+#include <core/parallel.hpp>
+#include <core/time.hpp>
+#include <logging/logging.hpp>
+#include <ui/scene.hpp>
+
+#include <atomic>
+#include <thread>
+
+namespace nebula {
+  // Placement_Graph
+  //
+  // Connectivity of the scene at the time the placement has been started.
+  // Gates are identified by their index in the scene's list of gates. Edges
+  // are stored in compressed sparse row form in both directions.
+  //
+  struct Placement_Graph {
+    // Maps the identifier of a gate to its index.
+    Flat_Hash_Map<u64, u32> indices;
+    // Identifiers of the gates by their indices. The gates are looked up by
+    // their identifiers once the placement is applied since they may have
+    // been deleted in the meantime.
+    Array<u64> ids;
+    Array<Vec2> dimensions;
+    Array<u32> fanin_offsets;
+    Array<u32> fanin;
+    Array<u32> fanout_offsets;
+    Array<u32> fanout;
+
+    [[nodiscard]] i64 size() const
+    {
+      return dimensions.size();
+    }
+  };
+
+  struct Placement_Job {
+    Placement_Graph graph;
+    Placement_Options options;
+    // Resulting coordinates of the top-left corners of the gates.
+    Array<Vec2> positions;
+    std::thread thread;
+    std::atomic<bool> finished = false;
+    std::atomic<bool> cancelled = false;
+  };
+
+  static void build_graph(Placement_Graph& graph, Scene const& scene)
+  {
+    u32 index = 0;
+    for(Gate const& gate: scene.gates) {
+      graph.indices.emplace(gate.id, index);
+      graph.ids.push_back(gate.id);
+      graph.dimensions.push_back(gate.dimensions);
+      index += 1;
+    }
+
+    i64 const n = graph.size();
+    graph.fanin_offsets.push_back(0);
+    for(Gate const& gate: scene.gates) {
+      for(Port const* const port: gate.in_ports) {
+        for(Port const* const other: port->connections) {
+          // The temporary linking port has no gate.
+          if(other->gate == nullptr) {
+            continue;
+          }
+
+          auto iter = graph.indices.find(other->gate->id);
+          if(iter != graph.indices.end()) {
+            graph.fanin.push_back(iter->value);
+          }
+        }
+      }
+      graph.fanin_offsets.push_back(graph.fanin.size());
+    }
+
+    // Transpose the fanin to obtain the fanout.
+    graph.fanout_offsets.resize(n + 1, 0);
+    for(u32 const driver: graph.fanin) {
+      graph.fanout_offsets[driver + 1] += 1;
+    }
+    for(i64 i = 0; i < n; ++i) {
+      graph.fanout_offsets[i + 1] += graph.fanout_offsets[i];
+    }
+    graph.fanout.resize(graph.fanin.size());
+    Array<u32> heads{anton::reserve, n};
+    for(i64 i = 0; i < n; ++i) {
+      heads.push_back(graph.fanout_offsets[i]);
+    }
+    for(i64 sink = 0; sink < n; ++sink) {
+      for(u32 e = graph.fanin_offsets[sink]; e < graph.fanin_offsets[sink + 1];
+          ++e) {
+        u32 const driver = graph.fanin[e];
+        graph.fanout[heads[driver]] = sink;
+        heads[driver] += 1;
+      }
+    }
+  }
+
+  // levelize
+  //
+  // Compute the logic depth of every gate, i.e. the length of the longest path
+  // from a gate without fanin. Kahn's algorithm stalls on combinational loops,
+  // in which case the next unvisited gate is visited regardless of its
+  // remaining fanin, which breaks the loop at that gate.
+  //
+  static void levelize(Placement_Graph const& graph, Array<u32>& levels)
+  {
+    i64 const n = graph.size();
+    levels.clear();
+    levels.resize(n, 0);
+    Array<u32> indegree{anton::reserve, n};
+    for(i64 i = 0; i < n; ++i) {
+      indegree.push_back(graph.fanin_offsets[i + 1] - graph.fanin_offsets[i]);
+    }
+
+    Array<u8> visited(n, 0);
+    Array<u32> queue{anton::reserve, n};
+    for(i64 i = 0; i < n; ++i) {
+      if(indegree[i] == 0) {
+        queue.push_back(i);
+        visited[i] = true;
+      }
+    }
+
+    i64 head = 0;
+    i64 cursor = 0;
+    while(head < n) {
+      if(head == queue.size()) {
+        while(visited[cursor]) {
+          ++cursor;
+        }
+        queue.push_back(cursor);
+        visited[cursor] = true;
+      }
+
+      u32 const gate = queue[head];
+      head += 1;
+      for(u32 e = graph.fanout_offsets[gate]; e < graph.fanout_offsets[gate + 1];
+          ++e) {
+        u32 const sink = graph.fanout[e];
+        if(visited[sink]) {
+          continue;
+        }
+
+        levels[sink] = math::max(levels[sink], levels[gate] + 1);
+        indegree[sink] -= 1;
+        if(indegree[sink] == 0) {
+          queue.push_back(sink);
+          visited[sink] = true;
+        }
+      }
+    }
+  }
+
+  // Columns
+  //
+  // Gates grouped by level. The gates of column c are
+  // nodes[offsets[c], offsets[c + 1]), ordered top to bottom.
+  //
+  struct Columns {
+    Array<u32> offsets;
+    Array<u32> nodes;
+    // Index of a gate within its column.
+    Array<u32> ranks;
+    Array<u32> levels;
+
+    [[nodiscard]] i64 count() const
+    {
+      return offsets.size() - 1;
+    }
+
+    [[nodiscard]] u32 column_size(u32 const level) const
+    {
+      return offsets[level + 1] - offsets[level];
+    }
+
+    // Position of a gate within its column normalised to [0, 1].
+    [[nodiscard]] f32 get_relative_rank(u32 const gate) const
+    {
+      f32 const size = column_size(levels[gate]);
+      return (static_cast<f32>(ranks[gate]) + 0.5f) / size;
+    }
+  };
+
+  static void build_columns(Columns& columns, Array<u32> const& levels)
+  {
+    i64 const n = levels.size();
+    u32 max_level = 0;
+    for(u32 const level: levels) {
+      max_level = math::max(max_level, level);
+    }
+
+    i64 const count = n > 0 ? max_level + 1 : 0;
+    columns.offsets.clear();
+    columns.offsets.resize(count + 1, 0);
+    for(u32 const level: levels) {
+      columns.offsets[level + 1] += 1;
+    }
+    for(i64 i = 0; i < count; ++i) {
+      columns.offsets[i + 1] += columns.offsets[i];
+    }
+
+    columns.nodes.resize(n);
+    columns.ranks.resize(n);
+    Array<u32> heads{anton::reserve, count};
+    for(i64 i = 0; i < count; ++i) {
+      heads.push_back(columns.offsets[i]);
+    }
+    for(i64 gate = 0; gate < n; ++gate) {
+      u32 const level = levels[gate];
+      columns.ranks[gate] = heads[level] - columns.offsets[level];
+      columns.nodes[heads[level]] = gate;
+      heads[level] += 1;
+    }
+    columns.levels = levels;
+  }
+
+  struct Barycentre {
+    f32 value;
+    u32 rank;
+    u32 gate;
+  };
+
+  // order_column
+  //
+  // Reorder a column by the mean relative rank of the neighbours of its gates.
+  // Gates without neighbours keep their relative rank.
+  //
+  static void order_column(Columns& columns, u32 const level,
+                           Array<u32> const& offsets,
+                           Array<u32> const& neighbours,
+                           Array<Barycentre>& scratch)
+  {
+    scratch.clear();
+    for(u32 i = columns.offsets[level]; i < columns.offsets[level + 1]; ++i) {
+      u32 const gate = columns.nodes[i];
+      f32 sum = 0.0f;
+      i64 count = 0;
+      for(u32 e = offsets[gate]; e < offsets[gate + 1]; ++e) {
+        u32 const neighbour = neighbours[e];
+        if(columns.levels[neighbour] == level) {
+          continue;
+        }
+        sum += columns.get_relative_rank(neighbour);
+        count += 1;
+      }
+
+      f32 const value = count > 0 ? sum / static_cast<f32>(count)
+                                  : columns.get_relative_rank(gate);
+      scratch.push_back(Barycentre{value, columns.ranks[gate], gate});
+    }
+
+    anton::quick_sort(scratch.begin(), scratch.end(),
+                      [](Barycentre const& lhs, Barycentre const& rhs) {
+                        // Break ties by the previous rank to keep the order
+                        // stable across sweeps.
+                        if(lhs.value != rhs.value) {
+                          return lhs.value < rhs.value;
+                        }
+                        return lhs.rank < rhs.rank;
+                      });
+
+    u32 const first = columns.offsets[level];
+    for(i64 i = 0; i < scratch.size(); ++i) {
+      u32 const gate = scratch[i].gate;
+      columns.nodes[first + i] = gate;
+      columns.ranks[gate] = i;
+    }
+  }
+
+  static void order_columns(Columns& columns, Placement_Graph const& graph,
+                            i64 const sweeps)
+  {
+    Array<Barycentre> scratch;
+    i64 const count = columns.count();
+    for(i64 sweep = 0; sweep < sweeps; ++sweep) {
+      for(i64 level = 1; level < count; ++level) {
+        order_column(columns, level, graph.fanin_offsets, graph.fanin, scratch);
+      }
+      for(i64 level = count - 2; level >= 0; --level) {
+        order_column(columns, level, graph.fanout_offsets, graph.fanout,
+                     scratch);
+      }
+    }
+  }
+
+  constexpr u32 invalid_index = static_cast<u32>(-1);
+
+  struct Quad_Cell {
+    Vec2 centre_of_mass;
+    // Bottom-left corner of the cell.
+    Vec2 origin;
+    f32 size;
+    f32 mass;
+    u32 children[4];
+    // The body of a leaf. Leaves at the maximum depth may aggregate several
+    // coincident bodies, in which case body is the first one.
+    u32 body;
+  };
+
+  // Quadtree
+  //
+  // Barnes-Hut quadtree. Every cell stores the number and the centre of mass
+  // of the bodies it contains.
+  //
+  struct Quadtree {
+    Array<Quad_Cell> cells;
+
+    static constexpr i64 max_depth = 32;
+
+    void build(Slice<Vec2 const> const points)
+    {
+      cells.clear();
+      if(points.size() == 0) {
+        return;
+      }
+
+      Vec2 min = points[0];
+      Vec2 max = points[0];
+      for(Vec2 const p: points) {
+        min = Vec2{math::min(min.x, p.x), math::min(min.y, p.y)};
+        max = Vec2{math::max(max.x, p.x), math::max(max.y, p.y)};
+      }
+
+      f32 const size = math::max(max.x - min.x, max.y - min.y) + 1.0f;
+      cells.ensure_capacity(2 * points.size());
+      cells.push_back(make_cell(min, size));
+      for(i64 i = 0; i < points.size(); ++i) {
+        insert(i, points);
+      }
+    }
+
+    [[nodiscard]] static Quad_Cell make_cell(Vec2 const origin, f32 const size)
+    {
+      return Quad_Cell{Vec2{0.0f, 0.0f},
+                       origin,
+                       size,
+                       0.0f,
+                       {invalid_index, invalid_index, invalid_index,
+                        invalid_index},
+                       invalid_index};
+    }
+
+    [[nodiscard]] static bool is_leaf(Quad_Cell const& cell)
+    {
+      return cell.children[0] == invalid_index &&
+             cell.children[1] == invalid_index &&
+             cell.children[2] == invalid_index &&
+             cell.children[3] == invalid_index;
+    }
+
+    // Index of the child of cell that contains point, creating the child if it
+    // does not exist.
+    [[nodiscard]] u32 get_child(u32 const cell, Vec2 const point)
+    {
+      f32 const half = cells[cell].size * 0.5f;
+      Vec2 const origin = cells[cell].origin;
+      u32 const right = point.x >= origin.x + half;
+      u32 const top = point.y >= origin.y + half;
+      u32 const quadrant = right | (top << 1);
+      if(cells[cell].children[quadrant] == invalid_index) {
+        Vec2 const child_origin{origin.x + (right ? half : 0.0f),
+                                origin.y + (top ? half : 0.0f)};
+        u32 const child = cells.size();
+        cells.push_back(make_cell(child_origin, half));
+        cells[cell].children[quadrant] = child;
+      }
+      return cells[cell].children[quadrant];
+    }
+
+    static void add_mass(Quad_Cell& cell, Vec2 const point)
+    {
+      cell.mass += 1.0f;
+      cell.centre_of_mass += (point - cell.centre_of_mass) / cell.mass;
+    }
+
+    void insert(u32 const body, Slice<Vec2 const> const points)
+    {
+      Vec2 const point = points[body];
+      u32 cell = 0;
+      for(i64 depth = 0;; ++depth) {
+        bool const empty = cells[cell].mass == 0.0f;
+        add_mass(cells[cell], point);
+        if(is_leaf(cells[cell])) {
+          if(empty) {
+            cells[cell].body = body;
+            return;
+          }
+
+          if(depth >= max_depth) {
+            return;
+          }
+
+          // Push the resident body down before descending with the new one.
+          u32 const resident = cells[cell].body;
+          cells[cell].body = invalid_index;
+          u32 const child = get_child(cell, points[resident]);
+          add_mass(cells[child], points[resident]);
+          cells[child].body = resident;
+        }
+        cell = get_child(cell, point);
+      }
+    }
+
+    // Repulsive force acting on body at point. The force between two bodies is
+    // k2 / distance along the line connecting them.
+    [[nodiscard]] Vec2 get_repulsion(u32 const body, Vec2 const point,
+                                     f32 const k2, f32 const theta) const
+    {
+      Vec2 force{0.0f, 0.0f};
+      if(cells.size() == 0) {
+        return force;
+      }
+
+      u32 stack[4 * max_depth + 4];
+      i64 top = 0;
+      stack[top++] = 0;
+      while(top > 0) {
+        Quad_Cell const& cell = cells[stack[--top]];
+        Vec2 centre = cell.centre_of_mass;
+        f32 mass = cell.mass;
+        bool const leaf = is_leaf(cell);
+        if(leaf && cell.body == body) {
+          // Exclude the body itself from the aggregate.
+          if(mass <= 1.0f) {
+            continue;
+          }
+          centre = (centre * mass - point) / (mass - 1.0f);
+          mass -= 1.0f;
+        }
+
+        Vec2 const delta = point - centre;
+        f32 const distance2 = math::max(math::length_squared(delta), 1e-4f);
+        bool const far = cell.size * cell.size < theta * theta * distance2;
+        if(leaf || far) {
+          force += delta * (mass * k2 / distance2);
+          continue;
+        }
+
+        for(u32 const child: cell.children) {
+          if(child != invalid_index) {
+            stack[top++] = child;
+          }
+        }
+      }
+      return force;
+    }
+  };
+
+  // refine
+  //
+  // Force-directed refinement in the style of Fruchterman and Reingold.
+  // Gates are kept in their columns and only move vertically. Forces are
+  // computed for all gates in parallel from the positions of the previous
+  // iteration, which makes the result independent of the number of threads.
+  //
+  static void refine(Placement_Job& job, Columns const& columns,
+                     Array<Vec2>& centres)
+  {
+    Placement_Graph const& graph = job.graph;
+    Placement_Options const& options = job.options;
+    i64 const n = graph.size();
+    f32 const k = options.row_spacing;
+    f32 const k2 = k * k;
+    Array<f32> displacement(n, 0.0f);
+    Quadtree tree;
+    for(i64 iteration = 0; iteration < options.refinement_iterations;
+        ++iteration) {
+      if(job.cancelled.load(std::memory_order_relaxed)) {
+        return;
+      }
+
+      // Linear cooling from one column spacing.
+      f32 const temperature =
+        options.column_spacing *
+        (1.0f - static_cast<f32>(iteration) /
+                  static_cast<f32>(options.refinement_iterations));
+      tree.build(centres);
+      parallel_for(n, options.threads, [&](i64 const begin, i64 const end) {
+        for(i64 gate = begin; gate < end; ++gate) {
+          Vec2 const point = centres[gate];
+          Vec2 force = tree.get_repulsion(gate, point, k2, options.theta);
+          for(u32 e = graph.fanin_offsets[gate];
+              e < graph.fanin_offsets[gate + 1]; ++e) {
+            Vec2 const delta = centres[graph.fanin[e]] - point;
+            force += delta * (math::length(delta) / k);
+          }
+          for(u32 e = graph.fanout_offsets[gate];
+              e < graph.fanout_offsets[gate + 1]; ++e) {
+            Vec2 const delta = centres[graph.fanout[e]] - point;
+            force += delta * (math::length(delta) / k);
+          }
+          displacement[gate] = math::clamp(force.y, -temperature, temperature);
+        }
+      });
+
+      for(i64 gate = 0; gate < n; ++gate) {
+        centres[gate].y += displacement[gate];
+      }
+    }
+
+    // Forces do not guarantee that gates do not overlap. Sort every column by
+    // position and push apart gates that are closer than the row spacing.
+    Array<Barycentre> order;
+    for(i64 level = 0; level < columns.count(); ++level) {
+      order.clear();
+      for(u32 i = columns.offsets[level]; i < columns.offsets[level + 1]; ++i) {
+        u32 const gate = columns.nodes[i];
+        order.push_back(Barycentre{centres[gate].y, columns.ranks[gate], gate});
+      }
+
+      anton::quick_sort(order.begin(), order.end(),
+                        [](Barycentre const& lhs, Barycentre const& rhs) {
+                          if(lhs.value != rhs.value) {
+                            return lhs.value < rhs.value;
+                          }
+                          return lhs.rank < rhs.rank;
+                        });
+      for(i64 i = 1; i < order.size(); ++i) {
+        f32 const minimum = centres[order[i - 1].gate].y + options.row_spacing;
+        Vec2& centre = centres[order[i].gate];
+        centre.y = math::max(centre.y, minimum);
+      }
+    }
+  }
+
+  static void compute_placement(Placement_Job& job)
+  {
+    f64 const start = get_time();
+    Placement_Graph const& graph = job.graph;
+    Placement_Options const& options = job.options;
+    i64 const n = graph.size();
+
+    Array<u32> levels;
+    levelize(graph, levels);
+    Columns columns;
+    build_columns(columns, levels);
+    order_columns(columns, graph, options.ordering_sweeps);
+
+    // Centre the columns vertically around the origin.
+    Array<Vec2> centres(n);
+    for(i64 gate = 0; gate < n; ++gate) {
+      f32 const size = columns.column_size(levels[gate]);
+      f32 const x = static_cast<f32>(levels[gate]) * options.column_spacing;
+      f32 const y =
+        (static_cast<f32>(columns.ranks[gate]) - size * 0.5f) *
+        options.row_spacing;
+      centres[gate] = Vec2{x, y} + graph.dimensions[gate] * 0.5f;
+    }
+
+    if(n > 0) {
+      refine(job, columns, centres);
+    }
+
+    job.positions.resize(n);
+    for(i64 gate = 0; gate < n; ++gate) {
+      job.positions[gate] = centres[gate] - graph.dimensions[gate] * 0.5f;
+    }
+
+    LOG_INFO("placed {} gates in {} columns in {}s", n, columns.count(),
+             get_time() - start);
+  }
+
+  Placement_Job* start_placement(Scene const& scene,
+                                 Placement_Options const& options)
+  {
+    Placement_Job* const job = new Placement_Job;
+    job->options = options;
+    build_graph(job->graph, scene);
+    job->thread = std::thread([job] {
+      compute_placement(*job);
+      job->finished.store(true, std::memory_order_release);
+    });
+    return job;
+  }
+
+  bool is_placement_finished(Placement_Job const* const job)
+  {
+    return job->finished.load(std::memory_order_acquire);
+  }
+
+  void apply_placement(Placement_Job* const job, Scene& scene)
+  {
+    job->thread.join();
+    if(!job->cancelled.load(std::memory_order_relaxed)) {
+      Placement_Graph const& graph = job->graph;
+      for(i64 i = 0; i < graph.size(); ++i) {
+        Gate* const gate = scene.find_gate(graph.ids[i]);
+        if(gate == nullptr) {
+          continue;
+        }
+
+        scene.move_gate(*gate, job->positions[i] - gate->coordinates);
+      }
+    }
+    delete job;
+  }
+
+  void cancel_placement(Placement_Job* const job)
+  {
+    job->cancelled.store(true, std::memory_order_relaxed);
+    job->thread.join();
+    delete job;
+  }
+
+  void place(Scene& scene, Placement_Options const& options)
+  {
+    Placement_Job* const job = start_placement(scene, options);
+    apply_placement(job, scene);
+  }
+} // namespace nebula
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <core/types.hpp>
+
+namespace nebula {
+  struct Scene;
+
+  /**
+   * @brief Parameters of the automatic placer.
+   */
+  struct Placement_Options {
+    // Horizontal distance between the left edges of consecutive columns.
+    f32 column_spacing = 1.5f;
+    // Vertical distance between the top edges of gates within a column.
+    f32 row_spacing = 0.8f;
+    // Number of down and up sweeps of the barycentric ordering.
+    i64 ordering_sweeps = 8;
+    // Number of iterations of the force-directed refinement. 0 disables the
+    // refinement.
+    i64 refinement_iterations = 50;
+    // Opening angle of the Barnes-Hut approximation. Cells whose size to
+    // distance ratio is below theta are treated as a single body.
+    f32 theta = 0.9f;
+    // Number of threads computing forces. 0 selects the hardware count.
+    i64 threads = 0;
+  };
+
+  /**
+   * @brief A placement running on a background thread.
+   */
+  struct Placement_Job;
+
+  /**
+   * @brief Starts placing all gates of a scene on a background thread.
+   *
+   * The connectivity of the scene is copied before the function returns,
+   * hence the scene may be modified while the job runs. Gates are:
+   * 1. levelized into columns by their logic depth,
+   * 2. ordered within columns by the barycentre of their neighbours to reduce
+   *    the number of wire crossings,
+   * 3. refined with a force-directed layout that approximates repulsion with
+   *    a Barnes-Hut quadtree.
+   *
+   * @param scene The scene to place.
+   * @param options The parameters of the placer.
+   * @return The running job. Must be released with apply_placement or
+   * cancel_placement.
+   */
+  [[nodiscard]] Placement_Job* start_placement(Scene const& scene,
+                                               Placement_Options const& options);
+
+  /**
+   * @brief Checks whether a job has finished computing.
+   */
+  [[nodiscard]] bool is_placement_finished(Placement_Job const* job);
+
+  /**
+   * @brief Writes the result of a finished job to the scene and releases the
+   * job.
+   *
+   * Moves the placed gates and their ports. Gates deleted since the job was
+   * started are skipped. Blocks until the job has finished.
+   *
+   * @param job The job to apply.
+   * @param scene The scene the job has been started for.
+   */
+  void apply_placement(Placement_Job* job, Scene& scene);
+
+  /**
+   * @brief Stops a job and releases it without modifying the scene.
+   */
+  void cancel_placement(Placement_Job* job);
+
+  /**
+   * @brief Places all gates of a scene on the calling thread.
+   *
+   * Equivalent to starting a job and immediately applying it.
+   */
+  void place(Scene& scene, Placement_Options const& options);
+} // namespace nebula
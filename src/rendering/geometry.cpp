@@ -0,0 +1,44 @@
+#include <rendering/rendering.hpp>
+
+#include <string.h>
+
+// Transient geometry storage. Kept apart from the OpenGL backend, so that the
+// draw commands may be prepared into CPU memory by tools without a context.
+
+namespace nebula::rendering {
+  static Buffer<Vertex> vertex_buffer;
+  static Buffer<u32> element_buffer;
+
+  void set_geometry_storage(Slice<Vertex> const vertices,
+                            Slice<u32> const indices)
+  {
+    vertex_buffer.buffer = vertices.data();
+    vertex_buffer.head = vertex_buffer.buffer;
+    vertex_buffer.end = vertex_buffer.buffer + vertices.size();
+    element_buffer.buffer = indices.data();
+    element_buffer.head = element_buffer.buffer;
+    element_buffer.end = element_buffer.buffer + indices.size();
+  }
+
+  Draw_Elements_Command write_geometry(Slice<Vertex const> const vertices,
+                                       Slice<u32 const> const indices)
+  {
+    Draw_Elements_Command cmd = {};
+    if(vertex_buffer.end - vertex_buffer.head < vertices.size()) {
+      vertex_buffer.head = vertex_buffer.buffer;
+    }
+    memcpy(vertex_buffer.head, vertices.data(),
+           vertices.size() * sizeof(Vertex));
+    cmd.base_vertex = vertex_buffer.head - vertex_buffer.buffer;
+    vertex_buffer.head += vertices.size();
+
+    if(element_buffer.end - element_buffer.head < indices.size()) {
+      element_buffer.head = element_buffer.buffer;
+    }
+    memcpy(element_buffer.head, indices.data(), indices.size() * sizeof(u32));
+    cmd.first_index = element_buffer.head - element_buffer.buffer;
+    element_buffer.head += indices.size();
+    cmd.count = indices.size();
+    return cmd;
+  }
+} // namespace nebula::rendering
@@ -60,8 +60,6 @@ namespace nebula::rendering {
   static Flat_Hash_Map<u64, Draw_Elements_Command>*
     persistent_draw_commands_map;
   static Array<Draw_Elements_Command>* draw_cmds;
-  static Buffer<Vertex> vertex_buffer;
-  static Buffer<u32> element_buffer;
   static Buffer<Draw_Elements_Command> draw_cmd_buffer;
   static Framebuffer primary_fb;
   static Framebuffer front_postprocess_fb;
@@ -110,14 +108,11 @@ namespace nebula::rendering {
     gpu_draw_cmd_buffer =
       create_gpu_buffer(8 * 1024 * sizeof(Draw_Elements_Command), buffer_flags);
 
-    vertex_buffer.buffer = reinterpret_cast<Vertex*>(gpu_vertex_buffer.mapped);
-    vertex_buffer.head = vertex_buffer.buffer;
-    vertex_buffer.end =
-      vertex_buffer.buffer + gpu_vertex_buffer.size / sizeof(Vertex);
-    element_buffer.buffer = reinterpret_cast<u32*>(gpu_element_buffer.mapped);
-    element_buffer.head = element_buffer.buffer;
-    element_buffer.end =
-      element_buffer.buffer + gpu_element_buffer.size / sizeof(u32);
+    set_geometry_storage(
+      Slice<Vertex>(reinterpret_cast<Vertex*>(gpu_vertex_buffer.mapped),
+                    gpu_vertex_buffer.size / sizeof(Vertex)),
+      Slice<u32>(reinterpret_cast<u32*>(gpu_element_buffer.mapped),
+                 gpu_element_buffer.size / sizeof(u32)));
     draw_cmd_buffer.buffer =
       reinterpret_cast<Draw_Elements_Command*>(gpu_draw_cmd_buffer.mapped);
     draw_cmd_buffer.head = draw_cmd_buffer.buffer;
@@ -269,28 +264,6 @@ namespace nebula::rendering {
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, gpu_element_buffer.handle);
   }
 
-  Draw_Elements_Command write_geometry(Slice<Vertex const> const vertices,
-                                       Slice<u32 const> const indices)
-  {
-    Draw_Elements_Command cmd = {};
-    if(vertex_buffer.end - vertex_buffer.head < vertices.size()) {
-      vertex_buffer.head = vertex_buffer.buffer;
-    }
-    memcpy(vertex_buffer.head, vertices.data(),
-           vertices.size() * sizeof(Vertex));
-    cmd.base_vertex = vertex_buffer.head - vertex_buffer.buffer;
-    vertex_buffer.head += vertices.size();
-
-    if(element_buffer.end - element_buffer.head < indices.size()) {
-      element_buffer.head = element_buffer.buffer;
-    }
-    memcpy(element_buffer.head, indices.data(), indices.size() * sizeof(u32));
-    cmd.first_index = element_buffer.head - element_buffer.buffer;
-    element_buffer.head += indices.size();
-    cmd.count = indices.size();
-    return cmd;
-  }
-
   void add_draw_command(Draw_Elements_Command const command)
   {
     draw_cmds->push_back(command);
@@ -125,6 +125,17 @@ namespace nebula::rendering {
    */
   void bind_transient_geometry_buffers();
 
+  /**
+   * @brief Sets the storage written to by write_geometry.
+   *
+   * The renderer uses the persistently mapped GPU buffers. Tools that prepare
+   * draw commands without an OpenGL context may provide CPU memory instead.
+   *
+   * @param vertices - Storage for the vertices.
+   * @param indices - Storage for the indices.
+   */
+  void set_geometry_storage(Slice<Vertex> vertices, Slice<u32> indices);
+
   /**
    * @brief Writes indexed vertex data (geometry) to GPU buffers.
    *
@@ -0,0 +1,386 @@
+#include <routing/router.hpp>
+
+#include <anton/flat_hash_map.hpp>
+#include <anton/math/math.hpp>
+
+#include <core/parallel.hpp>
+#include <core/spatial_index.hpp>
+#include <model/gate.hpp>
+#include <ui/scene.hpp>
+
+namespace nebula {
+  constexpr u32 invalid_index = static_cast<u32>(-1);
+
+  // Obstacles
+  //
+  // The gates inflated by the margin. The queries are inflated instead so that
+  // the bounds kept by the scene are used as they are and need not be rebuilt
+  // for every update.
+  //
+  struct Obstacles {
+    Spatial_Index const& bounds;
+    f32 margin;
+  };
+
+  [[nodiscard]] static bool is_blocked(Obstacles const& obstacles,
+                                       Vec2 const a, Vec2 const b)
+  {
+    Vec2 const inflation{obstacles.margin, obstacles.margin};
+    Vec2 const min{math::min(a.x, b.x), math::min(a.y, b.y)};
+    Vec2 const max{math::max(a.x, b.x), math::max(a.y, b.y)};
+    return obstacles.bounds.overlaps_any(
+      AABB{min - inflation, max + inflation});
+  }
+
+  // Directions in the order east, north, west, south. Opposite directions are
+  // 2 apart.
+  constexpr i32 direction_x[4] = {1, 0, -1, 0};
+  constexpr i32 direction_y[4] = {0, 1, 0, -1};
+
+  struct Search_Node {
+    i32 x;
+    i32 y;
+    f32 cost;
+    u32 parent;
+    u8 direction;
+    bool closed;
+  };
+
+  struct Heap_Entry {
+    f32 estimate;
+    f32 cost;
+    u32 node;
+  };
+
+  // Order by estimate. Among equal estimates prefer the node that is further
+  // along its path, which avoids exploring the whole plateau of equally good
+  // nodes between the start and the goal.
+  [[nodiscard]] static bool operator<(Heap_Entry const& lhs,
+                                      Heap_Entry const& rhs)
+  {
+    if(lhs.estimate != rhs.estimate) {
+      return lhs.estimate < rhs.estimate;
+    }
+    return lhs.cost > rhs.cost;
+  }
+
+  // Search
+  //
+  // Scratch state of the A* search reused across connections. Nodes are keyed
+  // by their grid position and the direction they have been entered from so
+  // that bends can be penalised.
+  //
+  struct Search {
+    Flat_Hash_Map<u64, u32> nodes_by_key;
+    Array<Search_Node> nodes;
+    // Binary min-heap ordered by estimate.
+    Array<Heap_Entry> heap;
+
+    void clear()
+    {
+      nodes_by_key.clear();
+      nodes.clear();
+      heap.clear();
+    }
+
+    void push(Heap_Entry const entry)
+    {
+      heap.push_back(entry);
+      i64 i = heap.size() - 1;
+      while(i > 0) {
+        i64 const parent = (i - 1) / 2;
+        if(!(heap[i] < heap[parent])) {
+          break;
+        }
+        swap(heap[parent], heap[i]);
+        i = parent;
+      }
+    }
+
+    [[nodiscard]] Heap_Entry pop()
+    {
+      Heap_Entry const top = heap[0];
+      heap[0] = heap.back();
+      heap.pop_back();
+      i64 const size = heap.size();
+      i64 i = 0;
+      while(true) {
+        i64 smallest = i;
+        i64 const left = 2 * i + 1;
+        i64 const right = left + 1;
+        if(left < size && heap[left] < heap[smallest]) {
+          smallest = left;
+        }
+        if(right < size && heap[right] < heap[smallest]) {
+          smallest = right;
+        }
+        if(smallest == i) {
+          break;
+        }
+        swap(heap[smallest], heap[i]);
+        i = smallest;
+      }
+      return top;
+    }
+  };
+
+  [[nodiscard]] static u64 get_node_key(i32 const x, i32 const y,
+                                        u8 const direction)
+  {
+    return (static_cast<u64>(static_cast<u32>(x)) << 32) |
+           (static_cast<u64>(static_cast<u32>(y) << 2)) | direction;
+  }
+
+  // append_point
+  //
+  // Append a point to a polyline, dropping duplicates and merging collinear
+  // axis-aligned segments.
+  //
+  static void append_point(Array<Vec2>& points, Vec2 const point)
+  {
+    i64 const size = points.size();
+    if(size > 0 && points[size - 1] == point) {
+      return;
+    }
+
+    if(size > 1) {
+      Vec2 const a = points[size - 2];
+      Vec2 const b = points[size - 1];
+      bool const vertical = a.x == b.x && b.x == point.x;
+      bool const horizontal = a.y == b.y && b.y == point.y;
+      if(vertical || horizontal) {
+        points[size - 1] = point;
+        return;
+      }
+    }
+
+    points.push_back(point);
+  }
+
+  // route_directly
+  //
+  // Fallback route that ignores obstacles. Leaves the OUT port to the right,
+  // enters the IN port from the left and goes around backwards connections.
+  //
+  static void route_directly(Array<Vec2>& route, Vec2 const from,
+                             Vec2 const origin, Vec2 const target,
+                             Vec2 const to)
+  {
+    append_point(route, from);
+    append_point(route, origin);
+    if(target.x >= origin.x) {
+      f32 const middle = (origin.x + target.x) * 0.5f;
+      append_point(route, Vec2{middle, origin.y});
+      append_point(route, Vec2{middle, target.y});
+    } else {
+      f32 const middle = (origin.y + target.y) * 0.5f;
+      append_point(route, Vec2{origin.x, middle});
+      append_point(route, Vec2{target.x, middle});
+    }
+    append_point(route, target);
+    append_point(route, to);
+  }
+
+  // route_pattern
+  //
+  // Try the Z-shaped routes with the vertical leg right after leaving the OUT
+  // port, right before entering the IN port, and halfway between. Most
+  // connections in a placed design are routed by one of these without
+  // searching.
+  //
+  // Returns:
+  // true if a route that avoids all obstacles has been found.
+  //
+  [[nodiscard]] static bool route_pattern(Array<Vec2>& route, Vec2 const from,
+                                          Vec2 const origin, Vec2 const target,
+                                          Vec2 const to,
+                                          Obstacles const& obstacles)
+  {
+    if(target.x < origin.x) {
+      return false;
+    }
+
+    f32 const legs[] = {origin.x, target.x, (origin.x + target.x) * 0.5f};
+    for(f32 const x: legs) {
+      Vec2 const a{x, origin.y};
+      Vec2 const b{x, target.y};
+      if(is_blocked(obstacles, origin, a) || is_blocked(obstacles, a, b) ||
+         is_blocked(obstacles, b, target)) {
+        continue;
+      }
+
+      route.clear();
+      append_point(route, from);
+      append_point(route, origin);
+      append_point(route, a);
+      append_point(route, b);
+      append_point(route, target);
+      append_point(route, to);
+      return true;
+    }
+    return false;
+  }
+
+  static void route_connection(Array<Vec2>& route, Vec2 const from,
+                               Vec2 const to, Obstacles const& obstacles,
+                               Routing_Options const& options, Search& search)
+  {
+    f32 const pitch = options.pitch;
+    Vec2 const origin = from + Vec2{options.clearance, 0.0f};
+    Vec2 const target = to - Vec2{options.clearance, 0.0f};
+    if(route_pattern(route, from, origin, target, to, obstacles)) {
+      return;
+    }
+
+    i32 const goal_x =
+      static_cast<i32>(math::floor((target.x - origin.x) / pitch + 0.5f));
+    i32 const goal_y =
+      static_cast<i32>(math::floor((target.y - origin.y) / pitch + 0.5f));
+    auto get_estimate = [goal_x, goal_y, &options](i32 const x, i32 const y) {
+      // Manhattan distance.
+      f32 estimate = math::abs(static_cast<f32>(goal_x - x)) +
+                     math::abs(static_cast<f32>(goal_y - y));
+      // Reaching a node that is neither in the same row nor column requires at
+      // least one bend.
+      if(x != goal_x && y != goal_y) {
+        estimate += options.bend_cost;
+      }
+      return estimate * options.heuristic_weight;
+    };
+
+    search.clear();
+    search.nodes.push_back(Search_Node{0, 0, 0.0f, invalid_index, 0, false});
+    search.nodes_by_key.emplace(get_node_key(0, 0, 0), 0);
+    search.push(Heap_Entry{get_estimate(0, 0), 0.0f, 0});
+
+    u32 found = invalid_index;
+    i64 expansions = 0;
+    while(search.heap.size() > 0 && expansions < options.max_expansions) {
+      u32 const index = search.pop().node;
+      if(search.nodes[index].closed) {
+        continue;
+      }
+
+      search.nodes[index].closed = true;
+      expansions += 1;
+      Search_Node const node = search.nodes[index];
+      if(node.x == goal_x && node.y == goal_y) {
+        found = index;
+        break;
+      }
+
+      for(u8 direction = 0; direction < 4; ++direction) {
+        if(direction == ((node.direction + 2) & 3)) {
+          continue;
+        }
+
+        i32 const x = node.x + direction_x[direction];
+        i32 const y = node.y + direction_y[direction];
+        f32 cost = node.cost + 1.0f;
+        if(direction != node.direction) {
+          cost += options.bend_cost;
+        }
+
+        u64 const key = get_node_key(x, y, direction);
+        auto iter = search.nodes_by_key.find(key);
+        if(iter != search.nodes_by_key.end()) {
+          Search_Node& other = search.nodes[iter->value];
+          if(other.closed || other.cost <= cost) {
+            continue;
+          }
+
+          other.cost = cost;
+          other.parent = index;
+          search.push(Heap_Entry{cost + get_estimate(x, y), cost, iter->value});
+          continue;
+        }
+
+        u32 const other = search.nodes.size();
+        search.nodes_by_key.emplace(key, other);
+        bool const goal = x == goal_x && y == goal_y;
+        Vec2 const position =
+          origin + Vec2{static_cast<f32>(x), static_cast<f32>(y)} * pitch;
+        if(!goal && is_blocked(obstacles, position, position)) {
+          // Remember blocked nodes as closed to avoid testing them again.
+          search.nodes.push_back(
+            Search_Node{x, y, cost, index, direction, true});
+          continue;
+        }
+
+        search.nodes.push_back(
+          Search_Node{x, y, cost, index, direction, false});
+        search.push(Heap_Entry{cost + get_estimate(x, y), cost, other});
+      }
+    }
+
+    route.clear();
+    if(found == invalid_index) {
+      route_directly(route, from, origin, target, to);
+      return;
+    }
+
+    // The path is collected backwards.
+    Array<Vec2> path;
+    for(u32 index = found; index != invalid_index;
+        index = search.nodes[index].parent) {
+      Search_Node const& node = search.nodes[index];
+      path.push_back(
+        origin +
+        Vec2{static_cast<f32>(node.x), static_cast<f32>(node.y)} * pitch);
+    }
+
+    append_point(route, from);
+    for(i64 i = path.size() - 1; i >= 0; --i) {
+      append_point(route, path[i]);
+    }
+    // The goal node is within half a pitch of the target. Step onto the row of
+    // the port before entering it.
+    append_point(route, Vec2{path[0].x, to.y});
+    append_point(route, to);
+  }
+
+  i64 update_routes(Scene& scene, Routing_Options const& options)
+  {
+    Array<Port*> pending;
+    for(Port* const port: scene.ports) {
+      if(port->kind != Port_Kind::in || port->gate == nullptr ||
+         port->connections.size() != 1 || port->route.size() > 0) {
+        continue;
+      }
+
+      Port const* const driver = *port->connections.begin();
+      if(driver->gate == nullptr) {
+        continue;
+      }
+
+      pending.push_back(port);
+    }
+
+    if(pending.size() == 0) {
+      return 0;
+    }
+
+    Obstacles const obstacles{scene.gate_bounds, options.margin};
+    parallel_for(pending.size(), options.threads,
+                 [&](i64 const begin, i64 const end) {
+                   Search search;
+                   for(i64 i = begin; i < end; ++i) {
+                     Port* const port = pending[i];
+                     Port const* const driver = *port->connections.begin();
+                     route_connection(port->route, driver->coordinates,
+                                      port->coordinates, obstacles, options,
+                                      search);
+                   }
+                 });
+    return pending.size();
+  }
+
+  void invalidate_routes(Scene& scene)
+  {
+    for(Port* const port: scene.ports) {
+      if(port->kind == Port_Kind::in) {
+        port->route.clear();
+      }
+    }
+  }
+} // namespace nebula
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <core/types.hpp>
+
+namespace nebula {
+  struct Scene;
+
+  /**
+   * @brief Parameters of the wire router.
+   */
+  struct Routing_Options {
+    // Distance between neighbouring nodes of the routing grid.
+    f32 pitch = 0.1f;
+    // Length of the straight stub leaving and entering a port. Must exceed
+    // the obstacle margin so that stubs start outside of the obstacles.
+    f32 clearance = 0.1f;
+    // Distance by which gates are inflated when testing for obstacles.
+    f32 margin = 0.03f;
+    // Additional cost of a bend expressed in grid steps.
+    f32 bend_cost = 3.0f;
+    // Weight of the A* heuristic. Weights above 1 make the search greedier,
+    // trading the optimality of routes for far fewer expanded nodes.
+    f32 heuristic_weight = 1.5f;
+    // Maximum number of nodes expanded per connection before the router gives
+    // up and falls back to a direct orthogonal route.
+    i64 max_expansions = 20000;
+    // Number of threads routing connections. 0 selects the hardware count.
+    i64 threads = 0;
+  };
+
+  /**
+   * @brief Routes all connections of a scene whose cached route is invalid.
+   *
+   * Connections are routed orthogonally. Simple Z-shaped routes are tried
+   * first and tested against a spatial hash of the gates. Connections that
+   * cannot be routed that way are routed with A* on a sparse grid anchored at
+   * the OUT port of each connection. Grid nodes are created only when visited
+   * and nodes within the bounds of any gate are obstacles. Routes are
+   * cached in the IN ports, hence only connections of gates that moved since
+   * the last call are routed again. Connections to the temporary linking port
+   * are not routed.
+   *
+   * @param scene The scene whose connections to route.
+   * @param options The parameters of the router.
+   * @return The number of routed connections.
+   */
+  i64 update_routes(Scene& scene, Routing_Options const& options);
+
+  /**
+   * @brief Invalidates the routes of all connections of a scene.
+   *
+   * Routes are only invalidated when their ends move. Call this function to
+   * account for gates that have been moved onto or away from other wires.
+   */
+  void invalidate_routes(Scene& scene);
+} // namespace nebula
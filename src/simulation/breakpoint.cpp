@@ -0,0 +1,472 @@
+#include <simulation/breakpoint.hpp>
+
+#include <anton/format.hpp>
+
+#include <ui/scene.hpp>
+
+namespace nebula {
+  // Compiler
+  //
+  // Recursive descent compiler of condition expressions into postfix
+  // programs.
+  //
+  struct Compiler {
+    Flat_Hash_Map<String, u64> const& names;
+    Array<u64>& gates;
+    Array<Breakpoint_Op>& program;
+    char const* i;
+    char const* end;
+  };
+
+  [[nodiscard]] static bool is_operator(char const c)
+  {
+    return c == '(' || c == ')' || c == '!' || c == '~' || c == '&' ||
+           c == '|' || c == '^';
+  }
+
+  [[nodiscard]] static bool is_whitespace(char const c)
+  {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+  }
+
+  static void skip_whitespace(Compiler& compiler)
+  {
+    while(compiler.i != compiler.end && is_whitespace(*compiler.i)) {
+      compiler.i += 1;
+    }
+  }
+
+  [[nodiscard]] static bool match(Compiler& compiler, char const c)
+  {
+    skip_whitespace(compiler);
+    if(compiler.i != compiler.end && *compiler.i == c) {
+      compiler.i += 1;
+      return true;
+    }
+    return false;
+  }
+
+  // resolve_net
+  //
+  // Find the gate driving a net. Unnamed gates are named g<id>.
+  //
+  [[nodiscard]] static Expected<u64, Error>
+  resolve_net(Flat_Hash_Map<String, u64> const& names, Scene& scene,
+              String_View const name)
+  {
+    auto iter = names.find(String(name));
+    if(iter != names.end()) {
+      return {expected_value, iter->value};
+    }
+
+    char const* const end = name.data() + name.size_bytes();
+    if(name.size_bytes() > 1 && *name.data() == 'g') {
+      u64 id = 0;
+      char const* i = name.data() + 1;
+      for(; i != end && *i >= '0' && *i <= '9'; ++i) {
+        id = id * 10 + static_cast<u64>(*i - '0');
+      }
+      if(i == end && scene.find_gate(id) != nullptr) {
+        return {expected_value, id};
+      }
+    }
+    return {expected_error, format("'{}' is not a net"_sv, name)};
+  }
+
+  [[nodiscard]] static Expected<void, Error> compile_or(Compiler& compiler,
+                                                        Scene& scene);
+
+  [[nodiscard]] static Expected<void, Error>
+  compile_primary(Compiler& compiler, Scene& scene)
+  {
+    if(match(compiler, '!') || match(compiler, '~')) {
+      Expected<void, Error> operand = compile_primary(compiler, scene);
+      if(!operand) {
+        return operand;
+      }
+      compiler.program.push_back(Breakpoint_Op{Breakpoint_Opcode::e_not, 0});
+      return expected_value;
+    }
+
+    if(match(compiler, '(')) {
+      Expected<void, Error> inner = compile_or(compiler, scene);
+      if(!inner) {
+        return inner;
+      }
+      if(!match(compiler, ')')) {
+        return {expected_error, Error("expected ')'")};
+      }
+      return expected_value;
+    }
+
+    char const* const begin = compiler.i;
+    while(compiler.i != compiler.end && !is_whitespace(*compiler.i) &&
+          !is_operator(*compiler.i)) {
+      compiler.i += 1;
+    }
+
+    String_View const name{begin, compiler.i};
+    if(name.size_bytes() == 0) {
+      return {expected_error, Error("expected a net")};
+    }
+
+    if(name == "0"_sv || name == "1"_sv) {
+      compiler.program.push_back(
+        Breakpoint_Op{Breakpoint_Opcode::e_constant, name == "1"_sv});
+      return expected_value;
+    }
+
+    Expected<u64, Error> gate = resolve_net(compiler.names, scene, name);
+    if(!gate) {
+      return {expected_error, ANTON_MOV(gate.error())};
+    }
+
+    // Operands refer to the nets of the breakpoint, which are mapped to
+    // watches once the breakpoint has been added.
+    u32 operand = 0;
+    while(operand < compiler.gates.size() &&
+          compiler.gates[operand] != gate.value()) {
+      operand += 1;
+    }
+    if(operand == compiler.gates.size()) {
+      compiler.gates.push_back(gate.value());
+    }
+    compiler.program.push_back(
+      Breakpoint_Op{Breakpoint_Opcode::e_load, operand});
+    return expected_value;
+  }
+
+  [[nodiscard]] static Expected<void, Error>
+  compile_binary(Compiler& compiler, Scene& scene, i64 const level)
+  {
+    // Levels in the order of increasing precedence.
+    constexpr char operators[] = {'|', '^', '&'};
+    constexpr Breakpoint_Opcode opcodes[] = {
+      Breakpoint_Opcode::e_or, Breakpoint_Opcode::e_xor,
+      Breakpoint_Opcode::e_and};
+    auto compile_operand = [&compiler, &scene, level] {
+      if(level + 1 < 3) {
+        return compile_binary(compiler, scene, level + 1);
+      } else {
+        return compile_primary(compiler, scene);
+      }
+    };
+
+    Expected<void, Error> left = compile_operand();
+    if(!left) {
+      return left;
+    }
+
+    while(match(compiler, operators[level])) {
+      Expected<void, Error> right = compile_operand();
+      if(!right) {
+        return right;
+      }
+      compiler.program.push_back(Breakpoint_Op{opcodes[level], 0});
+    }
+    return expected_value;
+  }
+
+  Expected<void, Error> compile_or(Compiler& compiler, Scene& scene)
+  {
+    return compile_binary(compiler, scene, 0);
+  }
+
+  [[nodiscard]] static bool run_program(Breakpoints& breakpoints,
+                                        Breakpoint const& breakpoint)
+  {
+    Array<u8>& stack = breakpoints.stack;
+    stack.clear();
+    for(Breakpoint_Op const& op: breakpoint.program) {
+      switch(op.opcode) {
+      case Breakpoint_Opcode::e_load:
+        stack.push_back(breakpoints.watches[op.operand].value);
+        break;
+      case Breakpoint_Opcode::e_constant:
+        stack.push_back(op.operand);
+        break;
+      case Breakpoint_Opcode::e_not:
+        stack.back() = !stack.back();
+        break;
+      case Breakpoint_Opcode::e_and: {
+        u8 const value = stack.back();
+        stack.pop_back();
+        stack.back() &= value;
+      } break;
+      case Breakpoint_Opcode::e_or: {
+        u8 const value = stack.back();
+        stack.pop_back();
+        stack.back() |= value;
+      } break;
+      case Breakpoint_Opcode::e_xor: {
+        u8 const value = stack.back();
+        stack.pop_back();
+        stack.back() ^= value;
+      } break;
+      }
+    }
+    return stack.back();
+  }
+
+  // rebuild_watches
+  //
+  // Map the nets of all breakpoints to watches and rewrite the operands of
+  // the programs to refer to the watches. gates holds the nets of every
+  // breakpoint in the order of their operands.
+  //
+  static void rebuild_watches(Breakpoints& breakpoints, Scene& scene,
+                              Slice<Array<u64> const> const gates)
+  {
+    breakpoints.watches.clear();
+    breakpoints.watch_indices.clear();
+    breakpoints.watch_breakpoints.clear();
+    breakpoints.watch_filter.clear();
+    for(Array<u64> const& nets: gates) {
+      for(u64 const gate: nets) {
+        if(breakpoints.watch_indices.find(gate) !=
+           breakpoints.watch_indices.end()) {
+          continue;
+        }
+
+        u32 const index = breakpoints.watches.size();
+        breakpoints.watches.push_back(Breakpoint_Watch{gate, false, 0, 0});
+        breakpoints.watch_indices.emplace(gate, index);
+        i64 const word = static_cast<i64>(gate >> 6);
+        if(word >= breakpoints.watch_filter.size()) {
+          breakpoints.watch_filter.resize(word + 1, 0);
+        }
+        breakpoints.watch_filter[word] |= static_cast<u64>(1) << (gate & 63);
+      }
+    }
+
+    for(i64 i = 0; i < breakpoints.breakpoints.size(); ++i) {
+      Breakpoint& breakpoint = breakpoints.breakpoints[i];
+      breakpoint.watches.clear();
+      for(u64 const gate: gates[i]) {
+        u32 const index = breakpoints.watch_indices.find(gate)->value;
+        breakpoint.watches.push_back(index);
+        breakpoints.watches[index].count += 1;
+      }
+    }
+
+    u32 first = 0;
+    for(Breakpoint_Watch& watch: breakpoints.watches) {
+      watch.first = first;
+      first += watch.count;
+      watch.count = 0;
+    }
+
+    breakpoints.watch_breakpoints.resize(first, 0);
+    for(i64 i = 0; i < breakpoints.breakpoints.size(); ++i) {
+      Breakpoint& breakpoint = breakpoints.breakpoints[i];
+      for(u32 const index: breakpoint.watches) {
+        Breakpoint_Watch& watch = breakpoints.watches[index];
+        breakpoints.watch_breakpoints[watch.first + watch.count] = i;
+        watch.count += 1;
+      }
+
+      for(Breakpoint_Op& op: breakpoint.program) {
+        if(op.opcode == Breakpoint_Opcode::e_load) {
+          op.operand = breakpoint.watches[op.operand];
+        }
+      }
+    }
+
+    breakpoints.pending_flags.clear();
+    breakpoints.pending_flags.resize(breakpoints.breakpoints.size(), 0);
+    reset_breakpoints(breakpoints, scene);
+  }
+
+  // collect_gates
+  //
+  // Collect the nets of every breakpoint in the order of their operands and
+  // restore the operands of the programs to refer to them.
+  //
+  static void collect_gates(Breakpoints& breakpoints, Array<Array<u64>>& gates)
+  {
+    for(Breakpoint& breakpoint: breakpoints.breakpoints) {
+      Array<u64>& nets = gates.emplace_back();
+      for(u32 const index: breakpoint.watches) {
+        nets.push_back(breakpoints.watches[index].gate);
+      }
+
+      for(Breakpoint_Op& op: breakpoint.program) {
+        if(op.opcode == Breakpoint_Opcode::e_load) {
+          for(u32 i = 0; i < breakpoint.watches.size(); ++i) {
+            if(breakpoint.watches[i] == op.operand) {
+              op.operand = i;
+              break;
+            }
+          }
+        }
+      }
+    }
+  }
+
+  Expected<void, Error> add_breakpoint(Breakpoints& breakpoints, Scene& scene,
+                                       Breakpoint_Kind const kind,
+                                       String_View const text)
+  {
+    Flat_Hash_Map<String, u64> names;
+    for(Gate const& gate: scene.gates) {
+      if(gate.name.size_bytes() > 0) {
+        names.emplace(gate.name, gate.id);
+      }
+    }
+
+    Breakpoint breakpoint;
+    breakpoint.kind = kind;
+    breakpoint.text = String(text);
+    Array<u64> nets;
+    Compiler compiler{names, nets, breakpoint.program, text.data(),
+                      text.data() + text.size_bytes()};
+    Expected<void, Error> compiled =
+      kind == Breakpoint_Kind::e_condition
+        ? compile_or(compiler, scene)
+        : compile_primary(compiler, scene);
+    if(!compiled) {
+      return compiled;
+    }
+
+    skip_whitespace(compiler);
+    if(compiler.i != compiler.end) {
+      return {expected_error,
+              format("unexpected '{}'"_sv,
+                     String_View{compiler.i, compiler.end})};
+    }
+
+    if(kind != Breakpoint_Kind::e_condition &&
+       (nets.size() != 1 || breakpoint.program.size() != 1)) {
+      return {expected_error, Error("expected a single net")};
+    }
+
+    if(nets.size() == 0) {
+      return {expected_error, Error("the condition refers to no nets")};
+    }
+
+    Array<Array<u64>> gates;
+    collect_gates(breakpoints, gates);
+    gates.push_back(ANTON_MOV(nets));
+    breakpoints.breakpoints.push_back(ANTON_MOV(breakpoint));
+    rebuild_watches(breakpoints, scene, gates);
+    return expected_value;
+  }
+
+  void remove_breakpoint(Breakpoints& breakpoints, Scene& scene,
+                         i64 const index)
+  {
+    Array<Array<u64>> gates;
+    collect_gates(breakpoints, gates);
+    gates.erase(gates.begin() + index, gates.begin() + index + 1);
+    breakpoints.breakpoints.erase(breakpoints.breakpoints.begin() + index,
+                                  breakpoints.breakpoints.begin() + index + 1);
+    rebuild_watches(breakpoints, scene, gates);
+  }
+
+  void reset_breakpoints(Breakpoints& breakpoints, Scene& scene)
+  {
+    for(Breakpoint_Watch& watch: breakpoints.watches) {
+      Gate const* const gate = scene.find_gate(watch.gate);
+      watch.value = gate != nullptr && gate->evaluation.value;
+    }
+
+    for(Breakpoint& breakpoint: breakpoints.breakpoints) {
+      if(breakpoint.kind == Breakpoint_Kind::e_condition) {
+        breakpoint.result = run_program(breakpoints, breakpoint);
+      }
+    }
+    breakpoints.hit_breakpoint = -1;
+    breakpoints.hit_gate = 0;
+  }
+
+  // update_watch
+  //
+  // Compare a watch with the value of its gate and check the edge
+  // breakpoints of the watch. Conditions are only marked as pending because
+  // several of their nets may change within a cycle.
+  //
+  static void update_watch(Breakpoints& breakpoints, u32 const index,
+                           bool const value)
+  {
+    Breakpoint_Watch& watch = breakpoints.watches[index];
+    if(watch.value == value) {
+      return;
+    }
+
+    watch.value = value;
+    for(u32 i = watch.first; i < watch.first + watch.count; ++i) {
+      u32 const breakpoint_index = breakpoints.watch_breakpoints[i];
+      Breakpoint& breakpoint = breakpoints.breakpoints[breakpoint_index];
+      bool hit = false;
+      switch(breakpoint.kind) {
+      case Breakpoint_Kind::e_rise:
+        hit = value;
+        break;
+      case Breakpoint_Kind::e_fall:
+        hit = !value;
+        break;
+      case Breakpoint_Kind::e_change:
+        hit = true;
+        break;
+      case Breakpoint_Kind::e_condition:
+        if(!breakpoints.pending_flags[breakpoint_index]) {
+          breakpoints.pending_flags[breakpoint_index] = true;
+          breakpoints.pending.push_back(breakpoint_index);
+          breakpoints.pending_gates.push_back(watch.gate);
+        }
+        break;
+      }
+
+      // Disabled breakpoints keep tracking their nets, hence enabling a
+      // condition does not report a stale edge.
+      if(hit && breakpoint.enabled) {
+        breakpoint.hits += 1;
+        if(breakpoints.hit_breakpoint < 0) {
+          breakpoints.hit_breakpoint = breakpoint_index;
+          breakpoints.hit_gate = watch.gate;
+        }
+      }
+    }
+  }
+
+  bool check_breakpoints(Breakpoints& breakpoints,
+                         Slice<Gate* const> const changed)
+  {
+    breakpoints.hit_breakpoint = -1;
+    breakpoints.hit_gate = 0;
+    if(breakpoints.watches.size() == 0) {
+      return false;
+    }
+
+    Array<u64> const& filter = breakpoints.watch_filter;
+    for(Gate const* const gate: changed) {
+      i64 const word = static_cast<i64>(gate->id >> 6);
+      if(word >= filter.size() || !((filter[word] >> (gate->id & 63)) & 1)) {
+        continue;
+      }
+
+      auto iter = breakpoints.watch_indices.find(gate->id);
+      if(iter != breakpoints.watch_indices.end()) {
+        update_watch(breakpoints, iter->value, gate->evaluation.value);
+      }
+    }
+
+    for(i64 i = 0; i < breakpoints.pending.size(); ++i) {
+      u32 const index = breakpoints.pending[i];
+      breakpoints.pending_flags[index] = false;
+      Breakpoint& breakpoint = breakpoints.breakpoints[index];
+      bool const result = run_program(breakpoints, breakpoint);
+      if(result && !breakpoint.result && breakpoint.enabled) {
+        breakpoint.hits += 1;
+        if(breakpoints.hit_breakpoint < 0) {
+          breakpoints.hit_breakpoint = index;
+          breakpoints.hit_gate = breakpoints.pending_gates[i];
+        }
+      }
+      breakpoint.result = result;
+    }
+    breakpoints.pending.clear();
+    breakpoints.pending_gates.clear();
+    return breakpoints.hit_breakpoint >= 0;
+  }
+} // namespace nebula
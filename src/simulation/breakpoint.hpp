@@ -0,0 +1,143 @@
+#pragma once
+
+#include <anton/expected.hpp>
+#include <anton/flat_hash_map.hpp>
+#include <anton/slice.hpp>
+#include <anton/string_view.hpp>
+
+#include <core/error.hpp>
+#include <core/types.hpp>
+#include <model/gate.hpp>
+
+namespace nebula {
+  struct Scene;
+
+  enum struct Breakpoint_Kind : u8 {
+    // The net changes from 0 to 1.
+    e_rise,
+    // The net changes from 1 to 0.
+    e_fall,
+    // The net changes in either direction.
+    e_change,
+    // An expression over several nets changes from false to true.
+    e_condition,
+  };
+
+  enum struct Breakpoint_Opcode : u8 {
+    // Pushes the value of the watch given by the operand.
+    e_load,
+    // Pushes the operand.
+    e_constant,
+    e_not,
+    e_and,
+    e_or,
+    e_xor,
+  };
+
+  /**
+   * @brief An instruction of the postfix program of a condition.
+   */
+  struct Breakpoint_Op {
+    Breakpoint_Opcode opcode;
+    u32 operand;
+  };
+
+  struct Breakpoint {
+    Breakpoint_Kind kind;
+    // The net or the expression as entered.
+    String text;
+    // Indices of the watches of the nets the breakpoint refers to.
+    Array<u32> watches;
+    // The compiled expression of condition breakpoints.
+    Array<Breakpoint_Op> program;
+    // Value of the expression after the last checked cycle.
+    bool result = false;
+    bool enabled = true;
+    i64 hits = 0;
+  };
+
+  /**
+   * @brief A watched net shared by all breakpoints referring to it.
+   *
+   * The breakpoints of the watch are
+   * Breakpoints::watch_breakpoints[first, first + count).
+   */
+  struct Breakpoint_Watch {
+    u64 gate;
+    // Value of the net after the last checked cycle.
+    bool value;
+    u32 first;
+    u32 count;
+  };
+
+  /**
+   * @brief A set of breakpoints checked after every cycle.
+   *
+   * Only the nets reported as changed by evaluate are looked up in the
+   * watches, hence the cost of checking is proportional to the activity of
+   * the design rather than to the number of breakpoints. evaluate reports
+   * inputs assigned between cycles as well, hence no net is compared every
+   * cycle.
+   */
+  struct Breakpoints {
+    Array<Breakpoint> breakpoints;
+    Array<Breakpoint_Watch> watches;
+    // Maps the identifier of a gate to the index of its watch.
+    Flat_Hash_Map<u64, u32> watch_indices;
+    // Bitset of the identifiers of the watched gates. Identifiers are dense,
+    // hence testing a bit rejects most changed gates without a lookup.
+    Array<u64> watch_filter;
+    Array<u32> watch_breakpoints;
+    // Index of the breakpoint hit by the last check or -1.
+    i64 hit_breakpoint = -1;
+    // Identifier of the gate whose change triggered the hit or 0.
+    u64 hit_gate = 0;
+    // Scratch buffers of a check. pending holds the conditions to evaluate
+    // and pending_gates the first changed net of each.
+    Array<u32> pending;
+    Array<u64> pending_gates;
+    Array<u8> pending_flags;
+    Array<u8> stack;
+  };
+
+  /**
+   * @brief Adds a breakpoint.
+   *
+   * Nets are referred to by name. Unnamed gates are named g<id>. The text of
+   * an edge breakpoint is a single net. The text of a condition is an
+   * expression of nets, the constants 0 and 1, parentheses and the operators
+   * ! (not), & (and), ^ (xor) and | (or) in the order of decreasing
+   * precedence.
+   *
+   * @return Nothing on success, otherwise an error message.
+   */
+  [[nodiscard]] Expected<void, Error>
+  add_breakpoint(Breakpoints& breakpoints, Scene& scene, Breakpoint_Kind kind,
+                 String_View text);
+
+  /**
+   * @brief Removes a breakpoint.
+   */
+  void remove_breakpoint(Breakpoints& breakpoints, Scene& scene, i64 index);
+
+  /**
+   * @brief Captures the current values of the watched nets.
+   *
+   * Must be called whenever the state of the scene changes other than by
+   * evaluating a cycle, for example after seeking or restoring a checkpoint.
+   */
+  void reset_breakpoints(Breakpoints& breakpoints, Scene& scene);
+
+  /**
+   * @brief Checks the breakpoints after a cycle has been evaluated.
+   *
+   * Sets hit_breakpoint and hit_gate to the first breakpoint that has been
+   * hit. All watches are updated even if a breakpoint has been hit.
+   *
+   * @param breakpoints The breakpoints to check.
+   * @param changed The gates reported as changed by evaluate, including
+   * the inputs assigned since the previous cycle.
+   * @return Whether a breakpoint has been hit.
+   */
+  bool check_breakpoints(Breakpoints& breakpoints, Slice<Gate* const> changed);
+} // namespace nebula
@@ -0,0 +1,244 @@
+#include <simulation/checkpoint.hpp>
+
+#include <anton/filesystem.hpp>
+#include <anton/format.hpp>
+
+#include <model/memory.hpp>
+#include <model/module.hpp>
+#include <model/port.hpp>
+#include <simulation/state.hpp>
+#include <ui/scene.hpp>
+
+#include <atomic>
+#include <thread>
+
+namespace nebula {
+  // "NEBCKPT" followed by the format version.
+  constexpr u64 checkpoint_magic = 0x0354504B4342454E;
+
+  // Checkpoint_Header
+  //
+  // Stored at the beginning of the file followed by word_count words of the
+  // values of the state and word_count words of the unknown flags.
+  //
+  struct Checkpoint_Header {
+    u64 magic;
+    u64 netlist_hash;
+    i64 cycle;
+    i64 clock_time;
+    i64 timed_time;
+    i64 gate_count;
+    i64 bit_count;
+    i64 word_count;
+  };
+
+  struct Checkpoint_Job {
+    String path;
+    // The header followed by the state.
+    Array<u64> data;
+    Error error;
+    bool failed = false;
+    std::thread thread;
+    std::atomic<bool> finished = false;
+  };
+
+  constexpr i64 header_words = sizeof(Checkpoint_Header) / sizeof(u64);
+
+  // hash_value
+  //
+  // Combine a hash with a value using 64-bit FNV-1a over its bytes.
+  //
+  [[nodiscard]] static u64 hash_value(u64 hash, u64 const value)
+  {
+    for(i64 i = 0; i < 8; ++i) {
+      hash ^= (value >> (i * 8)) & 0xFF;
+      hash *= 0x100000001B3;
+    }
+    return hash;
+  }
+
+  [[nodiscard]] static u64 hash_string(u64 hash, String_View const string)
+  {
+    hash = hash_value(hash, string.size_bytes());
+    char const* const end = string.data() + string.size_bytes();
+    for(char const* i = string.data(); i != end; ++i) {
+      hash ^= static_cast<u8>(*i);
+      hash *= 0x100000001B3;
+    }
+    return hash;
+  }
+
+  u64 hash_netlist(Scene& scene)
+  {
+    u64 hash = 0xCBF29CE484222325;
+    for(Gate& gate: scene.gates) {
+      hash = hash_value(hash, gate.id);
+      hash = hash_value(hash, static_cast<u64>(gate.kind));
+      hash = hash_value(hash, get_state_bit_count(gate));
+      if(gate.kind == Gate_Kind::e_module) {
+        hash = hash_string(hash, gate.definition->name);
+      } else if(is_memory(gate.kind)) {
+        hash = hash_string(hash, gate.memory->name);
+      } else if(gate.kind == Gate_Kind::e_lut) {
+        hash = hash_value(hash, gate.table);
+      }
+
+      for(Port const* const port: gate.in_ports) {
+        if(port->connections.size() == 0) {
+          hash = hash_value(hash, static_cast<u64>(-1));
+          continue;
+        }
+
+        Port const* const driver = *port->connections.begin();
+        hash = hash_value(hash, driver->gate->id);
+        hash = hash_value(hash, driver->index);
+      }
+    }
+    return hash;
+  }
+
+  static void write_checkpoint(Checkpoint_Job& job)
+  {
+    fs::Output_File_Stream file;
+    if(!file.open(job.path)) {
+      job.error = format("could not open '{}'"_sv, job.path);
+      job.failed = true;
+      return;
+    }
+
+    file.write(job.data.data(), job.data.size() * sizeof(u64));
+    file.close();
+  }
+
+  // get_first_bits
+  //
+  // Compute the bit the state of every gate starts at.
+  //
+  // Returns:
+  // The number of bits of the state of all gates.
+  //
+  static i64 get_first_bits(Scene const& scene, Array<i64>& first_bits)
+  {
+    i64 bit_count = 0;
+    first_bits.ensure_capacity(scene.gates.size());
+    for(Gate const& gate: scene.gates) {
+      first_bits.push_back(bit_count);
+      bit_count += get_state_bit_count(gate);
+    }
+    return bit_count;
+  }
+
+  Checkpoint_Job* start_checkpoint(Scene& scene, Checkpoint_Time const& time,
+                                   String_View const path)
+  {
+    Checkpoint_Job* const job = new Checkpoint_Job;
+    job->path = String(path);
+
+    Array<i64> first_bits;
+    i64 const bit_count = get_first_bits(scene, first_bits);
+
+    i64 const word_count = (bit_count + 63) / 64;
+    job->data.resize(header_words + 2 * word_count, 0);
+    Checkpoint_Header const header{checkpoint_magic,
+                                   hash_netlist(scene),
+                                   time.cycle,
+                                   time.clock_time,
+                                   time.timed_time,
+                                   scene.gates.size(),
+                                   bit_count,
+                                   word_count};
+    memcpy(job->data.data(), &header, sizeof(Checkpoint_Header));
+
+    u64* const state = job->data.data() + header_words;
+    u64* const unknown = state + word_count;
+    i64 index = 0;
+    for(Gate const& gate: scene.gates) {
+      save_state(gate, state, unknown, first_bits[index]);
+      index += 1;
+    }
+
+    job->thread = std::thread([job] {
+      write_checkpoint(*job);
+      job->finished.store(true, std::memory_order_release);
+    });
+    return job;
+  }
+
+  bool is_checkpoint_finished(Checkpoint_Job const* const job)
+  {
+    return job->finished.load(std::memory_order_acquire);
+  }
+
+  Expected<void, Error> finish_checkpoint(Checkpoint_Job* const job)
+  {
+    job->thread.join();
+    bool const failed = job->failed;
+    Error error = ANTON_MOV(job->error);
+    delete job;
+    if(failed) {
+      return {expected_error, ANTON_MOV(error)};
+    }
+    return expected_value;
+  }
+
+  Expected<void, Error> save_checkpoint(Scene& scene,
+                                        Checkpoint_Time const& time,
+                                        String_View const path)
+  {
+    return finish_checkpoint(start_checkpoint(scene, time, path));
+  }
+
+  Expected<Checkpoint_Time, Error> restore_checkpoint(Scene& scene,
+                                                      String_View const path)
+  {
+    fs::Input_File_Stream file;
+    if(!file.open(path)) {
+      return {expected_error, format("could not open '{}'"_sv, path)};
+    }
+
+    file.seek(Seek_Dir::end, 0);
+    i64 const size = file.tell();
+    file.seek(Seek_Dir::beg, 0);
+    if(size < static_cast<i64>(sizeof(Checkpoint_Header)) ||
+       size % sizeof(u64) != 0) {
+      return {expected_error,
+              format("'{}' is not a checkpoint"_sv, path)};
+    }
+
+    Array<u64> data(size / sizeof(u64), 0);
+    if(file.read(data.data(), size) != size) {
+      return {expected_error, format("could not read '{}'"_sv, path)};
+    }
+
+    Checkpoint_Header header;
+    memcpy(&header, data.data(), sizeof(Checkpoint_Header));
+    if(header.magic != checkpoint_magic) {
+      return {expected_error,
+              format("'{}' is not a checkpoint"_sv, path)};
+    }
+
+    if(header.netlist_hash != hash_netlist(scene) ||
+       header.gate_count != scene.gates.size()) {
+      return {expected_error,
+              format("'{}' has been saved for a different netlist"_sv, path)};
+    }
+
+    Array<i64> first_bits;
+    i64 const bit_count = get_first_bits(scene, first_bits);
+    if(header.bit_count != bit_count ||
+       2 * header.word_count != data.size() - header_words ||
+       header.word_count != (bit_count + 63) / 64) {
+      return {expected_error, format("'{}' is corrupted"_sv, path)};
+    }
+
+    u64 const* const state = data.data() + header_words;
+    u64 const* const unknown = state + header.word_count;
+    i64 index = 0;
+    for(Gate& gate: scene.gates) {
+      restore_state(gate, state, unknown, first_bits[index]);
+      index += 1;
+    }
+    return {expected_value, Checkpoint_Time{header.cycle, header.clock_time,
+                                            header.timed_time}};
+  }
+} // namespace nebula
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <anton/expected.hpp>
+#include <anton/string_view.hpp>
+
+#include <core/error.hpp>
+#include <core/types.hpp>
+
+namespace nebula {
+  struct Scene;
+
+  /**
+   * @brief A checkpoint being written on a background thread.
+   */
+  struct Checkpoint_Job;
+
+  /**
+   * @brief Position of the simulation saved along with its state.
+   *
+   * The times of the schedules are saved so that the clocks and the timed
+   * evaluation continue from where they were instead of starting over. The
+   * pending events of the timed evaluation are not saved, hence it continues
+   * by evaluating all gates at the following tick.
+   */
+  struct Checkpoint_Time {
+    // The last evaluated cycle.
+    i64 cycle = -1;
+    // Time of the last edge of the evaluation by clock domains.
+    i64 clock_time = -1;
+    // Last tick processed by the timed evaluation.
+    i64 timed_time = -1;
+  };
+
+  /**
+   * @brief Computes a hash of the structure of the netlist of a scene.
+   *
+   * The hash covers the gates in scene order with their identifiers, kinds
+   * and module definitions, and the driver of every input port. Two scenes
+   * with equal hashes have the same layout of the simulation state.
+   */
+  [[nodiscard]] u64 hash_netlist(Scene& scene);
+
+  /**
+   * @brief Starts saving the simulation state of a scene to a file.
+   *
+   * The state is packed into a bitset on the calling thread, hence the scene
+   * may be modified and evaluated while the job writes the file. The file
+   * consists of a header with the netlist hash, the time and the size of the
+   * state, followed by the bitset. The bitset holds the value of every gate
+   * followed by the state of module instances as laid out by get_state_bit.
+   * A second bitset of the same layout marks the unknown bits of the
+   * four-valued logic.
+   *
+   * @param scene The scene to save.
+   * @param time The last evaluated cycle and the times of the schedules.
+   * @param path The path to the checkpoint file.
+   * @return The running job. Must be released with finish_checkpoint.
+   */
+  [[nodiscard]] Checkpoint_Job* start_checkpoint(Scene& scene,
+                                                 Checkpoint_Time const& time,
+                                                 String_View path);
+
+  /**
+   * @brief Checks whether a job has finished writing.
+   */
+  [[nodiscard]] bool is_checkpoint_finished(Checkpoint_Job const* job);
+
+  /**
+   * @brief Waits for a job to finish and releases it.
+   *
+   * @return Nothing on success, otherwise an error message.
+   */
+  [[nodiscard]] Expected<void, Error> finish_checkpoint(Checkpoint_Job* job);
+
+  /**
+   * @brief Saves the simulation state of a scene on the calling thread.
+   *
+   * Equivalent to starting a job and immediately finishing it.
+   */
+  [[nodiscard]] Expected<void, Error>
+  save_checkpoint(Scene& scene, Checkpoint_Time const& time, String_View path);
+
+  /**
+   * @brief Restores the simulation state of a scene from a file.
+   *
+   * The file is read with a single read and rejected unless its netlist hash
+   * matches the scene. The scene is left unmodified on failure.
+   *
+   * The schedules are not modified. The caller continues them from the
+   * restored times with restart_clock_schedule and restart_timed_schedule.
+   *
+   * @param scene The scene to restore.
+   * @param path The path to the checkpoint file.
+   * @return The time the checkpoint has been saved at on success, otherwise
+   * an error message.
+   */
+  [[nodiscard]] Expected<Checkpoint_Time, Error>
+  restore_checkpoint(Scene& scene, String_View path);
+} // namespace nebula
@@ -0,0 +1,214 @@
+#include <simulation/coverage.hpp>
+
+#include <anton/filesystem.hpp>
+#include <anton/format.hpp>
+
+#include <ui/scene.hpp>
+
+namespace nebula {
+  [[nodiscard]] static u64 get_transitions(Toggle_Counters const& toggles,
+                                           i64 const slot)
+  {
+    return toggles.rises[slot] + toggles.falls[slot];
+  }
+
+  Coverage_Summary summarize_coverage(Toggle_Counters const& toggles)
+  {
+    Coverage_Summary summary;
+    summary.nets = toggles.gates.size();
+    for(i64 slot = 0; slot < toggles.gates.size(); ++slot) {
+      if(toggles.rises[slot] > 0 && toggles.falls[slot] > 0) {
+        summary.covered += 1;
+      } else if(get_transitions(toggles, slot) == 0) {
+        summary.untoggled += 1;
+      }
+    }
+    return summary;
+  }
+
+  void collect_untoggled(Toggle_Counters const& toggles, Array<i64>& slots)
+  {
+    slots.clear();
+    for(i64 slot = 0; slot < toggles.gates.size(); ++slot) {
+      if(get_transitions(toggles, slot) == 0) {
+        slots.push_back(slot);
+      }
+    }
+  }
+
+  void collect_hottest(Toggle_Counters const& toggles, i64 const count,
+                       Array<i64>& slots)
+  {
+    // slots is kept sorted by decreasing transitions and bounded by count,
+    // hence most nets are rejected by a single comparison with the last.
+    slots.clear();
+    if(count <= 0) {
+      return;
+    }
+
+    for(i64 slot = 0; slot < toggles.gates.size(); ++slot) {
+      u64 const transitions = get_transitions(toggles, slot);
+      if(transitions == 0 ||
+         (slots.size() == count &&
+          transitions <= get_transitions(toggles, slots.back()))) {
+        continue;
+      }
+
+      if(slots.size() < count) {
+        slots.push_back(slot);
+      } else {
+        slots.back() = slot;
+      }
+
+      for(i64 i = slots.size() - 1;
+          i > 0 && get_transitions(toggles, slots[i - 1]) < transitions; --i) {
+        i64 const swapped = slots[i - 1];
+        slots[i - 1] = slots[i];
+        slots[i] = swapped;
+      }
+    }
+  }
+
+  String get_coverage_name(Toggle_Counters const& toggles, Scene& scene,
+                           i64 const slot)
+  {
+    u64 const id = toggles.gates[slot];
+    Gate const* const gate = scene.find_gate(id);
+    if(gate != nullptr && gate->name.size_bytes() > 0) {
+      return gate->name;
+    }
+    return format("g{}"_sv, id);
+  }
+
+  // get_rate
+  //
+  // Transitions per cycle in thousandths, which avoids formatting floats.
+  //
+  [[nodiscard]] static String get_rate(Toggle_Counters const& toggles,
+                                       i64 const slot)
+  {
+    u64 const cycles = toggles.cycles > 0 ? toggles.cycles : 1;
+    u64 const rate = get_transitions(toggles, slot) * 1000 / cycles;
+    String fraction = format("{}"_sv, rate % 1000);
+    while(fraction.size_bytes() < 3) {
+      fraction = "0"_sv + fraction;
+    }
+    return format("{}.{}"_sv, rate / 1000, fraction);
+  }
+
+  [[nodiscard]] static bool has_suffix(String_View const text,
+                                       String_View const suffix)
+  {
+    if(text.size_bytes() < suffix.size_bytes()) {
+      return false;
+    }
+    String_View const tail{text.data() + text.size_bytes() -
+                             suffix.size_bytes(),
+                           text.data() + text.size_bytes()};
+    return tail == suffix;
+  }
+
+  // write_json_string
+  //
+  // Write a string escaping the characters JSON does not allow verbatim.
+  //
+  static void write_json_string(fs::Output_File_Stream& file,
+                                String_View const text)
+  {
+    file.write("\""_sv);
+    char const* const end = text.data() + text.size_bytes();
+    for(char const* i = text.data(); i != end; ++i) {
+      if(*i == '"' || *i == '\\') {
+        char const escaped[] = {'\\', *i};
+        file.write(String_View{escaped, escaped + 2});
+      } else if(static_cast<u8>(*i) < 0x20) {
+        char const* const digits = "0123456789abcdef";
+        char const escaped[] = {'\\', 'u', '0', '0', digits[*i >> 4],
+                                digits[*i & 15]};
+        file.write(String_View{escaped, escaped + 6});
+      } else {
+        file.write(String_View{i, i + 1});
+      }
+    }
+    file.write("\""_sv);
+  }
+
+  // write_csv_field
+  //
+  // Write a field as RFC 4180 requires. Fields containing commas, quotes or
+  // line breaks are enclosed in quotes with the quotes within doubled.
+  //
+  static void write_csv_field(fs::Output_File_Stream& file,
+                              String_View const text)
+  {
+    char const* const begin = text.data();
+    char const* const end = text.data() + text.size_bytes();
+    bool quoted = false;
+    for(char const* i = begin; i != end; ++i) {
+      if(*i == ',' || *i == '"' || *i == '\r' || *i == '\n') {
+        quoted = true;
+        break;
+      }
+    }
+
+    if(!quoted) {
+      file.write(text);
+      return;
+    }
+
+    file.write("\""_sv);
+    char const* run = begin;
+    for(char const* i = begin; i != end; ++i) {
+      if(*i == '"') {
+        // Write the run including the quote, then the quote again.
+        file.write(String_View{run, i + 1});
+        file.write("\""_sv);
+        run = i + 1;
+      }
+    }
+    file.write(String_View{run, end});
+    file.write("\""_sv);
+  }
+
+  Expected<void, Error> export_coverage(Toggle_Counters const& toggles,
+                                        Scene& scene, String_View const path)
+  {
+    fs::Output_File_Stream file;
+    if(!file.open(path)) {
+      return {expected_error, format("could not open '{}'"_sv, path)};
+    }
+
+    bool const json = has_suffix(path, ".json"_sv);
+    if(json) {
+      file.write("{\"cycles\": "_sv);
+      file.write(format("{}"_sv, toggles.cycles));
+      file.write(", \"nets\": ["_sv);
+    } else {
+      file.write("net,id,rises,falls,rate\n"_sv);
+    }
+
+    for(i64 slot = 0; slot < toggles.gates.size(); ++slot) {
+      String const name = get_coverage_name(toggles, scene, slot);
+      String const rate = get_rate(toggles, slot);
+      if(json) {
+        file.write(slot > 0 ? ",\n  {\"net\": "_sv : "\n  {\"net\": "_sv);
+        write_json_string(file, name);
+        file.write(format(", \"id\": {}, \"rises\": {}, \"falls\": {}"_sv,
+                          toggles.gates[slot], toggles.rises[slot],
+                          toggles.falls[slot]));
+        file.write(format(", \"rate\": {}"_sv, rate));
+        file.write("}"_sv);
+      } else {
+        write_csv_field(file, name);
+        file.write(format(",{},{},{},{}\n"_sv, toggles.gates[slot],
+                          toggles.rises[slot], toggles.falls[slot], rate));
+      }
+    }
+
+    if(json) {
+      file.write("\n]}\n"_sv);
+    }
+    file.close();
+    return expected_value;
+  }
+} // namespace nebula
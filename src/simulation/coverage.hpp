@@ -0,0 +1,60 @@
+#pragma once
+
+#include <anton/expected.hpp>
+#include <anton/string_view.hpp>
+
+#include <core/error.hpp>
+#include <core/types.hpp>
+#include <evaluator/evaluator.hpp>
+
+namespace nebula {
+  struct Scene;
+
+  /**
+   * @brief Summary of the toggle coverage of a design.
+   */
+  struct Coverage_Summary {
+    i64 nets = 0;
+    // Nets that have both risen and fallen.
+    i64 covered = 0;
+    // Nets that have neither risen nor fallen.
+    i64 untoggled = 0;
+  };
+
+  [[nodiscard]] Coverage_Summary
+  summarize_coverage(Toggle_Counters const& toggles);
+
+  /**
+   * @brief Collects the slots of the nets that have never toggled.
+   */
+  void collect_untoggled(Toggle_Counters const& toggles, Array<i64>& slots);
+
+  /**
+   * @brief Collects the slots of the nets with the most transitions.
+   *
+   * @param toggles The counters.
+   * @param count The maximum number of slots to collect.
+   * @param slots Receives the slots ordered by decreasing transitions.
+   */
+  void collect_hottest(Toggle_Counters const& toggles, i64 count,
+                       Array<i64>& slots);
+
+  /**
+   * @brief Gets the name of the net of a slot. Unnamed gates are named g<id>.
+   */
+  [[nodiscard]] String get_coverage_name(Toggle_Counters const& toggles,
+                                         Scene& scene, i64 slot);
+
+  /**
+   * @brief Writes the counters of all nets to a file.
+   *
+   * Files ending with .json are written as an array of objects, all other
+   * files as CSV with the columns net, id, rises, falls and the number of
+   * transitions per cycle. Net names are quoted as RFC 4180 requires.
+   *
+   * @return Nothing on success, otherwise an error message.
+   */
+  [[nodiscard]] Expected<void, Error>
+  export_coverage(Toggle_Counters const& toggles, Scene& scene,
+                  String_View path);
+} // namespace nebula
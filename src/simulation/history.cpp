@@ -0,0 +1,374 @@
+#include <simulation/history.hpp>
+
+#include <anton/format.hpp>
+
+#include <logging/logging.hpp>
+#include <ui/scene.hpp>
+
+namespace nebula {
+  constexpr u32 no_event = static_cast<u32>(-1);
+
+  static void set_bit(Array<u64>& bits, i64 const index, bool const value)
+  {
+    u64 const mask = static_cast<u64>(1) << (index & 63);
+    if(value) {
+      bits[index >> 6] |= mask;
+    } else {
+      bits[index >> 6] &= ~mask;
+    }
+  }
+
+  [[nodiscard]] static bool get_bit(Array<u64> const& bits, i64 const index)
+  {
+    return (bits[index >> 6] >> (index & 63)) & 1;
+  }
+
+  static void append_varint(Array<u8>& data, u64 value)
+  {
+    while(value >= 0x80) {
+      data.push_back(static_cast<u8>(value | 0x80));
+      value >>= 7;
+    }
+    data.push_back(static_cast<u8>(value));
+  }
+
+  [[nodiscard]] static u64 read_varint(u8 const*& i)
+  {
+    u64 value = 0;
+    i64 shift = 0;
+    while(*i & 0x80) {
+      value |= static_cast<u64>(*i & 0x7F) << shift;
+      shift += 7;
+      i += 1;
+    }
+    value |= static_cast<u64>(*i) << shift;
+    i += 1;
+    return value;
+  }
+
+  [[nodiscard]] static i64 get_chunk_size(History_Chunk const& chunk)
+  {
+    return chunk.initial_values.size() * static_cast<i64>(sizeof(u64)) +
+           chunk.offsets.size() * static_cast<i64>(sizeof(u32)) +
+           chunk.data.size();
+  }
+
+  // page_out
+  //
+  // Write a chunk to the page file unless it has been written before and
+  // release its memory. Chunks are never modified after they have been
+  // closed, hence a chunk is written at most once.
+  //
+  static void page_out(History& history, History_Chunk& chunk)
+  {
+    if(chunk.file_offset < 0) {
+      fs::Output_File_Stream& file = history.page_output;
+      file.write(chunk.initial_values.data(),
+                 chunk.initial_values.size() * sizeof(u64));
+      file.write(chunk.offsets.data(), chunk.offsets.size() * sizeof(u32));
+      file.write(chunk.data.data(), chunk.data.size());
+      file.flush();
+      chunk.file_offset = history.paged_size;
+      history.paged_size += chunk.size;
+    }
+
+    chunk.initial_values = Array<u64>();
+    chunk.offsets = Array<u32>();
+    chunk.data = Array<u8>();
+    chunk.resident = false;
+    history.resident_size -= chunk.size;
+  }
+
+  [[nodiscard]] static bool page_in(History& history, History_Chunk& chunk)
+  {
+    i64 const signal_count = history.signals.size();
+    i64 const words = (signal_count + 63) / 64;
+    i64 const offsets_size = (signal_count + 1) * sizeof(u32);
+    i64 const data_size = chunk.size - words * sizeof(u64) - offsets_size;
+    chunk.initial_values.resize(words);
+    chunk.offsets.resize(signal_count + 1);
+    chunk.data.resize(data_size);
+
+    fs::Input_File_Stream& file = history.page_input;
+    file.seek(Seek_Dir::beg, chunk.file_offset);
+    i64 read = file.read(chunk.initial_values.data(), words * sizeof(u64));
+    read += file.read(chunk.offsets.data(), offsets_size);
+    read += file.read(chunk.data.data(), data_size);
+    if(read != chunk.size) {
+      LOG_ERROR("could not read chunk at {} from '{}'", chunk.file_offset,
+                history.options.page_path);
+      chunk.initial_values = Array<u64>();
+      chunk.offsets = Array<u32>();
+      chunk.data = Array<u8>();
+      return false;
+    }
+
+    chunk.resident = true;
+    history.resident_size += chunk.size;
+    return true;
+  }
+
+  // enforce_budget
+  //
+  // Page out the least recently used chunks until the resident chunks fit
+  // within the memory budget. The kept chunk is never paged out.
+  //
+  static void enforce_budget(History& history, History_Chunk const* const keep)
+  {
+    while(history.resident_size > history.options.memory_budget) {
+      History_Chunk* oldest = nullptr;
+      for(History_Chunk& chunk: history.chunks) {
+        if(!chunk.resident || &chunk == keep) {
+          continue;
+        }
+
+        if(oldest == nullptr || chunk.last_use < oldest->last_use) {
+          oldest = &chunk;
+        }
+      }
+
+      if(oldest == nullptr) {
+        break;
+      }
+      page_out(history, *oldest);
+    }
+  }
+
+  static void open_chunk(History& history, i64 const cycle)
+  {
+    i64 const signal_count = history.signals.size();
+    history.open = true;
+    history.open_first_cycle = cycle;
+    history.open_initial_values.clear();
+    history.open_initial_values.resize((signal_count + 63) / 64, 0);
+    for(i64 i = 0; i < signal_count; ++i) {
+      set_bit(history.open_initial_values, i, history.values[i]);
+    }
+    history.open_events.clear();
+    history.open_last_events.clear();
+    history.open_last_events.resize(signal_count, no_event);
+  }
+
+  // close_chunk
+  //
+  // Encode the open chunk. The events of every signal are linked backwards,
+  // hence they are gathered and reversed before encoding.
+  //
+  static void close_chunk(History& history)
+  {
+    i64 const signal_count = history.signals.size();
+    History_Chunk chunk;
+    chunk.first_cycle = history.open_first_cycle;
+    chunk.last_cycle = history.last_cycle;
+    chunk.initial_values = ANTON_MOV(history.open_initial_values);
+    chunk.offsets.resize(signal_count + 1);
+    Array<u32> cycles;
+    for(i64 signal = 0; signal < signal_count; ++signal) {
+      chunk.offsets[signal] = static_cast<u32>(chunk.data.size());
+      cycles.clear();
+      for(u32 event = history.open_last_events[signal]; event != no_event;
+          event = history.open_events[event].previous) {
+        cycles.push_back(history.open_events[event].cycle);
+      }
+
+      u32 previous = 0;
+      for(i64 i = cycles.size() - 1; i >= 0; --i) {
+        append_varint(chunk.data, cycles[i] - previous);
+        previous = cycles[i];
+      }
+    }
+    chunk.offsets[signal_count] = static_cast<u32>(chunk.data.size());
+    chunk.size = get_chunk_size(chunk);
+    chunk.last_use = history.clock;
+
+    history.resident_size += chunk.size;
+    history.chunks.push_back(ANTON_MOV(chunk));
+    history.open = false;
+    history.open_events = Array<History_Event>();
+    history.open_last_events = Array<u32>();
+    enforce_budget(history, nullptr);
+  }
+
+  static void record_value(History& history, i64 const signal, bool const value,
+                           i64 const cycle)
+  {
+    if(history.values[signal] == value) {
+      return;
+    }
+
+    history.values[signal] = value;
+    u32 const event = history.open_events.size();
+    history.open_events.push_back(
+      History_Event{static_cast<u32>(cycle - history.open_first_cycle),
+                    history.open_last_events[signal]});
+    history.open_last_events[signal] = event;
+  }
+
+  Expected<void, Error> start_history(History& history,
+                                      Slice<Gate* const> const gates,
+                                      History_Options const& options)
+  {
+    clear_history(history);
+    history.options = options;
+    if(!history.page_output.open(options.page_path) ||
+       !history.page_input.open(options.page_path)) {
+      return {expected_error,
+              format("could not open '{}'"_sv, options.page_path)};
+    }
+
+    for(Gate const* const gate: gates) {
+      if(history.signal_indices.find(gate->id) !=
+         history.signal_indices.end()) {
+        continue;
+      }
+
+      i64 const index = history.signals.size();
+      String name = gate->name.size_bytes() > 0
+                      ? gate->name
+                      : format("g{}"_sv, gate->id);
+      history.signals.push_back(History_Signal{gate->id, ANTON_MOV(name)});
+      history.signal_indices.emplace(gate->id, index);
+      history.values.push_back(gate->evaluation.value);
+    }
+    return expected_value;
+  }
+
+  void clear_history(History& history)
+  {
+    history.signals = Array<History_Signal>();
+    history.signal_indices.clear();
+    history.values = Array<u8>();
+    history.first_cycle = 0;
+    history.last_cycle = -1;
+    history.chunks = Array<History_Chunk>();
+    history.open_initial_values = Array<u64>();
+    history.open_events = Array<History_Event>();
+    history.open_last_events = Array<u32>();
+    history.open = false;
+    history.resident_size = 0;
+    history.paged_size = 0;
+    history.clock = 0;
+    history.page_output.close();
+    history.page_input.close();
+  }
+
+  void record_history(History& history, Scene& scene, i64 const cycle,
+                      Slice<Gate* const> const changed)
+  {
+    if(history.last_cycle < history.first_cycle) {
+      // The first cycle records the values of all gates.
+      for(i64 i = 0; i < history.signals.size(); ++i) {
+        Gate const* const gate = scene.find_gate(history.signals[i].gate);
+        history.values[i] = gate != nullptr && gate->evaluation.value;
+      }
+      history.first_cycle = cycle;
+      history.last_cycle = cycle;
+      open_chunk(history, cycle);
+      return;
+    }
+
+    if(!history.open) {
+      open_chunk(history, cycle);
+    } else if(cycle - history.open_first_cycle >=
+              history.options.chunk_cycles) {
+      close_chunk(history);
+      open_chunk(history, cycle);
+    }
+
+    for(Gate const* const gate: changed) {
+      auto iter = history.signal_indices.find(gate->id);
+      if(iter != history.signal_indices.end()) {
+        record_value(history, iter->value, gate->evaluation.value, cycle);
+      }
+    }
+
+    history.last_cycle = cycle;
+    if(history.open_events.size() >= history.options.chunk_changes) {
+      close_chunk(history);
+    }
+  }
+
+  // find_chunk
+  //
+  // Find the last chunk starting at or before a cycle.
+  //
+  // Returns:
+  // Index of the chunk or 0 if all chunks start after the cycle.
+  //
+  [[nodiscard]] static i64 find_chunk(History const& history, i64 const cycle)
+  {
+    i64 low = 0;
+    i64 high = history.chunks.size();
+    while(high - low > 1) {
+      i64 const middle = (low + high) / 2;
+      if(history.chunks[middle].first_cycle <= cycle) {
+        low = middle;
+      } else {
+        high = middle;
+      }
+    }
+    return low;
+  }
+
+  bool query_history(History& history, i64 const signal, i64 const begin,
+                     i64 const end, Array<i64>& changes)
+  {
+    changes.clear();
+    history.clock += 1;
+    bool value = false;
+    bool initialised = false;
+    auto add_change = [&value, &changes, begin, end](i64 const cycle) {
+      if(cycle <= begin) {
+        value = !value;
+      } else if(cycle < end) {
+        changes.push_back(cycle);
+      }
+    };
+
+    for(i64 i = find_chunk(history, begin);
+        i < history.chunks.size() && history.chunks[i].first_cycle < end;
+        ++i) {
+      History_Chunk& chunk = history.chunks[i];
+      if(chunk.last_cycle < begin) {
+        continue;
+      }
+
+      if(!chunk.resident) {
+        if(!page_in(history, chunk)) {
+          return value;
+        }
+        enforce_budget(history, &chunk);
+      }
+      chunk.last_use = history.clock;
+
+      if(!initialised) {
+        initialised = true;
+        value = get_bit(chunk.initial_values, signal);
+      }
+
+      u8 const* byte = chunk.data.data() + chunk.offsets[signal];
+      u8 const* const data_end = chunk.data.data() + chunk.offsets[signal + 1];
+      i64 cycle = chunk.first_cycle;
+      while(byte != data_end) {
+        cycle += read_varint(byte);
+        add_change(cycle);
+      }
+    }
+
+    if(history.open && history.open_first_cycle < end) {
+      if(!initialised) {
+        value = get_bit(history.open_initial_values, signal);
+      }
+
+      Array<u32> cycles;
+      for(u32 event = history.open_last_events[signal]; event != no_event;
+          event = history.open_events[event].previous) {
+        cycles.push_back(history.open_events[event].cycle);
+      }
+      for(i64 i = cycles.size() - 1; i >= 0; --i) {
+        add_change(history.open_first_cycle + cycles[i]);
+      }
+    }
+    return value;
+  }
+} // namespace nebula
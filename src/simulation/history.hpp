@@ -0,0 +1,160 @@
+#pragma once
+
+#include <anton/expected.hpp>
+#include <anton/filesystem.hpp>
+#include <anton/flat_hash_map.hpp>
+#include <anton/slice.hpp>
+
+#include <core/error.hpp>
+#include <core/types.hpp>
+#include <model/gate.hpp>
+
+namespace nebula {
+  struct Scene;
+
+  /**
+   * @brief Parameters of a signal history.
+   */
+  struct History_Options {
+    // Maximum number of cycles covered by a chunk.
+    i64 chunk_cycles = 4096;
+    // Maximum number of changes within a chunk. Bounds the memory of the chunk
+    // that is being recorded.
+    i64 chunk_changes = 1 << 20;
+    // Maximum number of bytes of closed chunks kept in memory. Least recently
+    // used chunks are paged out to the page file.
+    i64 memory_budget = 64 << 20;
+    // File the chunks are paged out to. Overwritten by every history.
+    String page_path = String("nebula_history.bin");
+  };
+
+  /**
+   * @brief A recorded gate.
+   */
+  struct History_Signal {
+    u64 gate;
+    String name;
+  };
+
+  /**
+   * @brief A closed chunk of the history.
+   *
+   * The values of all signals at the start of the chunk are stored as a
+   * packed bitset. The changes of every signal are stored as the run lengths
+   * between consecutive changes encoded as LEB128 varints. The changes of a
+   * signal s occupy the bytes [offsets[s], offsets[s + 1]) of data, which is
+   * the index of the chunk.
+   */
+  struct History_Chunk {
+    i64 first_cycle;
+    i64 last_cycle;
+    Array<u64> initial_values;
+    Array<u32> offsets;
+    Array<u8> data;
+    // Offset of the chunk within the page file. -1 if the chunk has never
+    // been paged out.
+    i64 file_offset = -1;
+    // Size of the chunk in bytes.
+    i64 size = 0;
+    bool resident = true;
+    // Value of History::clock when the chunk was last used.
+    u64 last_use = 0;
+  };
+
+  /**
+   * @brief A change of the chunk that is being recorded.
+   */
+  struct History_Event {
+    // Cycle of the change relative to the first cycle of the chunk.
+    u32 cycle;
+    // Index of the previous event of the same signal or -1.
+    u32 previous;
+  };
+
+  /**
+   * @brief The recorded values of a set of gates over time.
+   *
+   * Cycles are recorded into an open chunk which is closed once it covers
+   * History_Options::chunk_cycles cycles or holds
+   * History_Options::chunk_changes changes. Closed chunks are compressed and
+   * paged out to disk when the memory budget is exceeded. Signals are
+   * identified by the identifiers of their gates, hence gates may be deleted
+   * while recording.
+   */
+  struct History {
+    History_Options options;
+    Array<History_Signal> signals;
+    // Maps the identifier of a gate to its signal.
+    Flat_Hash_Map<u64, i64> signal_indices;
+    // Last recorded values of the signals.
+    Array<u8> values;
+    // First and last recorded cycles. last_cycle is less than first_cycle
+    // while the history is empty.
+    i64 first_cycle = 0;
+    i64 last_cycle = -1;
+
+    Array<History_Chunk> chunks;
+    // The chunk being recorded.
+    i64 open_first_cycle = 0;
+    Array<u64> open_initial_values;
+    Array<History_Event> open_events;
+    // Index of the last event of every signal in open_events or -1.
+    Array<u32> open_last_events;
+    bool open = false;
+
+    // Number of bytes of the resident closed chunks.
+    i64 resident_size = 0;
+    // Number of bytes written to the page file.
+    i64 paged_size = 0;
+    u64 clock = 0;
+    fs::Output_File_Stream page_output;
+    fs::Input_File_Stream page_input;
+  };
+
+  /**
+   * @brief Clears a history and starts recording a set of gates.
+   *
+   * @param history The history to start.
+   * @param gates The gates to record.
+   * @param options The parameters of the history.
+   * @return An error message if the page file could not be opened.
+   */
+  [[nodiscard]] Expected<void, Error>
+  start_history(History& history, Slice<Gate* const> gates,
+                History_Options const& options);
+
+  /**
+   * @brief Clears a history and releases its memory.
+   */
+  void clear_history(History& history);
+
+  /**
+   * @brief Records the values of the gates after a cycle has been evaluated.
+   *
+   * Only the changed gates are compared.
+   *
+   * @param history The history to record into.
+   * @param scene The scene containing the gates.
+   * @param cycle The evaluated cycle. Must increase with every call.
+   * @param changed The gates reported as changed by evaluate.
+   */
+  void record_history(History& history, Scene& scene, i64 cycle,
+                      Slice<Gate* const> changed);
+
+  /**
+   * @brief Decodes the changes of a signal within a range of cycles.
+   *
+   * Decodes only the chunks overlapping the range, paging them in if
+   * necessary.
+   *
+   * @param history The history to query.
+   * @param signal The index of the signal.
+   * @param begin The first cycle of the range.
+   * @param end The cycle past the last cycle of the range.
+   * @param changes Receives the cycles within (begin, end) at which the value
+   * of the signal has changed in increasing order.
+   * @return The value of the signal at begin.
+   */
+  [[nodiscard]] bool query_history(History& history, i64 signal, i64 begin,
+                                   i64 end, Array<i64>& changes);
+} // namespace nebula
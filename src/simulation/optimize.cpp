@@ -0,0 +1,351 @@
+#include <simulation/optimize.hpp>
+
+#include <anton/flat_hash_map.hpp>
+
+#include <model/port.hpp>
+#include <ui/scene.hpp>
+
+namespace nebula {
+  // Pass that replaced a gate. Used to attribute the removed gates.
+  enum struct Replacement : u8 { e_folded, e_merged };
+
+  struct Optimizer {
+    Scene& scene;
+    // Driver of the constant 1 added on demand.
+    Gate* one = nullptr;
+    // Maps the address of a replaced gate to the pass that replaced it.
+    Flat_Hash_Map<u64, Replacement> replaced;
+    // Maps the hash of the structure of a gate to the first gate with that
+    // hash.
+    Flat_Hash_Map<u64, Gate*> structures;
+
+    explicit Optimizer(Scene& scene): scene(scene) {}
+  };
+
+  // Structure
+  //
+  // The kind and the drivers of a combinational gate. Gates with equal
+  // structures compute equal values.
+  //
+  struct Structure {
+    Gate_Kind kind;
+    u64 table;
+    Port const* drivers[lut_input_count];
+    i64 count;
+  };
+
+  [[nodiscard]] static u64 get_key(Gate const* const gate)
+  {
+    return reinterpret_cast<u64>(gate);
+  }
+
+  [[nodiscard]] static Port* get_driver(Port* const port)
+  {
+    if(port->connections.size() == 1) {
+      return *port->connections.begin();
+    } else {
+      return nullptr;
+    }
+  }
+
+  // get_constant_value
+  //
+  // Returns:
+  // The value of an input if it is constant, -1 otherwise. Unconnected
+  // inputs read 0.
+  //
+  [[nodiscard]] static i32 get_constant_value(Optimizer const& optimizer,
+                                              Port* const port)
+  {
+    Port const* const driver = get_driver(port);
+    if(driver == nullptr) {
+      return 0;
+    } else if(driver->gate == optimizer.one) {
+      return 1;
+    } else {
+      return -1;
+    }
+  }
+
+  [[nodiscard]] static Port* get_one(Optimizer& optimizer)
+  {
+    if(optimizer.one == nullptr) {
+      // Gates read unconnected inputs as 0, hence NAND drives 1. The
+      // constant is never drawn.
+      optimizer.one = &optimizer.scene.add_gate(
+        Vec2{1.0f, 1.0f}, Vec2{0.0f, 0.0f}, Gate_Kind::e_nand);
+    }
+    return optimizer.one->out_ports[0];
+  }
+
+  // get_combinational_readers
+  //
+  // Collect the inputs of combinational gates reading the output of a gate.
+  // Only those are replaced. Other gates read the previous values of their
+  // inputs, which in the first cycle are the initial values of the drivers
+  // rather than settled values, hence they keep their drivers.
+  //
+  static void get_combinational_readers(Gate const& gate,
+                                        Array<Port*>& readers)
+  {
+    for(Port* const reader: gate.out_ports[0]->connections) {
+      if(is_combinational(reader->gate->kind)) {
+        readers.push_back(reader);
+      }
+    }
+  }
+
+  // redirect_readers
+  //
+  // Connect the combinational gates reading the output of a gate to another
+  // driver.
+  //
+  static void redirect_readers(Optimizer& optimizer, Gate& gate,
+                               Port* const driver)
+  {
+    Array<Port*> readers;
+    get_combinational_readers(gate, readers);
+    for(Port* const reader: readers) {
+      optimizer.scene.connect_ports(reader, driver);
+    }
+  }
+
+  // replace_with_constant
+  //
+  // Connect the combinational gates reading the output of a gate to a
+  // constant. Unconnected inputs read 0, hence the readers of 0 are
+  // disconnected.
+  //
+  static void replace_with_constant(Optimizer& optimizer, Gate& gate,
+                                    bool const value)
+  {
+    Port* const output = gate.out_ports[0];
+    Array<Port*> readers;
+    get_combinational_readers(gate, readers);
+    for(Port* const reader: readers) {
+      if(value) {
+        optimizer.scene.connect_ports(reader, get_one(optimizer));
+      } else {
+        output->remove_connection(reader);
+        reader->remove_connection(output);
+      }
+    }
+  }
+
+  [[nodiscard]] static Structure get_structure(Gate const& gate)
+  {
+    Structure structure;
+    structure.kind = gate.kind;
+    structure.table = gate.kind == Gate_Kind::e_lut ? gate.table : 0;
+    structure.count = gate.in_ports.size();
+    for(i64 i = 0; i < structure.count; ++i) {
+      structure.drivers[i] = get_driver(gate.in_ports[i]);
+    }
+    // Gates with two inputs are commutative.
+    if(gate.kind != Gate_Kind::e_lut && structure.count == 2 &&
+       structure.drivers[0] > structure.drivers[1]) {
+      Port const* const driver = structure.drivers[0];
+      structure.drivers[0] = structure.drivers[1];
+      structure.drivers[1] = driver;
+    }
+    return structure;
+  }
+
+  [[nodiscard]] static u64 hash_structure(Structure const& structure)
+  {
+    u64 hash = 0xCBF29CE484222325;
+    auto mix = [&hash](u64 const value) {
+      hash = (hash ^ value) * 0x100000001B3;
+    };
+    mix(static_cast<u64>(structure.kind));
+    mix(structure.table);
+    for(i64 i = 0; i < structure.count; ++i) {
+      mix(reinterpret_cast<u64>(structure.drivers[i]));
+    }
+    return hash;
+  }
+
+  [[nodiscard]] static bool compare_structures(Structure const& lhs,
+                                               Structure const& rhs)
+  {
+    if(lhs.kind != rhs.kind || lhs.table != rhs.table ||
+       lhs.count != rhs.count) {
+      return false;
+    }
+
+    for(i64 i = 0; i < lhs.count; ++i) {
+      if(lhs.drivers[i] != rhs.drivers[i]) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // order_combinational
+  //
+  // Order the combinational gates topologically with Kahn's algorithm. Gates
+  // in or behind combinational loops never become ready and are left out.
+  //
+  static void order_combinational(Scene& scene, Array<Gate*>& order)
+  {
+    // Maps the address of a gate to the number of its combinational drivers
+    // that have not been ordered yet.
+    Flat_Hash_Map<u64, i64> pending;
+    for(Gate& gate: scene.gates) {
+      if(!is_combinational(gate.kind)) {
+        continue;
+      }
+
+      i64 count = 0;
+      for(Port* const port: gate.in_ports) {
+        Port const* const driver = get_driver(port);
+        if(driver != nullptr && is_combinational(driver->gate->kind)) {
+          count += 1;
+        }
+      }
+      if(count == 0) {
+        order.push_back(&gate);
+      } else {
+        pending.emplace(get_key(&gate), count);
+      }
+    }
+
+    for(i64 head = 0; head < order.size(); ++head) {
+      for(Port const* const reader: order[head]->out_ports[0]->connections) {
+        auto iter = pending.find(get_key(reader->gate));
+        if(iter == pending.end()) {
+          continue;
+        }
+
+        iter->value -= 1;
+        if(iter->value == 0) {
+          order.push_back(reader->gate);
+        }
+      }
+    }
+  }
+
+  // simplify_gate
+  //
+  // Fold a gate whose value is constant or equal to one of its inputs, or
+  // merge it with an earlier gate of the same structure. The drivers of the
+  // gate must have been simplified already.
+  //
+  static void simplify_gate(Optimizer& optimizer, Gate& gate)
+  {
+    // Combinations of the inputs that may occur given the constant inputs
+    // and the inputs reading the same driver.
+    u64 care = ~static_cast<u64>(0);
+    for(i64 i = 0; i < gate.in_ports.size(); ++i) {
+      i32 const constant = get_constant_value(optimizer, gate.in_ports[i]);
+      if(constant >= 0) {
+        care &= constant ? input_truth_tables[i] : ~input_truth_tables[i];
+        continue;
+      }
+
+      Port const* const driver = get_driver(gate.in_ports[i]);
+      for(i64 j = 0; j < i; ++j) {
+        if(get_driver(gate.in_ports[j]) == driver) {
+          care &= ~(input_truth_tables[i] ^ input_truth_tables[j]);
+        }
+      }
+    }
+
+    u64 const table = compose_truth_table(gate, input_truth_tables) & care;
+    if(table == 0 || table == care) {
+      replace_with_constant(optimizer, gate, table != 0);
+      optimizer.replaced.emplace(get_key(&gate), Replacement::e_folded);
+      return;
+    }
+
+    for(i64 i = 0; i < gate.in_ports.size(); ++i) {
+      Port* const driver = get_driver(gate.in_ports[i]);
+      if(driver != nullptr &&
+         ((input_truth_tables[i] & care) ^ table) == 0) {
+        redirect_readers(optimizer, gate, driver);
+        optimizer.replaced.emplace(get_key(&gate), Replacement::e_folded);
+        return;
+      }
+    }
+
+    Structure const structure = get_structure(gate);
+    u64 const hash = hash_structure(structure);
+    auto iter = optimizer.structures.find(hash);
+    if(iter == optimizer.structures.end()) {
+      optimizer.structures.emplace(hash, &gate);
+    } else if(compare_structures(structure, get_structure(*iter->value))) {
+      redirect_readers(optimizer, gate, iter->value->out_ports[0]);
+      optimizer.replaced.emplace(get_key(&gate), Replacement::e_merged);
+    }
+  }
+
+  Optimization_Statistics optimize_netlist(Scene& scene,
+                                           Slice<Gate* const> const observed)
+  {
+    Optimization_Statistics statistics;
+    statistics.gate_count = scene.gates.size();
+
+    // Gates are simplified in topological order, hence the replacements of
+    // the drivers of a gate are final when the gate is simplified.
+    Optimizer optimizer{scene};
+    Array<Gate*> order;
+    order_combinational(scene, order);
+    for(Gate* const gate: order) {
+      simplify_gate(optimizer, *gate);
+    }
+
+    // Mark the gates the observed gates depend on. Inputs and clocks are
+    // kept since the stimulus refers to them.
+    Flat_Hash_Map<u64, bool> live;
+    Array<Gate*> stack;
+    for(Gate* const gate: observed) {
+      live.emplace(get_key(gate), true);
+      stack.push_back(gate);
+    }
+    for(Gate& gate: scene.gates) {
+      if(gate.kind == Gate_Kind::e_input || gate.kind == Gate_Kind::e_clock) {
+        live.emplace(get_key(&gate), true);
+      }
+    }
+
+    while(stack.size() > 0) {
+      Gate* const gate = stack.back();
+      stack.pop_back();
+      for(Port* const port: gate->in_ports) {
+        Port const* const driver = get_driver(port);
+        if(driver == nullptr ||
+           live.find(get_key(driver->gate)) != live.end()) {
+          continue;
+        }
+
+        live.emplace(get_key(driver->gate), true);
+        stack.push_back(driver->gate);
+      }
+    }
+
+    Array<Gate*> removed;
+    for(Gate& gate: scene.gates) {
+      if(live.find(get_key(&gate)) != live.end()) {
+        continue;
+      }
+
+      removed.push_back(&gate);
+      if(&gate == optimizer.one) {
+        // The constant added by the passes is not counted.
+        continue;
+      }
+
+      auto iter = optimizer.replaced.find(get_key(&gate));
+      if(iter == optimizer.replaced.end()) {
+        statistics.dead += 1;
+      } else if(iter->value == Replacement::e_folded) {
+        statistics.folded += 1;
+      } else {
+        statistics.merged += 1;
+      }
+    }
+    scene.delete_gates(removed);
+    statistics.remaining = scene.gates.size();
+    return statistics;
+  }
+} // namespace nebula
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <anton/slice.hpp>
+
+#include <core/types.hpp>
+#include <model/gate.hpp>
+
+namespace nebula {
+  struct Scene;
+
+  /**
+   * @brief Counts of the gates removed by optimize_netlist.
+   */
+  struct Optimization_Statistics {
+    // Number of gates before the passes.
+    i64 gate_count = 0;
+    // Removed gates whose value was constant or equal to one of their
+    // inputs.
+    i64 folded = 0;
+    // Removed gates structurally identical to another gate.
+    i64 merged = 0;
+    // Removed gates that no observed gate depends on.
+    i64 dead = 0;
+    // Number of gates after the passes including the added constant drivers.
+    i64 remaining = 0;
+  };
+
+  /**
+   * @brief Simplifies a netlist for simulation.
+   *
+   * Runs constant propagation, structural hashing and dead gate elimination
+   * over the combinational gates. Constant propagation treats unconnected
+   * inputs as 0 like the two-valued evaluation and bypasses gates that pass
+   * one of their inputs through. Structural hashing merges gates of the same
+   * kind reading the same drivers. Dead gate elimination removes all gates
+   * except inputs and clocks that no observed gate depends on.
+   *
+   * The passes modify the scene in place, hence they are meant for a copy of
+   * the design that is only simulated, such as the design loaded by
+   * nebula-sim. The values of the observed gates are preserved under the
+   * two-valued levelized evaluation. Gates in or behind combinational loops
+   * are neither folded nor merged.
+   *
+   * @param scene The scene to optimize.
+   * @param observed The gates whose values are read after evaluation. They
+   * are never removed.
+   */
+  [[nodiscard]] Optimization_Statistics
+  optimize_netlist(Scene& scene, Slice<Gate* const> observed);
+} // namespace nebula
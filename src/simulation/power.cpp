@@ -0,0 +1,141 @@
+#include <simulation/power.hpp>
+
+#include <anton/algorithm/sort.hpp>
+#include <anton/flat_hash_map.hpp>
+#include <anton/math/math.hpp>
+
+#include <model/port.hpp>
+#include <ui/scene.hpp>
+
+namespace nebula {
+  f32 get_output_capacitance(Gate_Kind const kind)
+  {
+    // Roughly the relative sizes of static CMOS implementations.
+    switch(kind) {
+    case Gate_Kind::e_not:
+      return 1.0f;
+    case Gate_Kind::e_nand:
+    case Gate_Kind::e_nor:
+      return 1.5f;
+    case Gate_Kind::e_and:
+    case Gate_Kind::e_or:
+      return 2.0f;
+    case Gate_Kind::e_xor:
+    case Gate_Kind::e_xnor:
+    case Gate_Kind::e_lut:
+      return 3.0f;
+    case Gate_Kind::e_input:
+    case Gate_Kind::e_clock:
+      return 0.5f;
+    case Gate_Kind::e_sr_latch:
+      return 3.0f;
+    case Gate_Kind::e_dff:
+    case Gate_Kind::e_register:
+    case Gate_Kind::e_ram:
+    case Gate_Kind::e_rom:
+      return 4.0f;
+    default:
+      return 1.0f;
+    }
+  }
+
+  [[nodiscard]] static i64 get_fanout(Gate const& gate)
+  {
+    i64 fanout = 0;
+    for(Port const* const port: gate.out_ports) {
+      fanout += port->connections.size();
+    }
+    return fanout;
+  }
+
+  void estimate_power(Toggle_Counters const& toggles, Scene& scene,
+                      Power_Options const& options, Power_Estimate& estimate)
+  {
+    estimate.power.clear();
+    estimate.total = 0.0f;
+    estimate.maximum = 0.0f;
+    if(toggles.cycles == 0) {
+      estimate.power.resize(scene.gates.size(), 0.0f);
+      return;
+    }
+
+    // The slots of the counters follow the order of the gates unless the
+    // scene has changed since the last cycle.
+    bool const synced = toggles.gates.size() == scene.gates.size();
+    // Maps the identifiers of the gates to their slots. Built on the first
+    // gate that is out of order.
+    Flat_Hash_Map<u64, i64> slots;
+    bool slots_built = false;
+    f32 const cycles = static_cast<f32>(toggles.cycles);
+    i64 index = 0;
+    for(Gate const& gate: scene.gates) {
+      i64 slot = index;
+      index += 1;
+      if(!synced || toggles.gates[slot] != gate.id) {
+        if(!slots_built) {
+          slots_built = true;
+          for(i64 i = 0; i < toggles.gates.size(); ++i) {
+            slots.emplace(toggles.gates[i], i);
+          }
+        }
+
+        auto iter = slots.find(gate.id);
+        if(iter == slots.end()) {
+          estimate.power.push_back(0.0f);
+          continue;
+        }
+        slot = iter->value;
+      }
+
+      f32 const capacitance =
+        get_output_capacitance(gate.kind) +
+        options.input_capacitance * static_cast<f32>(get_fanout(gate));
+      f32 const transitions =
+        static_cast<f32>(toggles.rises[slot] + toggles.falls[slot]);
+      f32 const internal = static_cast<f32>(toggles.internal[slot]);
+      f32 const power = (capacitance * transitions +
+                         options.internal_capacitance * internal) /
+                        cycles;
+      estimate.power.push_back(power);
+      estimate.total += power;
+      estimate.maximum = math::max(estimate.maximum, power);
+    }
+  }
+
+  void summarize_module_power(Scene& scene, Power_Estimate const& estimate,
+                              Array<Module_Power>& modules)
+  {
+    modules.clear();
+    modules.push_back(Module_Power{nullptr, 0, 0.0f});
+    Flat_Hash_Map<u64, i64> indices;
+    i64 index = 0;
+    for(Gate const& gate: scene.gates) {
+      f32 const power =
+        index < estimate.power.size() ? estimate.power[index] : 0.0f;
+      index += 1;
+      if(gate.kind != Gate_Kind::e_module) {
+        modules[0].instances += 1;
+        modules[0].power += power;
+        continue;
+      }
+
+      u64 const key = reinterpret_cast<u64>(gate.definition);
+      auto iter = indices.find(key);
+      i64 module = 0;
+      if(iter != indices.end()) {
+        module = iter->value;
+      } else {
+        module = modules.size();
+        indices.emplace(key, module);
+        modules.push_back(Module_Power{gate.definition, 0, 0.0f});
+      }
+      modules[module].instances += 1;
+      modules[module].power += power;
+    }
+
+    anton::quick_sort(modules.begin() + 1, modules.end(),
+                      [](Module_Power const& lhs, Module_Power const& rhs) {
+                        return lhs.power > rhs.power;
+                      });
+  }
+} // namespace nebula
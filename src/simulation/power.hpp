@@ -0,0 +1,73 @@
+#pragma once
+
+#include <core/types.hpp>
+#include <evaluator/evaluator.hpp>
+#include <model/gate.hpp>
+#include <model/module.hpp>
+
+namespace nebula {
+  struct Scene;
+
+  /**
+   * @brief Relative capacitances of the switched nets.
+   *
+   * The units are arbitrary. The estimate is meant for comparing parts of a
+   * design rather than for absolute figures.
+   */
+  struct Power_Options {
+    // Capacitance of an input driven by a net, multiplied by the fanout.
+    f32 input_capacitance = 1.0f;
+    // Capacitance of a signal within a module instance.
+    f32 internal_capacitance = 2.0f;
+  };
+
+  /**
+   * @brief Dynamic power of the gates of a scene.
+   *
+   * The power of a gate is the capacitance of its net times the number of
+   * transitions of the net per cycle. The capacitance of a net is the
+   * intrinsic capacitance of the driving gate plus the input capacitance
+   * times the fanout.
+   */
+  struct Power_Estimate {
+    // Power of every gate in the order of the gates of the scene.
+    Array<f32> power;
+    f32 total = 0.0f;
+    f32 maximum = 0.0f;
+  };
+
+  /**
+   * @brief Power of the instances of a module definition.
+   *
+   * definition is nullptr for the primitive gates placed in the scene.
+   */
+  struct Module_Power {
+    Module_Definition const* definition;
+    i64 instances;
+    f32 power;
+  };
+
+  /**
+   * @brief Gets the intrinsic capacitance of the output of a gate.
+   */
+  [[nodiscard]] f32 get_output_capacitance(Gate_Kind kind);
+
+  /**
+   * @brief Estimates the power of the gates from their toggle counters.
+   *
+   * Gates without counters have no power.
+   */
+  void estimate_power(Toggle_Counters const& toggles, Scene& scene,
+                      Power_Options const& options, Power_Estimate& estimate);
+
+  /**
+   * @brief Sums the power of an estimate by module definition.
+   *
+   * @param scene The scene the estimate has been computed for.
+   * @param estimate The estimate.
+   * @param modules Receives the primitive gates followed by the definitions
+   * ordered by decreasing power.
+   */
+  void summarize_module_power(Scene& scene, Power_Estimate const& estimate,
+                              Array<Module_Power>& modules);
+} // namespace nebula
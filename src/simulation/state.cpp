@@ -0,0 +1,243 @@
+#include <simulation/state.hpp>
+
+#include <anton/math/math.hpp>
+
+#include <model/memory.hpp>
+#include <model/module.hpp>
+
+#include <string.h>
+
+namespace nebula {
+  // get_gate_state_size
+  //
+  // Number of bytes of Gate::state of a gate once it has been evaluated.
+  //
+  [[nodiscard]] static i64 get_gate_state_size(Gate const& gate)
+  {
+    if(gate.kind == Gate_Kind::e_module) {
+      Flat_Module const& flat = get_flat_module(*gate.definition);
+      return flat.input_count + flat.gates.size();
+    } else if(is_memory(gate.kind)) {
+      return get_memory_state_size(gate.kind, *gate.memory);
+    } else {
+      return get_state_size(gate);
+    }
+  }
+
+  i64 get_state_bit_count(Gate const& gate)
+  {
+    return 1 + get_gate_state_size(gate) + get_contents_bit_count(gate);
+  }
+
+  i64 get_contents_bit_count(Gate const& gate)
+  {
+    if(gate.kind == Gate_Kind::e_ram) {
+      return gate.memory->contents.size() * 8;
+    } else {
+      return 0;
+    }
+  }
+
+  Array<u8> const& get_state_contents(Gate const& gate)
+  {
+    // Instances that have not been evaluated yet hold the contents of their
+    // definition.
+    if(gate.contents.size() > 0) {
+      return gate.contents;
+    } else {
+      return gate.memory->contents;
+    }
+  }
+
+  bool get_state_bit(Gate const& gate, i64 const bit)
+  {
+    if(bit == 0) {
+      return gate.evaluation.value;
+    }
+
+    i64 const size = get_gate_state_size(gate);
+    if(bit - 1 < size) {
+      return bit - 1 < gate.state.size() && (gate.state[bit - 1] & 1);
+    }
+
+    i64 const index = bit - 1 - size;
+    Array<u8> const& contents = get_state_contents(gate);
+    return (contents[index / 8] >> (index % 8)) & 1;
+  }
+
+  bool is_state_bit_unknown(Gate const& gate, i64 const bit)
+  {
+    if(bit == 0) {
+      return gate.evaluation.unknown;
+    }
+
+    // Bit 2 of a state byte marks the current value unknown.
+    i64 const size = get_gate_state_size(gate);
+    return bit - 1 < size && bit - 1 < gate.state.size() &&
+           (gate.state[bit - 1] & 4);
+  }
+
+  void set_state_bit(Gate& gate, i64 const bit, bool const value,
+                     bool const unknown)
+  {
+    if(bit == 0) {
+      gate.evaluation.value = value;
+      gate.evaluation.prev_value = value;
+      gate.evaluation.unknown = unknown;
+      gate.evaluation.prev_unknown = unknown;
+      return;
+    }
+
+    i64 const size = get_gate_state_size(gate);
+    if(bit - 1 < size) {
+      if(gate.state.size() == 0) {
+        gate.state.resize(size, 0);
+      }
+      gate.state[bit - 1] = (value ? 3 : 0) | (unknown ? 12 : 0);
+      return;
+    }
+
+    if(gate.contents.size() == 0) {
+      gate.contents = gate.memory->contents;
+    }
+    i64 const index = bit - 1 - size;
+    u8 const mask = static_cast<u8>(1 << (index % 8));
+    if(value) {
+      gate.contents[index / 8] |= mask;
+    } else {
+      gate.contents[index / 8] &= ~mask;
+    }
+  }
+
+  // write_bits
+  //
+  // Set count bits of a bitset starting at first from the low bits of a word.
+  // The bits must be clear and count at most 64.
+  //
+  static void write_bits(u64* const bits, i64 const first, u64 const value,
+                         i64 const count)
+  {
+    i64 const shift = first & 63;
+    bits[first >> 6] |= value << shift;
+    if(shift + count > 64) {
+      bits[(first >> 6) + 1] |= value >> (64 - shift);
+    }
+  }
+
+  // read_bits
+  //
+  // Read count bits of a bitset starting at first into the low bits of a word.
+  // count is at most 64.
+  //
+  [[nodiscard]] static u64 read_bits(u64 const* const bits, i64 const first,
+                                     i64 const count)
+  {
+    i64 const shift = first & 63;
+    u64 value = bits[first >> 6] >> shift;
+    if(shift + count > 64) {
+      value |= bits[(first >> 6) + 1] << (64 - shift);
+    }
+    if(count < 64) {
+      value &= (static_cast<u64>(1) << count) - 1;
+    }
+    return value;
+  }
+
+  // pack_bytes
+  //
+  // Gather bit 0 of every byte of a word into the low 8 bits. The product
+  // moves bit 0 of byte i to bit 56 + i without any carries.
+  //
+  [[nodiscard]] static u64 pack_bytes(u64 const bytes)
+  {
+    return ((bytes & 0x0101010101010101) * 0x0102040810204080) >> 56;
+  }
+
+  // unpack_bytes
+  //
+  // Spread the low 8 bits of a word into bit 0 of every byte, the inverse of
+  // pack_bytes. Bit i is selected in byte i and carried into bit 7 of the
+  // byte by the addition if set.
+  //
+  [[nodiscard]] static u64 unpack_bytes(u64 const bits)
+  {
+    u64 const selected =
+      ((bits & 0xFF) * 0x0101010101010101) & 0x8040201008040201;
+    return ((selected + 0x7F7F7F7F7F7F7F7F) >> 7) & 0x0101010101010101;
+  }
+
+  void save_state(Gate const& gate, u64* const values, u64* const unknown,
+                  i64 const first_bit)
+  {
+    write_bits(values, first_bit, gate.evaluation.value, 1);
+    if(unknown != nullptr) {
+      write_bits(unknown, first_bit, gate.evaluation.unknown, 1);
+    }
+
+    // Gates that have not been evaluated yet have no state, which is all
+    // clear.
+    i64 const size = get_gate_state_size(gate);
+    for(i64 i = 0; i < gate.state.size(); i += 8) {
+      i64 const count = math::min(gate.state.size() - i, static_cast<i64>(8));
+      u64 bytes = 0;
+      memcpy(&bytes, gate.state.data() + i, count);
+      write_bits(values, first_bit + 1 + i, pack_bytes(bytes), count);
+      if(unknown != nullptr) {
+        // Bit 2 of a state byte marks the current value unknown.
+        write_bits(unknown, first_bit + 1 + i, pack_bytes(bytes >> 2), count);
+      }
+    }
+
+    if(get_contents_bit_count(gate) > 0) {
+      Array<u8> const& contents = get_state_contents(gate);
+      i64 const first = first_bit + 1 + size;
+      for(i64 i = 0; i < contents.size(); i += 8) {
+        i64 const count = math::min(contents.size() - i, static_cast<i64>(8));
+        u64 word = 0;
+        memcpy(&word, contents.data() + i, count);
+        write_bits(values, first + i * 8, word, count * 8);
+      }
+    }
+  }
+
+  void restore_state(Gate& gate, u64 const* const values,
+                     u64 const* const unknown, i64 const first_bit)
+  {
+    bool const value = read_bits(values, first_bit, 1);
+    bool const value_unknown =
+      unknown != nullptr && read_bits(unknown, first_bit, 1);
+    gate.evaluation.value = value;
+    gate.evaluation.prev_value = value;
+    gate.evaluation.unknown = value_unknown;
+    gate.evaluation.prev_unknown = value_unknown;
+
+    i64 const size = get_gate_state_size(gate);
+    if(size > 0 && gate.state.size() == 0) {
+      gate.state.resize(size, 0);
+    }
+    for(i64 i = 0; i < size; i += 8) {
+      i64 const count = math::min(size - i, static_cast<i64>(8));
+      u64 const set = unpack_bytes(read_bits(values, first_bit + 1 + i, count));
+      u64 const unset =
+        unknown != nullptr
+          ? unpack_bytes(read_bits(unknown, first_bit + 1 + i, count))
+          : 0;
+      // Both the current and the previous value, as in set_state_bit.
+      u64 const bytes = (set * 3) | (unset * 12);
+      memcpy(gate.state.data() + i, &bytes, count);
+    }
+
+    if(get_contents_bit_count(gate) > 0) {
+      if(gate.contents.size() == 0) {
+        gate.contents = gate.memory->contents;
+      }
+      i64 const first = first_bit + 1 + size;
+      for(i64 i = 0; i < gate.contents.size(); i += 8) {
+        i64 const count =
+          math::min(gate.contents.size() - i, static_cast<i64>(8));
+        u64 const word = read_bits(values, first + i * 8, count * 8);
+        memcpy(gate.contents.data() + i, &word, count);
+      }
+    }
+  }
+} // namespace nebula
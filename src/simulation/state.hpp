@@ -0,0 +1,79 @@
+#pragma once
+
+#include <core/types.hpp>
+#include <model/gate.hpp>
+
+namespace nebula {
+  /**
+   * @brief Gets the number of bits of the simulation state of a gate.
+   *
+   * Bit 0 of the state is the value of the gate. Module instances,
+   * sequential gates and memories follow with one bit per byte of
+   * Gate::state, which is the current value of the corresponding signal. RAM
+   * instances end with the bits of their contents. The count does not depend
+   * on whether the gate has been evaluated yet.
+   */
+  [[nodiscard]] i64 get_state_bit_count(Gate const& gate);
+
+  /**
+   * @brief Gets the number of bits at the end of the simulation state of a
+   * gate that are the contents of a RAM instance.
+   */
+  [[nodiscard]] i64 get_contents_bit_count(Gate const& gate);
+
+  /**
+   * @brief Gets the contents of a RAM instance as they appear in its
+   * simulation state.
+   */
+  [[nodiscard]] Array<u8> const& get_state_contents(Gate const& gate);
+
+  /**
+   * @brief Gets a bit of the simulation state of a gate.
+   */
+  [[nodiscard]] bool get_state_bit(Gate const& gate, i64 bit);
+
+  /**
+   * @brief Checks whether a bit of the simulation state of a gate is unknown
+   * (X) in the four-valued logic.
+   *
+   * The contents of RAM instances are always known.
+   */
+  [[nodiscard]] bool is_state_bit_unknown(Gate const& gate, i64 bit);
+
+  /**
+   * @brief Sets a bit of the simulation state of a gate.
+   *
+   * Sets both the current and the previous value, which the evaluator makes
+   * equal at the start of every cycle anyway. Allocates the state and the
+   * contents of gates that have not been evaluated yet.
+   *
+   * @param unknown Whether the bit becomes unknown. Ignored for the contents
+   * of RAM instances.
+   */
+  void set_state_bit(Gate& gate, i64 bit, bool value, bool unknown = false);
+
+  /**
+   * @brief Writes the simulation state of a gate into bitsets.
+   *
+   * The state is written a word at a time. The bits the state is written to
+   * must be clear.
+   *
+   * @param values The bitset receiving the values of the bits.
+   * @param unknown The bitset receiving the unknown flags of the bits. May be
+   * nullptr.
+   * @param first_bit The bit of the bitsets the state starts at.
+   */
+  void save_state(Gate const& gate, u64* values, u64* unknown, i64 first_bit);
+
+  /**
+   * @brief Reads the simulation state of a gate from bitsets written by
+   * save_state.
+   *
+   * Equivalent to setting every bit of the state with set_state_bit.
+   *
+   * @param unknown The unknown flags of the bits. May be nullptr, in which
+   * case the state becomes known.
+   */
+  void restore_state(Gate& gate, u64 const* values, u64 const* unknown,
+                     i64 first_bit);
+} // namespace nebula
@@ -0,0 +1,407 @@
+#include <simulation/stimulus.hpp>
+
+#include <anton/flat_hash_map.hpp>
+#include <anton/format.hpp>
+#include <anton/math/math.hpp>
+
+#include <evaluator/batch.hpp>
+#include <importer/builder.hpp>
+#include <ui/scene.hpp>
+
+namespace nebula {
+  [[nodiscard]] static Expected<i64, Error> parse_cycle(String_View const text)
+  {
+    i64 value = 0;
+    char const* const end = text.data() + text.size_bytes();
+    for(char const* i = text.data(); i != end; ++i) {
+      if(*i < '0' || *i > '9') {
+        return {expected_error, format("'{}' is not a cycle"_sv, text)};
+      }
+      value = value * 10 + (*i - '0');
+    }
+    return {expected_value, value};
+  }
+
+  [[nodiscard]] static Expected<void, Error>
+  parse_event(Flat_Hash_Map<String, Gate*> const& inputs,
+              Slice<String_View const> const tokens, Stimulus& stimulus)
+  {
+    if(tokens.size() != 3) {
+      return {expected_error, Error("expected '<cycle> <net> <value>'")};
+    }
+
+    Expected<i64, Error> cycle = parse_cycle(tokens[0]);
+    if(!cycle) {
+      return {expected_error, ANTON_MOV(cycle.error())};
+    }
+
+    if(stimulus.events.size() > 0 &&
+       stimulus.events.back().cycle > cycle.value()) {
+      return {expected_error, Error("cycles must not decrease")};
+    }
+
+    auto iter = inputs.find(String(tokens[1]));
+    if(iter == inputs.end()) {
+      return {expected_error,
+              format("'{}' is not driven by an input"_sv, tokens[1])};
+    }
+
+    String_View const value = tokens[2];
+    if(value != "0"_sv && value != "1"_sv) {
+      return {expected_error, format("'{}' is not a bit"_sv, value)};
+    }
+
+    stimulus.events.push_back(
+      Stimulus_Event{cycle.value(), iter->value, value == "1"_sv});
+    return expected_value;
+  }
+
+  Expected<Stimulus, Error> load_stimulus(Scene& scene,
+                                          String_View const path)
+  {
+    Line_Reader reader{String(path)};
+    if(!reader.is_open()) {
+      return {expected_error, format("could not open '{}'"_sv, path)};
+    }
+
+    Flat_Hash_Map<String, Gate*> inputs;
+    for(Gate& gate: scene.gates) {
+      if(gate.kind == Gate_Kind::e_input && gate.name.size_bytes() > 0) {
+        inputs.emplace(gate.name, &gate);
+      }
+    }
+
+    Stimulus stimulus;
+    Array<String_View> tokens;
+    String_View line;
+    while(reader.next_line(line)) {
+      split_whitespace(line, tokens);
+      if(tokens.size() == 0 || tokens[0].data()[0] == '#') {
+        continue;
+      }
+
+      Expected<void, Error> result = parse_event(inputs, tokens, stimulus);
+      if(!result) {
+        return {expected_error, format("{}:{}: {}"_sv, path,
+                                       reader.get_line_number(),
+                                       result.error())};
+      }
+    }
+    return {expected_value, ANTON_MOV(stimulus)};
+  }
+
+  void apply_stimulus(Stimulus& stimulus, i64 const cycle)
+  {
+    while(stimulus.next < stimulus.events.size()) {
+      Stimulus_Event const& event = stimulus.events[stimulus.next];
+      if(event.cycle > cycle) {
+        break;
+      }
+
+      event.gate->evaluation.value = event.value;
+      stimulus.next += 1;
+    }
+  }
+
+  [[nodiscard]] static u64 get_gray_code(u64 const value)
+  {
+    return value ^ (value >> 1);
+  }
+
+  // get_random_word
+  //
+  // Values of an input in the batch_width vectors of a block. Words are
+  // hashed from the seed and their position with the SplitMix64 finalizer,
+  // hence any vector is computed without the preceding ones.
+  //
+  [[nodiscard]] static u64 get_random_word(Test_Vectors const& vectors,
+                                           i64 const block, i64 const input)
+  {
+    u64 const position = block * vectors.inputs.size() + input + 1;
+    u64 x = vectors.seed + position * 0x9E3779B97F4A7C15;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EB;
+    return x ^ (x >> 31);
+  }
+
+  Expected<Test_Vectors, Error>
+  make_exhaustive_vectors(Slice<Gate* const> const inputs)
+  {
+    if(inputs.size() > exhaustive_input_limit) {
+      return {expected_error,
+              format("{} inputs are too many to enumerate, at most {} are "
+                     "supported"_sv,
+                     inputs.size(), exhaustive_input_limit)};
+    }
+
+    Test_Vectors vectors;
+    vectors.order = Vector_Order::e_exhaustive;
+    for(Gate* const gate: inputs) {
+      vectors.inputs.push_back(gate);
+    }
+    vectors.count = static_cast<i64>(1) << inputs.size();
+    return {expected_value, ANTON_MOV(vectors)};
+  }
+
+  Test_Vectors make_random_vectors(Slice<Gate* const> const inputs,
+                                   i64 const count, u64 const seed)
+  {
+    Test_Vectors vectors;
+    vectors.order = Vector_Order::e_random;
+    for(Gate* const gate: inputs) {
+      vectors.inputs.push_back(gate);
+    }
+    vectors.count = count;
+    vectors.seed = seed;
+    return vectors;
+  }
+
+  // split_fields
+  //
+  // Split a line of a vector file at commas and whitespace.
+  //
+  static void split_fields(String_View const line, Array<String_View>& fields)
+  {
+    fields.clear();
+    char const* begin = line.data();
+    char const* const end = line.data() + line.size_bytes();
+    for(char const* i = begin;; ++i) {
+      bool const separator =
+        i == end || *i == ',' || *i == ' ' || *i == '\t' || *i == '\r';
+      if(!separator) {
+        continue;
+      }
+
+      if(i != begin) {
+        fields.push_back(String_View{begin, i});
+      }
+      if(i == end) {
+        break;
+      }
+      begin = i + 1;
+    }
+  }
+
+  // Column
+  //
+  // The input or the output whose values a column of a vector file holds.
+  //
+  struct Column {
+    i64 input;
+    i64 output;
+  };
+
+  [[nodiscard]] static Expected<void, Error>
+  parse_header(Flat_Hash_Map<String, Gate*> const& gates,
+               Slice<String_View const> const fields, Array<Column>& columns,
+               Test_Vectors& vectors)
+  {
+    for(String_View const field: fields) {
+      auto iter = gates.find(String(field));
+      if(iter == gates.end()) {
+        return {expected_error, format("no net named '{}'"_sv, field)};
+      }
+
+      Gate* const gate = iter->value;
+      if(gate->kind == Gate_Kind::e_input) {
+        columns.push_back(Column{vectors.inputs.size(), -1});
+        vectors.inputs.push_back(gate);
+      } else {
+        columns.push_back(Column{-1, vectors.outputs.size()});
+        vectors.outputs.push_back(gate);
+      }
+    }
+    return expected_value;
+  }
+
+  [[nodiscard]] static Expected<void, Error>
+  parse_vector(Slice<Column const> const columns,
+               Slice<String_View const> const fields, Test_Vectors& vectors)
+  {
+    if(fields.size() != columns.size()) {
+      return {expected_error, format("expected {} values, found {}"_sv,
+                                     columns.size(), fields.size())};
+    }
+
+    i64 const first_value = vectors.values.size();
+    i64 const first_expected = vectors.expected.size();
+    vectors.values.resize(first_value + vectors.inputs.size());
+    vectors.expected.resize(first_expected + vectors.outputs.size());
+    for(i64 i = 0; i < columns.size(); ++i) {
+      String_View const field = fields[i];
+      Column const column = columns[i];
+      if(field == "0"_sv || field == "1"_sv) {
+        u8 const value = field == "1"_sv;
+        if(column.input >= 0) {
+          vectors.values[first_value + column.input] = value;
+        } else {
+          vectors.expected[first_expected + column.output] = value;
+        }
+      } else if(column.output >= 0 && (field == "x"_sv || field == "-"_sv)) {
+        vectors.expected[first_expected + column.output] = 2;
+      } else {
+        return {expected_error, format("'{}' is not a bit"_sv, field)};
+      }
+    }
+    vectors.count += 1;
+    return expected_value;
+  }
+
+  Expected<Test_Vectors, Error> load_vectors(Scene& scene,
+                                             String_View const path)
+  {
+    Line_Reader reader{String(path)};
+    if(!reader.is_open()) {
+      return {expected_error, format("could not open '{}'"_sv, path)};
+    }
+
+    Flat_Hash_Map<String, Gate*> gates;
+    for(Gate& gate: scene.gates) {
+      if(gate.name.size_bytes() > 0) {
+        gates.emplace(gate.name, &gate);
+      }
+    }
+
+    Test_Vectors vectors;
+    vectors.order = Vector_Order::e_file;
+    Array<Column> columns;
+    Array<String_View> fields;
+    String_View line;
+    while(reader.next_line(line)) {
+      split_fields(line, fields);
+      if(fields.size() == 0 || fields[0].data()[0] == '#') {
+        continue;
+      }
+
+      Expected<void, Error> result =
+        columns.size() == 0 ? parse_header(gates, fields, columns, vectors)
+                            : parse_vector(columns, fields, vectors);
+      if(!result) {
+        return {expected_error, format("{}:{}: {}"_sv, path,
+                                       reader.get_line_number(),
+                                       result.error())};
+      }
+    }
+    return {expected_value, ANTON_MOV(vectors)};
+  }
+
+  bool get_vector_value(Test_Vectors const& vectors, i64 const vector,
+                        i64 const input)
+  {
+    switch(vectors.order) {
+    case Vector_Order::e_exhaustive:
+      return (get_gray_code(vector) >> input) & 1;
+    case Vector_Order::e_random: {
+      u64 const word =
+        get_random_word(vectors, vector / batch_width, input);
+      return (word >> (vector % batch_width)) & 1;
+    }
+    case Vector_Order::e_file:
+      return vectors.values[vector * vectors.inputs.size() + input];
+    }
+    return false;
+  }
+
+  void apply_vector(Test_Vectors const& vectors, i64 const vector)
+  {
+    for(i64 i = 0; i < vectors.inputs.size(); ++i) {
+      vectors.inputs[i]->evaluation.value =
+        get_vector_value(vectors, vector, i);
+    }
+  }
+
+  void check_vector(Test_Vectors const& vectors, i64 const vector,
+                    Vector_Check& check)
+  {
+    i64 const count = vectors.outputs.size();
+    bool mismatch = false;
+    for(i64 i = 0; i < count; ++i) {
+      u8 const expected = vectors.expected[vector * count + i];
+      Gate* const output = vectors.outputs[i];
+      if(expected == 2 || (output->evaluation.value == expected &&
+                           !output->evaluation.unknown)) {
+        continue;
+      }
+
+      if(!mismatch && check.first_vector < 0) {
+        check.first_vector = vector;
+        check.first_output = output;
+        check.first_expected = expected;
+      }
+      mismatch = true;
+    }
+    check.vectors += 1;
+    check.mismatches += mismatch;
+  }
+
+  void fill_batch_inputs(Test_Vectors const& vectors,
+                         Batch_Program const& program, i64 const first,
+                         Slice<u64> const slots)
+  {
+    for(i64 i = 0; i < vectors.inputs.size(); ++i) {
+      u64 word = 0;
+      if(vectors.order == Vector_Order::e_random) {
+        word = get_random_word(vectors, first / batch_width, i);
+      } else if(vectors.order == Vector_Order::e_exhaustive && i >= 6) {
+        // Bit i of a Gray code is bit i xor bit i + 1 of the number, which
+        // above the bits indexing the vectors of a batch are constant.
+        word = (get_gray_code(first) >> i) & 1 ? ~static_cast<u64>(0) : 0;
+      } else {
+        i64 const count = math::min(batch_width, vectors.count - first);
+        for(i64 bit = 0; bit < count; ++bit) {
+          u64 const value = get_vector_value(vectors, first + bit, i);
+          word |= value << bit;
+        }
+      }
+      slots[program.input_slots[i]] = word;
+    }
+  }
+
+  void check_batch(Test_Vectors const& vectors, Batch_Program const& program,
+                   i64 const first, Slice<u64 const> const slots,
+                   Slice<u64 const> const unknowns, Vector_Check& check)
+  {
+    i64 const size = math::min(batch_width, vectors.count - first);
+    i64 const count = vectors.outputs.size();
+    // Bits of the vectors with a mismatch.
+    u64 mismatched = 0;
+    i64 first_bit = batch_width;
+    i64 first_output = -1;
+    for(i64 i = 0; i < count; ++i) {
+      u64 expected = 0;
+      u64 care = 0;
+      for(i64 bit = 0; bit < size; ++bit) {
+        u8 const value = vectors.expected[(first + bit) * count + i];
+        if(value != 2) {
+          care |= static_cast<u64>(1) << bit;
+          expected |= static_cast<u64>(value) << bit;
+        }
+      }
+
+      u32 const slot = get_batch_slot(program, vectors.outputs[i]);
+      u64 const unknown = unknowns.size() > 0 ? unknowns[slot] : 0;
+      u64 const difference = ((slots[slot] ^ expected) | unknown) & care;
+      for(i64 bit = 0; bit < first_bit; ++bit) {
+        if((difference >> bit) & 1) {
+          first_bit = bit;
+          first_output = i;
+        }
+      }
+      mismatched |= difference;
+    }
+
+    if(first_output >= 0 && check.first_vector < 0) {
+      Gate* const output = vectors.outputs[first_output];
+      check.first_vector = first + first_bit;
+      check.first_output = output;
+      check.first_expected =
+        vectors.expected[(first + first_bit) * count + first_output];
+    }
+
+    check.vectors += size;
+    while(mismatched != 0) {
+      mismatched &= mismatched - 1;
+      check.mismatches += 1;
+    }
+  }
+} // namespace nebula
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <anton/expected.hpp>
+#include <anton/slice.hpp>
+#include <anton/string_view.hpp>
+
+#include <core/error.hpp>
+#include <core/types.hpp>
+#include <model/gate.hpp>
+
+namespace nebula {
+  struct Batch_Program;
+  struct Scene;
+
+  /**
+   * @brief A value assigned to an input gate at the start of a cycle.
+   */
+  struct Stimulus_Event {
+    i64 cycle;
+    Gate* gate;
+    bool value;
+  };
+
+  /**
+   * @brief A sequence of input assignments ordered by cycle.
+   */
+  struct Stimulus {
+    Array<Stimulus_Event> events;
+    // Index of the first event that has not been applied yet.
+    i64 next = 0;
+  };
+
+  /**
+   * @brief Loads a stimulus file.
+   *
+   * Every line of the file has the form
+   *
+   *   <cycle> <net> <0|1>
+   *
+   * and assigns the value to the input gate driving the net at the start of
+   * the cycle. The cycles must not decrease. Empty lines and lines starting
+   * with # are ignored.
+   *
+   * @param scene The scene containing the input gates.
+   * @param path The path to the stimulus file.
+   * @return The stimulus on success, otherwise an error message that contains
+   * the offending line.
+   */
+  [[nodiscard]] Expected<Stimulus, Error> load_stimulus(Scene& scene,
+                                                        String_View path);
+
+  /**
+   * @brief Applies all events scheduled up to and including a cycle.
+   *
+   * @param stimulus The stimulus to apply.
+   * @param cycle The cycle that is about to be evaluated.
+   */
+  void apply_stimulus(Stimulus& stimulus, i64 cycle);
+
+  enum struct Vector_Order {
+    // All combinations of the inputs in Gray code order, hence consecutive
+    // vectors differ in a single input.
+    e_exhaustive,
+    // Vectors drawn from a seeded generator. Any vector may be computed
+    // without the preceding ones.
+    e_random,
+    // Vectors read from a file.
+    e_file,
+  };
+
+  /**
+   * @brief A sequence of values of a set of input gates and optionally the
+   * values of outputs expected for them.
+   */
+  struct Test_Vectors {
+    Vector_Order order = Vector_Order::e_exhaustive;
+    Array<Gate*> inputs;
+    Array<Gate*> outputs;
+    i64 count = 0;
+    u64 seed = 0;
+    // Values of the inputs of vector files, inputs.size() per vector.
+    Array<u8> values;
+    // Expected values of the outputs, outputs.size() per vector. 2 accepts
+    // any value.
+    Array<u8> expected;
+  };
+
+  /**
+   * @brief Outcome of comparing the outputs with the expected values.
+   */
+  struct Vector_Check {
+    i64 vectors = 0;
+    // Number of vectors with at least one output differing from the
+    // expected value.
+    i64 mismatches = 0;
+    // The first output that differed and the vector it differed for.
+    i64 first_vector = -1;
+    Gate* first_output = nullptr;
+    bool first_expected = false;
+  };
+
+  /**
+   * @brief Maximum number of inputs of exhaustive vectors.
+   */
+  constexpr i64 exhaustive_input_limit = 40;
+
+  /**
+   * @brief Creates all 2^n combinations of n inputs.
+   *
+   * Vector i assigns the bits of the Gray code of i to the inputs with the
+   * first input as the least significant bit.
+   *
+   * @return The vectors or an error if there are more than
+   * exhaustive_input_limit inputs.
+   */
+  [[nodiscard]] Expected<Test_Vectors, Error>
+  make_exhaustive_vectors(Slice<Gate* const> inputs);
+
+  /**
+   * @brief Creates uniformly random vectors.
+   *
+   * @param count The number of vectors.
+   * @param seed The seed. Equal seeds give equal vectors.
+   */
+  [[nodiscard]] Test_Vectors make_random_vectors(Slice<Gate* const> inputs,
+                                                 i64 count, u64 seed);
+
+  /**
+   * @brief Loads a vector file.
+   *
+   * The first line names the columns, the following lines hold one vector
+   * each. Columns are separated by commas or whitespace. A column named
+   * after an input gate holds its values, a column named after any other
+   * gate holds the expected values of its output. Values are 0 or 1,
+   * expected values may also be x or - to accept any value. Empty lines and
+   * lines starting with # are ignored.
+   *
+   * @param scene The scene containing the gates.
+   * @param path The path to the vector file.
+   * @return The vectors on success, otherwise an error message that contains
+   * the offending line.
+   */
+  [[nodiscard]] Expected<Test_Vectors, Error> load_vectors(Scene& scene,
+                                                           String_View path);
+
+  /**
+   * @brief Gets the value of an input in a vector.
+   *
+   * @param vector The index of the vector. Must be less than count.
+   * @param input The index of the input in Test_Vectors::inputs.
+   */
+  [[nodiscard]] bool get_vector_value(Test_Vectors const& vectors,
+                                      i64 vector, i64 input);
+
+  /**
+   * @brief Assigns the values of a vector to the input gates.
+   */
+  void apply_vector(Test_Vectors const& vectors, i64 vector);
+
+  /**
+   * @brief Compares the current values of the outputs with the values
+   * expected for a vector. Unknown values never match.
+   */
+  void check_vector(Test_Vectors const& vectors, i64 vector,
+                    Vector_Check& check);
+
+  /**
+   * @brief Fills the input slots of a batch program with batch_width
+   * consecutive vectors.
+   *
+   * @param program A program compiled with Test_Vectors::inputs as its
+   * inputs.
+   * @param first The index of the first vector. Must be a multiple of
+   * batch_width. Vectors past the last one hold unspecified values.
+   */
+  void fill_batch_inputs(Test_Vectors const& vectors,
+                         Batch_Program const& program, i64 first,
+                         Slice<u64> slots);
+
+  /**
+   * @brief Compares the outputs of a batch evaluation with the expected
+   * values of batch_width consecutive vectors.
+   *
+   * @param first The index of the first vector of the batch.
+   * @param unknowns The unknown planes of a four-valued evaluation, whose
+   * unknown bits never match, or empty.
+   */
+  void check_batch(Test_Vectors const& vectors, Batch_Program const& program,
+                   i64 first, Slice<u64 const> slots,
+                   Slice<u64 const> unknowns, Vector_Check& check);
+} // namespace nebula
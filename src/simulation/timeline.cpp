@@ -0,0 +1,339 @@
+#include <simulation/timeline.hpp>
+
+#include <anton/math/math.hpp>
+
+#include <simulation/state.hpp>
+#include <ui/scene.hpp>
+
+namespace nebula {
+  [[nodiscard]] static bool get_bit(Array<u64> const& bits, i64 const index)
+  {
+    return (bits[index >> 6] >> (index & 63)) & 1;
+  }
+
+  static void toggle_bit(Array<u64>& bits, i64 const index)
+  {
+    bits[index >> 6] ^= static_cast<u64>(1) << (index & 63);
+  }
+
+  [[nodiscard]] static bool has_state(Gate const& gate)
+  {
+    return gate.kind == Gate_Kind::e_module || is_memory(gate.kind) ||
+           get_state_size(gate) > 0;
+  }
+
+  [[nodiscard]] static i64 get_segment_size(Timeline_Segment const& segment)
+  {
+    return (segment.snapshot.size() * sizeof(u64)) +
+           (segment.toggles.size() + segment.offsets.size()) * sizeof(u32);
+  }
+
+  // capture_gates
+  //
+  // Assign the bits of the state to the gates of the scene and capture their
+  // state as the first snapshot.
+  //
+  static void capture_gates(Timeline& timeline, Scene& scene)
+  {
+    u32 bit_count = 0;
+    for(Gate& gate: scene.gates) {
+      u32 const index = timeline.gates.size();
+      u32 const count = get_state_bit_count(gate);
+      i64 const contents_bits = get_contents_bit_count(gate);
+      if(contents_bits > 0) {
+        // The contents of RAM instances occupy whole words of the state,
+        // which compare_contents compares at once.
+        u32 const contents_bit = bit_count + count - contents_bits;
+        bit_count += (64 - contents_bit % 64) % 64;
+      }
+      timeline.gates.push_back(Timeline_Gate{gate.id, bit_count, count});
+      timeline.gate_indices.emplace(gate.id, index);
+      if(has_state(gate)) {
+        timeline.stateful.push_back(index);
+      }
+      bit_count += count;
+      if(contents_bits > 0) {
+        bit_count += (64 - bit_count % 64) % 64;
+      }
+    }
+
+    timeline.state.resize((bit_count + 63) / 64, 0);
+    i64 index = 0;
+    for(Gate const& gate: scene.gates) {
+      save_state(gate, timeline.state.data(), nullptr,
+                 timeline.gates[index].first_bit);
+      index += 1;
+    }
+  }
+
+  // compare_contents
+  //
+  // Toggle the bits of the contents of a RAM instance that differ from the
+  // state. The contents start at a multiple of 64 bits, hence every eight
+  // bytes are compared with a word of the state at once.
+  //
+  static void compare_contents(Timeline& timeline, u32 const first_bit,
+                               Array<u8> const& contents)
+  {
+    i64 const size = contents.size();
+    for(i64 offset = 0; offset < size; offset += 8) {
+      i64 const count = math::min(size - offset, static_cast<i64>(8));
+      u64 word = 0;
+      memcpy(&word, contents.data() + offset, count);
+      u32 const word_bit = first_bit + offset * 8;
+      u64& recorded = timeline.state[word_bit >> 6];
+      u64 const difference = word ^ recorded;
+      if(difference == 0) {
+        continue;
+      }
+
+      recorded = word;
+      for(u32 bit = 0; bit < 64; ++bit) {
+        if((difference >> bit) & 1) {
+          timeline.toggles.push_back(word_bit + bit);
+        }
+      }
+    }
+  }
+
+  // compare_gate
+  //
+  // Toggle the bits of the state that differ from the gate and remember them
+  // in the scratch buffer.
+  //
+  static void compare_gate(Timeline& timeline, u32 const index,
+                           Gate const& gate)
+  {
+    Timeline_Gate const& entry = timeline.gates[index];
+    i64 const contents_bits = get_contents_bit_count(gate);
+    i64 const count = entry.bit_count - contents_bits;
+    for(i64 bit = 0; bit < count; ++bit) {
+      // The value is followed by bit 0 of every byte of Gate::state, which
+      // are read directly since the gate is compared every cycle.
+      bool value;
+      if(bit == 0) {
+        value = gate.evaluation.value;
+      } else {
+        value = bit - 1 < gate.state.size() && (gate.state[bit - 1] & 1);
+      }
+
+      u32 const state_bit = entry.first_bit + bit;
+      if(value != get_bit(timeline.state, state_bit)) {
+        toggle_bit(timeline.state, state_bit);
+        timeline.toggles.push_back(state_bit);
+      }
+    }
+
+    if(contents_bits > 0) {
+      compare_contents(timeline, entry.first_bit + count,
+                       get_state_contents(gate));
+    }
+  }
+
+  // find_segment
+  //
+  // Find the last segment starting at or before a cycle.
+  //
+  [[nodiscard]] static i64 find_segment(Timeline const& timeline,
+                                        i64 const cycle)
+  {
+    i64 low = 0;
+    i64 high = timeline.segments.size();
+    while(high - low > 1) {
+      i64 const middle = (low + high) / 2;
+      if(timeline.segments[middle].first_cycle <= cycle) {
+        low = middle;
+      } else {
+        high = middle;
+      }
+    }
+    return low;
+  }
+
+  // get_toggle_count
+  //
+  // Get the number of toggles of a segment up to and including a cycle.
+  //
+  [[nodiscard]] static i64 get_toggle_count(Timeline_Segment const& segment,
+                                            i64 const cycle)
+  {
+    if(cycle <= segment.first_cycle) {
+      return 0;
+    }
+    return segment.offsets[cycle - segment.first_cycle - 1];
+  }
+
+  // reconstruct_state
+  //
+  // Compute the state after a recorded cycle by replaying the toggles since
+  // the closest snapshot.
+  //
+  static void reconstruct_state(Timeline const& timeline, i64 const cycle,
+                                Array<u64>& state)
+  {
+    Timeline_Segment const& segment =
+      timeline.segments[find_segment(timeline, cycle)];
+    state = segment.snapshot;
+    i64 const count = get_toggle_count(segment, cycle);
+    for(i64 i = 0; i < count; ++i) {
+      toggle_bit(state, segment.toggles[i]);
+    }
+  }
+
+  // truncate_timeline
+  //
+  // Discard the cycles after a cycle and restore the state after the cycle.
+  //
+  static void truncate_timeline(Timeline& timeline, i64 const cycle)
+  {
+    reconstruct_state(timeline, cycle, timeline.state);
+    i64 const index = find_segment(timeline, cycle);
+    for(i64 i = index + 1; i < timeline.segments.size(); ++i) {
+      timeline.size -= get_segment_size(timeline.segments[i]);
+    }
+    timeline.segments.erase(timeline.segments.begin() + index + 1,
+                            timeline.segments.end());
+
+    Timeline_Segment& segment = timeline.segments[index];
+    timeline.size -= get_segment_size(segment);
+    segment.toggles.erase(segment.toggles.begin() +
+                            get_toggle_count(segment, cycle),
+                          segment.toggles.end());
+    segment.offsets.erase(segment.offsets.begin() +
+                            (cycle - segment.first_cycle),
+                          segment.offsets.end());
+    segment.last_cycle = cycle;
+    timeline.size += get_segment_size(segment);
+  }
+
+  static void add_segment(Timeline& timeline, i64 const cycle)
+  {
+    Timeline_Segment segment;
+    segment.first_cycle = cycle;
+    segment.last_cycle = cycle;
+    segment.snapshot = timeline.state;
+    timeline.size += get_segment_size(segment);
+    timeline.segments.push_back(ANTON_MOV(segment));
+  }
+
+  void start_timeline(Timeline& timeline, Timeline_Options const& options)
+  {
+    clear_timeline(timeline);
+    timeline.options = options;
+  }
+
+  void clear_timeline(Timeline& timeline)
+  {
+    timeline.gates = Array<Timeline_Gate>();
+    timeline.gate_indices.clear();
+    timeline.stateful = Array<u32>();
+    timeline.state = Array<u64>();
+    timeline.segments = Array<Timeline_Segment>();
+    timeline.size = 0;
+    timeline.toggles = Array<u32>();
+  }
+
+  i64 get_timeline_first_cycle(Timeline const& timeline)
+  {
+    if(timeline.segments.size() == 0) {
+      return -1;
+    }
+    return timeline.segments[0].first_cycle;
+  }
+
+  i64 get_timeline_last_cycle(Timeline const& timeline)
+  {
+    if(timeline.segments.size() == 0) {
+      return -1;
+    }
+    return timeline.segments.back().last_cycle;
+  }
+
+  void record_timeline(Timeline& timeline, Scene& scene, i64 const cycle,
+                       Slice<Gate* const> const changed)
+  {
+    if(timeline.segments.size() == 0) {
+      capture_gates(timeline, scene);
+      add_segment(timeline, cycle);
+      return;
+    }
+
+    i64 const first_cycle = get_timeline_first_cycle(timeline);
+    if(cycle <= first_cycle) {
+      // Nothing before the cycle remains, hence recording starts over.
+      Timeline_Options const options = timeline.options;
+      start_timeline(timeline, options);
+      record_timeline(timeline, scene, cycle, changed);
+      return;
+    }
+
+    if(cycle <= get_timeline_last_cycle(timeline)) {
+      truncate_timeline(timeline, cycle - 1);
+    }
+
+    timeline.toggles.clear();
+    // The evaluator does not report which bits of the state of a module, a
+    // sequential gate or a memory have changed.
+    for(u32 const index: timeline.stateful) {
+      Gate const* const gate = scene.find_gate(timeline.gates[index].id);
+      if(gate != nullptr) {
+        compare_gate(timeline, index, *gate);
+      }
+    }
+
+    for(Gate const* const gate: changed) {
+      if(has_state(*gate)) {
+        continue;
+      }
+
+      auto iter = timeline.gate_indices.find(gate->id);
+      if(iter != timeline.gate_indices.end()) {
+        compare_gate(timeline, iter->value, *gate);
+      }
+    }
+
+    // A snapshot is taken once the toggles since the last snapshot take as
+    // much memory as the snapshot, which bounds the cost of a seek.
+    Timeline_Segment& segment = timeline.segments.back();
+    i64 const snapshot_size = timeline.state.size() * sizeof(u64);
+    i64 const toggles_size =
+      (segment.toggles.size() + timeline.toggles.size()) * sizeof(u32);
+    if(cycle - segment.first_cycle >= timeline.options.snapshot_interval ||
+       toggles_size > snapshot_size) {
+      add_segment(timeline, cycle);
+    } else {
+      for(u32 const bit: timeline.toggles) {
+        segment.toggles.push_back(bit);
+      }
+      segment.offsets.push_back(segment.toggles.size());
+      segment.last_cycle = cycle;
+      timeline.size += (timeline.toggles.size() + 1) * sizeof(u32);
+    }
+
+    while(timeline.size > timeline.options.memory_budget &&
+          timeline.segments.size() > 1) {
+      timeline.size -= get_segment_size(timeline.segments[0]);
+      timeline.segments.erase(timeline.segments.begin(),
+                              timeline.segments.begin() + 1);
+    }
+  }
+
+  bool seek_timeline(Timeline& timeline, Scene& scene, i64 const cycle)
+  {
+    if(cycle < get_timeline_first_cycle(timeline) ||
+       cycle > get_timeline_last_cycle(timeline)) {
+      return false;
+    }
+
+    reconstruct_state(timeline, cycle, timeline.state);
+    for(Timeline_Gate const& entry: timeline.gates) {
+      Gate* const gate = scene.find_gate(entry.id);
+      if(gate == nullptr) {
+        continue;
+      }
+
+      restore_state(*gate, timeline.state.data(), nullptr, entry.first_bit);
+    }
+    return true;
+  }
+} // namespace nebula
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <anton/flat_hash_map.hpp>
+#include <anton/slice.hpp>
+
+#include <core/types.hpp>
+#include <model/gate.hpp>
+
+namespace nebula {
+  struct Scene;
+
+  /**
+   * @brief Parameters of a timeline.
+   */
+  struct Timeline_Options {
+    // Maximum number of cycles between consecutive snapshots. Bounds the
+    // number of cycles replayed by a seek.
+    i64 snapshot_interval = 1024;
+    // Maximum number of bytes used by the snapshots and deltas. The oldest
+    // segments are discarded when the budget is exceeded.
+    i64 memory_budget = 256 << 20;
+  };
+
+  /**
+   * @brief A gate whose state is recorded by a timeline.
+   *
+   * The state of a gate occupies consecutive bits of the timeline state
+   * starting with its value followed by bit 0 of every byte of Gate::state.
+   * The contents of RAM instances follow in whole words, hence unused bits
+   * may precede and follow them.
+   */
+  struct Timeline_Gate {
+    u64 id;
+    u32 first_bit;
+    u32 bit_count;
+  };
+
+  /**
+   * @brief A snapshot followed by the changes of the subsequent cycles.
+   *
+   * snapshot is the state after first_cycle. The bits toggled by the cycle
+   * first_cycle + i for i in [1, last_cycle - first_cycle] are
+   * toggles[offsets[i - 1], offsets[i]).
+   */
+  struct Timeline_Segment {
+    i64 first_cycle;
+    i64 last_cycle;
+    Array<u64> snapshot;
+    Array<u32> toggles;
+    Array<u32> offsets;
+  };
+
+  /**
+   * @brief Record of the simulation state that allows seeking to past cycles.
+   *
+   * The state of all gates is stored as a packed bitset. A full snapshot is
+   * taken every Timeline_Options::snapshot_interval cycles or once the
+   * changes since the last snapshot take as much memory as a snapshot, hence
+   * a seek restores one snapshot and replays a bounded number of changes.
+   * The gates are captured at the first recorded cycle and are identified by
+   * their identifiers. Gates added later are not recorded.
+   */
+  struct Timeline {
+    Timeline_Options options;
+    Array<Timeline_Gate> gates;
+    // Maps the identifier of a gate to its index in gates.
+    Flat_Hash_Map<u64, u32> gate_indices;
+    // Indices of module instances, sequential gates with state and memories,
+    // whose states are compared every cycle.
+    Array<u32> stateful;
+    // State after last_cycle.
+    Array<u64> state;
+    Array<Timeline_Segment> segments;
+    // Number of bytes used by the segments.
+    i64 size = 0;
+    // Scratch buffer of the toggles of the cycle being recorded.
+    Array<u32> toggles;
+  };
+
+  /**
+   * @brief Clears a timeline and sets its parameters. Recording starts with
+   * the next call to record_timeline.
+   */
+  void start_timeline(Timeline& timeline, Timeline_Options const& options);
+
+  /**
+   * @brief Clears a timeline and releases its memory.
+   */
+  void clear_timeline(Timeline& timeline);
+
+  /**
+   * @brief Gets the first cycle that can be sought to.
+   *
+   * @return The first cycle or -1 if the timeline is empty.
+   */
+  [[nodiscard]] i64 get_timeline_first_cycle(Timeline const& timeline);
+
+  /**
+   * @brief Gets the last recorded cycle.
+   *
+   * @return The last cycle or -1 if the timeline is empty.
+   */
+  [[nodiscard]] i64 get_timeline_last_cycle(Timeline const& timeline);
+
+  /**
+   * @brief Records the state of the gates after a cycle has been evaluated.
+   *
+   * Recording a cycle that is not after the last recorded cycle discards the
+   * recorded cycles starting with that cycle, which continues the simulation
+   * from a cycle that has been sought to.
+   *
+   * @param timeline The timeline to record into.
+   * @param scene The scene containing the gates.
+   * @param cycle The evaluated cycle. Must be at most one after the last
+   * recorded cycle.
+   * @param changed The gates reported as changed by evaluate.
+   */
+  void record_timeline(Timeline& timeline, Scene& scene, i64 cycle,
+                       Slice<Gate* const> changed);
+
+  /**
+   * @brief Restores the state of the gates after a recorded cycle.
+   *
+   * Restores the closest snapshot at or before the cycle and replays the
+   * changes up to the cycle. Gates deleted since the cycle was recorded are
+   * skipped.
+   *
+   * @param timeline The timeline to seek in.
+   * @param scene The scene containing the gates.
+   * @param cycle The cycle to restore.
+   * @return Whether the cycle has been recorded.
+   */
+  [[nodiscard]] bool seek_timeline(Timeline& timeline, Scene& scene,
+                                   i64 cycle);
+} // namespace nebula
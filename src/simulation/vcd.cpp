@@ -0,0 +1,344 @@
+#include <simulation/vcd.hpp>
+
+#include <anton/filesystem.hpp>
+#include <anton/flat_hash_map.hpp>
+#include <anton/format.hpp>
+
+#include <model/memory.hpp>
+#include <model/module.hpp>
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace nebula {
+  // Size of a buffer at which it is handed to the background thread.
+  constexpr i64 flush_threshold = 1 << 20;
+
+  // VCD_Signal
+  //
+  // A recorded output. output is the index of the output of a module
+  // instance, a register or a memory and unused for other gates.
+  //
+  struct VCD_Signal {
+    Gate const* gate;
+    i64 output;
+  };
+
+  struct VCD_Recorder {
+    fs::Output_File_Stream file;
+    Array<VCD_Signal> signals;
+    // Identifier codes of the signals, each terminated by a newline.
+    Array<char> identifiers;
+    Array<i64> identifier_offsets;
+    // Last recorded values.
+    Array<u8> values;
+    // Maps the address of a gate to the index of its first signal. The
+    // signals of a gate are consecutive.
+    Flat_Hash_Map<u64, i64> first_signals;
+    // The last cycle whose timestep has been written. -1 until the initial
+    // values have been dumped.
+    i64 written_cycle = -1;
+
+    // The simulation appends to buffers[active] while the background thread
+    // writes the other buffer if pending is set.
+    Array<char> buffers[2];
+    i32 active = 0;
+    bool pending = false;
+    bool stopping = false;
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::thread thread;
+  };
+
+  static void append(Array<char>& buffer, String_View const text)
+  {
+    char const* const end = text.data() + text.size_bytes();
+    for(char const* i = text.data(); i != end; ++i) {
+      buffer.push_back(*i);
+    }
+  }
+
+  static void append_number(Array<char>& buffer, i64 value)
+  {
+    char digits[20];
+    i64 count = 0;
+    do {
+      digits[count] = static_cast<char>('0' + value % 10);
+      value /= 10;
+      count += 1;
+    } while(value > 0);
+    while(count > 0) {
+      count -= 1;
+      buffer.push_back(digits[count]);
+    }
+  }
+
+  // append_identifier
+  //
+  // Identifier codes are numbers in base 94 written with the printable ASCII
+  // characters from '!' to '~'.
+  //
+  static void append_identifier(Array<char>& buffer, i64 index)
+  {
+    do {
+      buffer.push_back(static_cast<char>('!' + index % 94));
+      index /= 94;
+    } while(index > 0);
+  }
+
+  [[nodiscard]] static u64 get_key(Gate const* const gate)
+  {
+    return reinterpret_cast<u64>(gate);
+  }
+
+  [[nodiscard]] static String get_gate_name(Gate const& gate)
+  {
+    if(gate.name.size_bytes() > 0) {
+      return gate.name;
+    } else {
+      return format("g{}"_sv, gate.id);
+    }
+  }
+
+  // Value of an unknown signal. Known signals are 0 or 1.
+  constexpr u8 unknown_value = 2;
+
+  // get_state_signal
+  //
+  // Bit 0 of a state byte holds the value and bit 2 whether it is unknown.
+  //
+  [[nodiscard]] static u8 get_state_signal(u8 const byte)
+  {
+    return (byte & 4) ? unknown_value : (byte & 1);
+  }
+
+  // get_signal_value
+  //
+  // Module instances, registers and memories keep the current values of
+  // their outputs in their state.
+  //
+  // Returns:
+  // 0, 1 or unknown_value.
+  //
+  [[nodiscard]] static u8 get_signal_value(VCD_Signal const& signal)
+  {
+    Gate const& gate = *signal.gate;
+    if(gate.kind == Gate_Kind::e_register || is_memory(gate.kind)) {
+      return gate.state.size() > 0 ? get_state_signal(gate.state[signal.output])
+                                   : 0;
+    } else if(gate.kind != Gate_Kind::e_module) {
+      return gate.evaluation.unknown ? unknown_value : gate.evaluation.value;
+    }
+
+    if(gate.state.size() == 0 || !gate.definition->flattened) {
+      return 0;
+    }
+
+    u32 const reference = gate.definition->flat.outputs[signal.output];
+    if(reference == invalid_signal) {
+      return 0;
+    }
+    return get_state_signal(gate.state[reference]);
+  }
+
+  static void append_value(VCD_Recorder& recorder, i64 const signal,
+                           u8 const value)
+  {
+    Array<char>& buffer = recorder.buffers[recorder.active];
+    char const characters[] = {'0', '1', 'x'};
+    buffer.push_back(characters[value]);
+    char const* i = recorder.identifiers.data() +
+                    recorder.identifier_offsets[signal];
+    do {
+      buffer.push_back(*i);
+    } while(*(i++) != '\n');
+  }
+
+  static void declare_signal(VCD_Recorder& recorder, Array<char>& header,
+                             VCD_Signal const signal, String_View const name)
+  {
+    i64 const index = recorder.signals.size();
+    recorder.signals.push_back(signal);
+    recorder.values.push_back(0);
+    recorder.identifier_offsets.push_back(recorder.identifiers.size());
+    append_identifier(recorder.identifiers, index);
+    recorder.identifiers.push_back('\n');
+
+    append(header, "$var wire 1 "_sv);
+    append_identifier(header, index);
+    append(header, " "_sv);
+    append(header, name);
+    append(header, " $end\n"_sv);
+  }
+
+  static void write_header(VCD_Recorder& recorder, Array<char>& header,
+                           Slice<Gate* const> const gates)
+  {
+    append(header, "$version nebula $end\n"_sv);
+    append(header, "$timescale 1ns $end\n"_sv);
+    append(header, "$scope module scene $end\n"_sv);
+    for(Gate const* const gate: gates) {
+      String const name = get_gate_name(*gate);
+      recorder.first_signals.emplace(get_key(gate), recorder.signals.size());
+      if(gate->kind == Gate_Kind::e_register || is_memory(gate->kind)) {
+        append(header, "$scope module "_sv);
+        append(header, name);
+        append(header, " $end\n"_sv);
+        for(i64 i = 0; i < gate->out_ports.size(); ++i) {
+          declare_signal(recorder, header, VCD_Signal{gate, i},
+                         format("q{}"_sv, i));
+        }
+        append(header, "$upscope $end\n"_sv);
+        continue;
+      } else if(gate->kind != Gate_Kind::e_module) {
+        declare_signal(recorder, header, VCD_Signal{gate, 0}, name);
+        continue;
+      }
+
+      append(header, "$scope module "_sv);
+      append(header, name);
+      append(header, " $end\n"_sv);
+      Array<String> const& outputs = gate->definition->output_names;
+      for(i64 i = 0; i < outputs.size(); ++i) {
+        declare_signal(recorder, header, VCD_Signal{gate, i}, outputs[i]);
+      }
+      append(header, "$upscope $end\n"_sv);
+    }
+    append(header, "$upscope $end\n"_sv);
+    append(header, "$enddefinitions $end\n"_sv);
+  }
+
+  // flush_buffers
+  //
+  // Body of the background thread. Writes pending buffers until the recorder
+  // is stopped.
+  //
+  static void flush_buffers(VCD_Recorder& recorder)
+  {
+    std::unique_lock<std::mutex> lock{recorder.mutex};
+    while(true) {
+      recorder.condition.wait(
+        lock, [&recorder] { return recorder.pending || recorder.stopping; });
+      if(!recorder.pending) {
+        break;
+      }
+
+      // The simulation does not touch the inactive buffer while pending is
+      // set, hence it is written without holding the lock.
+      Array<char>& buffer = recorder.buffers[1 - recorder.active];
+      lock.unlock();
+      recorder.file.write(String_View{buffer.data(), buffer.size()});
+      buffer.clear();
+      lock.lock();
+      recorder.pending = false;
+      recorder.condition.notify_all();
+    }
+  }
+
+  // submit_buffer
+  //
+  // Hand the active buffer to the background thread and continue with the
+  // other buffer. Waits only if the background thread is still writing the
+  // previous buffer.
+  //
+  static void submit_buffer(VCD_Recorder& recorder)
+  {
+    std::unique_lock<std::mutex> lock{recorder.mutex};
+    recorder.condition.wait(lock, [&recorder] { return !recorder.pending; });
+    recorder.active = 1 - recorder.active;
+    recorder.pending = true;
+    recorder.condition.notify_all();
+  }
+
+  Expected<VCD_Recorder*, Error>
+  start_vcd_recording(String_View const path, Slice<Gate* const> const gates)
+  {
+    VCD_Recorder* const recorder = new VCD_Recorder;
+    if(!recorder->file.open(path)) {
+      delete recorder;
+      return {expected_error, format("could not open '{}'"_sv, path)};
+    }
+
+    recorder->buffers[0].ensure_capacity(flush_threshold);
+    recorder->buffers[1].ensure_capacity(flush_threshold);
+    write_header(*recorder, recorder->buffers[0], gates);
+    recorder->thread = std::thread([recorder] { flush_buffers(*recorder); });
+    return {expected_value, recorder};
+  }
+
+  // record_signal
+  //
+  // Write the value of a signal if it differs from the last recorded value.
+  // The timestep is written before the first change within it.
+  //
+  static void record_signal(VCD_Recorder& recorder, i64 const signal,
+                            i64 const cycle)
+  {
+    u8 const value = get_signal_value(recorder.signals[signal]);
+    if(value == recorder.values[signal]) {
+      return;
+    }
+
+    if(recorder.written_cycle != cycle) {
+      recorder.written_cycle = cycle;
+      Array<char>& buffer = recorder.buffers[recorder.active];
+      buffer.push_back('#');
+      append_number(buffer, cycle);
+      buffer.push_back('\n');
+    }
+    recorder.values[signal] = value;
+    append_value(recorder, signal, value);
+  }
+
+  void record_vcd(VCD_Recorder* const recorder, i64 const cycle,
+                  Slice<Gate* const> const changed)
+  {
+    Array<char>& buffer = recorder->buffers[recorder->active];
+    if(recorder->written_cycle < 0) {
+      recorder->written_cycle = cycle;
+      buffer.push_back('#');
+      append_number(buffer, cycle);
+      append(buffer, "\n$dumpvars\n"_sv);
+      for(i64 i = 0; i < recorder->signals.size(); ++i) {
+        u8 const value = get_signal_value(recorder->signals[i]);
+        recorder->values[i] = value;
+        append_value(*recorder, i, value);
+      }
+      append(buffer, "$end\n"_sv);
+    } else {
+      for(Gate const* const gate: changed) {
+        auto iter = recorder->first_signals.find(get_key(gate));
+        if(iter == recorder->first_signals.end()) {
+          continue;
+        }
+
+        for(i64 i = iter->value; i < recorder->signals.size() &&
+                                 recorder->signals[i].gate == gate;
+            ++i) {
+          record_signal(*recorder, i, cycle);
+        }
+      }
+    }
+
+    if(buffer.size() >= flush_threshold) {
+      submit_buffer(*recorder);
+    }
+  }
+
+  void stop_vcd_recording(VCD_Recorder* const recorder)
+  {
+    if(recorder->buffers[recorder->active].size() > 0) {
+      submit_buffer(*recorder);
+    }
+
+    {
+      std::unique_lock<std::mutex> lock{recorder->mutex};
+      recorder->stopping = true;
+      recorder->condition.notify_all();
+    }
+    recorder->thread.join();
+    recorder->file.close();
+    delete recorder;
+  }
+} // namespace nebula
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <anton/expected.hpp>
+#include <anton/slice.hpp>
+#include <anton/string_view.hpp>
+
+#include <core/error.hpp>
+#include <core/types.hpp>
+#include <model/gate.hpp>
+
+namespace nebula {
+  /**
+   * @brief A Value Change Dump being written on a background thread.
+   */
+  struct VCD_Recorder;
+
+  /**
+   * @brief Starts recording the outputs of gates to a VCD file.
+   *
+   * Writes the header of the file declaring one signal per output of every
+   * gate. Gates are named after their nets, unnamed gates are named g<id>.
+   * The outputs of module instances are declared within a scope named after
+   * the instance. Every cycle is one timestep of 1ns.
+   *
+   * Changes are collected into a buffer that is handed to a background thread
+   * once full, which writes it to the file while the simulation continues
+   * filling the other buffer.
+   *
+   * @param path The path to the VCD file.
+   * @param gates The gates to record. Must outlive the recorder.
+   * @return The recorder on success, otherwise an error message. Must be
+   * released with stop_vcd_recording.
+   */
+  [[nodiscard]] Expected<VCD_Recorder*, Error>
+  start_vcd_recording(String_View path, Slice<Gate* const> gates);
+
+  /**
+   * @brief Records the values of the gates after a cycle has been evaluated.
+   *
+   * The first call dumps all values, subsequent calls write only the values
+   * that have changed since the previous call. Only the changed gates and the
+   * inputs are compared. Timesteps without changes are omitted.
+   *
+   * @param recorder The recorder.
+   * @param cycle The evaluated cycle. Must increase with every call.
+   * @param changed The gates reported as changed by evaluate.
+   */
+  void record_vcd(VCD_Recorder* recorder, i64 cycle,
+                  Slice<Gate* const> changed);
+
+  /**
+   * @brief Writes all buffered changes, closes the file and releases the
+   * recorder.
+   */
+  void stop_vcd_recording(VCD_Recorder* recorder);
+} // namespace nebula
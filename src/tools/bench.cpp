@@ -0,0 +1,405 @@
+#include <anton/filesystem.hpp>
+#include <anton/format.hpp>
+#include <anton/math/math.hpp>
+#include <anton/stdio.hpp>
+
+#include <core/time.hpp>
+#include <core/types.hpp>
+#include <evaluator/evaluator.hpp>
+#include <logging/logging.hpp>
+#include <simulation/optimize.hpp>
+#include <tools/generators.hpp>
+#include <ui/draw.hpp>
+#include <ui/scene.hpp>
+
+// nebula-bench
+//
+// Generates synthetic circuits of increasing size and times scene
+// construction, evaluation, hit testing and draw command preparation. The
+// results are written as JSON, one record per circuit and size.
+//
+
+using namespace nebula;
+
+struct Options {
+  Array<i64> sizes;
+  Array<Circuit_Kind> circuits;
+  String output;
+  String label;
+  u64 seed = 1;
+  // Minimum duration of every measurement in seconds.
+  f64 budget = 0.25;
+  // Whether to also time the evaluation of the optimized netlist.
+  bool optimize = false;
+};
+
+struct Measurement {
+  Circuit_Kind circuit;
+  i64 requested_gates;
+  i64 gates;
+  i64 ports;
+  f64 construct_ms;
+  i64 evaluate_cycles;
+  f64 evaluate_cycles_per_second;
+  f64 evaluate_ns_per_gate;
+  f64 hit_gates_us;
+  f64 hit_ports_us;
+  // Fractions of the hit tests that found a gate or a port.
+  f64 gate_hit_ratio;
+  f64 port_hit_ratio;
+  f64 geometry_ms;
+  i64 geometry_indices;
+  // Measured only with --optimize, 0 otherwise.
+  i64 optimized_gates;
+  f64 optimized_cycles_per_second;
+  f64 optimize_speedup;
+};
+
+static void print_usage()
+{
+  anton::print(
+    "usage: nebula-bench [options]\n"
+    "  --sizes <n,...>      gate counts (default 1000,10000,100000,1000000)\n"
+    "  --circuits <c,...>   circuits to generate (default all)\n"
+    "  --seed <n>           seed of the random circuits (default 1)\n"
+    "  --label <text>       label stored with the results, e.g. a commit\n"
+    "  --output <file>      write the JSON to a file instead of stdout\n"
+    "  --optimize           also time the evaluation after removing constant,\n"
+    "                       duplicated and unobserved gates\n"_sv);
+}
+
+[[nodiscard]] static Expected<i64, Error> parse_count(String_View const text)
+{
+  if(text.size_bytes() == 0) {
+    return {expected_error, Error("expected a number")};
+  }
+
+  i64 value = 0;
+  char const* const end = text.data() + text.size_bytes();
+  for(char const* i = text.data(); i != end; ++i) {
+    if(*i < '0' || *i > '9') {
+      return {expected_error, format("'{}' is not a number"_sv, text)};
+    }
+    value = value * 10 + (*i - '0');
+  }
+  return {expected_value, value};
+}
+
+// split_list
+//
+// Split a comma separated list into its elements.
+//
+static void split_list(String_View const text, Array<String_View>& elements)
+{
+  char const* begin = text.data();
+  char const* const end = text.data() + text.size_bytes();
+  for(char const* i = begin; i != end; ++i) {
+    if(*i == ',') {
+      elements.push_back(String_View{begin, i});
+      begin = i + 1;
+    }
+  }
+  elements.push_back(String_View{begin, end});
+}
+
+[[nodiscard]] static Expected<Circuit_Kind, Error>
+parse_circuit(String_View const name)
+{
+  for(i32 i = 0; i < static_cast<i32>(Circuit_Kind::e_count); ++i) {
+    Circuit_Kind const kind = static_cast<Circuit_Kind>(i);
+    if(get_circuit_name(kind) == name) {
+      return {expected_value, kind};
+    }
+  }
+  return {expected_error, format("unknown circuit '{}'"_sv, name)};
+}
+
+[[nodiscard]] static Expected<Options, Error> parse_options(int const argc,
+                                                            char** const argv)
+{
+  Options options;
+  for(int i = 1; i < argc; ++i) {
+    String_View const argument{argv[i]};
+    if(argument == "--optimize"_sv) {
+      options.optimize = true;
+      continue;
+    } else if(i + 1 >= argc) {
+      return {expected_error, format("unexpected argument '{}'"_sv, argument)};
+    }
+
+    String_View const value{argv[++i]};
+    Array<String_View> elements;
+    if(argument == "--sizes"_sv) {
+      split_list(value, elements);
+      for(String_View const element: elements) {
+        Expected<i64, Error> size = parse_count(element);
+        if(!size) {
+          return {expected_error, ANTON_MOV(size.error())};
+        }
+        options.sizes.push_back(size.value());
+      }
+    } else if(argument == "--circuits"_sv) {
+      split_list(value, elements);
+      for(String_View const element: elements) {
+        Expected<Circuit_Kind, Error> circuit = parse_circuit(element);
+        if(!circuit) {
+          return {expected_error, ANTON_MOV(circuit.error())};
+        }
+        options.circuits.push_back(circuit.value());
+      }
+    } else if(argument == "--seed"_sv) {
+      Expected<i64, Error> seed = parse_count(value);
+      if(!seed) {
+        return {expected_error, ANTON_MOV(seed.error())};
+      }
+      options.seed = static_cast<u64>(seed.value());
+    } else if(argument == "--label"_sv) {
+      options.label = String(value);
+    } else if(argument == "--output"_sv) {
+      options.output = String(value);
+    } else {
+      return {expected_error, format("unexpected argument '{}'"_sv, argument)};
+    }
+  }
+
+  if(options.sizes.size() == 0) {
+    i64 const sizes[] = {1000, 10000, 100000, 1000000};
+    for(i64 const size: sizes) {
+      options.sizes.push_back(size);
+    }
+  }
+  if(options.circuits.size() == 0) {
+    for(i32 i = 0; i < static_cast<i32>(Circuit_Kind::e_count); ++i) {
+      options.circuits.push_back(static_cast<Circuit_Kind>(i));
+    }
+  }
+  return {expected_value, ANTON_MOV(options)};
+}
+
+static void measure_evaluate(Scene& scene, f64 const budget,
+                             Measurement& measurement)
+{
+  i64 cycles = 0;
+  f64 const start = get_time();
+  f64 elapsed = 0.0;
+  while(cycles < 3 || elapsed < budget) {
+    evaluate(scene.gates);
+    cycles += 1;
+    elapsed = get_time() - start;
+  }
+
+  measurement.evaluate_cycles = cycles;
+  measurement.evaluate_cycles_per_second = static_cast<f64>(cycles) / elapsed;
+  measurement.evaluate_ns_per_gate =
+    elapsed * 1.0e9 / static_cast<f64>(cycles * measurement.gates);
+}
+
+// measure_optimized
+//
+// Optimize the circuit observing the gates without fanout and time the
+// evaluation again. Runs last since it modifies the scene.
+//
+static void measure_optimized(Scene& scene, f64 const budget,
+                              Measurement& measurement)
+{
+  Array<Gate*> observed;
+  for(Gate& gate: scene.gates) {
+    bool connected = false;
+    for(Port* const port: gate.out_ports) {
+      connected |= port->connections.size() > 0;
+    }
+    if(!connected) {
+      observed.push_back(&gate);
+    }
+  }
+
+  Optimization_Statistics const statistics =
+    optimize_netlist(scene, observed);
+  measurement.optimized_gates = statistics.remaining;
+  i64 cycles = 0;
+  f64 const start = get_time();
+  f64 elapsed = 0.0;
+  while(cycles < 3 || elapsed < budget) {
+    evaluate(scene.gates);
+    cycles += 1;
+    elapsed = get_time() - start;
+  }
+  measurement.optimized_cycles_per_second =
+    static_cast<f64>(cycles) / elapsed;
+  measurement.optimize_speedup = measurement.optimized_cycles_per_second /
+                                 measurement.evaluate_cycles_per_second;
+}
+
+// measure_hit_tests
+//
+// Time hit tests at pseudo-random points within the bounds of the circuit.
+// Points are generated by a Weyl sequence, which spreads them evenly.
+//
+static void measure_hit_tests(Scene& scene, f64 const budget,
+                              Measurement& measurement)
+{
+  Vec2 max{0.0f, 0.0f};
+  for(Gate const& gate: scene.gates) {
+    max = Vec2{math::max(max.x, gate.coordinates.x + gate.dimensions.x),
+               math::max(max.y, gate.coordinates.y + gate.dimensions.y)};
+  }
+
+  auto get_point = [max](i64 const index) -> Vec2 {
+    f32 const x = static_cast<f32>(index) * 0.6180339887f;
+    f32 const y = static_cast<f32>(index) * 0.7548776662f;
+    return Vec2{(x - math::floor(x)) * max.x, (y - math::floor(y)) * max.y};
+  };
+
+  i64 hits = 0;
+  i64 queries = 0;
+  f64 start = get_time();
+  f64 elapsed = 0.0;
+  while(queries < 3 || elapsed < budget) {
+    hits += test_hit_gates(scene, get_point(queries)) != nullptr;
+    queries += 1;
+    elapsed = get_time() - start;
+  }
+  measurement.hit_gates_us = elapsed * 1.0e6 / static_cast<f64>(queries);
+  measurement.gate_hit_ratio =
+    static_cast<f64>(hits) / static_cast<f64>(queries);
+
+  hits = 0;
+  queries = 0;
+  start = get_time();
+  elapsed = 0.0;
+  while(queries < 3 || elapsed < budget) {
+    hits += test_hit_ports(scene, get_point(queries)) != nullptr;
+    queries += 1;
+    elapsed = get_time() - start;
+  }
+  measurement.hit_ports_us = elapsed * 1.0e6 / static_cast<f64>(queries);
+  measurement.port_hit_ratio =
+    static_cast<f64>(hits) / static_cast<f64>(queries);
+}
+
+// measure_geometry
+//
+// Time the preparation of the draw commands of the gates, connections and
+// ports as done by render_scene. Connections are drawn as straight segments,
+// hence routing is not part of the measurement.
+//
+static void measure_geometry(Scene& scene, f64 const budget,
+                             Measurement& measurement)
+{
+  Array<Vertex> vertices(1048576);
+  Array<u32> indices(1048576);
+  rendering::set_geometry_storage(vertices, indices);
+
+  i64 frames = 0;
+  i64 index_count = 0;
+  f64 const start = get_time();
+  f64 elapsed = 0.0;
+  while(frames < 1 || elapsed < budget) {
+    for(Gate const& gate: scene.gates) {
+      index_count += prepare_draw(gate).count;
+    }
+
+    for(Port const* const port: scene.ports) {
+      if(port->kind != Port_Kind::in || port->connections.size() == 0) {
+        continue;
+      }
+
+      Port const* const other = *port->connections.begin();
+      Vec2 const points[] = {other->coordinates, port->coordinates};
+      index_count += prepare_draw_connection(points).count;
+    }
+
+    for(Port const* const port: scene.ports) {
+      index_count += prepare_draw(*port).count;
+    }
+
+    frames += 1;
+    elapsed = get_time() - start;
+  }
+  measurement.geometry_ms = elapsed * 1.0e3 / static_cast<f64>(frames);
+  measurement.geometry_indices = index_count / frames;
+}
+
+[[nodiscard]] static String format_record(Measurement const& m,
+                                          String_View const label)
+{
+  return format(
+    "\"label\": \"{}\", \"circuit\": \"{}\", \"requested_gates\": {}, "
+    "\"gates\": {}, \"ports\": {}, \"construct_ms\": {}, "
+    "\"evaluate_cycles\": {}, \"evaluate_cycles_per_second\": {}, "
+    "\"evaluate_ns_per_gate\": {}, \"hit_gates_us\": {}, "
+    "\"hit_ports_us\": {}, \"gate_hit_ratio\": {}, "
+    "\"port_hit_ratio\": {}, \"geometry_ms\": {}, "
+    "\"geometry_indices\": {}, \"optimized_gates\": {}, "
+    "\"optimized_cycles_per_second\": {}, \"optimize_speedup\": {}"_sv,
+    label, get_circuit_name(m.circuit), m.requested_gates, m.gates, m.ports,
+    m.construct_ms, m.evaluate_cycles, m.evaluate_cycles_per_second,
+    m.evaluate_ns_per_gate, m.hit_gates_us, m.hit_ports_us,
+    m.gate_hit_ratio, m.port_hit_ratio, m.geometry_ms, m.geometry_indices,
+    m.optimized_gates, m.optimized_cycles_per_second, m.optimize_speedup);
+}
+
+int main(int argc, char* argv[])
+{
+  Expected<Options, Error> parsed = parse_options(argc, argv);
+  if(!parsed) {
+    LOG_ERROR("{}", parsed.error());
+    print_usage();
+    return 1;
+  }
+
+  Options const& options = parsed.value();
+  fs::Output_File_Stream file;
+  if(options.output.size_bytes() > 0 && !file.open(options.output)) {
+    LOG_ERROR("could not open '{}'", options.output);
+    return 1;
+  }
+
+  auto write = [&file](String_View const text) {
+    if(file.is_open()) {
+      file.write(text);
+    } else {
+      anton::print(text);
+    }
+  };
+
+  write("[\n"_sv);
+  bool first = true;
+  for(Circuit_Kind const circuit: options.circuits) {
+    for(i64 const size: options.sizes) {
+      Measurement measurement = {};
+      measurement.circuit = circuit;
+      measurement.requested_gates = size;
+      {
+        Scene scene;
+        f64 const start = get_time();
+        measurement.gates =
+          generate_circuit(scene, circuit, size, options.seed);
+        measurement.construct_ms = (get_time() - start) * 1.0e3;
+        measurement.ports = scene.ports.size();
+        measure_evaluate(scene, options.budget, measurement);
+        measure_hit_tests(scene, options.budget, measurement);
+        measure_geometry(scene, options.budget, measurement);
+        if(options.optimize) {
+          measure_optimized(scene, options.budget, measurement);
+        }
+      }
+
+      if(!first) {
+        write(",\n"_sv);
+      }
+      first = false;
+      // Braces are written separately to keep them out of the format string.
+      write("  {"_sv);
+      write(format_record(measurement, options.label));
+      write("}"_sv);
+      if(file.is_open()) {
+        LOG_INFO("{} {}: {} ns/gate", get_circuit_name(circuit),
+                 measurement.gates,
+                 static_cast<i64>(measurement.evaluate_ns_per_gate));
+      }
+    }
+  }
+  write("\n]\n"_sv);
+  return 0;
+}
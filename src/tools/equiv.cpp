@@ -0,0 +1,223 @@
+#include <anton/format.hpp>
+#include <anton/stdio.hpp>
+
+#include <core/time.hpp>
+#include <core/types.hpp>
+#include <importer/importer.hpp>
+#include <logging/logging.hpp>
+#include <simulation/optimize.hpp>
+#include <ui/journal.hpp>
+#include <ui/scene.hpp>
+#include <verification/equivalence.hpp>
+
+// nebula-equiv
+//
+// Checks whether two netlists compute the same outputs, for example a design
+// before and after an edit or a synthesis step. Prints a counterexample if
+// they do not. The exit code is 0 if the netlists are equivalent, 1 if they
+// differ and 2 if the check failed or has been given up.
+//
+
+using namespace nebula;
+
+struct Options {
+  String first;
+  String second;
+  // Number of conflicts the solver may spend on a single output. Negative
+  // for no limit.
+  i64 conflict_limit = 1000000;
+  // Whether the second netlist is optimized before the check.
+  bool optimize = false;
+  // Whether edits of the second netlist are undone and redone through the
+  // edit journal before the check.
+  bool replay_journal = false;
+};
+
+static void print_usage()
+{
+  anton::print(
+    "usage: nebula-equiv <first> <second> [options]\n"
+    "  <first>, <second>    BLIF (.blif) or structural Verilog (.v) netlists\n"
+    "  --conflicts <n>      give up an output after n solver conflicts,\n"
+    "                       -1 for no limit (default 1000000)\n"
+    "  --optimize           optimize the second netlist like nebula-sim\n"
+    "                       --optimize before the check\n"
+    "  --replay-journal     disconnect and delete the gates of the second\n"
+    "                       netlist, then undo, redo and undo the edits\n"
+    "                       before the check\n"_sv);
+}
+
+[[nodiscard]] static Expected<i64, Error> parse_limit(String_View const text)
+{
+  if(text == "-1"_sv) {
+    return {expected_value, -1};
+  }
+
+  i64 value = 0;
+  char const* const end = text.data() + text.size_bytes();
+  for(char const* i = text.data(); i != end; ++i) {
+    if(*i < '0' || *i > '9') {
+      return {expected_error, format("'{}' is not a count"_sv, text)};
+    }
+    value = value * 10 + (*i - '0');
+  }
+  return {expected_value, value};
+}
+
+[[nodiscard]] static Expected<Options, Error> parse_options(int const argc,
+                                                            char** const argv)
+{
+  Options options;
+  for(int i = 1; i < argc; ++i) {
+    String_View const argument{argv[i]};
+    bool const has_value = i + 1 < argc;
+    if(argument == "--conflicts"_sv && has_value) {
+      Expected<i64, Error> limit = parse_limit(String_View{argv[++i]});
+      if(!limit) {
+        return {expected_error, ANTON_MOV(limit.error())};
+      }
+      options.conflict_limit = limit.value();
+    } else if(argument == "--optimize"_sv) {
+      options.optimize = true;
+    } else if(argument == "--replay-journal"_sv) {
+      options.replay_journal = true;
+    } else if(options.first.size_bytes() == 0 && argv[i][0] != '-') {
+      options.first = String(argument);
+    } else if(options.second.size_bytes() == 0 && argv[i][0] != '-') {
+      options.second = String(argument);
+    } else {
+      return {expected_error, format("unexpected argument '{}'"_sv, argument)};
+    }
+  }
+
+  if(options.second.size_bytes() == 0) {
+    return {expected_error, Error("two netlists are needed")};
+  }
+  return {expected_value, ANTON_MOV(options)};
+}
+
+// optimize_design
+//
+// Optimizes a netlist preserving its outputs and sequential gates, which are
+// the interface the check compares.
+//
+static void optimize_design(Scene& scene)
+{
+  Array<Gate*> observed;
+  for(Gate& gate: scene.gates) {
+    if(gate.kind == Gate_Kind::e_input || gate.kind == Gate_Kind::e_clock) {
+      continue;
+    }
+
+    bool connected = false;
+    for(Port* const port: gate.out_ports) {
+      connected |= port->connections.size() > 0;
+    }
+    if(!connected || is_sequential(gate.kind)) {
+      observed.push_back(&gate);
+    }
+  }
+
+  Optimization_Statistics const statistics = optimize_netlist(scene, observed);
+  LOG_INFO("optimization removed {} of {} gates",
+           statistics.folded + statistics.merged + statistics.dead,
+           statistics.gate_count);
+}
+
+// replay_journal
+//
+// Disconnects the output of the first gate and deletes the gates in two
+// entries of an edit journal, hence restoring the second entry reconnects
+// gates restored by the first. Undoes, redoes and undoes all entries again,
+// after which the netlist must compute what it did when loaded.
+//
+static void replay_journal(Scene& scene)
+{
+  Array<Gate*> halves[2];
+  i64 index = 0;
+  for(Gate& gate: scene.gates) {
+    halves[index % 2].push_back(&gate);
+    index += 1;
+  }
+
+  Journal journal;
+  if(halves[0].size() > 0 && halves[0][0]->out_ports.size() > 0) {
+    Port* const port = halves[0][0]->out_ports[0];
+    record_disconnection(journal, port);
+    port->remove_all_connections();
+  }
+  for(Array<Gate*> const& gates: halves) {
+    record_removed_gates(journal, gates);
+    scene.delete_gates(gates);
+  }
+
+  while(undo(journal, scene)) {}
+  while(redo(journal, scene)) {}
+  while(undo(journal, scene)) {}
+}
+
+int main(int argc, char* argv[])
+{
+  Expected<Options, Error> parsed = parse_options(argc, argv);
+  if(!parsed) {
+    LOG_ERROR("{}", parsed.error());
+    print_usage();
+    return 2;
+  }
+
+  Options const& options = parsed.value();
+  Scene scenes[2];
+  String const* const paths[2] = {&options.first, &options.second};
+  for(i64 i = 0; i < 2; ++i) {
+    Expected<Import_Statistics, Error> imported =
+      import_netlist(scenes[i], *paths[i], Vec2{0.6f, 0.5f});
+    if(!imported) {
+      LOG_ERROR("import of '{}' failed: {}", *paths[i], imported.error());
+      return 2;
+    }
+  }
+
+  if(options.replay_journal) {
+    replay_journal(scenes[1]);
+  }
+  if(options.optimize) {
+    optimize_design(scenes[1]);
+  }
+
+  f64 const start = get_time();
+  Expected<Equivalence_Result, Error> checked =
+    check_equivalence(scenes[0], scenes[1], options.conflict_limit);
+  if(!checked) {
+    LOG_ERROR("{}", checked.error());
+    return 2;
+  }
+
+  Equivalence_Result const& result = checked.value();
+  LOG_INFO("{} graph nodes, {} merged, {} solver calls in {} ms",
+           result.node_count, result.merged, result.sat_calls,
+           static_cast<i64>((get_time() - start) * 1000.0));
+  switch(result.verdict) {
+  case Equivalence_Verdict::e_equivalent:
+    anton::print("equivalent\n"_sv);
+    return 0;
+
+  case Equivalence_Verdict::e_different:
+    anton::print(format("different: output '{}' is {} in '{}' and {} in "
+                        "'{}' for\n"_sv,
+                        result.output, static_cast<i32>(result.first_value),
+                        options.first, static_cast<i32>(result.second_value),
+                        options.second));
+    for(Counterexample_Value const& value: result.counterexample) {
+      anton::print(format("  {} = {}\n"_sv, value.name,
+                          static_cast<i32>(value.value)));
+    }
+    return 1;
+
+  case Equivalence_Verdict::e_undecided:
+    anton::print(format("undecided: output '{}' exceeded the conflict "
+                        "limit\n"_sv,
+                        result.output));
+    return 2;
+  }
+  return 2;
+}
@@ -0,0 +1,337 @@
+#include <tools/generators.hpp>
+
+#include <anton/math/math.hpp>
+
+#include <ui/scene.hpp>
+
+namespace nebula {
+  // Circuit_Builder
+  //
+  // Adds gates to a scene on a square grid in the order of creation.
+  //
+  struct Circuit_Builder {
+    Scene& scene;
+    i64 rows;
+    i64 count = 0;
+  };
+
+  [[nodiscard]] static Gate* add_gate(Circuit_Builder& builder,
+                                      Gate_Kind const kind)
+  {
+    Vec2 const dimensions{0.6f, 0.5f};
+    f32 const column = static_cast<f32>(builder.count / builder.rows);
+    f32 const row = static_cast<f32>(builder.count % builder.rows);
+    Vec2 const coordinates{column * 1.2f, row * 0.75f};
+    builder.count += 1;
+    return &builder.scene.add_gate(dimensions, coordinates, kind);
+  }
+
+  // connect
+  //
+  // Connect the output of a driver to an input of a gate. A null driver leaves
+  // the input unconnected, which reads false.
+  //
+  static void connect(Circuit_Builder& builder, Gate* const driver,
+                      Gate* const gate, i64 const port)
+  {
+    if(driver != nullptr) {
+      builder.scene.connect_ports(driver->out_ports[0], gate->in_ports[port]);
+    }
+  }
+
+  [[nodiscard]] static Gate* add_gate(Circuit_Builder& builder,
+                                      Gate_Kind const kind, Gate* const in1,
+                                      Gate* const in2)
+  {
+    Gate* const gate = add_gate(builder, kind);
+    connect(builder, in1, gate, 0);
+    connect(builder, in2, gate, 1);
+    return gate;
+  }
+
+  struct Adder_Bit {
+    Gate* sum;
+    Gate* carry;
+  };
+
+  [[nodiscard]] static Adder_Bit add_full_adder(Circuit_Builder& builder,
+                                                Gate* const a, Gate* const b,
+                                                Gate* const carry)
+  {
+    Gate* const half = add_gate(builder, Gate_Kind::e_xor, a, b);
+    Gate* const sum = add_gate(builder, Gate_Kind::e_xor, half, carry);
+    Gate* const generate = add_gate(builder, Gate_Kind::e_and, a, b);
+    Gate* const propagate = add_gate(builder, Gate_Kind::e_and, half, carry);
+    Gate* const carry_out =
+      add_gate(builder, Gate_Kind::e_or, generate, propagate);
+    return Adder_Bit{sum, carry_out};
+  }
+
+  static void add_inputs(Circuit_Builder& builder, Array<Gate*>& inputs,
+                         i64 const count)
+  {
+    inputs.clear();
+    for(i64 i = 0; i < count; ++i) {
+      inputs.push_back(add_gate(builder, Gate_Kind::e_input));
+    }
+  }
+
+  static void generate_ripple_carry_adder(Circuit_Builder& builder,
+                                          i64 const width)
+  {
+    Array<Gate*> a;
+    Array<Gate*> b;
+    add_inputs(builder, a, width);
+    add_inputs(builder, b, width);
+    Gate* carry = add_gate(builder, Gate_Kind::e_input);
+    for(i64 i = 0; i < width; ++i) {
+      carry = add_full_adder(builder, a[i], b[i], carry).carry;
+    }
+  }
+
+  // generate_carry_lookahead_adder
+  //
+  // Kogge-Stone parallel prefix adder. The carry-in is folded into the
+  // generate signal of the least significant bit.
+  //
+  static void generate_carry_lookahead_adder(Circuit_Builder& builder,
+                                             i64 const width)
+  {
+    Array<Gate*> a;
+    Array<Gate*> b;
+    add_inputs(builder, a, width);
+    add_inputs(builder, b, width);
+    Gate* const carry_in = add_gate(builder, Gate_Kind::e_input);
+    Array<Gate*> propagate{anton::reserve, width};
+    Array<Gate*> generate{anton::reserve, width};
+    for(i64 i = 0; i < width; ++i) {
+      propagate.push_back(add_gate(builder, Gate_Kind::e_xor, a[i], b[i]));
+      generate.push_back(add_gate(builder, Gate_Kind::e_and, a[i], b[i]));
+    }
+
+    Array<Gate*> group_generate = generate;
+    Array<Gate*> group_propagate = propagate;
+    Gate* const carry_term =
+      add_gate(builder, Gate_Kind::e_and, propagate[0], carry_in);
+    group_generate[0] =
+      add_gate(builder, Gate_Kind::e_or, generate[0], carry_term);
+    for(i64 distance = 1; distance < width; distance *= 2) {
+      Array<Gate*> next_generate = group_generate;
+      Array<Gate*> next_propagate = group_propagate;
+      for(i64 i = distance; i < width; ++i) {
+        Gate* const term = add_gate(builder, Gate_Kind::e_and,
+                                    group_propagate[i],
+                                    group_generate[i - distance]);
+        next_generate[i] =
+          add_gate(builder, Gate_Kind::e_or, group_generate[i], term);
+        next_propagate[i] = add_gate(builder, Gate_Kind::e_and,
+                                     group_propagate[i],
+                                     group_propagate[i - distance]);
+      }
+      group_generate = ANTON_MOV(next_generate);
+      group_propagate = ANTON_MOV(next_propagate);
+    }
+
+    (void)add_gate(builder, Gate_Kind::e_xor, propagate[0], carry_in);
+    for(i64 i = 1; i < width; ++i) {
+      (void)add_gate(builder, Gate_Kind::e_xor, propagate[i],
+                     group_generate[i - 1]);
+    }
+  }
+
+  // generate_array_multiplier
+  //
+  // Partial products are accumulated row by row with ripple-carry adders.
+  //
+  static void generate_array_multiplier(Circuit_Builder& builder,
+                                        i64 const width)
+  {
+    Array<Gate*> a;
+    Array<Gate*> b;
+    add_inputs(builder, a, width);
+    add_inputs(builder, b, width);
+    Array<Gate*> accumulator{anton::reserve, width};
+    for(i64 i = 0; i < width; ++i) {
+      accumulator.push_back(add_gate(builder, Gate_Kind::e_and, a[i], b[0]));
+    }
+
+    Gate* carry_out = nullptr;
+    for(i64 row = 1; row < width; ++row) {
+      // The least significant bit of the accumulator is a finished bit of the
+      // product. The remaining bits are shifted down by one.
+      Array<Gate*> next{anton::reserve, width};
+      Gate* carry = nullptr;
+      for(i64 i = 0; i < width; ++i) {
+        Gate* const product = add_gate(builder, Gate_Kind::e_and, a[i], b[row]);
+        Gate* const shifted = i + 1 < width ? accumulator[i + 1] : carry_out;
+        Adder_Bit const bit = add_full_adder(builder, shifted, product, carry);
+        next.push_back(bit.sum);
+        carry = bit.carry;
+      }
+      accumulator = ANTON_MOV(next);
+      carry_out = carry;
+    }
+  }
+
+  // Random_Generator
+  //
+  // SplitMix64 generator. Deterministic for a given seed.
+  //
+  struct Random_Generator {
+    u64 state;
+  };
+
+  [[nodiscard]] static u64 next_random(Random_Generator& generator)
+  {
+    generator.state += 0x9E3779B97F4A7C15;
+    u64 z = generator.state;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+    return z ^ (z >> 31);
+  }
+
+  // generate_random_dag
+  //
+  // Every gate reads two earlier gates. Three quarters of the inputs are
+  // picked from a window of recent gates to mimic the locality of real
+  // netlists.
+  //
+  static void generate_random_dag(Circuit_Builder& builder,
+                                  i64 const gate_count, u64 const seed)
+  {
+    constexpr Gate_Kind kinds[] = {Gate_Kind::e_and,  Gate_Kind::e_or,
+                                   Gate_Kind::e_xor,  Gate_Kind::e_nand,
+                                   Gate_Kind::e_nor,  Gate_Kind::e_xnor};
+    constexpr i64 window = 1024;
+    Random_Generator random{seed};
+    Array<Gate*> gates{anton::reserve, gate_count};
+    i64 const input_count = math::max(static_cast<i64>(16), gate_count / 100);
+    for(i64 i = 0; i < input_count; ++i) {
+      gates.push_back(add_gate(builder, Gate_Kind::e_input));
+    }
+
+    auto pick = [&random, &gates]() -> Gate* {
+      u64 const value = next_random(random);
+      i64 const size = gates.size();
+      if((value & 3) != 0 && size > window) {
+        return gates[size - 1 - static_cast<i64>((value >> 2) % window)];
+      } else {
+        return gates[static_cast<i64>((value >> 2) % size)];
+      }
+    };
+
+    for(i64 i = input_count; i < gate_count; ++i) {
+      Gate_Kind const kind = kinds[next_random(random) % 6];
+      Gate* const in1 = pick();
+      Gate* const in2 = pick();
+      gates.push_back(add_gate(builder, kind, in1, in2));
+    }
+  }
+
+  // generate_counter
+  //
+  // Synchronous counter. Every bit toggles itself through a feedback
+  // connection when the carry into it is high. The carry into the least
+  // significant bit is the clock.
+  //
+  static void generate_counter(Circuit_Builder& builder, i64 const width)
+  {
+    Gate* carry = add_gate(builder, Gate_Kind::e_clock);
+    for(i64 i = 0; i < width; ++i) {
+      Gate* const bit = add_gate(builder, Gate_Kind::e_xor);
+      connect(builder, bit, bit, 0);
+      connect(builder, carry, bit, 1);
+      carry = add_gate(builder, Gate_Kind::e_and, bit, carry);
+    }
+  }
+
+  // generate_lfsr
+  //
+  // Fibonacci LFSR with taps 32, 22, 2 and 1. Every gate delays its input by
+  // one evaluation, hence buffers form the stages of the shift register. The
+  // XNOR feedback avoids the all zeros lock-up state.
+  //
+  static void generate_lfsr(Circuit_Builder& builder, i64 const width)
+  {
+    Gate* const feedback = add_gate(builder, Gate_Kind::e_xnor);
+    Array<Gate*> stages{anton::reserve, width};
+    Gate* previous = feedback;
+    for(i64 i = 0; i < width; ++i) {
+      previous = add_gate(builder, Gate_Kind::e_and, previous, previous);
+      stages.push_back(previous);
+    }
+
+    Gate* const high = add_gate(builder, Gate_Kind::e_xnor, stages[width - 1],
+                                stages[(width * 22) / 32 - 1]);
+    Gate* const low =
+      add_gate(builder, Gate_Kind::e_xnor, stages[1], stages[0]);
+    connect(builder, high, feedback, 0);
+    connect(builder, low, feedback, 1);
+  }
+
+  static void generate_block(Circuit_Builder& builder, Circuit_Kind const kind)
+  {
+    switch(kind) {
+    case Circuit_Kind::ripple_carry_adder:
+      generate_ripple_carry_adder(builder, 64);
+      break;
+    case Circuit_Kind::carry_lookahead_adder:
+      generate_carry_lookahead_adder(builder, 64);
+      break;
+    case Circuit_Kind::array_multiplier:
+      generate_array_multiplier(builder, 16);
+      break;
+    case Circuit_Kind::counter_chain:
+      generate_counter(builder, 32);
+      break;
+    case Circuit_Kind::lfsr_chain:
+      generate_lfsr(builder, 32);
+      break;
+    case Circuit_Kind::random_dag:
+    case Circuit_Kind::e_count:
+      ANTON_UNREACHABLE("not a block circuit");
+    }
+  }
+
+  String_View get_circuit_name(Circuit_Kind const kind)
+  {
+    switch(kind) {
+    case Circuit_Kind::ripple_carry_adder:
+      return "ripple_carry_adder"_sv;
+    case Circuit_Kind::carry_lookahead_adder:
+      return "carry_lookahead_adder"_sv;
+    case Circuit_Kind::array_multiplier:
+      return "array_multiplier"_sv;
+    case Circuit_Kind::random_dag:
+      return "random_dag"_sv;
+    case Circuit_Kind::counter_chain:
+      return "counter_chain"_sv;
+    case Circuit_Kind::lfsr_chain:
+      return "lfsr_chain"_sv;
+    case Circuit_Kind::e_count:
+      ANTON_UNREACHABLE("count is not a valid enumeration");
+    }
+    return "invalid"_sv;
+  }
+
+  i64 generate_circuit(Scene& scene, Circuit_Kind const kind,
+                       i64 const gate_count, u64 const seed)
+  {
+    i64 const rows = math::max(
+      static_cast<i64>(1),
+      static_cast<i64>(math::sqrt(static_cast<f32>(gate_count))));
+    Circuit_Builder builder{scene, rows};
+    if(kind == Circuit_Kind::random_dag) {
+      generate_random_dag(builder, gate_count, seed);
+      return builder.count;
+    }
+
+    // Replicate the block while the count gets closer to the requested one.
+    generate_block(builder, kind);
+    i64 const block_size = builder.count;
+    while(builder.count + block_size / 2 < gate_count) {
+      generate_block(builder, kind);
+    }
+    return builder.count;
+  }
+} // namespace nebula
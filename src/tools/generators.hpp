@@ -0,0 +1,46 @@
+#pragma once
+
+#include <anton/string_view.hpp>
+
+#include <core/types.hpp>
+
+namespace nebula {
+  struct Scene;
+
+  /**
+   * @brief Enumeration of the synthetic circuits.
+   */
+  enum struct Circuit_Kind {
+    // 64-bit ripple-carry adders.
+    ripple_carry_adder,
+    // 64-bit Kogge-Stone carry-lookahead adders.
+    carry_lookahead_adder,
+    // 16x16-bit array multipliers.
+    array_multiplier,
+    // Random directed acyclic graph of two input gates.
+    random_dag,
+    // 32-bit counters incremented by an e_clock gate.
+    counter_chain,
+    // 32-bit linear feedback shift registers.
+    lfsr_chain,
+    e_count,
+  };
+
+  [[nodiscard]] String_View get_circuit_name(Circuit_Kind kind);
+
+  /**
+   * @brief Generates a synthetic circuit into a scene.
+   *
+   * Circuits built of fixed-width blocks are replicated until the number of
+   * gates is approximately the requested count. Gates are laid out on a square
+   * grid.
+   *
+   * @param scene The scene to add the gates to.
+   * @param kind The kind of circuit.
+   * @param gate_count The approximate number of gates to generate.
+   * @param seed Seed of the random number generator used by random circuits.
+   * @return The number of generated gates.
+   */
+  i64 generate_circuit(Scene& scene, Circuit_Kind kind, i64 gate_count,
+                       u64 seed);
+} // namespace nebula
@@ -0,0 +1,961 @@
+#include <anton/filesystem.hpp>
+#include <anton/flat_hash_map.hpp>
+#include <anton/format.hpp>
+#include <anton/math/math.hpp>
+#include <anton/stdio.hpp>
+
+#include <core/time.hpp>
+#include <core/types.hpp>
+#include <evaluator/batch.hpp>
+#include <evaluator/evaluator.hpp>
+#include <importer/importer.hpp>
+#include <logging/logging.hpp>
+#include <simulation/checkpoint.hpp>
+#include <simulation/coverage.hpp>
+#include <simulation/optimize.hpp>
+#include <simulation/stimulus.hpp>
+#include <simulation/vcd.hpp>
+#include <ui/scene.hpp>
+
+// nebula-sim
+//
+// Headless simulator for batch regression runs. Loads an imported design,
+// applies an optional stimulus file, evaluates a number of cycles and dumps
+// the values of the outputs of the design. Optionally records the history of
+// the nets to a VCD file. Long runs may be checkpointed and resumed from a
+// checkpoint. The inputs may instead be driven by generated or loaded test
+// vectors, one per cycle or, for combinational designs, batch_width at a
+// time. Designs with several clocks may be evaluated from edge to edge of
+// their clocks instead of cycle by cycle. The timed mode evaluates the gates
+// with propagation delays tick by tick and reports glitches.
+//
+
+using namespace nebula;
+
+struct Options {
+  String design;
+  String stimulus;
+  String output;
+  String vcd;
+  // Names of the nets recorded to the VCD file. Empty records all nets.
+  Array<String> vcd_nets;
+  String checkpoint;
+  // Number of cycles between checkpoints. 0 saves a checkpoint only after
+  // the last cycle.
+  i64 checkpoint_interval = 0;
+  String restore;
+  String coverage;
+  i64 cycles = 1000;
+  bool trace = false;
+  bool four_valued = false;
+  bool levelized = false;
+  bool fuse = false;
+  bool optimize = false;
+  // Sources of test vectors. At most one is used.
+  bool exhaustive = false;
+  i64 random_count = 0;
+  u64 seed = 1;
+  String vectors;
+  bool batch = false;
+  // Whether --cycles has been given. The number of vectors is the default
+  // otherwise.
+  bool cycles_given = false;
+  // Periods of the clocks as '<net>=<period>[:<phase>]'.
+  Array<String> clocks;
+  bool clock_domains = false;
+  bool timed = false;
+  // Delays of the gate kinds as '<kind>=<ticks>'.
+  Array<String> delays;
+  i64 glitch_width = 0;
+};
+
+// Destination of the dump. Writes to the standard output when no file has
+// been opened.
+struct Dump {
+  fs::Output_File_Stream file;
+
+  void write(String_View const text)
+  {
+    if(file.is_open()) {
+      file.write(text);
+    } else {
+      anton::print(text);
+    }
+  }
+};
+
+static void print_usage()
+{
+  anton::print(
+    "usage: nebula-sim <design> [options]\n"
+    "  <design>             BLIF (.blif) or structural Verilog (.v) netlist\n"
+    "  --stimulus <file>    apply '<cycle> <net> <0|1>' lines to the inputs\n"
+    "  --cycles <n>         number of cycles to evaluate (default 1000)\n"
+    "  --output <file>      write the dump to a file instead of stdout\n"
+    "  --trace              dump the outputs after every cycle\n"
+    "  --four-valued        start from unknown state and propagate X\n"
+    "  --levelized          settle combinational logic within every cycle\n"
+    "  --fuse               evaluate combinational cones as lookup tables,\n"
+    "                       implies --levelized\n"
+    "  --optimize           fold constants, merge duplicated gates and remove\n"
+    "                       unobserved gates before simulating, implies\n"
+    "                       --levelized\n"
+    "  --vcd <file>         record the nets to a VCD file\n"
+    "  --vcd-nets <n,...>   record only the named nets (default all)\n"
+    "  --checkpoint <file>  save the simulation state after the last cycle\n"
+    "  --checkpoint-interval <n>\n"
+    "                       also save the state every n cycles\n"
+    "  --restore <file>     continue from a saved simulation state\n"
+    "  --coverage <file>    write the toggle counts of all nets as CSV, or as\n"
+    "                       JSON if the name ends with .json\n"
+    "  --exhaustive         apply all combinations of the inputs in Gray code\n"
+    "                       order, one per cycle, implies --levelized\n"
+    "  --random <n>         apply n random vectors, implies --levelized\n"
+    "  --seed <n>           seed of the random vectors (default 1)\n"
+    "  --vectors <file>     apply the vectors of a CSV file and compare the\n"
+    "                       outputs with the expected values it holds,\n"
+    "                       implies --levelized\n"
+    "  --batch              evaluate 64 vectors at once, only for\n"
+    "                       combinational designs\n"
+    "  --clock <net>=<period>[:<phase>]\n"
+    "                       toggle the clock every half period ticks from\n"
+    "                       the phase on (default period 2, phase 0)\n"
+    "  --clock-domains      advance from edge to edge of the clocks and\n"
+    "                       evaluate only the logic of the toggling clocks,\n"
+    "                       --cycles counts edges, implies --levelized\n"
+    "  --timed              evaluate with gate delays, one tick per cycle\n"
+    "  --delay <kind>=<n>   delay of the gates of a kind in ticks, e.g. and=2\n"
+    "                       (default 1), implies --timed\n"
+    "  --glitch-width <n>   report pulses narrower than n ticks, implies\n"
+    "                       --timed\n"_sv);
+}
+
+[[nodiscard]] static Expected<i64, Error> parse_count(String_View const text)
+{
+  i64 value = 0;
+  char const* const end = text.data() + text.size_bytes();
+  for(char const* i = text.data(); i != end; ++i) {
+    if(*i < '0' || *i > '9') {
+      return {expected_error, format("'{}' is not a count"_sv, text)};
+    }
+    value = value * 10 + (*i - '0');
+  }
+  return {expected_value, value};
+}
+
+[[nodiscard]] static Expected<Options, Error> parse_options(int const argc,
+                                                            char** const argv)
+{
+  Options options;
+  for(int i = 1; i < argc; ++i) {
+    String_View const argument{argv[i]};
+    bool const has_value = i + 1 < argc;
+    if(argument == "--trace"_sv) {
+      options.trace = true;
+    } else if(argument == "--four-valued"_sv) {
+      options.four_valued = true;
+    } else if(argument == "--levelized"_sv) {
+      options.levelized = true;
+    } else if(argument == "--fuse"_sv) {
+      options.levelized = true;
+      options.fuse = true;
+    } else if(argument == "--optimize"_sv) {
+      options.levelized = true;
+      options.optimize = true;
+    } else if(argument == "--exhaustive"_sv) {
+      options.levelized = true;
+      options.exhaustive = true;
+    } else if(argument == "--batch"_sv) {
+      options.batch = true;
+    } else if(argument == "--clock-domains"_sv) {
+      options.levelized = true;
+      options.clock_domains = true;
+    } else if(argument == "--timed"_sv) {
+      options.timed = true;
+    } else if(argument == "--delay"_sv && has_value) {
+      options.timed = true;
+      options.delays.push_back(String(argv[++i]));
+    } else if(argument == "--glitch-width"_sv && has_value) {
+      Expected<i64, Error> width = parse_count(String_View{argv[++i]});
+      if(!width) {
+        return {expected_error, ANTON_MOV(width.error())};
+      }
+      options.timed = true;
+      options.glitch_width = width.value();
+    } else if(argument == "--clock"_sv && has_value) {
+      options.clocks.push_back(String(argv[++i]));
+    } else if(argument == "--random"_sv && has_value) {
+      Expected<i64, Error> count = parse_count(String_View{argv[++i]});
+      if(!count) {
+        return {expected_error, ANTON_MOV(count.error())};
+      }
+      options.levelized = true;
+      options.random_count = count.value();
+    } else if(argument == "--seed"_sv && has_value) {
+      Expected<i64, Error> seed = parse_count(String_View{argv[++i]});
+      if(!seed) {
+        return {expected_error, ANTON_MOV(seed.error())};
+      }
+      options.seed = seed.value();
+    } else if(argument == "--vectors"_sv && has_value) {
+      options.levelized = true;
+      options.vectors = String(argv[++i]);
+    } else if(argument == "--stimulus"_sv && has_value) {
+      options.stimulus = String(argv[++i]);
+    } else if(argument == "--output"_sv && has_value) {
+      options.output = String(argv[++i]);
+    } else if(argument == "--vcd"_sv && has_value) {
+      options.vcd = String(argv[++i]);
+    } else if(argument == "--vcd-nets"_sv && has_value) {
+      String_View const list{argv[++i]};
+      char const* begin = list.data();
+      char const* const end = list.data() + list.size_bytes();
+      for(char const* c = begin; c != end; ++c) {
+        if(*c == ',') {
+          options.vcd_nets.push_back(String(begin, c));
+          begin = c + 1;
+        }
+      }
+      options.vcd_nets.push_back(String(begin, end));
+    } else if(argument == "--checkpoint"_sv && has_value) {
+      options.checkpoint = String(argv[++i]);
+    } else if(argument == "--checkpoint-interval"_sv && has_value) {
+      Expected<i64, Error> interval = parse_count(String_View{argv[++i]});
+      if(!interval) {
+        return {expected_error, ANTON_MOV(interval.error())};
+      }
+      options.checkpoint_interval = interval.value();
+    } else if(argument == "--restore"_sv && has_value) {
+      options.restore = String(argv[++i]);
+    } else if(argument == "--coverage"_sv && has_value) {
+      options.coverage = String(argv[++i]);
+    } else if(argument == "--cycles"_sv && has_value) {
+      Expected<i64, Error> cycles = parse_count(String_View{argv[++i]});
+      if(!cycles) {
+        return {expected_error, ANTON_MOV(cycles.error())};
+      }
+      options.cycles = cycles.value();
+      options.cycles_given = true;
+    } else if(options.design.size_bytes() == 0 && argv[i][0] != '-') {
+      options.design = String(argument);
+    } else {
+      return {expected_error, format("unexpected argument '{}'"_sv, argument)};
+    }
+  }
+
+  if(options.design.size_bytes() == 0) {
+    return {expected_error, Error("no design given")};
+  }
+
+  if(options.checkpoint_interval > 0 && options.checkpoint.size_bytes() == 0) {
+    return {expected_error, Error("--checkpoint-interval needs --checkpoint")};
+  }
+
+  // The passes fold unconnected inputs to 0, which they read as Z in the
+  // four-valued logic.
+  if(options.optimize && options.four_valued) {
+    return {expected_error, Error("--optimize needs two-valued logic")};
+  }
+
+  if(options.clock_domains && options.batch) {
+    return {expected_error,
+            Error("--clock-domains does not support --batch")};
+  }
+
+  i64 const sources = static_cast<i64>(options.exhaustive) +
+                      static_cast<i64>(options.random_count > 0) +
+                      static_cast<i64>(options.vectors.size_bytes() > 0);
+  if(sources > 1) {
+    return {expected_error,
+            Error("--exhaustive, --random and --vectors are exclusive")};
+  }
+
+  // A tick is far too short for the logic to settle between test vectors.
+  // Checkpoints do not hold the pending events of the timed evaluation.
+  if(options.timed) {
+    bool const checkpointed = options.checkpoint.size_bytes() > 0 ||
+                              options.restore.size_bytes() > 0;
+    if(checkpointed || options.batch || options.clock_domains ||
+       options.fuse || sources > 0) {
+      return {expected_error,
+              Error("--timed does not support --checkpoint, --restore, "
+                    "--batch, --clock-domains, --fuse or test vectors")};
+    }
+  }
+
+  // The batch evaluation replaces the cycles, hence everything observing
+  // them is unavailable.
+  if(options.batch) {
+    bool const observed =
+      options.stimulus.size_bytes() > 0 || options.vcd.size_bytes() > 0 ||
+      options.checkpoint.size_bytes() > 0 ||
+      options.restore.size_bytes() > 0 || options.coverage.size_bytes() > 0;
+    if(sources == 0) {
+      return {expected_error, Error("--batch needs test vectors")};
+    } else if(observed) {
+      return {expected_error,
+              Error("--batch does not support --stimulus, --vcd, "
+                    "--checkpoint, --restore or --coverage")};
+    }
+  }
+  return {expected_value, ANTON_MOV(options)};
+}
+
+// collect_outputs
+//
+// Gates whose outputs are not connected to anything are the outputs of the
+// design.
+//
+static void collect_outputs(Scene& scene, Array<Gate*>& outputs)
+{
+  for(Gate& gate: scene.gates) {
+    if(gate.kind == Gate_Kind::e_input || gate.kind == Gate_Kind::e_clock) {
+      continue;
+    }
+
+    bool connected = false;
+    for(Port* const port: gate.out_ports) {
+      connected |= port->connections.size() > 0;
+    }
+    if(!connected) {
+      outputs.push_back(&gate);
+    }
+  }
+}
+
+[[nodiscard]] static String get_output_name(Gate const& gate)
+{
+  if(gate.name.size_bytes() > 0) {
+    return gate.name;
+  } else {
+    return format("g{}"_sv, gate.id);
+  }
+}
+
+// collect_recorded_gates
+//
+// Look up the gates driving the named nets. All gates are recorded when no
+// names are given.
+//
+[[nodiscard]] static Expected<void, Error>
+collect_recorded_gates(Scene& scene, Slice<String const> const names,
+                       Array<Gate*>& gates)
+{
+  if(names.size() == 0) {
+    for(Gate& gate: scene.gates) {
+      gates.push_back(&gate);
+    }
+    return expected_value;
+  }
+
+  Flat_Hash_Map<String, Gate*> named;
+  for(Gate& gate: scene.gates) {
+    if(gate.name.size_bytes() > 0) {
+      named.emplace(gate.name, &gate);
+    }
+  }
+
+  for(String const& name: names) {
+    auto iter = named.find(name);
+    if(iter == named.end()) {
+      return {expected_error, format("no net named '{}'"_sv, name)};
+    }
+    gates.push_back(iter->value);
+  }
+  return expected_value;
+}
+
+// apply_clocks
+//
+// Set the periods and phases of the clocks named by '<net>=<period>' or
+// '<net>=<period>:<phase>'.
+//
+[[nodiscard]] static Expected<void, Error>
+apply_clocks(Scene& scene, Slice<String const> const clocks)
+{
+  for(String const& clock: clocks) {
+    char const* const begin = clock.data();
+    char const* const end = begin + clock.size_bytes();
+    char const* equals = begin;
+    while(equals != end && *equals != '=') {
+      ++equals;
+    }
+    char const* colon = equals;
+    while(colon != end && *colon != ':') {
+      ++colon;
+    }
+    if(equals == end) {
+      return {expected_error,
+              format("'{}' is not <net>=<period>[:<phase>]"_sv, clock)};
+    }
+
+    Expected<i64, Error> period = parse_count(String_View{equals + 1, colon});
+    if(!period) {
+      return {expected_error, ANTON_MOV(period.error())};
+    }
+    i64 phase = 0;
+    if(colon != end) {
+      Expected<i64, Error> parsed = parse_count(String_View{colon + 1, end});
+      if(!parsed) {
+        return {expected_error, ANTON_MOV(parsed.error())};
+      }
+      phase = parsed.value();
+    }
+    if(period.value() < 2) {
+      return {expected_error,
+              format("the period of '{}' is shorter than 2 ticks"_sv, clock)};
+    }
+
+    String_View const name{begin, equals};
+    Gate* found = nullptr;
+    for(Gate& gate: scene.gates) {
+      if(gate.kind == Gate_Kind::e_clock && gate.name == name) {
+        found = &gate;
+      }
+    }
+    if(found == nullptr) {
+      return {expected_error, format("no clock named '{}'"_sv, name)};
+    }
+    found->clock_period = static_cast<u32>(period.value());
+    found->clock_phase = static_cast<u32>(phase);
+  }
+  return expected_value;
+}
+
+// apply_delays
+//
+// Set the delays of the gate kinds named by '<kind>=<ticks>'.
+//
+[[nodiscard]] static Expected<void, Error>
+apply_delays(Timed_Schedule& timing, Slice<String const> const delays)
+{
+  struct Kind_Name {
+    String_View name;
+    Gate_Kind kind;
+  };
+
+  static Kind_Name const kinds[] = {
+    {"and"_sv, Gate_Kind::e_and},
+    {"or"_sv, Gate_Kind::e_or},
+    {"xor"_sv, Gate_Kind::e_xor},
+    {"nand"_sv, Gate_Kind::e_nand},
+    {"nor"_sv, Gate_Kind::e_nor},
+    {"xnor"_sv, Gate_Kind::e_xnor},
+    {"not"_sv, Gate_Kind::e_not},
+    {"module"_sv, Gate_Kind::e_module},
+    {"dff"_sv, Gate_Kind::e_dff},
+    {"latch"_sv, Gate_Kind::e_sr_latch},
+    {"register"_sv, Gate_Kind::e_register},
+    {"ram"_sv, Gate_Kind::e_ram},
+    {"rom"_sv, Gate_Kind::e_rom},
+    {"lut"_sv, Gate_Kind::e_lut},
+  };
+
+  for(String const& delay: delays) {
+    char const* const begin = delay.data();
+    char const* const end = begin + delay.size_bytes();
+    char const* equals = begin;
+    while(equals != end && *equals != '=') {
+      ++equals;
+    }
+    if(equals == end) {
+      return {expected_error,
+              format("'{}' is not <kind>=<ticks>"_sv, delay)};
+    }
+
+    Expected<i64, Error> ticks = parse_count(String_View{equals + 1, end});
+    if(!ticks) {
+      return {expected_error, ANTON_MOV(ticks.error())};
+    }
+    if(ticks.value() < 1) {
+      return {expected_error,
+              format("the delay of '{}' is shorter than 1 tick"_sv, delay)};
+    }
+
+    String_View const name{begin, equals};
+    Kind_Name const* found = nullptr;
+    for(Kind_Name const& kind: kinds) {
+      if(kind.name == name) {
+        found = &kind;
+      }
+    }
+    if(found == nullptr) {
+      return {expected_error, format("no gate kind named '{}'"_sv, name)};
+    }
+    timing.kind_delays[static_cast<i64>(found->kind)] =
+      static_cast<u32>(ticks.value());
+  }
+  return expected_value;
+}
+
+[[nodiscard]] static char get_value_char(Gate const& gate)
+{
+  if(gate.evaluation.unknown) {
+    return 'x';
+  }
+  return gate.evaluation.value ? '1' : '0';
+}
+
+static void dump_trace_line(Dump& dump, i64 const cycle,
+                            Slice<Gate* const> const outputs,
+                            Array<char>& line)
+{
+  line.clear();
+  for(Gate const* const gate: outputs) {
+    line.push_back(get_value_char(*gate));
+  }
+  line.push_back('\n');
+  dump.write(format("{} "_sv, cycle));
+  dump.write(String_View{line.data(), line.size()});
+}
+
+// report_glitches
+//
+// Log the glitches detected since the last call, at most glitch_report_limit
+// of them in total.
+//
+static void report_glitches(Timed_Schedule& timing)
+{
+  constexpr i64 glitch_report_limit = 100;
+  i64 const first = timing.glitch_count - timing.glitches.size();
+  for(i64 i = 0; i < timing.glitches.size(); ++i) {
+    Glitch const& glitch = timing.glitches[i];
+    if(first + i < glitch_report_limit) {
+      LOG_WARNING("'{}' pulsed for {} ticks at {}",
+                  get_output_name(*glitch.gate), glitch.width, glitch.time);
+    } else if(first + i == glitch_report_limit) {
+      LOG_WARNING("further glitches are only counted");
+    }
+  }
+  timing.glitches.clear();
+}
+
+[[nodiscard]] static Expected<Test_Vectors, Error>
+load_test_vectors(Scene& scene, Options const& options)
+{
+  if(options.vectors.size_bytes() > 0) {
+    return load_vectors(scene, options.vectors);
+  }
+
+  Array<Gate*> inputs;
+  for(Gate& gate: scene.gates) {
+    if(gate.kind == Gate_Kind::e_input) {
+      inputs.push_back(&gate);
+    }
+  }
+
+  if(options.exhaustive) {
+    return make_exhaustive_vectors(inputs);
+  } else {
+    return {expected_value,
+            make_random_vectors(inputs, options.random_count, options.seed)};
+  }
+}
+
+// report_check
+//
+// Returns:
+// The exit code, 1 if any vector mismatched the expected outputs.
+//
+[[nodiscard]] static int report_check(Test_Vectors const& vectors,
+                                      Vector_Check const& check)
+{
+  if(vectors.outputs.size() == 0) {
+    return 0;
+  }
+
+  if(check.mismatches == 0) {
+    LOG_INFO("all {} vectors matched the expected outputs", check.vectors);
+    return 0;
+  }
+
+  LOG_ERROR("{} of {} vectors mismatched, first at vector {}: '{}' should "
+            "be {}",
+            check.mismatches, check.vectors, check.first_vector,
+            get_output_name(*check.first_output),
+            static_cast<i32>(check.first_expected));
+  return 1;
+}
+
+// run_batch
+//
+// Evaluate the vectors batch_width at a time instead of one per cycle. The
+// four-valued logic keeps the unknown planes of the nets next to the values.
+//
+[[nodiscard]] static int run_batch(Scene& scene, Test_Vectors const& vectors,
+                                   Slice<Gate* const> const outputs,
+                                   bool const four_valued, bool const trace,
+                                   Dump& dump)
+{
+  Expected<Batch_Program, Error> compiled =
+    compile_batch(scene, vectors.inputs);
+  if(!compiled) {
+    LOG_ERROR("{}", compiled.error());
+    return 1;
+  }
+
+  Batch_Program const& program = compiled.value();
+  Array<u64> slots;
+  slots.resize(program.slot_count);
+  // The inputs are known, the other slots are overwritten.
+  Array<u64> unknowns;
+  if(four_valued) {
+    unknowns.resize(program.slot_count, 0);
+  }
+  Array<u32> output_slots;
+  for(Gate const* const gate: outputs) {
+    output_slots.push_back(get_batch_slot(program, gate));
+  }
+
+  Vector_Check check;
+  Array<char> line;
+  f64 const start = get_time();
+  for(i64 first = 0; first < vectors.count; first += batch_width) {
+    fill_batch_inputs(vectors, program, first, slots);
+    if(four_valued) {
+      evaluate_batch_logic(program, slots, unknowns);
+    } else {
+      evaluate_batch(program, slots);
+    }
+    check_batch(vectors, program, first, slots, unknowns, check);
+    if(!trace) {
+      continue;
+    }
+
+    i64 const size = math::min(batch_width, vectors.count - first);
+    for(i64 bit = 0; bit < size; ++bit) {
+      line.clear();
+      for(u32 const slot: output_slots) {
+        if(four_valued && (unknowns[slot] >> bit) & 1) {
+          line.push_back('x');
+        } else {
+          line.push_back((slots[slot] >> bit) & 1 ? '1' : '0');
+        }
+      }
+      line.push_back('\n');
+      dump.write(format("{} "_sv, first + bit));
+      dump.write(String_View{line.data(), line.size()});
+    }
+  }
+  f64 const seconds = get_time() - start;
+  LOG_INFO("{} vectors of {} gates in {} us", vectors.count,
+           scene.gates.size(), static_cast<i64>(seconds * 1000000.0));
+  return report_check(vectors, check);
+}
+
+int main(int argc, char* argv[])
+{
+  Expected<Options, Error> parsed = parse_options(argc, argv);
+  if(!parsed) {
+    LOG_ERROR("{}", parsed.error());
+    print_usage();
+    return 1;
+  }
+
+  Options const& options = parsed.value();
+  Scene scene;
+  Expected<Import_Statistics, Error> imported =
+    import_netlist(scene, options.design, Vec2{0.6f, 0.5f});
+  if(!imported) {
+    LOG_ERROR("import failed: {}", imported.error());
+    return 1;
+  }
+
+  Expected<void, Error> clocked = apply_clocks(scene, options.clocks);
+  if(!clocked) {
+    LOG_ERROR("{}", clocked.error());
+    return 1;
+  }
+
+  if(options.clock_domains) {
+    bool has_clock = false;
+    for(Gate const& gate: scene.gates) {
+      has_clock = has_clock || gate.kind == Gate_Kind::e_clock;
+    }
+    if(!has_clock) {
+      LOG_ERROR("--clock-domains needs a design with clocks");
+      return 1;
+    }
+  }
+
+  // The outputs and the recorded nets are collected before the netlist is
+  // optimized since they are the gates the optimization must preserve.
+  Array<Gate*> outputs;
+  collect_outputs(scene, outputs);
+  Array<Gate*> recorded;
+  if(options.vcd.size_bytes() > 0) {
+    Expected<void, Error> collected =
+      collect_recorded_gates(scene, options.vcd_nets, recorded);
+    if(!collected) {
+      LOG_ERROR("{}", collected.error());
+      return 1;
+    }
+  }
+
+  // Outputs compared with expected values must be preserved as well.
+  Test_Vectors vectors;
+  bool const driven = options.exhaustive || options.random_count > 0 ||
+                      options.vectors.size_bytes() > 0;
+  if(driven) {
+    Expected<Test_Vectors, Error> loaded = load_test_vectors(scene, options);
+    if(!loaded) {
+      LOG_ERROR("vectors failed: {}", loaded.error());
+      return 1;
+    }
+    vectors = ANTON_MOV(loaded.value());
+  }
+  i64 const cycle_count =
+    driven && !options.cycles_given ? vectors.count : options.cycles;
+
+  if(options.optimize) {
+    Array<Gate*> observed;
+    for(Gate* const gate: outputs) {
+      observed.push_back(gate);
+    }
+    for(Gate* const gate: recorded) {
+      observed.push_back(gate);
+    }
+    for(Gate* const gate: vectors.outputs) {
+      observed.push_back(gate);
+    }
+
+    Optimization_Statistics const statistics =
+      optimize_netlist(scene, observed);
+    i64 const removed =
+      statistics.folded + statistics.merged + statistics.dead;
+    LOG_INFO("optimization removed {} of {} gates: {} folded, {} merged, "
+             "{} dead",
+             removed, statistics.gate_count, statistics.folded,
+             statistics.merged, statistics.dead);
+    // The cost of a cycle is roughly proportional to the number of gates.
+    if(statistics.remaining > 0) {
+      i64 const speedup =
+        statistics.gate_count * 100 / statistics.remaining - 100;
+      LOG_INFO("{} gate evaluations per cycle instead of {}, an estimated "
+               "{}% speedup",
+               statistics.remaining, statistics.gate_count, speedup);
+    }
+  }
+
+  // The cycles continue from the restored cycle, hence the stimulus applies
+  // to the same cycles as in the run that saved the checkpoint.
+  i64 first_cycle = 0;
+  Checkpoint_Time restored_time;
+  if(options.four_valued) {
+    reset_unknown(scene.gates);
+  }
+  if(options.restore.size_bytes() > 0) {
+    Expected<Checkpoint_Time, Error> restored =
+      restore_checkpoint(scene, options.restore);
+    if(!restored) {
+      LOG_ERROR("restore failed: {}", restored.error());
+      return 1;
+    }
+    restored_time = restored.value();
+    first_cycle = restored_time.cycle + 1;
+    // Checkpoints saved in the four-valued logic may hold unknown bits.
+    if(!options.four_valued) {
+      clear_unknown(scene.gates);
+    }
+  }
+
+  Stimulus stimulus;
+  if(options.stimulus.size_bytes() > 0) {
+    Expected<Stimulus, Error> loaded = load_stimulus(scene, options.stimulus);
+    if(!loaded) {
+      LOG_ERROR("stimulus failed: {}", loaded.error());
+      return 1;
+    }
+    stimulus = ANTON_MOV(loaded.value());
+  }
+
+  Dump dump;
+  if(options.output.size_bytes() > 0) {
+    if(!dump.file.open(options.output)) {
+      LOG_ERROR("could not open '{}'", options.output);
+      return 1;
+    }
+  }
+
+  if(options.trace) {
+    bool const timed = options.clock_domains || options.timed;
+    dump.write(timed ? "# time"_sv : "# cycle"_sv);
+    for(Gate const* const gate: outputs) {
+      dump.write(format(" {}"_sv, get_output_name(*gate)));
+    }
+    dump.write("\n"_sv);
+  }
+
+  if(options.batch) {
+    return run_batch(scene, vectors, outputs, options.four_valued,
+                     options.trace, dump);
+  }
+
+  VCD_Recorder* recorder = nullptr;
+  if(options.vcd.size_bytes() > 0) {
+    Expected<VCD_Recorder*, Error> started =
+      start_vcd_recording(options.vcd, recorded);
+    if(!started) {
+      LOG_ERROR("{}", started.error());
+      return 1;
+    }
+    recorder = started.value();
+  }
+
+  Array<char> line;
+  Array<Gate*> changed;
+  Toggle_Counters toggles;
+  Toggle_Counters* const counters =
+    options.coverage.size_bytes() > 0 ? &toggles : nullptr;
+  Checkpoint_Job* checkpoint = nullptr;
+  Logic_Mode const mode = options.four_valued ? Logic_Mode::e_four_valued
+                                              : Logic_Mode::e_two_valued;
+  Evaluation_Schedule schedule;
+  schedule.fuse = options.fuse;
+  Evaluation_Schedule* const order = options.levelized ? &schedule : nullptr;
+  Clock_Schedule clocks;
+  Timed_Schedule timing;
+  timing.glitch_width = options.glitch_width;
+  Expected<void, Error> delayed = apply_delays(timing, options.delays);
+  if(!delayed) {
+    LOG_ERROR("{}", delayed.error());
+    return 1;
+  }
+  if(options.restore.size_bytes() > 0) {
+    restart_clock_schedule(clocks, restored_time.clock_time);
+    restart_timed_schedule(timing, restored_time.timed_time);
+  }
+  Vector_Check check;
+  i64 const last_cycle = first_cycle + cycle_count - 1;
+  f64 const start = get_time();
+  for(i64 cycle = first_cycle; cycle <= last_cycle; ++cycle) {
+    apply_stimulus(stimulus, cycle);
+    i64 const vector = cycle - first_cycle;
+    if(vector < vectors.count) {
+      apply_vector(vectors, vector);
+    }
+    // Edges are recorded and traced at their time rather than their cycle.
+    Array<Gate*>* const changes = recorder != nullptr ? &changed : nullptr;
+    changed.clear();
+    i64 time = cycle;
+    if(options.clock_domains) {
+      time = evaluate_next_edge(scene.gates, clocks, schedule, changes,
+                                counters, mode);
+    } else if(options.timed) {
+      evaluate_until(scene.gates, timing, cycle, changes, counters, mode);
+      report_glitches(timing);
+    } else {
+      evaluate(scene.gates, changes, counters, mode, order);
+    }
+    if(recorder != nullptr) {
+      record_vcd(recorder, time, changed);
+    }
+    if(vector < vectors.count && vectors.outputs.size() > 0) {
+      check_vector(vectors, vector, check);
+    }
+    if(options.trace) {
+      dump_trace_line(dump, time, outputs, line);
+    }
+
+    // A checkpoint is skipped while the previous one is still being written
+    // rather than stalling the simulation.
+    if(options.checkpoint_interval > 0 &&
+       (cycle - first_cycle + 1) % options.checkpoint_interval == 0 &&
+       cycle != last_cycle) {
+      if(checkpoint != nullptr && is_checkpoint_finished(checkpoint)) {
+        Expected<void, Error> result = finish_checkpoint(checkpoint);
+        checkpoint = nullptr;
+        if(!result) {
+          LOG_ERROR("checkpoint failed: {}", result.error());
+        }
+      }
+
+      if(checkpoint == nullptr) {
+        checkpoint = start_checkpoint(
+          scene, Checkpoint_Time{cycle, clocks.time, timing.time},
+          options.checkpoint);
+      }
+    }
+  }
+  f64 const seconds = get_time() - start;
+  if(schedule.loop_count > 0) {
+    LOG_WARNING("{} gates in {} combinational loops are evaluated until "
+                "they settle",
+                schedule.loop_count, schedule.loops.size());
+  }
+  if(schedule.unsettled_count > 0) {
+    LOG_WARNING("{} evaluations of combinational loops did not settle "
+                "within {} passes",
+                schedule.unsettled_count, loop_pass_limit);
+  }
+  if(schedule.fused && !options.clock_domains) {
+    LOG_INFO("{} gates evaluated as {} lookup tables",
+             schedule.members.size(), schedule.nodes.size());
+  }
+  if(options.timed) {
+    f64 const events_per_second =
+      seconds > 0.0 ? static_cast<f64>(timing.events) / seconds : 0.0;
+    LOG_INFO("{} events, {} gate evaluations, {} events/s", timing.events,
+             timing.evaluated, static_cast<i64>(events_per_second));
+    if(options.glitch_width > 0) {
+      LOG_INFO("{} pulses narrower than {} ticks", timing.glitch_count,
+               options.glitch_width);
+    }
+  }
+  if(options.clock_domains && clocks.evaluations > 0) {
+    LOG_INFO("{} clocks, time {} reached, {} of {} gates evaluated per edge "
+             "on average",
+             clocks.clocks.size(), clocks.time,
+             clocks.evaluated / clocks.evaluations, scene.gates.size());
+  }
+
+  if(checkpoint != nullptr) {
+    Expected<void, Error> result = finish_checkpoint(checkpoint);
+    if(!result) {
+      LOG_ERROR("checkpoint failed: {}", result.error());
+    }
+  }
+
+  if(options.checkpoint.size_bytes() > 0 && cycle_count > 0) {
+    Expected<void, Error> result = save_checkpoint(
+      scene, Checkpoint_Time{last_cycle, clocks.time, timing.time},
+      options.checkpoint);
+    if(!result) {
+      LOG_ERROR("checkpoint failed: {}", result.error());
+      return 1;
+    }
+  }
+
+  if(recorder != nullptr) {
+    stop_vcd_recording(recorder);
+  }
+
+  if(counters != nullptr) {
+    Expected<void, Error> result =
+      export_coverage(toggles, scene, options.coverage);
+    if(!result) {
+      LOG_ERROR("{}", result.error());
+      return 1;
+    }
+
+    Coverage_Summary const summary = summarize_coverage(toggles);
+    LOG_INFO("toggle coverage: {} of {} nets rose and fell, {} never toggled",
+             summary.covered, summary.nets, summary.untoggled);
+  }
+
+  for(Gate const* const gate: outputs) {
+    char const value = get_value_char(*gate);
+    dump.write(format("{} {}\n"_sv, get_output_name(*gate),
+                      String_View{&value, 1}));
+  }
+
+  i64 const gate_count = scene.gates.size();
+  f64 const cycles_per_second =
+    seconds > 0.0 ? static_cast<f64>(cycle_count) / seconds : 0.0;
+  LOG_INFO("{} gates, {} cycles in {} ms", gate_count, cycle_count,
+           static_cast<i64>(seconds * 1000.0));
+  LOG_INFO("{} cycles/s, {} gate-evals/s",
+           static_cast<i64>(cycles_per_second),
+           static_cast<i64>(cycles_per_second * static_cast<f64>(gate_count)));
+  return report_check(vectors, check);
+}
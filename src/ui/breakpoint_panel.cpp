@@ -0,0 +1,66 @@
+#include <ui/breakpoint_panel.hpp>
+
+#include <anton/format.hpp>
+
+#include <ui/scene.hpp>
+
+#include <imgui.h>
+
+namespace nebula {
+  [[nodiscard]] static char const*
+  breakpoint_kind_to_string(Breakpoint_Kind const kind)
+  {
+    switch(kind) {
+    case Breakpoint_Kind::e_rise:
+      return "Rise";
+    case Breakpoint_Kind::e_fall:
+      return "Fall";
+    case Breakpoint_Kind::e_change:
+      return "Change";
+    case Breakpoint_Kind::e_condition:
+      return "Condition";
+    }
+    return "INVALID";
+  }
+
+  void display_breakpoints(Breakpoint_Panel& panel, Breakpoints& breakpoints,
+                           Scene& scene, u64& highlighted_gate)
+  {
+    char const* const kinds[] = {"Rise", "Fall", "Change", "Condition"};
+    ImGui::Combo("Break on", &panel.kind, kinds, 4);
+    ImGui::InputText("Net or condition", panel.text, sizeof(panel.text));
+    if(ImGui::Button("Add breakpoint")) {
+      Expected<void, Error> result =
+        add_breakpoint(breakpoints, scene,
+                       static_cast<Breakpoint_Kind>(panel.kind), panel.text);
+      if(result) {
+        panel.status = String();
+      } else {
+        panel.status = ANTON_MOV(result.error());
+      }
+    }
+
+    if(panel.status.size_bytes() > 0) {
+      ImGui::TextWrapped("%s", panel.status.data());
+    }
+
+    for(i64 i = 0; i < breakpoints.breakpoints.size(); ++i) {
+      Breakpoint& breakpoint = breakpoints.breakpoints[i];
+      ImGui::PushID(static_cast<int>(i));
+      ImGui::Checkbox("##enabled", &breakpoint.enabled);
+      ImGui::SameLine();
+      String const label = format("{} {} ({} hits)"_sv,
+                                  breakpoint_kind_to_string(breakpoint.kind),
+                                  breakpoint.text, breakpoint.hits);
+      ImGui::TextUnformatted(label.data());
+      ImGui::SameLine();
+      bool const removed = ImGui::Button("Remove");
+      ImGui::PopID();
+      if(removed) {
+        remove_breakpoint(breakpoints, scene, i);
+        highlighted_gate = 0;
+        break;
+      }
+    }
+  }
+} // namespace nebula
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <anton/string.hpp>
+
+#include <core/types.hpp>
+#include <simulation/breakpoint.hpp>
+
+namespace nebula {
+  struct Scene;
+
+  /**
+   * @brief State of the breakpoint panel.
+   */
+  struct Breakpoint_Panel {
+    // Breakpoint_Kind of the next breakpoint.
+    int kind = 0;
+    char text[256] = {};
+    // The error of the last added breakpoint or the last hit.
+    String status;
+  };
+
+  /**
+   * @brief Displays the breakpoints, which may be added, disabled or
+   * removed.
+   *
+   * @param highlighted_gate The gate outlined in the viewport. Cleared once a
+   * breakpoint is removed.
+   */
+  void display_breakpoints(Breakpoint_Panel& panel, Breakpoints& breakpoints,
+                           Scene& scene, u64& highlighted_gate);
+} // namespace nebula
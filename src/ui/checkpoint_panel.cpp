@@ -0,0 +1,50 @@
+#include <ui/checkpoint_panel.hpp>
+
+#include <anton/format.hpp>
+
+#include <logging/logging.hpp>
+#include <ui/scene.hpp>
+
+#include <imgui.h>
+
+namespace nebula {
+  Checkpoint_Time display_checkpoints(Checkpoint_Panel& panel, Scene& scene,
+                                      Checkpoint_Time const& time)
+  {
+    if(panel.job != nullptr && is_checkpoint_finished(panel.job)) {
+      Expected<void, Error> result = finish_checkpoint(panel.job);
+      panel.job = nullptr;
+      if(result) {
+        panel.status = String("Checkpoint saved");
+      } else {
+        LOG_ERROR("checkpoint failed: {}", result.error());
+        panel.status = ANTON_MOV(result.error());
+      }
+    }
+
+    ImGui::InputText("Checkpoint", panel.path, sizeof(panel.path));
+    if(panel.job != nullptr) {
+      ImGui::TextUnformatted("Saving...");
+    } else if(ImGui::Button("Save checkpoint")) {
+      panel.job = start_checkpoint(scene, time, panel.path);
+    }
+    ImGui::SameLine();
+    Checkpoint_Time restored;
+    if(ImGui::Button("Restore checkpoint")) {
+      Expected<Checkpoint_Time, Error> result =
+        restore_checkpoint(scene, panel.path);
+      if(result) {
+        restored = result.value();
+        panel.status = format("Restored cycle {}"_sv, restored.cycle);
+      } else {
+        LOG_ERROR("restore failed: {}", result.error());
+        panel.status = ANTON_MOV(result.error());
+      }
+    }
+
+    if(panel.status.size_bytes() > 0) {
+      ImGui::TextWrapped("%s", panel.status.data());
+    }
+    return restored;
+  }
+} // namespace nebula
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <anton/string.hpp>
+
+#include <core/types.hpp>
+#include <simulation/checkpoint.hpp>
+
+namespace nebula {
+  struct Scene;
+
+  /**
+   * @brief State of the checkpoint panel.
+   */
+  struct Checkpoint_Panel {
+    char path[512] = {};
+    String status;
+    // The checkpoint being written in the background, if any.
+    Checkpoint_Job* job = nullptr;
+  };
+
+  /**
+   * @brief Displays the checkpoint controls, which save the state of the
+   * scene in the background or restore it.
+   *
+   * @param time The last evaluated cycle and the times of the schedules,
+   * saved with the state.
+   * @return The time of the restored checkpoint. The cycle is -1 unless a
+   * checkpoint has been restored.
+   */
+  [[nodiscard]] Checkpoint_Time
+  display_checkpoints(Checkpoint_Panel& panel, Scene& scene,
+                      Checkpoint_Time const& time);
+} // namespace nebula
@@ -0,0 +1,86 @@
+#include <ui/coverage_panel.hpp>
+
+#include <anton/format.hpp>
+
+#include <logging/logging.hpp>
+#include <simulation/coverage.hpp>
+#include <ui/scene.hpp>
+
+#include <imgui.h>
+
+namespace nebula {
+  static void display_coverage_list(Toggle_Counters const& toggles,
+                                    Scene& scene, char const* const id,
+                                    Slice<i64 const> const slots,
+                                    u64& highlighted_gate)
+  {
+    constexpr f32 row_height = 18.0f;
+    ImGui::BeginChild(id, ImVec2(0.0f, 8.0f * row_height));
+    ImGuiListClipper clipper;
+    clipper.Begin(static_cast<int>(slots.size()), row_height);
+    while(clipper.Step()) {
+      for(int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row) {
+        i64 const slot = slots[row];
+        String const label = format(
+          "{}  {} rises, {} falls"_sv, get_coverage_name(toggles, scene, slot),
+          toggles.rises[slot], toggles.falls[slot]);
+        ImGui::PushID(row);
+        // Selecting a net outlines its gate in the viewport.
+        if(ImGui::Selectable(label.data(),
+                             highlighted_gate == toggles.gates[slot])) {
+          highlighted_gate = toggles.gates[slot];
+        }
+        ImGui::PopID();
+      }
+    }
+    clipper.End();
+    ImGui::EndChild();
+  }
+
+  void display_coverage(Coverage_Panel& panel, Toggle_Counters& toggles,
+                        bool& counting, Scene& scene, u64& highlighted_gate)
+  {
+    ImGui::Begin("Coverage");
+    if(ImGui::Checkbox("Count toggles", &counting) && counting) {
+      reset_toggle_counters(toggles);
+    }
+    ImGui::SameLine();
+    if(ImGui::Button("Reset")) {
+      reset_toggle_counters(toggles);
+    }
+
+    Coverage_Summary const summary = summarize_coverage(toggles);
+    String const status = format(
+      "{} of {} nets rose and fell, {} never toggled in {} cycles"_sv,
+      summary.covered, summary.nets, summary.untoggled, toggles.cycles);
+    ImGui::TextUnformatted(status.data());
+
+    ImGui::InputText("Report", panel.path, sizeof(panel.path));
+    ImGui::SameLine();
+    if(ImGui::Button("Export CSV/JSON")) {
+      Expected<void, Error> result =
+        export_coverage(toggles, scene, panel.path);
+      if(result) {
+        panel.status = format("Exported {} nets"_sv, summary.nets);
+      } else {
+        LOG_ERROR("{}", result.error());
+        panel.status = ANTON_MOV(result.error());
+      }
+    }
+    if(panel.status.size_bytes() > 0) {
+      ImGui::TextWrapped("%s", panel.status.data());
+    }
+
+    if(ImGui::CollapsingHeader("Never toggled")) {
+      collect_untoggled(toggles, panel.slots);
+      display_coverage_list(toggles, scene, "Untoggled", panel.slots,
+                            highlighted_gate);
+    }
+    if(ImGui::CollapsingHeader("Hottest")) {
+      collect_hottest(toggles, 100, panel.slots);
+      display_coverage_list(toggles, scene, "Hottest", panel.slots,
+                            highlighted_gate);
+    }
+    ImGui::End();
+  }
+} // namespace nebula
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <anton/string.hpp>
+
+#include <core/types.hpp>
+#include <evaluator/evaluator.hpp>
+
+namespace nebula {
+  struct Scene;
+
+  /**
+   * @brief State of the coverage panel.
+   */
+  struct Coverage_Panel {
+    // Path of the exported report.
+    char path[512] = {};
+    String status;
+    // Scratch buffer of the slots of the listed nets.
+    Array<i64> slots;
+  };
+
+  /**
+   * @brief Displays the toggle coverage of the nets, lists the nets that
+   * never toggled and the hottest ones, and exports the report.
+   *
+   * @param toggles The counters to display.
+   * @param counting Whether the simulation counts toggles.
+   * @param highlighted_gate The gate outlined in the viewport. Set to the net
+   * selected in a list.
+   */
+  void display_coverage(Coverage_Panel& panel, Toggle_Counters& toggles,
+                        bool& counting, Scene& scene, u64& highlighted_gate);
+} // namespace nebula
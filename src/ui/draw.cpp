@@ -0,0 +1,146 @@
+#include <ui/draw.hpp>
+
+#include <anton/math/math.hpp>
+
+namespace nebula {
+  // get_heat_color
+  //
+  // Map heat to a color going from blue through green and yellow to red.
+  //
+  [[nodiscard]] static math::Vec3 get_heat_color(f32 const heat)
+  {
+    f32 const t = math::min(math::max(heat, 0.0f), 1.0f);
+    if(t < 0.5f) {
+      f32 const u = t * 2.0f;
+      return {0.0f, u, 1.0f - u};
+    } else {
+      f32 const u = (t - 0.5f) * 2.0f;
+      return {u, 1.0f - u, 0.0f};
+    }
+  }
+
+  rendering::Draw_Elements_Command prepare_draw(Gate const& gate,
+                                                Color_Mode const mode,
+                                                f32 const heat)
+  {
+    // TODO: green and red in evaluation mode and unique color for each type
+    //       in create mode.
+    math::Vec3 const green{0.498f, 1.0f, 0.0f};
+    math::Vec3 const red{1.0f, 0.0f, 0.2235f};
+    math::Vec3 const blue{0.2f, 0.55f, 1.0f};
+    math::Vec3 color = gate.evaluation.value ? green : red;
+    if(gate.evaluation.unknown) {
+      color = blue;
+    }
+    if(mode == Color_Mode::e_heatmap) {
+      color = get_heat_color(heat);
+    }
+    Vertex vert[] = {
+      Vertex{.position = {gate.coordinates.x + gate.dimensions.x,
+                          gate.coordinates.y + gate.dimensions.y, 0.0f},
+             .normal = color,
+             .uv = {1.0f, 1.0f}},
+      Vertex{.position = {gate.coordinates.x,
+                          gate.coordinates.y + gate.dimensions.y, 0.0f},
+             .normal = color,
+             .uv = {0.0f, 1.0f}},
+      Vertex{.position = {gate.coordinates.x + gate.dimensions.x,
+                          gate.coordinates.y, 0.0f},
+             .normal = color,
+             .uv = {1.0f, 0.0f}},
+      Vertex{.position = {gate.coordinates.x, gate.coordinates.y, 0.0f},
+             .normal = color,
+             .uv = {0.0f, 0.0f}},
+    };
+    u32 indices[] = {
+      0, 1, 2, 1, 3, 2,
+    };
+    rendering::Draw_Elements_Command cmd =
+      rendering::write_geometry(vert, indices);
+    cmd.instance_count = 1;
+    return cmd;
+  }
+
+  rendering::Draw_Elements_Command prepare_draw(Port const& port)
+  {
+    math::Vec3 color;
+    if(port.kind == Port_Kind::in) {
+      color = {0.99f, 0.3f, 0.3f};
+    } else {
+      color = {0.6f, 0.9f, 0.2f};
+    }
+    Vertex vert[] = {
+      Vertex{.position = {port.coordinates.x + port.radius,
+                          port.coordinates.y + port.radius, 0.0f},
+             .normal = color,
+             .uv = {1.0f, 1.0f}},
+      Vertex{.position = {port.coordinates.x - port.radius,
+                          port.coordinates.y + port.radius, 0.0f},
+             .normal = color,
+             .uv = {0.0f, 1.0f}},
+      Vertex{.position = {port.coordinates.x + port.radius,
+                          port.coordinates.y - port.radius, 0.0f},
+             .normal = color,
+             .uv = {1.0f, 0.0f}},
+      Vertex{.position = {port.coordinates.x - port.radius,
+                          port.coordinates.y - port.radius, 0.0f},
+             .normal = color,
+             .uv = {0.0f, 0.0f}},
+    };
+    u32 indices[] = {
+      0, 1, 2, 1, 3, 2,
+    };
+    rendering::Draw_Elements_Command cmd =
+      rendering::write_geometry(vert, indices);
+    cmd.instance_count = 1;
+    return cmd;
+  }
+
+  rendering::Draw_Elements_Command
+  prepare_draw_connection(Slice<Vec2 const> const points)
+  {
+    // TODO: make it 'greener' when port output is true
+    math::Vec3 const color = {0.5f, 0.8f, 0.5f};
+    f32 const thickness = 0.04f;
+    i64 const segments = points.size() - 1;
+    Array<Vertex> vertices{anton::reserve, 4 * segments};
+    Array<u32> indices{anton::reserve, 6 * segments};
+    for(i64 i = 0; i < segments; ++i) {
+      Vec2 const begin = points[i];
+      Vec2 const end = points[i + 1];
+      // Calculate normalized direction vector
+      Vec2 direction = end - begin;
+      f32 const length = math::length(direction);
+      if(length == 0.0f) {
+        continue;
+      }
+
+      direction /= length;
+      // Extend the segments by the thickness to fill the corners.
+      Vec2 const along = direction * thickness;
+      Vec2 const across = Vec2{-direction.y, direction.x} * thickness;
+      Vec2 const p1 = begin - along;
+      Vec2 const p2 = end + along;
+      u32 const first = vertices.size();
+      Vec2 const corners[] = {p1 + across, p1 - across, p2 + across,
+                              p2 - across};
+      math::Vec2 const uvs[] = {
+        {1.0f, 1.0f}, {0.0f, 1.0f}, {1.0f, 0.0f}, {0.0f, 0.0f}};
+      for(i64 c = 0; c < 4; ++c) {
+        vertices.push_back(
+          Vertex{.position = {corners[c].x, corners[c].y, 0.0f},
+                 .normal = color,
+                 .uv = uvs[c]});
+      }
+      u32 const quad[] = {0, 1, 2, 1, 3, 2};
+      for(u32 const index: quad) {
+        indices.push_back(first + index);
+      }
+    }
+
+    rendering::Draw_Elements_Command cmd =
+      rendering::write_geometry(vertices, indices);
+    cmd.instance_count = 1;
+    return cmd;
+  }
+} // namespace nebula
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <anton/slice.hpp>
+
+#include <core/types.hpp>
+#include <model/gate.hpp>
+#include <model/port.hpp>
+#include <rendering/rendering.hpp>
+
+namespace nebula {
+  enum struct Color_Mode : u8 {
+    // Gates are green when their value is 1, red when it is 0 and blue when
+    // it is unknown.
+    e_value,
+    // Gates are colored from blue to red by their heat.
+    e_heatmap,
+  };
+
+  /**
+   * @brief Prepares draw command for rendering a gate.
+   *
+   * This function prepares a draw command for rendering the specified gate. The
+   * draw command includes information necessary to render the gate.
+   *
+   * @param gate The gate to prepare the draw command for.
+   * @param mode How the gate is colored.
+   * @param heat The heat of the gate in [0, 1] used by the heatmap mode.
+   * @return A rendering::Draw_Elements_Command for rendering the gate.
+   */
+  [[nodiscard]] rendering::Draw_Elements_Command
+  prepare_draw(Gate const& gate, Color_Mode mode = Color_Mode::e_value,
+               f32 heat = 0.0f);
+
+  /**
+   * @brief Prepares draw command for rendering a port.
+   *
+   * This function prepares a draw command for rendering the specified port. The
+   * draw command includes information necessary to render the port.
+   *
+   * @param port The port to prepare the draw command for.
+   * @return A rendering::Draw_Elements_Command for rendering the port.
+   */
+  [[nodiscard]] rendering::Draw_Elements_Command prepare_draw(Port const& port);
+
+  /**
+   * @brief Prepares draw command for rendering a connection along a polyline.
+   *
+   * This function prepares a draw command for rendering a connection as a
+   * sequence of segments between consecutive points. The draw command includes
+   * information necessary to render the connection.
+   *
+   * @param points The points of the polyline. At least 2.
+   * @return A rendering::Draw_Elements_Command for rendering the connection.
+   */
+  [[nodiscard]] rendering::Draw_Elements_Command
+  prepare_draw_connection(Slice<Vec2 const> points);
+} // namespace nebula
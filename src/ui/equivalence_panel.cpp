@@ -0,0 +1,86 @@
+#include <ui/equivalence_panel.hpp>
+
+#include <anton/format.hpp>
+
+#include <importer/importer.hpp>
+#include <ui/scene.hpp>
+#include <verification/equivalence.hpp>
+
+#include <imgui.h>
+
+namespace nebula {
+  // check_reference
+  //
+  // Check the scene against the reference netlist. The reference is imported
+  // into a scene of its own that is discarded after the check.
+  //
+  static void check_reference(Equivalence_Panel& panel, Scene& scene,
+                              Vec2 const gate_dimensions)
+  {
+    panel.counterexample_gates.clear();
+    panel.counterexample_values.clear();
+    Scene reference;
+    Expected<Import_Statistics, Error> imported =
+      import_netlist(reference, panel.reference_path, gate_dimensions);
+    if(!imported) {
+      panel.status = ANTON_MOV(imported.error());
+      return;
+    }
+
+    Expected<Equivalence_Result, Error> checked =
+      check_equivalence(scene, reference, 100000);
+    if(!checked) {
+      panel.status = ANTON_MOV(checked.error());
+      return;
+    }
+
+    Equivalence_Result const& result = checked.value();
+    if(result.verdict == Equivalence_Verdict::e_equivalent) {
+      panel.status = String("Equivalent");
+    } else if(result.verdict == Equivalence_Verdict::e_undecided) {
+      panel.status =
+        format("Undecided: output '{}' is too hard"_sv, result.output);
+    } else {
+      panel.status = format(
+        "Different: output '{}' is {} here and {} in the reference for"_sv,
+        result.output, static_cast<i32>(result.first_value),
+        static_cast<i32>(result.second_value));
+      for(Counterexample_Value const& value: result.counterexample) {
+        panel.status = format("{}\n  {} = {}"_sv, panel.status, value.name,
+                              static_cast<i32>(value.value));
+        // Sequential gates are inputs of the check as well, but their state
+        // cannot be set from the panel.
+        if(value.gate->kind == Gate_Kind::e_input) {
+          panel.counterexample_gates.push_back(value.gate->id);
+          panel.counterexample_values.push_back(value.value);
+        }
+      }
+    }
+  }
+
+  void display_equivalence(Equivalence_Panel& panel, Scene& scene,
+                           Vec2 const gate_dimensions)
+  {
+    ImGui::InputText("Reference", panel.reference_path,
+                     sizeof(panel.reference_path));
+    if(ImGui::Button("Check equivalence")) {
+      check_reference(panel, scene, gate_dimensions);
+    }
+
+    if(panel.counterexample_gates.size() > 0) {
+      ImGui::SameLine();
+      if(ImGui::Button("Apply counterexample")) {
+        for(i64 i = 0; i < panel.counterexample_gates.size(); ++i) {
+          Gate* const gate = scene.find_gate(panel.counterexample_gates[i]);
+          if(gate != nullptr) {
+            gate->evaluation.value = panel.counterexample_values[i];
+          }
+        }
+      }
+    }
+
+    if(panel.status.size_bytes() > 0) {
+      ImGui::TextWrapped("%s", panel.status.data());
+    }
+  }
+} // namespace nebula
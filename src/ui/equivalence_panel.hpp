@@ -0,0 +1,31 @@
+#pragma once
+
+#include <anton/array.hpp>
+#include <anton/string.hpp>
+
+#include <core/types.hpp>
+
+namespace nebula {
+  struct Scene;
+
+  /**
+   * @brief State of the equivalence panel.
+   */
+  struct Equivalence_Panel {
+    // Netlist the scene is checked against for equivalence.
+    char reference_path[512] = {};
+    String status;
+    // Identifiers and values of the inputs of the last counterexample.
+    Array<u64> counterexample_gates;
+    Array<u8> counterexample_values;
+  };
+
+  /**
+   * @brief Checks the scene for equivalence against a reference netlist and
+   * assigns the inputs of a counterexample to the scene.
+   *
+   * @param gate_dimensions The dimensions of the imported reference gates.
+   */
+  void display_equivalence(Equivalence_Panel& panel, Scene& scene,
+                           Vec2 gate_dimensions);
+} // namespace nebula
@@ -0,0 +1,410 @@
+#include <ui/journal.hpp>
+
+#include <anton/flat_hash_map.hpp>
+
+#include <ui/scene.hpp>
+
+namespace nebula {
+  Journal::Journal(i64 const capacity, i64 const memory_budget)
+    : entries(capacity), memory_budget(memory_budget)
+  {
+  }
+
+  [[nodiscard]] static i64 get_entry_memory(Journal_Entry const& entry)
+  {
+    i64 memory = sizeof(Journal_Entry);
+    memory += (entry.added_gates.size() + entry.removed_gates.size()) *
+              sizeof(Gate_Record);
+    for(Gate_Record const& record: entry.added_gates) {
+      memory += record.name.size_bytes();
+    }
+    for(Gate_Record const& record: entry.removed_gates) {
+      memory += record.name.size_bytes();
+    }
+    memory +=
+      (entry.added_connections.size() + entry.removed_connections.size()) *
+      sizeof(Connection_Record);
+    memory += entry.moved_gates.size() * sizeof(u64);
+    memory += entry.offsets.size() * sizeof(Vec2);
+    return memory;
+  }
+
+  [[nodiscard]] static i64 get_index(Journal const& journal, i64 const i)
+  {
+    return (journal.first + i) % journal.entries.size();
+  }
+
+  static void drop_oldest(Journal& journal)
+  {
+    Journal_Entry& entry = journal.entries[journal.first];
+    journal.memory -= get_entry_memory(entry);
+    entry = Journal_Entry();
+    journal.first = get_index(journal, 1);
+    journal.count -= 1;
+    journal.cursor -= 1;
+  }
+
+  static void push_entry(Journal& journal, Journal_Entry&& entry)
+  {
+    journal.open = false;
+    if(journal.entries.size() == 0) {
+      return;
+    }
+
+    // Recording an edit discards the undone entries.
+    while(journal.count > journal.cursor) {
+      Journal_Entry& newest =
+        journal.entries[get_index(journal, journal.count - 1)];
+      journal.memory -= get_entry_memory(newest);
+      newest = Journal_Entry();
+      journal.count -= 1;
+    }
+
+    if(journal.count == journal.entries.size()) {
+      drop_oldest(journal);
+    }
+
+    journal.memory += get_entry_memory(entry);
+    journal.entries[get_index(journal, journal.count)] = ANTON_MOV(entry);
+    journal.count += 1;
+    journal.cursor = journal.count;
+    while(journal.memory > journal.memory_budget && journal.count > 1) {
+      drop_oldest(journal);
+    }
+  }
+
+  [[nodiscard]] static Connection_Record
+  make_connection_record(Port const* const p1, Port const* const p2)
+  {
+    Port const* const out = p1->kind == Port_Kind::out ? p1 : p2;
+    Port const* const in = p1->kind == Port_Kind::out ? p2 : p1;
+    return Connection_Record{out->gate->id, in->gate->id, out->index,
+                             in->index};
+  }
+
+  Gate_Record make_gate_record(Gate const& gate)
+  {
+    return Gate_Record{gate.id,         gate.coordinates,  gate.dimensions,
+                       gate.kind,       gate.evaluation,   gate.name,
+                       gate.definition, gate.memory,       gate.width,
+                       gate.table,      gate.clock_period, gate.clock_phase,
+                       gate.delay};
+  }
+
+  // collect_connections
+  //
+  // Append all connections of the gates to records. Connections between two
+  // of the gates are appended once.
+  //
+  static void collect_connections(Slice<Gate* const> const gates,
+                                  Array<Connection_Record>& records)
+  {
+    Flat_Hash_Map<u64, bool> members;
+    for(Gate const* const gate: gates) {
+      members.emplace(gate->id, true);
+    }
+
+    for(Gate const* const gate: gates) {
+      for(Port const* const port: gate->in_ports) {
+        for(Port const* const other: port->connections) {
+          if(other->gate != nullptr) {
+            records.push_back(make_connection_record(other, port));
+          }
+        }
+      }
+
+      for(Port const* const port: gate->out_ports) {
+        for(Port const* const other: port->connections) {
+          // Internal connections have been recorded from the IN side.
+          if(other->gate != nullptr &&
+             members.find(other->gate->id) == members.end()) {
+            records.push_back(make_connection_record(port, other));
+          }
+        }
+      }
+    }
+  }
+
+  [[nodiscard]] static bool is_move(Journal_Entry const& entry)
+  {
+    return entry.added_gates.size() == 0 && entry.removed_gates.size() == 0 &&
+           entry.added_connections.size() == 0 &&
+           entry.removed_connections.size() == 0 && entry.offsets.size() == 0;
+  }
+
+  [[nodiscard]] static bool is_same_set(Array<u64> const& ids,
+                                        Slice<Gate* const> const gates)
+  {
+    if(ids.size() != gates.size()) {
+      return false;
+    }
+
+    for(i64 i = 0; i < ids.size(); ++i) {
+      if(ids[i] != gates[i]->id) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void record_move(Journal& journal, Slice<Gate* const> const gates,
+                   Vec2 const offset)
+  {
+    if(gates.size() == 0) {
+      return;
+    }
+
+    bool const coalesce = journal.open && journal.count > 0 &&
+                          journal.cursor == journal.count;
+    if(coalesce) {
+      Journal_Entry& newest =
+        journal.entries[get_index(journal, journal.count - 1)];
+      if(is_move(newest) && is_same_set(newest.moved_gates, gates)) {
+        newest.offset += offset;
+        return;
+      }
+    }
+
+    Journal_Entry entry;
+    entry.moved_gates.ensure_capacity(gates.size());
+    for(Gate const* const gate: gates) {
+      entry.moved_gates.push_back(gate->id);
+    }
+    entry.offset = offset;
+    push_entry(journal, ANTON_MOV(entry));
+    journal.open = true;
+  }
+
+  void record_moves(Journal& journal, Slice<Gate* const> const gates,
+                    Slice<Vec2 const> const offsets)
+  {
+    if(gates.size() == 0) {
+      return;
+    }
+
+    Journal_Entry entry;
+    entry.moved_gates.ensure_capacity(gates.size());
+    entry.offsets.ensure_capacity(gates.size());
+    for(i64 i = 0; i < gates.size(); ++i) {
+      entry.moved_gates.push_back(gates[i]->id);
+      entry.offsets.push_back(offsets[i]);
+    }
+    push_entry(journal, ANTON_MOV(entry));
+  }
+
+  void record_added_gates(Journal& journal, Slice<Gate* const> const gates)
+  {
+    if(gates.size() == 0) {
+      return;
+    }
+
+    Journal_Entry entry;
+    entry.added_gates.ensure_capacity(gates.size());
+    for(Gate const* const gate: gates) {
+      entry.added_gates.push_back(make_gate_record(*gate));
+    }
+    collect_connections(gates, entry.added_connections);
+    push_entry(journal, ANTON_MOV(entry));
+  }
+
+  void record_removed_gates(Journal& journal, Slice<Gate* const> const gates)
+  {
+    if(gates.size() == 0) {
+      return;
+    }
+
+    Journal_Entry entry;
+    entry.removed_gates.ensure_capacity(gates.size());
+    for(Gate const* const gate: gates) {
+      entry.removed_gates.push_back(make_gate_record(*gate));
+    }
+    collect_connections(gates, entry.removed_connections);
+    push_entry(journal, ANTON_MOV(entry));
+  }
+
+  void record_connection(Journal& journal, Port const* const p1,
+                         Port const* const p2)
+  {
+    if(p1->gate == nullptr || p2->gate == nullptr) {
+      return;
+    }
+
+    Journal_Entry entry;
+    Port const* const in = p1->kind == Port_Kind::in ? p1 : p2;
+    // IN ports accept a single connection, which is replaced.
+    for(Port const* const other: in->connections) {
+      if(other->gate != nullptr) {
+        entry.removed_connections.push_back(make_connection_record(other, in));
+      }
+    }
+    entry.added_connections.push_back(make_connection_record(p1, p2));
+    push_entry(journal, ANTON_MOV(entry));
+  }
+
+  void record_disconnection(Journal& journal, Port const* const port)
+  {
+    if(port->gate == nullptr) {
+      return;
+    }
+
+    Journal_Entry entry;
+    for(Port const* const other: port->connections) {
+      if(other->gate != nullptr) {
+        entry.removed_connections.push_back(
+          make_connection_record(port, other));
+      }
+    }
+
+    if(entry.removed_connections.size() > 0) {
+      push_entry(journal, ANTON_MOV(entry));
+    }
+  }
+
+  void seal(Journal& journal)
+  {
+    journal.open = false;
+  }
+
+  [[nodiscard]] static Port* get_port(Scene& scene, u64 const gate_id,
+                                      u32 const index, Port_Kind const kind)
+  {
+    Gate* const gate = scene.find_gate(gate_id);
+    if(gate == nullptr) {
+      return nullptr;
+    }
+
+    Array<Port*>& ports =
+      kind == Port_Kind::in ? gate->in_ports : gate->out_ports;
+    return index < ports.size() ? ports[index] : nullptr;
+  }
+
+  static void add_connections(Scene& scene,
+                              Slice<Connection_Record const> const records)
+  {
+    for(Connection_Record const& record: records) {
+      Port* const out =
+        get_port(scene, record.out_gate, record.out_port, Port_Kind::out);
+      Port* const in =
+        get_port(scene, record.in_gate, record.in_port, Port_Kind::in);
+      if(out != nullptr && in != nullptr) {
+        scene.connect_ports(out, in);
+      }
+    }
+  }
+
+  static void remove_connections(Scene& scene,
+                                 Slice<Connection_Record const> const records)
+  {
+    for(Connection_Record const& record: records) {
+      Port* const out =
+        get_port(scene, record.out_gate, record.out_port, Port_Kind::out);
+      Port* const in =
+        get_port(scene, record.in_gate, record.in_port, Port_Kind::in);
+      if(out != nullptr && in != nullptr) {
+        out->remove_connection(in);
+        in->remove_connection(out);
+      }
+    }
+  }
+
+  Gate& restore_gate(Scene& scene, Gate_Record const& record,
+                     Vec2 const coordinates, u64 const id)
+  {
+    Gate& gate = scene.add_gate(record.dimensions, coordinates, record.kind, id,
+                                record.definition, record.memory, record.width);
+    gate.evaluation = record.evaluation;
+    gate.name = record.name;
+    gate.table = record.table;
+    gate.clock_period = record.clock_period;
+    gate.clock_phase = record.clock_phase;
+    gate.delay = record.delay;
+    return gate;
+  }
+
+  static void add_gates(Scene& scene, Slice<Gate_Record const> const records)
+  {
+    for(Gate_Record const& record: records) {
+      restore_gate(scene, record, record.coordinates, record.id);
+    }
+  }
+
+  static void remove_gates(Scene& scene,
+                           Slice<Gate_Record const> const records)
+  {
+    Array<Gate*> gates{anton::reserve, records.size()};
+    for(Gate_Record const& record: records) {
+      Gate* const gate = scene.find_gate(record.id);
+      if(gate != nullptr) {
+        gates.push_back(gate);
+      }
+    }
+    scene.delete_gates(gates);
+  }
+
+  static void move_gates(Scene& scene, Journal_Entry const& entry,
+                         f32 const sign)
+  {
+    for(i64 i = 0; i < entry.moved_gates.size(); ++i) {
+      Gate* const gate = scene.find_gate(entry.moved_gates[i]);
+      if(gate == nullptr) {
+        continue;
+      }
+
+      Vec2 const offset =
+        entry.offsets.size() > 0 ? entry.offsets[i] : entry.offset;
+      scene.move_gate(*gate, offset * sign);
+    }
+  }
+
+  static void apply(Journal_Entry const& entry, Scene& scene)
+  {
+    remove_connections(scene, entry.removed_connections);
+    remove_gates(scene, entry.removed_gates);
+    add_gates(scene, entry.added_gates);
+    add_connections(scene, entry.added_connections);
+    move_gates(scene, entry, 1.0f);
+  }
+
+  static void revert(Journal_Entry const& entry, Scene& scene)
+  {
+    move_gates(scene, entry, -1.0f);
+    remove_connections(scene, entry.added_connections);
+    remove_gates(scene, entry.added_gates);
+    add_gates(scene, entry.removed_gates);
+    add_connections(scene, entry.removed_connections);
+  }
+
+  bool undo(Journal& journal, Scene& scene)
+  {
+    if(!can_undo(journal)) {
+      return false;
+    }
+
+    journal.open = false;
+    journal.cursor -= 1;
+    revert(journal.entries[get_index(journal, journal.cursor)], scene);
+    return true;
+  }
+
+  bool redo(Journal& journal, Scene& scene)
+  {
+    if(!can_redo(journal)) {
+      return false;
+    }
+
+    journal.open = false;
+    apply(journal.entries[get_index(journal, journal.cursor)], scene);
+    journal.cursor += 1;
+    return true;
+  }
+
+  bool can_undo(Journal const& journal)
+  {
+    return journal.cursor > 0;
+  }
+
+  bool can_redo(Journal const& journal)
+  {
+    return journal.cursor < journal.count;
+  }
+} // namespace nebula
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <anton/slice.hpp>
+
+#include <core/types.hpp>
+#include <model/gate.hpp>
+
+namespace nebula {
+  struct Scene;
+
+  /**
+   * @brief Snapshot of a gate sufficient to restore it after deletion.
+   */
+  struct Gate_Record {
+    u64 id;
+    Vec2 coordinates;
+    Vec2 dimensions;
+    Gate_Kind kind;
+    Evaluation_State evaluation;
+    String name;
+    Module_Definition* definition;
+    Memory_Definition* memory;
+    u32 width;
+    u64 table;
+    u32 clock_period;
+    u32 clock_phase;
+    u32 delay;
+  };
+
+  /**
+   * @brief Records a gate with its current properties.
+   */
+  [[nodiscard]] Gate_Record make_gate_record(Gate const& gate);
+
+  /**
+   * @brief Adds a gate with the properties of a record to a scene.
+   *
+   * @param coordinates The coordinates of the new gate.
+   * @param id The identifier of the new gate.
+   * @return The new gate.
+   */
+  Gate& restore_gate(Scene& scene, Gate_Record const& record, Vec2 coordinates,
+                     u64 id);
+
+  /**
+   * @brief A connection between two ports identified by their gates and their
+   * indices within the gates.
+   */
+  struct Connection_Record {
+    u64 out_gate;
+    u64 in_gate;
+    u32 out_port;
+    u32 in_port;
+  };
+
+  /**
+   * @brief A single undoable edit.
+   *
+   * An entry describes the edit as a delta. Redoing the edit removes
+   * connections, removes gates, adds gates, adds connections and moves gates
+   * in that order. Undoing applies the inverse in reverse order. Fields that
+   * are not used by the edit are empty and take no memory, hence a drag is a
+   * list of gate identifiers and a single offset.
+   */
+  struct Journal_Entry {
+    Array<Gate_Record> added_gates;
+    Array<Gate_Record> removed_gates;
+    Array<Connection_Record> added_connections;
+    Array<Connection_Record> removed_connections;
+    Array<u64> moved_gates;
+    // Offsets of the moved gates. Empty when all gates moved by offset.
+    Array<Vec2> offsets;
+    Vec2 offset = {0.0f, 0.0f};
+  };
+
+  /**
+   * @brief Undo/redo history of edits of a scene.
+   *
+   * Entries are stored in a ring buffer. The oldest entries are discarded
+   * when the buffer is full or when the entries exceed the memory budget.
+   */
+  struct Journal {
+    // Ring buffer of entries. Its size is the capacity of the journal.
+    Array<Journal_Entry> entries;
+    // Index of the oldest entry in the ring buffer.
+    i64 first = 0;
+    // Number of entries in the journal.
+    i64 count = 0;
+    // Number of entries that have been applied. Entries [cursor, count) have
+    // been undone and may be redone.
+    i64 cursor = 0;
+    // Approximate number of bytes used by the entries.
+    i64 memory = 0;
+    i64 memory_budget;
+    // Whether the newest entry may still be coalesced with further moves.
+    bool open = false;
+
+    /**
+     * @param capacity The maximum number of entries.
+     * @param memory_budget The maximum number of bytes used by the entries.
+     */
+    Journal(i64 capacity = 1024, i64 memory_budget = 64 * 1024 * 1024);
+  };
+
+  /**
+   * @brief Records a move of gates by a common offset.
+   *
+   * Must be called after moving. Consecutive moves of the same gates are
+   * coalesced into a single entry until the journal is sealed, hence a drag
+   * produces one entry.
+   *
+   * @param journal The journal to record in.
+   * @param gates The moved gates.
+   * @param offset The offset the gates have been moved by.
+   */
+  void record_move(Journal& journal, Slice<Gate* const> gates, Vec2 offset);
+
+  /**
+   * @brief Records a move of gates by individual offsets.
+   *
+   * Must be called after moving. Never coalesced.
+   */
+  void record_moves(Journal& journal, Slice<Gate* const> gates,
+                    Slice<Vec2 const> offsets);
+
+  /**
+   * @brief Records the addition of gates.
+   *
+   * Must be called after the gates and their connections have been added.
+   * The connections of the gates are recorded as part of the entry, hence
+   * undoing a paste removes the gates with all their connections in a single
+   * step.
+   */
+  void record_added_gates(Journal& journal, Slice<Gate* const> gates);
+
+  /**
+   * @brief Records the removal of gates.
+   *
+   * Must be called before the gates are deleted. Records all connections of
+   * the gates.
+   */
+  void record_removed_gates(Journal& journal, Slice<Gate* const> gates);
+
+  /**
+   * @brief Records connecting two ports.
+   *
+   * Must be called before connecting. Records the connection replaced by the
+   * new one if the IN port has been connected.
+   */
+  void record_connection(Journal& journal, Port const* p1, Port const* p2);
+
+  /**
+   * @brief Records removing all connections of a port.
+   *
+   * Must be called before the connections are removed.
+   */
+  void record_disconnection(Journal& journal, Port const* port);
+
+  /**
+   * @brief Prevents coalescing further moves into the newest entry.
+   *
+   * Call at the end of an interaction such as a drag.
+   */
+  void seal(Journal& journal);
+
+  /**
+   * @brief Reverts the most recent applied entry.
+   *
+   * @return true if an entry has been undone.
+   */
+  bool undo(Journal& journal, Scene& scene);
+
+  /**
+   * @brief Reapplies the most recently undone entry.
+   *
+   * @return true if an entry has been redone.
+   */
+  bool redo(Journal& journal, Scene& scene);
+
+  [[nodiscard]] bool can_undo(Journal const& journal);
+  [[nodiscard]] bool can_redo(Journal const& journal);
+} // namespace nebula
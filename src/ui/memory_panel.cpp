@@ -0,0 +1,59 @@
+#include <ui/memory_panel.hpp>
+
+#include <anton/format.hpp>
+
+#include <logging/logging.hpp>
+#include <ui/scene.hpp>
+
+#include <imgui.h>
+
+namespace nebula {
+  Memory_Definition* display_memories(Memory_Panel& panel, Scene& scene,
+                                      Gate_Kind& kind)
+  {
+    ImGui::InputText("Memory name", panel.name, sizeof(panel.name));
+    ImGui::InputInt("Address bits", &panel.address_width);
+    ImGui::InputInt("Data bits", &panel.data_width);
+    ImGui::InputText("Image", panel.image, sizeof(panel.image));
+    if(ImGui::Button("Create memory")) {
+      String name{panel.name};
+      if(name.size_bytes() == 0) {
+        name = format("memory{}"_sv, scene.memories.size());
+      }
+      Expected<Memory_Definition*, Error> result =
+        define_memory(scene.memories, ANTON_MOV(name), panel.address_width,
+                      panel.data_width, String_View{panel.image});
+      if(result) {
+        LOG_INFO("defined memory {} of {} bytes", result.value()->name,
+                 result.value()->contents.size());
+      } else {
+        LOG_ERROR("memory failed: {}", result.error());
+      }
+    }
+
+    Memory_Definition* dragged = nullptr;
+    Gate_Kind const kinds[] = {Gate_Kind::e_ram, Gate_Kind::e_rom};
+    for(Memory_Definition& definition: scene.memories) {
+      ImGui::PushID(&definition);
+      for(Gate_Kind const memory_kind: kinds) {
+        String const label =
+          format("{} {}"_sv, definition.name,
+                 memory_kind == Gate_Kind::e_ram ? "RAM"_sv : "ROM"_sv);
+        ImGui::Selectable(label.data());
+        ImGuiDragDropFlags const flags =
+          ImGuiDragDropFlags_SourceNoDisableHover |
+          ImGuiDragDropFlags_SourceNoHoldToOpenOthers;
+        if(ImGui::BeginDragDropSource(flags)) {
+          ImGui::Text("Moving \"%s\"", label.data());
+          ImGui::SetDragDropPayload("DND_MEMORY", nullptr, 0);
+          ImGui::EndDragDropSource();
+
+          kind = memory_kind;
+          dragged = &definition;
+        }
+      }
+      ImGui::PopID();
+    }
+    return dragged;
+  }
+} // namespace nebula
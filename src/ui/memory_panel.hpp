@@ -0,0 +1,31 @@
+#pragma once
+
+#include <core/types.hpp>
+#include <model/gate.hpp>
+#include <model/memory.hpp>
+
+namespace nebula {
+  struct Scene;
+
+  /**
+   * @brief State of the memory panel.
+   */
+  struct Memory_Panel {
+    // Name of the next defined memory. Memories are numbered if empty.
+    char name[128] = {};
+    // Path of the image the contents are loaded from.
+    char image[512] = {};
+    int address_width = 8;
+    int data_width = 8;
+  };
+
+  /**
+   * @brief Displays the memory definitions of a scene and defines a memory
+   * from an image. Every definition may be placed as a RAM or a ROM.
+   *
+   * @param kind Set to the kind the dragged definition is placed as.
+   * @return The definition dragged from the panel in this frame or nullptr.
+   */
+  [[nodiscard]] Memory_Definition*
+  display_memories(Memory_Panel& panel, Scene& scene, Gate_Kind& kind);
+} // namespace nebula
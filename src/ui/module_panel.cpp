@@ -0,0 +1,52 @@
+#include <ui/module_panel.hpp>
+
+#include <anton/format.hpp>
+
+#include <logging/logging.hpp>
+#include <ui/scene.hpp>
+
+#include <imgui.h>
+
+namespace nebula {
+  Module_Definition* display_modules(Module_Panel& panel, Scene& scene)
+  {
+    ImGui::InputText("Module name", panel.name, sizeof(panel.name));
+    if(ImGui::Button("Create module from selection") &&
+       scene.selected_gates.size() > 0) {
+      bool flattenable = true;
+      for(Gate const* const gate: scene.selected_gates) {
+        flattenable = flattenable && can_flatten(gate->kind);
+      }
+
+      if(!flattenable) {
+        LOG_WARNING(
+          "modules must not contain sequential gates, memories or LUTs");
+      } else {
+        String name{panel.name};
+        if(name.size_bytes() == 0) {
+          name = format("module{}"_sv, scene.modules.size());
+        }
+        Module_Definition const& definition =
+          define_module(scene.modules, ANTON_MOV(name), scene.selected_gates);
+        LOG_INFO("defined module {} with {} inputs and {} outputs",
+                 definition.name, definition.input_names.size(),
+                 definition.output_names.size());
+      }
+    }
+
+    Module_Definition* dragged = nullptr;
+    for(Module_Definition& definition: scene.modules) {
+      ImGui::Selectable(definition.name.data());
+      ImGuiDragDropFlags const flags =
+        ImGuiDragDropFlags_SourceNoDisableHover |
+        ImGuiDragDropFlags_SourceNoHoldToOpenOthers;
+      if(ImGui::BeginDragDropSource(flags)) {
+        ImGui::Text("Moving \"%s\"", definition.name.data());
+        ImGui::SetDragDropPayload("DND_MODULE", nullptr, 0);
+        ImGui::EndDragDropSource();
+        dragged = &definition;
+      }
+    }
+    return dragged;
+  }
+} // namespace nebula
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <core/types.hpp>
+#include <model/module.hpp>
+
+namespace nebula {
+  struct Scene;
+
+  /**
+   * @brief State of the module panel.
+   */
+  struct Module_Panel {
+    // Name of the next defined module. Modules are numbered if empty.
+    char name[128] = {};
+  };
+
+  /**
+   * @brief Displays the module definitions of a scene and defines a module
+   * from the selected gates.
+   *
+   * @return The definition dragged from the panel in this frame or nullptr.
+   */
+  [[nodiscard]] Module_Definition* display_modules(Module_Panel& panel,
+                                                   Scene& scene);
+} // namespace nebula
@@ -0,0 +1,66 @@
+#include <ui/power_panel.hpp>
+
+#include <ui/scene.hpp>
+
+#include <imgui.h>
+
+namespace nebula {
+  void display_power(Power_Panel& panel, Toggle_Counters& toggles,
+                     bool& counting, Scene& scene)
+  {
+    ImGui::Begin("Power");
+    // The estimate is derived from the toggle counters, hence showing it
+    // starts counting.
+    if(ImGui::Checkbox("Heatmap", &panel.heatmap) && panel.heatmap &&
+       !counting) {
+      counting = true;
+      reset_toggle_counters(toggles);
+    }
+    ImGui::DragFloat("Input capacitance", &panel.options.input_capacitance,
+                     0.05f, 0.0f, 100.0f);
+    ImGui::DragFloat("Internal capacitance",
+                     &panel.options.internal_capacitance, 0.05f, 0.0f,
+                     100.0f);
+    if(!counting) {
+      ImGui::TextWrapped("Enable toggle counting to estimate the power.");
+      ImGui::End();
+      return;
+    }
+
+    estimate_power(toggles, scene, panel.options, panel.estimate);
+    summarize_module_power(scene, panel.estimate, panel.modules);
+    ImGui::Text("Total %.2f, hottest gate %.2f (capacitance x toggles/cycle)",
+                panel.estimate.total, panel.estimate.maximum);
+
+    ImGuiTableFlags const flags = ImGuiTableFlags_Borders |
+                                  ImGuiTableFlags_RowBg |
+                                  ImGuiTableFlags_ScrollY;
+    if(ImGui::BeginTable("Modules", 4, flags)) {
+      ImGui::TableSetupColumn("Module");
+      ImGui::TableSetupColumn("Instances");
+      ImGui::TableSetupColumn("Power");
+      ImGui::TableSetupColumn("Share");
+      ImGui::TableHeadersRow();
+      for(Module_Power const& module: panel.modules) {
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        if(module.definition != nullptr) {
+          ImGui::TextUnformatted(module.definition->name.data());
+        } else {
+          ImGui::TextUnformatted("(primitive gates)");
+        }
+        ImGui::TableNextColumn();
+        ImGui::Text("%lld", static_cast<long long>(module.instances));
+        ImGui::TableNextColumn();
+        ImGui::Text("%.2f", module.power);
+        ImGui::TableNextColumn();
+        f32 const share = panel.estimate.total > 0.0f
+                            ? 100.0f * module.power / panel.estimate.total
+                            : 0.0f;
+        ImGui::Text("%.1f%%", share);
+      }
+      ImGui::EndTable();
+    }
+    ImGui::End();
+  }
+} // namespace nebula
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <anton/array.hpp>
+
+#include <core/types.hpp>
+#include <evaluator/evaluator.hpp>
+#include <simulation/power.hpp>
+
+namespace nebula {
+  struct Scene;
+
+  /**
+   * @brief State of the power panel.
+   */
+  struct Power_Panel {
+    // Whether the viewport colors the gates by their estimated power.
+    bool heatmap = false;
+    Power_Options options;
+    Power_Estimate estimate;
+    Array<Module_Power> modules;
+  };
+
+  /**
+   * @brief Displays the estimated dynamic power of the scene and its
+   * breakdown per module. Updates the estimate of the panel.
+   *
+   * @param toggles The counters the estimate is derived from.
+   * @param counting Whether the simulation counts toggles. Enabling the
+   * heatmap starts counting.
+   */
+  void display_power(Power_Panel& panel, Toggle_Counters& toggles,
+                     bool& counting, Scene& scene);
+} // namespace nebula
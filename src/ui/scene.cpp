@@ -1,6 +1,13 @@
 #include <ui/scene.hpp>
 
+#include <anton/math/math.hpp>
+
 namespace nebula {
+  [[nodiscard]] static AABB get_bounds(Gate const& gate)
+  {
+    return AABB{gate.coordinates, gate.coordinates + gate.dimensions};
+  }
+
   Scene::~Scene()
   {
     for(Port* p: ports) {
@@ -8,16 +15,60 @@ namespace nebula {
     }
   }
 
-  void Scene::add_gate(Vec2 const dimensions, math::Vec2 const coordinates,
-                       Gate_Kind const kind)
+  Gate& Scene::add_gate(Vec2 const dimensions, math::Vec2 const coordinates,
+                        Gate_Kind const kind)
   {
-    Gate& gate = *gates.emplace_back(dimensions, coordinates, kind);
+    return add_gate(dimensions, coordinates, kind, next_gate_id);
+  }
+
+  Gate& Scene::add_gate(Vec2 const dimensions, math::Vec2 const coordinates,
+                        Gate_Kind const kind, u64 const id,
+                        Module_Definition* const definition,
+                        Memory_Definition* const memory, u32 const width)
+  {
+    Gate& gate = *gates.emplace_back(dimensions, coordinates, kind, definition,
+                                     memory, width);
+    gate.id = id;
+    next_gate_id = math::max(next_gate_id, id + 1);
+    gates_by_id.emplace(id, &gate);
+    u32 const box = gate_bounds.add(get_bounds(gate));
+    if(box < bounded_gates.size()) {
+      bounded_gates[box] = &gate;
+    } else {
+      bounded_gates.push_back(&gate);
+    }
+    gate_boxes.emplace(id, box);
+    // Removing the gate disconnects its ports, which changes the revision as
+    // well. An unconnected gate is in no loop.
+    u64 const revision = get_connection_revision();
+    bump_connection_revision();
+    carry_loops(loops, revision);
     for(Port* p: gate.in_ports) {
       ports.push_back(p);
     }
     for(Port* p: gate.out_ports) {
       ports.push_back(p);
     }
+    return gate;
+  }
+
+  Gate* Scene::find_gate(u64 const id)
+  {
+    auto iter = gates_by_id.find(id);
+    if(iter != gates_by_id.end()) {
+      return iter->value;
+    } else {
+      return nullptr;
+    }
+  }
+
+  void Scene::move_gate(Gate& gate, Vec2 const offset)
+  {
+    gate.move(offset);
+    auto iter = gate_boxes.find(gate.id);
+    if(iter != gate_boxes.end()) {
+      gate_bounds.update(iter->value, get_bounds(gate));
+    }
   }
 
   Gate* Scene::check_if_gate_clicked(Vec2 const mouse_position)
@@ -44,18 +95,26 @@ namespace nebula {
   void Scene::create_tmp_port(Port* p, Vec2 const coordinates,
                               Port_Kind const type)
   {
-    Port* tmp_port = new Port(coordinates, type, nullptr);
+    Port* tmp_port = new Port(coordinates, type, nullptr, 0);
     ports.emplace_back(tmp_port);
+    // The temporary port belongs to no gate, hence closes no loop.
+    u64 const revision = get_connection_revision();
     p->add_connection(tmp_port);
     tmp_port->add_connection(p);
+    carry_loops(loops, revision);
     tmp_port_exists = true;
   }
 
   void Scene::connect_ports(Port* p1, Port* p2)
   {
-    remove_tmp_port(p1);
+    u64 const revision = get_connection_revision();
     p1->add_connection(p2);
     p2->add_connection(p1);
+    if(p1->kind == Port_Kind::out) {
+      add_loop_connection(loops, p1, p2, revision);
+    } else {
+      add_loop_connection(loops, p2, p1, revision);
+    }
   }
 
   void Scene::move_tmp_port(Vec2 const offset)
@@ -66,7 +125,9 @@ namespace nebula {
   void Scene::remove_tmp_port(Port* p)
   {
     Port* tmp_port = ports.back();
+    u64 const revision = get_connection_revision();
     p->remove_connection(tmp_port);
+    carry_loops(loops, revision);
     ports.pop_back();
     delete tmp_port;
     tmp_port_exists = false;
@@ -74,40 +135,72 @@ namespace nebula {
 
   void Scene::delete_gate(Gate* gate)
   {
-    for(Port* p: gate->in_ports) {
-      // Remove all IN ports from ports list
-      for(auto it = ports.begin(); it != ports.end(); ++it) {
-        auto c = it;
-        if((*it) == p) {
-          ports.erase(c, ++it);
-          break;
-        }
+    delete_gates(Slice<Gate* const>(&gate, 1));
+  }
+
+  void Scene::delete_gates(Slice<Gate* const> const deleted)
+  {
+    if(deleted.size() == 0) {
+      return;
+    }
+
+    for(Gate* const gate: deleted) {
+      for(Port* p: gate->in_ports) {
+        p->remove_all_connections();
+      }
+      for(Port* p: gate->out_ports) {
+        p->remove_all_connections();
+      }
+      if(currently_moved_gate == gate) {
+        currently_moved_gate = nullptr;
+      }
+      // Gates are marked deleted by removing them from the id map.
+      auto iter = gates_by_id.find(gate->id);
+      if(iter != gates_by_id.end()) {
+        gates_by_id.erase(iter);
+      }
+      auto box = gate_boxes.find(gate->id);
+      if(box != gate_boxes.end()) {
+        gate_bounds.remove(box->value);
+        bounded_gates[box->value] = nullptr;
+        gate_boxes.erase(box);
       }
-      // Remove connections
-      p->remove_all_connections();
-      delete p;
     }
 
-    for(Port* p: gate->out_ports) {
-      // Remove all OUT ports from ports list
-      for(auto it = ports.begin(); it != ports.end(); ++it) {
-        auto c = it;
-        if((*it) == p) {
-          ports.erase(c, ++it);
-          break;
-        }
+    // Remove the ports of the deleted gates from the ports list preserving
+    // the order of the remaining ports. The temporary port has no gate and
+    // stays last.
+    i64 remaining = 0;
+    for(i64 i = 0; i < ports.size(); ++i) {
+      Port* const p = ports[i];
+      if(p->gate != nullptr && find_gate(p->gate->id) != p->gate) {
+        delete p;
+        continue;
+      }
+      ports[remaining] = p;
+      remaining += 1;
+    }
+    ports.erase(ports.begin() + remaining, ports.end());
+
+    remaining = 0;
+    for(i64 i = 0; i < selected_gates.size(); ++i) {
+      Gate* const gate = selected_gates[i];
+      if(find_gate(gate->id) == gate) {
+        selected_gates[remaining] = gate;
+        remaining += 1;
       }
-      p->remove_all_connections();
-      delete p;
     }
-    currently_moved_gate = nullptr;
+    selected_gates.erase(selected_gates.begin() + remaining,
+                         selected_gates.end());
 
-    // Remove gate from gates list
-    for(auto it = gates.begin(); it != gates.end(); ++it) {
-      if(&(*it) == gate) {
+    // Remove gates from gates list
+    for(auto it = gates.begin(); it != gates.end();) {
+      auto next = it;
+      ++next;
+      if(find_gate(it->id) != &(*it)) {
         gates.erase(it);
-        break;
       }
+      it = next;
     }
   }
 
@@ -1,7 +1,14 @@
 #pragma once
 
+#include <anton/flat_hash_map.hpp>
+#include <anton/slice.hpp>
+
+#include <core/spatial_index.hpp>
 #include <core/types.hpp>
 #include <model/gate.hpp>
+#include <model/loops.hpp>
+#include <model/memory.hpp>
+#include <model/module.hpp>
 
 namespace nebula {
   /**
@@ -12,6 +19,8 @@ namespace nebula {
     camera_moving,
     gate_moving,
     port_linking,
+    selecting,
+    selection_moving,
   };
 
   /**
@@ -22,11 +31,35 @@ namespace nebula {
     Window_Mode mode = Window_Mode::none;
     Vec2 last_mouse_position;
     Gate* currently_moved_gate = nullptr;
+    Array<Gate*> selected_gates;
+    // Corner of the selection rectangle where selecting started.
+    Vec2 selection_start;
     Port* connected_port = nullptr;
     List<Gate> gates;
     Array<Port*> ports;
     Vec2 viewport_size = {1920, 1080};
     bool tmp_port_exists = false;
+    // Identifier assigned to the next added gate.
+    u64 next_gate_id = 1;
+    Flat_Hash_Map<u64, Gate*> gates_by_id;
+    // Module definitions instantiated by e_module gates. Definitions are never
+    // removed, hence gates may keep pointers to them.
+    List<Module_Definition> modules;
+    // Memory definitions instantiated by e_ram and e_rom gates. Never removed
+    // like module definitions.
+    List<Memory_Definition> memories;
+    // Combinational loops of the gates. Kept up to date by connect_ports
+    // while the connections are only added, found anew by update_loops
+    // otherwise.
+    Combinational_Loops loops;
+    // Bounds of the gates kept up to date by add_gate, move_gate and
+    // delete_gates. Used by the selection and the router.
+    Spatial_Index gate_bounds;
+    // Gates by the index of their box in gate_bounds. Removed boxes map to
+    // nullptr.
+    Array<Gate*> bounded_gates;
+    // Index of the box in gate_bounds by gate identifier.
+    Flat_Hash_Map<u64, u32> gate_boxes;
 
   public:
     ~Scene();
@@ -41,9 +74,50 @@ namespace nebula {
      * @param dimensions The dimensions of the new gate.
      * @param coordinates The coordinates of the new gate.
      * @param kind The kind of gate to be created.
+     * @return Reference to the newly created gate.
+     */
+    Gate& add_gate(math::Vec2 dimensions, math::Vec2 coordinates,
+                   Gate_Kind kind);
+
+    /**
+     * @brief Adds a new gate with a given identifier.
+     *
+     * Used to restore deleted gates. The identifier must not be used by any
+     * gate in the scene.
+     *
+     * @param dimensions The dimensions of the new gate.
+     * @param coordinates The coordinates of the new gate.
+     * @param kind The kind of gate to be created.
+     * @param id The identifier of the new gate.
+     * @param definition The definition of the module if kind is e_module.
+     * @param memory The definition of the memory if kind is e_ram or e_rom.
+     * @param width The number of bits if kind is e_register.
+     * @return Reference to the newly created gate.
+     */
+    Gate& add_gate(math::Vec2 dimensions, math::Vec2 coordinates,
+                   Gate_Kind kind, u64 id,
+                   Module_Definition* definition = nullptr,
+                   Memory_Definition* memory = nullptr,
+                   u32 width = default_register_width);
+
+    /**
+     * @brief Finds a gate by its identifier.
+     *
+     * @param id The identifier of the gate.
+     * @return Pointer to the gate, or nullptr if no gate has the identifier.
+     */
+    [[nodiscard]] Gate* find_gate(u64 id);
+
+    /**
+     * @brief Moves a gate by the specified offset.
+     *
+     * Gates must be moved with this function so that their bounds remain up to
+     * date.
+     *
+     * @param gate The gate to move.
+     * @param offset The offset vector.
      */
-    void add_gate(math::Vec2 dimensions, math::Vec2 coordinates,
-                  Gate_Kind kind);
+    void move_gate(Gate& gate, Vec2 offset);
 
     /**
      * @brief Deletes the specified gate from the scene.
@@ -54,6 +128,17 @@ namespace nebula {
      */
     void delete_gate(Gate* gate);
 
+    /**
+     * @brief Deletes multiple gates from the scene.
+     *
+     * Removes the connections, the ports and the gates in a single pass over
+     * the scene, which is considerably faster than deleting the gates one by
+     * one. Deleted gates are removed from the selection.
+     *
+     * @param gates The gates to be deleted.
+     */
+    void delete_gates(Slice<Gate* const> gates);
+
     /**
      * @brief Checks if any gate has been clicked at the given mouse position.
      *
@@ -101,10 +186,11 @@ namespace nebula {
     void remove_tmp_port(Port* p);
 
     /**
-     * @brief Connects two ports and removes the temporary port.
+     * @brief Connects two ports.
      *
-     * This function connects two ports and removes the temporary port used for
-     * linking.
+     * This function connects two ports. The temporary port used for linking
+     * must be removed with remove_tmp_port beforehand. Known loops are
+     * updated by searching the fanout of the reader for the driver.
      *
      * @param p1 The first port to connect.
      * @param p2 The second port to connect.
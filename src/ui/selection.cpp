@@ -0,0 +1,165 @@
+#include <ui/selection.hpp>
+
+#include <anton/flat_hash_map.hpp>
+#include <anton/math/math.hpp>
+
+#include <core/spatial_index.hpp>
+#include <ui/scene.hpp>
+
+namespace nebula {
+  void select_gates(Scene& scene, Vec2 const corner1, Vec2 const corner2)
+  {
+    AABB const rectangle{
+      Vec2{math::min(corner1.x, corner2.x), math::min(corner1.y, corner2.y)},
+      Vec2{math::max(corner1.x, corner2.x), math::max(corner1.y, corner2.y)}};
+    Array<u32> hits;
+    scene.gate_bounds.query(rectangle, hits);
+    scene.selected_gates.clear();
+    for(u32 const hit: hits) {
+      // Select only the gates entirely within the rectangle.
+      Gate* const gate = scene.bounded_gates[hit];
+      Vec2 const max = gate->coordinates + gate->dimensions;
+      if(gate->coordinates.x >= rectangle.min.x &&
+         gate->coordinates.y >= rectangle.min.y && max.x <= rectangle.max.x &&
+         max.y <= rectangle.max.y) {
+        scene.selected_gates.push_back(gate);
+      }
+    }
+  }
+
+  void clear_selection(Scene& scene)
+  {
+    scene.selected_gates.clear();
+  }
+
+  bool is_selected(Scene const& scene, Gate const* const gate)
+  {
+    for(Gate const* const selected: scene.selected_gates) {
+      if(selected == gate) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void move_selection(Scene& scene, Journal& journal, Vec2 const offset)
+  {
+    for(Gate* const gate: scene.selected_gates) {
+      scene.move_gate(*gate, offset);
+    }
+    record_move(journal, scene.selected_gates, offset);
+  }
+
+  void delete_selection(Scene& scene, Journal& journal)
+  {
+    // delete_gates removes the gates from the selection, hence the selection
+    // must not be passed directly.
+    Array<Gate*> gates = ANTON_MOV(scene.selected_gates);
+    scene.selected_gates = Array<Gate*>();
+    record_removed_gates(journal, gates);
+    scene.delete_gates(gates);
+  }
+
+  void copy_selection(Scene const& scene, Clipboard& clipboard)
+  {
+    clipboard.gates.clear();
+    clipboard.connections.clear();
+    if(scene.selected_gates.size() == 0) {
+      return;
+    }
+
+    Flat_Hash_Map<u64, u32> indices;
+    Vec2 origin = scene.selected_gates[0]->coordinates;
+    clipboard.gates.ensure_capacity(scene.selected_gates.size());
+    for(Gate const* const gate: scene.selected_gates) {
+      indices.emplace(gate->id, clipboard.gates.size());
+      clipboard.gates.push_back(make_gate_record(*gate));
+      origin = Vec2{math::min(origin.x, gate->coordinates.x),
+                    math::min(origin.y, gate->coordinates.y)};
+    }
+    clipboard.origin = origin;
+
+    // Every connection has exactly one IN port, hence visiting the IN ports
+    // finds every internal connection once.
+    for(i64 i = 0; i < scene.selected_gates.size(); ++i) {
+      Gate const* const gate = scene.selected_gates[i];
+      for(i64 in_index = 0; in_index < gate->in_ports.size(); ++in_index) {
+        for(Port const* const other: gate->in_ports[in_index]->connections) {
+          if(other->gate == nullptr) {
+            continue;
+          }
+
+          auto iter = indices.find(other->gate->id);
+          if(iter == indices.end()) {
+            continue;
+          }
+
+          clipboard.connections.push_back(Connection_Record{
+            iter->value, static_cast<u64>(i), other->index,
+            static_cast<u32>(in_index)});
+        }
+      }
+    }
+  }
+
+  void paste(Scene& scene, Journal& journal, Clipboard const& clipboard,
+             Vec2 const position)
+  {
+    Array<Gate*> pasted{anton::reserve, clipboard.gates.size()};
+    for(Gate_Record const& record: clipboard.gates) {
+      Vec2 const coordinates = record.coordinates - clipboard.origin + position;
+      pasted.push_back(
+        &restore_gate(scene, record, coordinates, scene.next_gate_id));
+    }
+
+    for(Connection_Record const& record: clipboard.connections) {
+      Port* const out = pasted[record.out_gate]->out_ports[record.out_port];
+      Port* const in = pasted[record.in_gate]->in_ports[record.in_port];
+      scene.connect_ports(out, in);
+    }
+
+    record_added_gates(journal, pasted);
+    scene.selected_gates = ANTON_MOV(pasted);
+  }
+
+  rendering::Draw_Elements_Command prepare_draw_frame(Vec2 const min,
+                                                      Vec2 const max,
+                                                      math::Vec3 const color)
+  {
+    f32 const thickness = 0.02f;
+    // Left, right, bottom and top edges.
+    AABB const edges[] = {
+      {Vec2{min.x - thickness, min.y}, Vec2{min.x + thickness, max.y}},
+      {Vec2{max.x - thickness, min.y}, Vec2{max.x + thickness, max.y}},
+      {Vec2{min.x - thickness, min.y - thickness},
+       Vec2{max.x + thickness, min.y + thickness}},
+      {Vec2{min.x - thickness, max.y - thickness},
+       Vec2{max.x + thickness, max.y + thickness}},
+    };
+    Vertex vert[16];
+    u32 indices[24];
+    for(i64 i = 0; i < 4; ++i) {
+      AABB const& edge = edges[i];
+      vert[4 * i + 0] = Vertex{.position = {edge.max.x, edge.max.y, 0.0f},
+                               .normal = color,
+                               .uv = {1.0f, 1.0f}};
+      vert[4 * i + 1] = Vertex{.position = {edge.min.x, edge.max.y, 0.0f},
+                               .normal = color,
+                               .uv = {0.0f, 1.0f}};
+      vert[4 * i + 2] = Vertex{.position = {edge.max.x, edge.min.y, 0.0f},
+                               .normal = color,
+                               .uv = {1.0f, 0.0f}};
+      vert[4 * i + 3] = Vertex{.position = {edge.min.x, edge.min.y, 0.0f},
+                               .normal = color,
+                               .uv = {0.0f, 0.0f}};
+      u32 const quad[] = {0, 1, 2, 1, 3, 2};
+      for(i64 j = 0; j < 6; ++j) {
+        indices[6 * i + j] = 4 * i + quad[j];
+      }
+    }
+    rendering::Draw_Elements_Command cmd =
+      rendering::write_geometry(vert, indices);
+    cmd.instance_count = 1;
+    return cmd;
+  }
+} // namespace nebula
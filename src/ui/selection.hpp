@@ -0,0 +1,79 @@
+#pragma once
+
+#include <core/types.hpp>
+#include <rendering/rendering.hpp>
+#include <ui/journal.hpp>
+
+namespace nebula {
+  struct Scene;
+
+  /**
+   * @brief Copied gates and the connections between them.
+   */
+  struct Clipboard {
+    Array<Gate_Record> gates;
+    // Connections between the copied gates. The gate fields are indices into
+    // gates rather than identifiers.
+    Array<Connection_Record> connections;
+    // Top-left corner of the bounds of the copied gates.
+    Vec2 origin;
+  };
+
+  /**
+   * @brief Replaces the selection with the gates inside a rectangle.
+   *
+   * Gates are found with a range query on a spatial index of the gates.
+   *
+   * @param scene The scene to select in.
+   * @param corner1 A corner of the rectangle.
+   * @param corner2 The opposite corner of the rectangle.
+   */
+  void select_gates(Scene& scene, Vec2 corner1, Vec2 corner2);
+
+  void clear_selection(Scene& scene);
+
+  [[nodiscard]] bool is_selected(Scene const& scene, Gate const* gate);
+
+  /**
+   * @brief Moves all selected gates.
+   *
+   * Consecutive moves are coalesced into a single journal entry until the
+   * journal is sealed.
+   */
+  void move_selection(Scene& scene, Journal& journal, Vec2 offset);
+
+  /**
+   * @brief Deletes all selected gates as a single journal entry.
+   */
+  void delete_selection(Scene& scene, Journal& journal);
+
+  /**
+   * @brief Copies the selected gates and the connections between them.
+   *
+   * Connections to gates outside of the selection are not copied.
+   */
+  void copy_selection(Scene const& scene, Clipboard& clipboard);
+
+  /**
+   * @brief Adds the gates of a clipboard to a scene and selects them.
+   *
+   * All gates are created first, then the connections are duplicated in a
+   * single pass. The paste is a single journal entry.
+   *
+   * @param scene The scene to paste into.
+   * @param journal The journal to record the paste in.
+   * @param clipboard The gates to paste.
+   * @param position The position of the top-left corner of the pasted gates.
+   */
+  void paste(Scene& scene, Journal& journal, Clipboard const& clipboard,
+             Vec2 position);
+
+  /**
+   * @brief Prepares draw command for rendering the outline of a rectangle.
+   *
+   * Used to draw the selection rectangle and to highlight gates.
+   */
+  [[nodiscard]] rendering::Draw_Elements_Command
+  prepare_draw_frame(Vec2 min, Vec2 max,
+                     math::Vec3 color = math::Vec3{0.3f, 0.6f, 1.0f});
+} // namespace nebula
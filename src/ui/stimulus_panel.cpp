@@ -0,0 +1,211 @@
+#include <ui/stimulus_panel.hpp>
+
+#include <anton/format.hpp>
+#include <anton/math/math.hpp>
+
+#include <core/time.hpp>
+#include <evaluator/batch.hpp>
+#include <model/port.hpp>
+#include <ui/scene.hpp>
+
+#include <imgui.h>
+
+namespace nebula {
+  // make_test_vectors
+  //
+  // Make the vectors selected in the panel. Exhaustive and random vectors
+  // drive all inputs of the scene.
+  //
+  [[nodiscard]] static Expected<Test_Vectors, Error>
+  make_test_vectors(Stimulus_Panel const& panel, Scene& scene)
+  {
+    if(panel.order == 2) {
+      return load_vectors(scene, panel.path);
+    }
+
+    Array<Gate*> inputs;
+    for(Gate& gate: scene.gates) {
+      if(gate.kind == Gate_Kind::e_input) {
+        inputs.push_back(&gate);
+      }
+    }
+
+    if(panel.order == 0) {
+      return make_exhaustive_vectors(inputs);
+    } else {
+      return {expected_value,
+              make_random_vectors(inputs, panel.count,
+                                  static_cast<u64>(panel.seed))};
+    }
+  }
+
+  [[nodiscard]] static String format_check(Vector_Check const& check)
+  {
+    if(check.mismatches == 0) {
+      return format("{} vectors matched"_sv, check.vectors);
+    }
+
+    return format("{} of {} vectors mismatched, first at vector {}: '{}' "
+                  "should be {}"_sv,
+                  check.mismatches, check.vectors, check.first_vector,
+                  check.first_output->name,
+                  static_cast<i32>(check.first_expected));
+  }
+
+  static void stop_driving(Stimulus_Panel& panel, bool& running,
+                           String status)
+  {
+    panel.driving = false;
+    running = false;
+    panel.vectors = Test_Vectors();
+    panel.status = ANTON_MOV(status);
+  }
+
+  static void start_driving(Stimulus_Panel& panel, Scene& scene,
+                            bool& levelized, bool& running)
+  {
+    Expected<Test_Vectors, Error> made = make_test_vectors(panel, scene);
+    if(!made) {
+      stop_driving(panel, running, ANTON_MOV(made.error()));
+      return;
+    }
+    if(made.value().count == 0) {
+      stop_driving(panel, running, String("There are no vectors"));
+      return;
+    }
+
+    panel.vectors = ANTON_MOV(made.value());
+    panel.check = Vector_Check();
+    panel.index = 0;
+    panel.revision = get_connection_revision();
+    panel.gate_count = scene.gates.size();
+    panel.status = String();
+    // The outputs are compared within the cycle the vector is applied in,
+    // hence the combinational logic must settle.
+    levelized = true;
+  }
+
+  // run_batch
+  //
+  // Evaluate all vectors 64 at a time without touching the state of the
+  // scene.
+  //
+  static void run_batch(Stimulus_Panel& panel, Scene& scene,
+                        bool const four_valued)
+  {
+    Expected<Test_Vectors, Error> made = make_test_vectors(panel, scene);
+    if(!made) {
+      panel.status = ANTON_MOV(made.error());
+      return;
+    }
+
+    Test_Vectors const& vectors = made.value();
+    Expected<Batch_Program, Error> compiled =
+      compile_batch(scene, vectors.inputs);
+    if(!compiled) {
+      panel.status = ANTON_MOV(compiled.error());
+      return;
+    }
+
+    Batch_Program const& program = compiled.value();
+    Array<u64> slots;
+    slots.resize(program.slot_count);
+    Array<u64> unknowns;
+    if(four_valued) {
+      unknowns.resize(program.slot_count, 0);
+    }
+    Vector_Check check;
+    f64 const start = get_time();
+    for(i64 first = 0; first < vectors.count; first += batch_width) {
+      fill_batch_inputs(vectors, program, first, slots);
+      if(four_valued) {
+        evaluate_batch_logic(program, slots, unknowns);
+      } else {
+        evaluate_batch(program, slots);
+      }
+      check_batch(vectors, program, first, slots, unknowns, check);
+    }
+    i64 const microseconds =
+      static_cast<i64>((get_time() - start) * 1000000.0);
+    if(vectors.outputs.size() > 0) {
+      panel.status = format("{} in {} us"_sv, format_check(check),
+                            microseconds);
+    } else {
+      panel.status = format("{} vectors in {} us"_sv, vectors.count,
+                            microseconds);
+    }
+  }
+
+  void display_stimulus(Stimulus_Panel& panel, Scene& scene,
+                        bool const four_valued, bool& levelized, bool& running)
+  {
+    ImGui::Begin("Stimulus");
+    char const* const orders[] = {"Exhaustive", "Random", "File"};
+    ImGui::Combo("Vectors", &panel.order, orders, 3);
+    if(panel.order == 1) {
+      ImGui::InputInt("Count", &panel.count);
+      ImGui::InputInt("Seed", &panel.seed);
+      panel.count = math::max(panel.count, 1);
+    } else if(panel.order == 2) {
+      ImGui::InputText("Path", panel.path, sizeof(panel.path));
+    }
+
+    if(ImGui::Checkbox("Drive inputs", &panel.driving)) {
+      if(panel.driving) {
+        start_driving(panel, scene, levelized, running);
+      } else {
+        stop_driving(panel, running, String());
+      }
+    }
+    ImGui::SameLine();
+    if(ImGui::Button("Run batch")) {
+      run_batch(panel, scene, four_valued);
+    }
+
+    if(panel.driving) {
+      String const status = format("Vector {} of {}, {} mismatched"_sv,
+                                   panel.index, panel.vectors.count,
+                                   panel.check.mismatches);
+      ImGui::TextUnformatted(status.data());
+    }
+    if(panel.status.size_bytes() > 0) {
+      ImGui::TextWrapped("%s", panel.status.data());
+    }
+    ImGui::End();
+  }
+
+  void apply_stimulus(Stimulus_Panel& panel, Scene const& scene,
+                      bool& running)
+  {
+    if(!panel.driving) {
+      return;
+    }
+
+    if(panel.revision != get_connection_revision() ||
+       panel.gate_count != scene.gates.size()) {
+      stop_driving(panel, running,
+                   String("The design changed, the vectors were dropped"));
+    } else {
+      apply_vector(panel.vectors, panel.index);
+    }
+  }
+
+  void check_stimulus(Stimulus_Panel& panel, bool& running)
+  {
+    if(!panel.driving) {
+      return;
+    }
+
+    Test_Vectors const& vectors = panel.vectors;
+    if(vectors.outputs.size() > 0) {
+      check_vector(vectors, panel.index, panel.check);
+    }
+    panel.index += 1;
+    if(panel.index == vectors.count) {
+      String status = vectors.outputs.size() > 0
+                        ? format_check(panel.check)
+                        : format("Applied {} vectors"_sv, vectors.count);
+      stop_driving(panel, running, ANTON_MOV(status));
+    }
+  }
+} // namespace nebula
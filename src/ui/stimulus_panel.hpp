@@ -0,0 +1,61 @@
+#pragma once
+
+#include <anton/string.hpp>
+
+#include <core/types.hpp>
+#include <simulation/stimulus.hpp>
+
+namespace nebula {
+  struct Scene;
+
+  /**
+   * @brief State of the stimulus panel, the test vectors applied to the
+   * inputs, one per cycle, while driving.
+   */
+  struct Stimulus_Panel {
+    // 0 is exhaustive, 1 is random, 2 is loaded from the path.
+    int order = 0;
+    int count = 1000;
+    int seed = 1;
+    char path[512] = {};
+    bool driving = false;
+    Test_Vectors vectors;
+    Vector_Check check;
+    i64 index = 0;
+    // The vectors refer to the gates, hence they are dropped once the
+    // connections or the number of gates change.
+    u64 revision = 0;
+    i64 gate_count = 0;
+    String status;
+  };
+
+  /**
+   * @brief Displays the stimulus panel which drives the inputs with the
+   * vectors or evaluates all of them in batches.
+   *
+   * @param four_valued Whether the batches are evaluated in the four-valued
+   * logic.
+   * @param levelized Set once driving starts since the outputs are compared
+   * within the cycle the vector is applied in.
+   * @param running Whether the simulation runs. Cleared once driving stops.
+   */
+  void display_stimulus(Stimulus_Panel& panel, Scene& scene, bool four_valued,
+                        bool& levelized, bool& running);
+
+  /**
+   * @brief Applies the current vector to the inputs before a cycle is
+   * evaluated. Drops the vectors if the design changed.
+   *
+   * @param running Cleared if the vectors are dropped.
+   */
+  void apply_stimulus(Stimulus_Panel& panel, Scene const& scene,
+                      bool& running);
+
+  /**
+   * @brief Compares the outputs with the current vector after a cycle has
+   * been evaluated and advances to the next vector.
+   *
+   * @param running Cleared once the last vector has been checked.
+   */
+  void check_stimulus(Stimulus_Panel& panel, bool& running);
+} // namespace nebula
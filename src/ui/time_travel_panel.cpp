@@ -0,0 +1,41 @@
+#include <ui/time_travel_panel.hpp>
+
+#include <anton/format.hpp>
+
+#include <imgui.h>
+
+namespace nebula {
+  i64 display_time_travel(Timeline& timeline, bool& time_travel,
+                          i64 const cycle)
+  {
+    if(ImGui::Checkbox("Time travel", &time_travel)) {
+      if(time_travel) {
+        start_timeline(timeline, Timeline_Options{});
+      } else {
+        clear_timeline(timeline);
+      }
+    }
+
+    i64 const first_cycle = get_timeline_first_cycle(timeline);
+    i64 const last_cycle = get_timeline_last_cycle(timeline);
+    if(!time_travel || first_cycle < 0) {
+      return -1;
+    }
+
+    i64 seek = -1;
+    i64 selected = cycle;
+    if(ImGui::SliderScalar("Cycle", ImGuiDataType_S64, &selected, &first_cycle,
+                           &last_cycle)) {
+      seek = selected;
+    }
+    if(ImGui::Button("Step back") && cycle > first_cycle) {
+      seek = cycle - 1;
+    }
+
+    String const status =
+      format("{} snapshots, {} KiB"_sv, timeline.segments.size(),
+             timeline.size / 1024);
+    ImGui::TextUnformatted(status.data());
+    return seek;
+  }
+} // namespace nebula
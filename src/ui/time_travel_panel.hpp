@@ -0,0 +1,18 @@
+#pragma once
+
+#include <core/types.hpp>
+#include <simulation/timeline.hpp>
+
+namespace nebula {
+  /**
+   * @brief Displays the time travel controls, which start or stop recording
+   * the timeline and pick a recorded cycle to seek to.
+   *
+   * @param timeline The timeline to record into.
+   * @param time_travel Whether the simulation records into the timeline.
+   * @param cycle The last evaluated cycle.
+   * @return The cycle to seek to or -1.
+   */
+  [[nodiscard]] i64 display_time_travel(Timeline& timeline, bool& time_travel,
+                                        i64 cycle);
+} // namespace nebula
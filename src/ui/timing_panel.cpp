@@ -0,0 +1,62 @@
+#include <ui/timing_panel.hpp>
+
+#include <anton/format.hpp>
+#include <anton/math/math.hpp>
+
+#include <model/port.hpp>
+#include <ui/scene.hpp>
+#include <ui/selection.hpp>
+
+#include <imgui.h>
+
+namespace nebula {
+  [[nodiscard]] static String get_gate_label(Gate const& gate)
+  {
+    if(gate.name.size_bytes() > 0) {
+      return gate.name;
+    } else {
+      return format("g{}"_sv, gate.id);
+    }
+  }
+
+  void display_timing(Timed_Schedule& timing, Scene& scene)
+  {
+    // The gates of the glitches may have been deleted since the last tick.
+    if(timing.revision != get_connection_revision() ||
+       timing.gate_count != scene.gates.size()) {
+      timing.glitches.clear();
+    }
+
+    String const status =
+      format("Time {}, {} events, {} glitches"_sv, timing.time, timing.events,
+             timing.glitch_count);
+    ImGui::TextUnformatted(status.data());
+    int glitch_width = static_cast<int>(timing.glitch_width);
+    if(ImGui::InputInt("Glitch width", &glitch_width)) {
+      timing.glitch_width = math::max(glitch_width, 0);
+    }
+
+    Array<Glitch> const& glitches = timing.glitches;
+    i64 const shown = math::min(glitches.size(), static_cast<i64>(8));
+    for(i64 i = glitches.size() - shown; i < glitches.size(); ++i) {
+      Glitch const& glitch = glitches[i];
+      String const line = format("{} pulsed for {} ticks at {}"_sv,
+                                 get_gate_label(*glitch.gate), glitch.width,
+                                 glitch.time);
+      ImGui::TextUnformatted(line.data());
+    }
+
+    if(ImGui::Button("Select glitching gates")) {
+      clear_selection(scene);
+      for(Glitch const& glitch: glitches) {
+        if(!is_selected(scene, glitch.gate)) {
+          scene.selected_gates.push_back(glitch.gate);
+        }
+      }
+    }
+    ImGui::SameLine();
+    if(ImGui::Button("Clear glitches")) {
+      timing.glitches.clear();
+    }
+  }
+} // namespace nebula
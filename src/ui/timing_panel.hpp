@@ -0,0 +1,17 @@
+#pragma once
+
+#include <core/types.hpp>
+#include <evaluator/evaluator.hpp>
+
+namespace nebula {
+  struct Scene;
+
+  /**
+   * @brief Displays the state of the timed evaluation and the latest
+   * glitches, and selects the glitching gates.
+   *
+   * @param timing The schedule of the timed evaluation. Its glitches are
+   * cleared if the gates have changed since the last tick.
+   */
+  void display_timing(Timed_Schedule& timing, Scene& scene);
+} // namespace nebula
@@ -0,0 +1,192 @@
+#include <ui/waveform_panel.hpp>
+
+#include <anton/format.hpp>
+#include <anton/math/math.hpp>
+
+#include <logging/logging.hpp>
+#include <ui/scene.hpp>
+
+#include <imgui.h>
+
+namespace nebula {
+  static void start_recording(Waveform_Panel& panel, History& history,
+                              bool& recording, Slice<Gate* const> const gates)
+  {
+    Expected<void, Error> result =
+      start_history(history, gates, History_Options{});
+    if(!result) {
+      LOG_ERROR("recording failed: {}", result.error());
+      recording = false;
+      return;
+    }
+
+    recording = true;
+    panel.follow = true;
+  }
+
+  [[nodiscard]] static i64 floor_cycle(f64 const cycle)
+  {
+    i64 const truncated = static_cast<i64>(cycle);
+    return static_cast<f64>(truncated) > cycle ? truncated - 1 : truncated;
+  }
+
+  // draw_waveform
+  //
+  // Draw the recorded values of a signal within the visible range. Changes
+  // closer than a pixel are merged into a filled block.
+  //
+  static void draw_waveform(Waveform_Panel& panel, History& history,
+                            ImDrawList* const draw_list, i64 const signal,
+                            ImVec2 const origin, f32 const width,
+                            f32 const height)
+  {
+    f64 const ppc = panel.pixels_per_cycle;
+    f64 const first_cycle = panel.first_cycle;
+    i64 const begin = math::max(history.first_cycle, floor_cycle(first_cycle));
+    i64 const last_visible = floor_cycle(first_cycle + width / ppc);
+    i64 const end = math::min(history.last_cycle + 1, last_visible + 2);
+    if(begin >= end) {
+      return;
+    }
+
+    auto get_x = [origin, first_cycle, ppc, width](i64 const cycle) -> f32 {
+      f64 const x = (static_cast<f64>(cycle) - first_cycle) * ppc;
+      f64 const clamped = math::min(math::max(x, 0.0), static_cast<f64>(width));
+      return origin.x + static_cast<f32>(clamped);
+    };
+
+    ImU32 const color = IM_COL32(80, 220, 120, 255);
+    f32 const high = origin.y + 2.0f;
+    f32 const low = origin.y + height - 3.0f;
+    bool value = query_history(history, signal, begin, end, panel.changes);
+    f32 x = get_x(begin);
+    // Start of the block of merged changes or a negative value.
+    f32 block = -1.0f;
+    for(i64 const change: panel.changes) {
+      f32 const change_x = get_x(change);
+      if(change_x - x < 1.0f) {
+        if(block < 0.0f) {
+          block = x;
+        }
+      } else {
+        if(block >= 0.0f) {
+          draw_list->AddRectFilled(ImVec2(block, high), ImVec2(x, low), color);
+          block = -1.0f;
+        }
+        f32 const y = value ? high : low;
+        draw_list->AddLine(ImVec2(x, y), ImVec2(change_x, y), color);
+        draw_list->AddLine(ImVec2(change_x, high), ImVec2(change_x, low),
+                           color);
+      }
+      x = change_x;
+      value = !value;
+    }
+
+    if(block >= 0.0f) {
+      draw_list->AddRectFilled(ImVec2(block, high), ImVec2(x, low), color);
+    }
+    f32 const y = value ? high : low;
+    draw_list->AddLine(ImVec2(x, y), ImVec2(get_x(end), y), color);
+  }
+
+  // update_waveform_view
+  //
+  // Zoom around the mouse with CTRL + wheel and pan by dragging.
+  //
+  static void update_waveform_view(Waveform_Panel& panel, f32 const origin_x)
+  {
+    ImGuiIO const& io = ImGui::GetIO();
+    if(!ImGui::IsWindowHovered()) {
+      return;
+    }
+
+    f64 const mouse_offset = io.MousePos.x - origin_x;
+    if(io.KeyCtrl && io.MouseWheel != 0.0f) {
+      f64 const mouse_cycle =
+        panel.first_cycle + mouse_offset / panel.pixels_per_cycle;
+      f64 const factor = io.MouseWheel > 0.0f ? 1.25 : 0.8;
+      panel.pixels_per_cycle =
+        math::min(math::max(panel.pixels_per_cycle * factor, 1.0e-4), 64.0);
+      panel.first_cycle = mouse_cycle - mouse_offset / panel.pixels_per_cycle;
+      panel.follow = false;
+    }
+
+    if(ImGui::IsMouseDragging(ImGuiMouseButton_Left)) {
+      panel.first_cycle -= io.MouseDelta.x / panel.pixels_per_cycle;
+      panel.follow = false;
+    }
+
+    if(mouse_offset >= 0.0) {
+      i64 const cycle = floor_cycle(panel.first_cycle +
+                                    mouse_offset / panel.pixels_per_cycle);
+      ImGui::SetTooltip("cycle %lld", static_cast<long long>(cycle));
+    }
+  }
+
+  void display_waveforms(Waveform_Panel& panel, Scene& scene, History& history,
+                         bool& recording)
+  {
+    ImGui::Begin("Waveforms");
+    if(ImGui::Button("Record selection") && scene.selected_gates.size() > 0) {
+      start_recording(panel, history, recording, scene.selected_gates);
+    }
+    ImGui::SameLine();
+    if(ImGui::Button("Record all")) {
+      Array<Gate*> gates{anton::reserve, scene.gates.size()};
+      for(Gate& gate: scene.gates) {
+        gates.push_back(&gate);
+      }
+      start_recording(panel, history, recording, gates);
+    }
+    ImGui::SameLine();
+    if(recording && ImGui::Button("Stop")) {
+      recording = false;
+    }
+    ImGui::SameLine();
+    ImGui::Checkbox("Follow", &panel.follow);
+
+    String const status = format(
+      "{} signals, cycles {}-{}, {} KiB in memory, {} KiB paged out"_sv,
+      history.signals.size(), history.first_cycle, history.last_cycle,
+      history.resident_size / 1024, history.paged_size / 1024);
+    ImGui::TextUnformatted(status.data());
+    if(history.signals.size() == 0 ||
+       history.last_cycle < history.first_cycle) {
+      ImGui::End();
+      return;
+    }
+
+    constexpr f32 name_width = 120.0f;
+    constexpr f32 row_height = 18.0f;
+    ImGui::BeginChild("Signals");
+    ImVec2 const origin = ImGui::GetCursorScreenPos();
+    f32 const width =
+      math::max(ImGui::GetContentRegionAvail().x - name_width, 1.0f);
+    update_waveform_view(panel, origin.x + name_width);
+    if(panel.follow) {
+      f64 const visible_cycles = width / panel.pixels_per_cycle;
+      panel.first_cycle =
+        math::max(static_cast<f64>(history.first_cycle),
+                  static_cast<f64>(history.last_cycle + 1) - visible_cycles);
+    }
+
+    // Only the visible rows are decoded.
+    ImDrawList* const draw_list = ImGui::GetWindowDrawList();
+    ImGuiListClipper clipper;
+    clipper.Begin(static_cast<int>(history.signals.size()), row_height);
+    while(clipper.Step()) {
+      for(int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row) {
+        ImVec2 const position = ImGui::GetCursorScreenPos();
+        draw_list->AddText(position, IM_COL32(220, 220, 220, 255),
+                           history.signals[row].name.data());
+        draw_waveform(panel, history, draw_list, row,
+                      ImVec2(position.x + name_width, position.y), width,
+                      row_height);
+        ImGui::Dummy(ImVec2(name_width + width, row_height));
+      }
+    }
+    clipper.End();
+    ImGui::EndChild();
+    ImGui::End();
+  }
+} // namespace nebula
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <core/types.hpp>
+#include <simulation/history.hpp>
+
+namespace nebula {
+  struct Scene;
+
+  /**
+   * @brief View of the waveform panel.
+   */
+  struct Waveform_Panel {
+    // Visible range of the panel.
+    f64 first_cycle = 0.0;
+    f64 pixels_per_cycle = 8.0;
+    // Whether the panel scrolls to the last recorded cycle.
+    bool follow = true;
+    // Scratch buffer of the changes of the drawn signal.
+    Array<i64> changes;
+  };
+
+  /**
+   * @brief Displays the recorded values of a history.
+   *
+   * The panel starts recording the selected or all gates of the scene and
+   * stops the recording. Only the visible rows are decoded.
+   *
+   * @param history The history to display and record into.
+   * @param recording Whether the simulation records into the history.
+   */
+  void display_waveforms(Waveform_Panel& panel, Scene& scene, History& history,
+                         bool& recording);
+} // namespace nebula
@@ -0,0 +1,686 @@
+#include <verification/equivalence.hpp>
+
+#include <anton/flat_hash_map.hpp>
+#include <anton/format.hpp>
+
+#include <model/memory.hpp>
+#include <model/port.hpp>
+#include <ui/scene.hpp>
+#include <verification/sat.hpp>
+
+namespace nebula {
+  // Literals of the and-inverter graph are node * 2 + complemented, hence
+  // they are also the literals of the SAT variables of the nodes.
+  using Aig_Literal = Sat_Literal;
+
+  // Node 0 is the constant false.
+  constexpr Aig_Literal literal_false = 0;
+  constexpr Aig_Literal literal_true = 1;
+  // Fanin of the constant and the input nodes.
+  constexpr Aig_Literal no_fanin = static_cast<Aig_Literal>(-1);
+  // Number of words of random values simulated per node.
+  constexpr i64 signature_words = 8;
+  // Conflicts spent on proving two nodes equivalent while the graph is
+  // built. Most equivalences are proven with few conflicts, while the
+  // others would stall the construction.
+  constexpr i64 sweep_conflict_limit = 100;
+
+  struct Aig_Node {
+    Aig_Literal first;
+    Aig_Literal second;
+  };
+
+  struct Checker {
+    Array<Aig_Node> nodes;
+    // signature_words words of random simulation per node.
+    Array<u64> signatures;
+    // Maps the fanins of an AND to the literal it has been built as.
+    Flat_Hash_Map<u64, Aig_Literal> structures;
+    // Maps the hash of a signature to the first node with that signature.
+    // Signatures are normalized so that their first bit is 0, hence the
+    // stored literal is complemented if the signature of its node is not.
+    Flat_Hash_Map<u64, Aig_Literal> classes;
+    Sat_Solver solver;
+    u64 random_state = 0x9E3779B97F4A7C15;
+    i64 merged = 0;
+    i64 sat_calls = 0;
+  };
+
+  // Signal
+  //
+  // A named input or output of a circuit. Inputs are OUT ports of inputs,
+  // clocks and sequential gates. Outputs are OUT ports of combinational
+  // gates or IN ports of sequential gates, whose drivers are compared.
+  //
+  struct Signal {
+    String name;
+    Gate* gate;
+    Port* port;
+    i64 output;
+  };
+
+  struct Interface {
+    Array<Signal> inputs;
+    Array<Signal> outputs;
+  };
+
+  struct Translator {
+    Checker& checker;
+    // Maps the address of an OUT port to its literal.
+    Flat_Hash_Map<u64, Aig_Literal> literals;
+    // Gates whose literals are being computed.
+    Flat_Hash_Map<u64, bool> visiting;
+
+    explicit Translator(Checker& checker): checker(checker) {}
+  };
+
+  [[nodiscard]] static u64 get_key(void const* const pointer)
+  {
+    return reinterpret_cast<u64>(pointer);
+  }
+
+  [[nodiscard]] static Port* get_driver(Port* const port)
+  {
+    if(port->connections.size() == 1) {
+      return *port->connections.begin();
+    } else {
+      return nullptr;
+    }
+  }
+
+  [[nodiscard]] static String get_gate_name(Gate const& gate)
+  {
+    if(gate.name.size_bytes() > 0) {
+      return gate.name;
+    } else {
+      return format("g{}"_sv, gate.id);
+    }
+  }
+
+  [[nodiscard]] static String_View get_port_name(Gate const& gate,
+                                                 i64 const index)
+  {
+    if(gate.kind == Gate_Kind::e_sr_latch) {
+      return index == 0 ? "S"_sv : "R"_sv;
+    }
+
+    // The D inputs of flip-flops and registers are followed by CLK, EN and
+    // RST.
+    i64 const data_count =
+      gate.kind == Gate_Kind::e_register ? static_cast<i64>(gate.width) : 1;
+    if(index < data_count) {
+      return "D"_sv;
+    } else if(index == data_count) {
+      return "CLK"_sv;
+    } else if(index == data_count + 1) {
+      return "EN"_sv;
+    } else {
+      return "RST"_sv;
+    }
+  }
+
+  // collect_interface
+  //
+  // Name the inputs and the outputs of a circuit. Unnamed gates are named by
+  // their position among the unnamed gates of their category.
+  //
+  [[nodiscard]] static Expected<void, Error>
+  collect_interface(Scene& scene, Interface& interface)
+  {
+    i64 unnamed_inputs = 0;
+    i64 unnamed_states = 0;
+    i64 unnamed_outputs = 0;
+    for(Gate& gate: scene.gates) {
+      if(gate.kind == Gate_Kind::e_module || is_memory(gate.kind)) {
+        return {expected_error,
+                format("'{}' is a module instance or a memory, which are "
+                       "not supported"_sv,
+                       get_gate_name(gate))};
+      }
+
+      if(gate.kind == Gate_Kind::e_input || gate.kind == Gate_Kind::e_clock) {
+        String name = gate.name;
+        if(name.size_bytes() == 0) {
+          name = format("input#{}"_sv, unnamed_inputs);
+          unnamed_inputs += 1;
+        }
+        interface.inputs.push_back(
+          Signal{ANTON_MOV(name), &gate, gate.out_ports[0], 0});
+      } else if(is_sequential(gate.kind)) {
+        String base = gate.name;
+        if(base.size_bytes() == 0) {
+          base = format("state#{}"_sv, unnamed_states);
+          unnamed_states += 1;
+        }
+
+        i64 const output_count = gate.out_ports.size();
+        for(i64 i = 0; i < output_count; ++i) {
+          String name =
+            output_count > 1 ? format("{}[{}]"_sv, base, i) : String(base);
+          interface.inputs.push_back(
+            Signal{ANTON_MOV(name), &gate, gate.out_ports[i], i});
+        }
+
+        for(i64 i = 0; i < gate.in_ports.size(); ++i) {
+          String_View const port = get_port_name(gate, i);
+          String name = gate.kind == Gate_Kind::e_register && i < gate.width
+                          ? format("{}.{}{}"_sv, base, port, i)
+                          : format("{}.{}"_sv, base, port);
+          interface.outputs.push_back(
+            Signal{ANTON_MOV(name), &gate, gate.in_ports[i], 0});
+        }
+      } else if(gate.out_ports[0]->connections.size() == 0) {
+        String name = gate.name;
+        if(name.size_bytes() == 0) {
+          name = format("output#{}"_sv, unnamed_outputs);
+          unnamed_outputs += 1;
+        }
+        interface.outputs.push_back(
+          Signal{ANTON_MOV(name), &gate, gate.out_ports[0], 0});
+      }
+    }
+    return expected_value;
+  }
+
+  [[nodiscard]] static u64 get_random_word(Checker& checker)
+  {
+    // xorshift64*
+    u64 x = checker.random_state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    checker.random_state = x;
+    return x * 0x2545F4914F6CDD1D;
+  }
+
+  [[nodiscard]] static u64 get_signature_word(Checker const& checker,
+                                              Aig_Literal const literal,
+                                              i64 const word)
+  {
+    u64 const mask = (literal & 1) ? ~static_cast<u64>(0) : 0;
+    return checker.signatures[get_variable(literal) * signature_words + word] ^
+           mask;
+  }
+
+  [[nodiscard]] static u64 hash_signature(Checker const& checker,
+                                          Aig_Literal const literal)
+  {
+    u64 hash = 0xCBF29CE484222325;
+    for(i64 i = 0; i < signature_words; ++i) {
+      hash = (hash ^ get_signature_word(checker, literal, i)) * 0x100000001B3;
+    }
+    return hash;
+  }
+
+  [[nodiscard]] static bool compare_signatures(Checker const& checker,
+                                               Aig_Literal const lhs,
+                                               Aig_Literal const rhs)
+  {
+    for(i64 i = 0; i < signature_words; ++i) {
+      if(get_signature_word(checker, lhs, i) !=
+         get_signature_word(checker, rhs, i)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  [[nodiscard]] static Aig_Literal add_node(Checker& checker,
+                                            Aig_Literal const first,
+                                            Aig_Literal const second)
+  {
+    u32 const node = add_variable(checker.solver);
+    checker.nodes.push_back(Aig_Node{first, second});
+    for(i64 i = 0; i < signature_words; ++i) {
+      if(first == no_fanin) {
+        checker.signatures.push_back(node > 0 ? get_random_word(checker) : 0);
+      } else {
+        checker.signatures.push_back(get_signature_word(checker, first, i) &
+                                     get_signature_word(checker, second, i));
+      }
+    }
+    return make_literal(node, false);
+  }
+
+  static void initialize_checker(Checker& checker)
+  {
+    Aig_Literal const constant = add_node(checker, no_fanin, no_fanin);
+    Sat_Literal const clause[] = {negate(constant)};
+    add_clause(checker.solver, Slice<Sat_Literal const>(clause, 1));
+    checker.classes.emplace(hash_signature(checker, constant), constant);
+  }
+
+  // find_difference
+  //
+  // Decide whether two literals may have different values. Literals proven
+  // equal are constrained to be equal, which simplifies later calls.
+  //
+  // Returns:
+  // e_satisfiable with the differing assignment in the model of the solver,
+  // e_unsatisfiable if the literals are equal or e_unknown if the conflict
+  // limit has been reached.
+  //
+  [[nodiscard]] static Sat_Result find_difference(Checker& checker,
+                                                  Aig_Literal const lhs,
+                                                  Aig_Literal const rhs,
+                                                  i64 const conflict_limit)
+  {
+    Sat_Literal const first[] = {lhs, negate(rhs)};
+    checker.sat_calls += 1;
+    Sat_Result const result = solve(
+      checker.solver, Slice<Sat_Literal const>(first, 2), conflict_limit);
+    if(result != Sat_Result::e_unsatisfiable) {
+      return result;
+    }
+
+    Sat_Literal const second[] = {negate(lhs), rhs};
+    checker.sat_calls += 1;
+    Sat_Result const reverse = solve(
+      checker.solver, Slice<Sat_Literal const>(second, 2), conflict_limit);
+    if(reverse != Sat_Result::e_unsatisfiable) {
+      return reverse;
+    }
+
+    Sat_Literal const implication[] = {negate(lhs), rhs};
+    Sat_Literal const converse[] = {lhs, negate(rhs)};
+    add_clause(checker.solver, Slice<Sat_Literal const>(implication, 2));
+    add_clause(checker.solver, Slice<Sat_Literal const>(converse, 2));
+    return Sat_Result::e_unsatisfiable;
+  }
+
+  // sweep_node
+  //
+  // Replace a new node by an earlier node with the same signature if they
+  // are proven equivalent. The constant has the signature of all zeros.
+  //
+  [[nodiscard]] static Aig_Literal sweep_node(Checker& checker,
+                                              Aig_Literal const node)
+  {
+    Aig_Literal const phase = get_signature_word(checker, node, 0) & 1;
+    Aig_Literal const normalized = node ^ phase;
+    u64 const hash = hash_signature(checker, normalized);
+    auto iter = checker.classes.find(hash);
+    if(iter == checker.classes.end()) {
+      checker.classes.emplace(hash, normalized);
+      return node;
+    }
+
+    Aig_Literal const candidate = iter->value;
+    if(!compare_signatures(checker, normalized, candidate)) {
+      return node;
+    }
+
+    Sat_Result const result =
+      find_difference(checker, normalized, candidate, sweep_conflict_limit);
+    if(result != Sat_Result::e_unsatisfiable) {
+      return node;
+    }
+
+    checker.merged += 1;
+    return candidate ^ phase;
+  }
+
+  [[nodiscard]] static Aig_Literal make_and(Checker& checker, Aig_Literal a,
+                                            Aig_Literal b)
+  {
+    if(a > b) {
+      Aig_Literal const literal = a;
+      a = b;
+      b = literal;
+    }
+
+    if(a == literal_false || a == negate(b)) {
+      return literal_false;
+    } else if(a == literal_true || a == b) {
+      return b;
+    }
+
+    u64 const key = (static_cast<u64>(a) << 32) | b;
+    auto iter = checker.structures.find(key);
+    if(iter != checker.structures.end()) {
+      return iter->value;
+    }
+
+    // Tseitin encoding of node = a & b.
+    Aig_Literal const node = add_node(checker, a, b);
+    Sat_Literal const first[] = {negate(node), a};
+    Sat_Literal const second[] = {negate(node), b};
+    Sat_Literal const third[] = {node, negate(a), negate(b)};
+    add_clause(checker.solver, Slice<Sat_Literal const>(first, 2));
+    add_clause(checker.solver, Slice<Sat_Literal const>(second, 2));
+    add_clause(checker.solver, Slice<Sat_Literal const>(third, 3));
+
+    Aig_Literal const result = sweep_node(checker, node);
+    checker.structures.emplace(key, result);
+    return result;
+  }
+
+  [[nodiscard]] static Aig_Literal make_or(Checker& checker,
+                                           Aig_Literal const a,
+                                           Aig_Literal const b)
+  {
+    return negate(make_and(checker, negate(a), negate(b)));
+  }
+
+  [[nodiscard]] static Aig_Literal make_xor(Checker& checker,
+                                            Aig_Literal const a,
+                                            Aig_Literal const b)
+  {
+    return make_or(checker, make_and(checker, a, negate(b)),
+                   make_and(checker, negate(a), b));
+  }
+
+  [[nodiscard]] static Aig_Literal make_mux(Checker& checker,
+                                            Aig_Literal const select,
+                                            Aig_Literal const one,
+                                            Aig_Literal const zero)
+  {
+    if(one == zero) {
+      return one;
+    }
+    return make_or(checker, make_and(checker, select, one),
+                   make_and(checker, negate(select), zero));
+  }
+
+  // make_lut
+  //
+  // Build the function of the bits [first, first + 2^count) of a truth table
+  // by Shannon expansion on the input count - 1.
+  //
+  [[nodiscard]] static Aig_Literal make_lut(Checker& checker, u64 const table,
+                                            Aig_Literal const* const inputs,
+                                            i64 const first, i64 const count)
+  {
+    if(count == 0) {
+      return (table >> first) & 1 ? literal_true : literal_false;
+    }
+
+    i64 const half = static_cast<i64>(1) << (count - 1);
+    Aig_Literal const zero = make_lut(checker, table, inputs, first, count - 1);
+    Aig_Literal const one =
+      make_lut(checker, table, inputs, first + half, count - 1);
+    return make_mux(checker, inputs[count - 1], one, zero);
+  }
+
+  [[nodiscard]] static Aig_Literal get_input_literal(Translator& translator,
+                                                     Port* const port)
+  {
+    Port const* const driver = get_driver(port);
+    if(driver == nullptr) {
+      return literal_false;
+    }
+    return translator.literals.find(get_key(driver))->value;
+  }
+
+  [[nodiscard]] static Aig_Literal translate_gate(Translator& translator,
+                                                  Gate& gate)
+  {
+    Checker& checker = translator.checker;
+    Aig_Literal inputs[lut_input_count];
+    for(i64 i = 0; i < gate.in_ports.size(); ++i) {
+      inputs[i] = get_input_literal(translator, gate.in_ports[i]);
+    }
+
+    switch(gate.kind) {
+    case Gate_Kind::e_and:
+      return make_and(checker, inputs[0], inputs[1]);
+    case Gate_Kind::e_or:
+      return make_or(checker, inputs[0], inputs[1]);
+    case Gate_Kind::e_xor:
+      return make_xor(checker, inputs[0], inputs[1]);
+    case Gate_Kind::e_nand:
+      return negate(make_and(checker, inputs[0], inputs[1]));
+    case Gate_Kind::e_nor:
+      return negate(make_or(checker, inputs[0], inputs[1]));
+    case Gate_Kind::e_xnor:
+      return negate(make_xor(checker, inputs[0], inputs[1]));
+    case Gate_Kind::e_not:
+      return negate(inputs[0]);
+    case Gate_Kind::e_lut:
+      return make_lut(checker, gate.table, inputs, 0, gate.in_ports.size());
+    default:
+      ANTON_UNREACHABLE("gate is not combinational");
+    }
+  }
+
+  // translate_port
+  //
+  // Build the literal of an OUT port and of all the gates it depends on.
+  // Gates are visited depth-first without recursion since the cones of
+  // imported netlists may be arbitrarily deep.
+  //
+  [[nodiscard]] static Expected<Aig_Literal, Error>
+  translate_port(Translator& translator, Port* const port)
+  {
+    auto iter = translator.literals.find(get_key(port));
+    if(iter != translator.literals.end()) {
+      return {expected_value, iter->value};
+    }
+
+    Array<Gate*> stack;
+    stack.push_back(port->gate);
+    translator.visiting.emplace(get_key(port->gate), true);
+    while(stack.size() > 0) {
+      Gate* const gate = stack.back();
+      Gate* pending = nullptr;
+      for(Port* const input: gate->in_ports) {
+        Port* const driver = get_driver(input);
+        if(driver != nullptr &&
+           translator.literals.find(get_key(driver)) ==
+             translator.literals.end()) {
+          pending = driver->gate;
+          break;
+        }
+      }
+
+      if(pending == nullptr) {
+        stack.pop_back();
+        Aig_Literal const literal = translate_gate(translator, *gate);
+        translator.literals.emplace(get_key(gate->out_ports[0]), literal);
+        continue;
+      }
+
+      // Finished gates have literals, hence a visited driver without one is
+      // on the stack.
+      if(translator.visiting.find(get_key(pending)) !=
+         translator.visiting.end()) {
+        return {expected_error,
+                format("combinational loop through '{}'"_sv,
+                       get_gate_name(*pending))};
+      }
+      translator.visiting.emplace(get_key(pending), true);
+      stack.push_back(pending);
+    }
+    return {expected_value, translator.literals.find(get_key(port))->value};
+  }
+
+  [[nodiscard]] static Expected<Aig_Literal, Error>
+  translate_output(Translator& translator, Signal const& signal)
+  {
+    if(signal.port->kind == Port_Kind::out) {
+      return translate_port(translator, signal.port);
+    }
+
+    Port* const driver = get_driver(signal.port);
+    if(driver == nullptr) {
+      return {expected_value, literal_false};
+    }
+    return translate_port(translator, driver);
+  }
+
+  [[nodiscard]] static bool get_model_value(Checker const& checker,
+                                            Aig_Literal const literal)
+  {
+    return checker.solver.model[get_variable(literal)] ^ (literal & 1);
+  }
+
+  // find_signature_difference
+  //
+  // Returns:
+  // The index of a simulated assignment under which the literals differ, -1
+  // if they agree on all of them.
+  //
+  [[nodiscard]] static i64 find_signature_difference(Checker const& checker,
+                                                     Aig_Literal const lhs,
+                                                     Aig_Literal const rhs)
+  {
+    for(i64 i = 0; i < signature_words; ++i) {
+      u64 const difference = get_signature_word(checker, lhs, i) ^
+                             get_signature_word(checker, rhs, i);
+      if(difference != 0) {
+        i64 bit = 0;
+        while(((difference >> bit) & 1) == 0) {
+          bit += 1;
+        }
+        return i * 64 + bit;
+      }
+    }
+    return -1;
+  }
+
+  [[nodiscard]] static bool get_simulated_value(Checker const& checker,
+                                                Aig_Literal const literal,
+                                                i64 const assignment)
+  {
+    u64 const word = get_signature_word(checker, literal, assignment / 64);
+    return (word >> (assignment % 64)) & 1;
+  }
+
+  Expected<Equivalence_Result, Error>
+  check_equivalence(Scene& first, Scene& second, i64 const conflict_limit)
+  {
+    Interface interfaces[2];
+    Scene* const scenes[2] = {&first, &second};
+    for(i64 i = 0; i < 2; ++i) {
+      Expected<void, Error> collected =
+        collect_interface(*scenes[i], interfaces[i]);
+      if(!collected) {
+        return {expected_error, format("{} circuit: {}"_sv,
+                                       i == 0 ? "first"_sv : "second"_sv,
+                                       collected.error())};
+      }
+    }
+
+    if(interfaces[0].inputs.size() != interfaces[1].inputs.size() ||
+       interfaces[0].outputs.size() != interfaces[1].outputs.size()) {
+      return {expected_error,
+              format("the circuits have {} and {} inputs, {} and {} outputs"_sv,
+                     interfaces[0].inputs.size(), interfaces[1].inputs.size(),
+                     interfaces[0].outputs.size(),
+                     interfaces[1].outputs.size())};
+    }
+
+    Checker checker;
+    initialize_checker(checker);
+    Translator translators[2] = {Translator(checker), Translator(checker)};
+    Flat_Hash_Map<String, Aig_Literal> inputs;
+    Array<Aig_Literal> input_literals;
+    for(Signal const& signal: interfaces[0].inputs) {
+      if(inputs.find(signal.name) != inputs.end()) {
+        return {expected_error,
+                format("input '{}' is not unique"_sv, signal.name)};
+      }
+
+      Aig_Literal const literal = add_node(checker, no_fanin, no_fanin);
+      inputs.emplace(signal.name, literal);
+      input_literals.push_back(literal);
+      translators[0].literals.emplace(get_key(signal.port), literal);
+    }
+    for(Signal const& signal: interfaces[1].inputs) {
+      auto iter = inputs.find(signal.name);
+      if(iter == inputs.end()) {
+        return {expected_error,
+                format("input '{}' of the second circuit is not an input of "
+                       "the first circuit"_sv,
+                       signal.name)};
+      }
+      translators[1].literals.emplace(get_key(signal.port), iter->value);
+    }
+
+    Flat_Hash_Map<String, i64> second_outputs;
+    for(i64 i = 0; i < interfaces[1].outputs.size(); ++i) {
+      second_outputs.emplace(interfaces[1].outputs[i].name, i);
+    }
+
+    // Literals of the outputs of both circuits in the order of the outputs
+    // of the first circuit.
+    Array<Aig_Literal> outputs[2];
+    for(Signal const& signal: interfaces[0].outputs) {
+      auto iter = second_outputs.find(signal.name);
+      if(iter == second_outputs.end()) {
+        return {expected_error,
+                format("output '{}' of the first circuit is not an output of "
+                       "the second circuit"_sv,
+                       signal.name)};
+      }
+
+      Signal const* const signals[2] = {&signal,
+                                        &interfaces[1].outputs[iter->value]};
+      for(i64 i = 0; i < 2; ++i) {
+        Expected<Aig_Literal, Error> literal =
+          translate_output(translators[i], *signals[i]);
+        if(!literal) {
+          return {expected_error, format("{} circuit: {}"_sv,
+                                         i == 0 ? "first"_sv : "second"_sv,
+                                         literal.error())};
+        }
+        outputs[i].push_back(literal.value());
+      }
+    }
+
+    Equivalence_Result result;
+    // Random simulation refutes most differing outputs without the solver.
+    // -1 if the difference has been found by the solver instead.
+    i64 assignment = -1;
+    i64 different = -1;
+    for(i64 i = 0; i < outputs[0].size() && different < 0; ++i) {
+      assignment =
+        find_signature_difference(checker, outputs[0][i], outputs[1][i]);
+      if(assignment >= 0) {
+        different = i;
+      }
+    }
+
+    for(i64 i = 0; i < outputs[0].size() && different < 0; ++i) {
+      if(outputs[0][i] == outputs[1][i]) {
+        continue;
+      }
+
+      Sat_Result const difference =
+        find_difference(checker, outputs[0][i], outputs[1][i], conflict_limit);
+      if(difference == Sat_Result::e_satisfiable) {
+        different = i;
+      } else if(difference == Sat_Result::e_unknown &&
+                result.verdict == Equivalence_Verdict::e_equivalent) {
+        result.verdict = Equivalence_Verdict::e_undecided;
+        result.output = interfaces[0].outputs[i].name;
+      }
+    }
+
+    if(different >= 0) {
+      auto get_value = [&checker, assignment](Aig_Literal const literal) {
+        if(assignment >= 0) {
+          return get_simulated_value(checker, literal, assignment);
+        } else {
+          return get_model_value(checker, literal);
+        }
+      };
+
+      result.verdict = Equivalence_Verdict::e_different;
+      result.output = interfaces[0].outputs[different].name;
+      result.first_value = get_value(outputs[0][different]);
+      result.second_value = get_value(outputs[1][different]);
+      for(i64 i = 0; i < interfaces[0].inputs.size(); ++i) {
+        Signal const& signal = interfaces[0].inputs[i];
+        result.counterexample.push_back(
+          Counterexample_Value{signal.name, signal.gate, signal.output,
+                               get_value(input_literals[i])});
+      }
+    }
+
+    result.node_count = checker.nodes.size();
+    result.merged = checker.merged;
+    result.sat_calls = checker.sat_calls;
+    return {expected_value, ANTON_MOV(result)};
+  }
+} // namespace nebula
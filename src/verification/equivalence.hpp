@@ -0,0 +1,78 @@
+#pragma once
+
+#include <anton/expected.hpp>
+
+#include <core/error.hpp>
+#include <core/types.hpp>
+
+namespace nebula {
+  struct Gate;
+  struct Scene;
+
+  enum struct Equivalence_Verdict {
+    e_equivalent,
+    e_different,
+    // The conflict limit has been reached before an output was decided.
+    e_undecided,
+  };
+
+  /**
+   * @brief Value of an input of the first circuit in a counterexample.
+   */
+  struct Counterexample_Value {
+    String name;
+    // An input, a clock or a sequential gate whose output is treated as an
+    // input.
+    Gate* gate;
+    // Index of the OUT port of the gate.
+    i64 output;
+    bool value;
+  };
+
+  struct Equivalence_Result {
+    Equivalence_Verdict verdict = Equivalence_Verdict::e_equivalent;
+    // The output that differs or could not be decided.
+    String output;
+    // Values of the output in the first and the second circuit under the
+    // counterexample.
+    bool first_value = false;
+    bool second_value = false;
+    // Values of all inputs of the first circuit that make the output differ.
+    // Empty unless the verdict is e_different.
+    Array<Counterexample_Value> counterexample;
+    // Number of nodes of the and-inverter graph shared by both circuits.
+    i64 node_count = 0;
+    // Number of nodes proven equivalent to an earlier node.
+    i64 merged = 0;
+    i64 sat_calls = 0;
+  };
+
+  /**
+   * @brief Checks whether two circuits compute the same outputs.
+   *
+   * Both circuits are translated into a single and-inverter graph whose
+   * inputs are shared. Nodes with equal structure are hashed together and
+   * nodes that agree on random simulation are proven equivalent by a SAT
+   * solver and merged, hence circuits that are largely similar are checked
+   * quickly. The remaining outputs are compared by random simulation and the
+   * SAT solver, which provides a counterexample if they differ.
+   *
+   * Inputs and clocks are matched by name. Outputs are the gates whose
+   * outputs are not connected and are matched by name as well. Unnamed
+   * inputs and outputs are matched by their order in the scenes. Sequential
+   * gates are matched by name and cut: their outputs become inputs and their
+   * inputs become outputs, hence the check proves that the next state and
+   * the outputs are equal for all states. Unconnected inputs read 0 like in
+   * the two-valued evaluation.
+   *
+   * @param first The first circuit.
+   * @param second The second circuit.
+   * @param conflict_limit The number of conflicts the SAT solver may spend on
+   * a single output before the check gives up. Negative for no limit.
+   * @return The verdict, or an error if the interfaces of the circuits
+   * differ, either circuit contains modules, memories or combinational
+   * loops.
+   */
+  [[nodiscard]] Expected<Equivalence_Result, Error>
+  check_equivalence(Scene& first, Scene& second, i64 conflict_limit);
+} // namespace nebula
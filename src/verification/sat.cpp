@@ -0,0 +1,590 @@
+#include <verification/sat.hpp>
+
+#include <anton/algorithm/sort.hpp>
+#include <anton/math/math.hpp>
+
+namespace nebula {
+  constexpr u32 no_reason = static_cast<u32>(-1);
+  constexpr Sat_Literal no_literal = static_cast<Sat_Literal>(-1);
+  constexpr u8 value_false = 0;
+  constexpr u8 value_true = 1;
+  constexpr u8 value_unassigned = 2;
+  constexpr f64 variable_decay = 0.95;
+  constexpr f32 clause_decay = 0.999f;
+  // Number of conflicts of the shortest restart interval.
+  constexpr i64 restart_interval = 100;
+
+  enum struct Search_Result {
+    e_satisfiable,
+    e_unsatisfiable,
+    e_restart,
+    e_limit,
+  };
+
+  [[nodiscard]] static u8 get_value(Sat_Solver const& solver,
+                                    Sat_Literal const literal)
+  {
+    u8 const value = solver.values[get_variable(literal)];
+    if(value == value_unassigned) {
+      return value_unassigned;
+    }
+    return value ^ static_cast<u8>(literal & 1);
+  }
+
+  [[nodiscard]] static i32 get_decision_level(Sat_Solver const& solver)
+  {
+    return static_cast<i32>(solver.trail_limits.size());
+  }
+
+  // Heap of the variables
+  //
+  // The variable with the highest activity is at the root.
+  //
+
+  static void place_in_heap(Sat_Solver& solver, i64 const position,
+                            u32 const variable)
+  {
+    solver.heap[position] = variable;
+    solver.heap_positions[variable] = static_cast<i32>(position);
+  }
+
+  static void sift_up(Sat_Solver& solver, i64 position)
+  {
+    u32 const variable = solver.heap[position];
+    f64 const activity = solver.activities[variable];
+    while(position > 0) {
+      i64 const parent = (position - 1) / 2;
+      if(solver.activities[solver.heap[parent]] >= activity) {
+        break;
+      }
+      place_in_heap(solver, position, solver.heap[parent]);
+      position = parent;
+    }
+    place_in_heap(solver, position, variable);
+  }
+
+  static void sift_down(Sat_Solver& solver, i64 position)
+  {
+    u32 const variable = solver.heap[position];
+    f64 const activity = solver.activities[variable];
+    i64 const size = solver.heap.size();
+    while(true) {
+      i64 child = 2 * position + 1;
+      if(child >= size) {
+        break;
+      }
+      if(child + 1 < size && solver.activities[solver.heap[child + 1]] >
+                               solver.activities[solver.heap[child]]) {
+        child += 1;
+      }
+      if(solver.activities[solver.heap[child]] <= activity) {
+        break;
+      }
+      place_in_heap(solver, position, solver.heap[child]);
+      position = child;
+    }
+    place_in_heap(solver, position, variable);
+  }
+
+  static void insert_variable(Sat_Solver& solver, u32 const variable)
+  {
+    if(solver.heap_positions[variable] >= 0) {
+      return;
+    }
+    solver.heap.push_back(variable);
+    solver.heap_positions[variable] =
+      static_cast<i32>(solver.heap.size() - 1);
+    sift_up(solver, solver.heap.size() - 1);
+  }
+
+  [[nodiscard]] static u32 pop_variable(Sat_Solver& solver)
+  {
+    u32 const variable = solver.heap[0];
+    u32 const last = solver.heap.back();
+    solver.heap.pop_back();
+    solver.heap_positions[variable] = -1;
+    if(solver.heap.size() > 0) {
+      place_in_heap(solver, 0, last);
+      sift_down(solver, 0);
+    }
+    return variable;
+  }
+
+  static void bump_variable(Sat_Solver& solver, u32 const variable)
+  {
+    solver.activities[variable] += solver.variable_increment;
+    if(solver.activities[variable] > 1e100) {
+      for(f64& activity: solver.activities) {
+        activity *= 1e-100;
+      }
+      solver.variable_increment *= 1e-100;
+    }
+    if(solver.heap_positions[variable] >= 0) {
+      sift_up(solver, solver.heap_positions[variable]);
+    }
+  }
+
+  static void bump_clause(Sat_Solver& solver, Sat_Clause& clause)
+  {
+    clause.activity += solver.clause_increment;
+    if(clause.activity > 1e20f) {
+      for(Sat_Clause& other: solver.clauses) {
+        if(other.learnt) {
+          other.activity *= 1e-20f;
+        }
+      }
+      solver.clause_increment *= 1e-20f;
+    }
+  }
+
+  u32 add_variable(Sat_Solver& solver)
+  {
+    u32 const variable = solver.values.size();
+    solver.values.push_back(value_unassigned);
+    solver.levels.push_back(0);
+    solver.reasons.push_back(no_reason);
+    solver.phases.push_back(value_false);
+    solver.activities.push_back(0.0);
+    solver.heap_positions.push_back(-1);
+    solver.model.push_back(value_false);
+    solver.seen.push_back(0);
+    solver.watches.push_back(Array<Sat_Watcher>());
+    solver.watches.push_back(Array<Sat_Watcher>());
+    insert_variable(solver, variable);
+    return variable;
+  }
+
+  static void enqueue(Sat_Solver& solver, Sat_Literal const literal,
+                      u32 const reason)
+  {
+    u32 const variable = get_variable(literal);
+    solver.values[variable] = static_cast<u8>((literal & 1) ^ 1);
+    solver.levels[variable] = get_decision_level(solver);
+    solver.reasons[variable] = reason;
+    solver.trail.push_back(literal);
+  }
+
+  static void attach_clause(Sat_Solver& solver, u32 const index)
+  {
+    Array<Sat_Literal> const& literals = solver.clauses[index].literals;
+    solver.watches[negate(literals[0])].push_back(
+      Sat_Watcher{index, literals[1]});
+    solver.watches[negate(literals[1])].push_back(
+      Sat_Watcher{index, literals[0]});
+  }
+
+  static void cancel_until(Sat_Solver& solver, i32 const level)
+  {
+    if(get_decision_level(solver) <= level) {
+      return;
+    }
+
+    i64 const limit = solver.trail_limits[level];
+    for(i64 i = solver.trail.size() - 1; i >= limit; --i) {
+      u32 const variable = get_variable(solver.trail[i]);
+      solver.phases[variable] = solver.values[variable];
+      solver.values[variable] = value_unassigned;
+      solver.reasons[variable] = no_reason;
+      insert_variable(solver, variable);
+    }
+    solver.trail.erase(solver.trail.begin() + limit, solver.trail.end());
+    solver.trail_limits.erase(solver.trail_limits.begin() + level,
+                              solver.trail_limits.end());
+    solver.propagated = solver.trail.size();
+  }
+
+  // propagate
+  //
+  // Assign the literals implied by unit clauses.
+  //
+  // Returns:
+  // The index of a clause whose literals are all false, no_reason if there
+  // is none.
+  //
+  [[nodiscard]] static u32 propagate(Sat_Solver& solver)
+  {
+    while(solver.propagated < solver.trail.size()) {
+      Sat_Literal const assigned = solver.trail[solver.propagated];
+      solver.propagated += 1;
+      Sat_Literal const false_literal = negate(assigned);
+      Array<Sat_Watcher>& watchers = solver.watches[assigned];
+      i64 kept = 0;
+      for(i64 i = 0; i < watchers.size(); ++i) {
+        Sat_Watcher const watcher = watchers[i];
+        if(get_value(solver, watcher.blocker) == value_true) {
+          watchers[kept] = watcher;
+          kept += 1;
+          continue;
+        }
+
+        Sat_Clause& clause = solver.clauses[watcher.clause];
+        if(clause.deleted) {
+          continue;
+        }
+
+        // The false literal is moved to the second position.
+        Array<Sat_Literal>& literals = clause.literals;
+        if(literals[0] == false_literal) {
+          literals[0] = literals[1];
+          literals[1] = false_literal;
+        }
+
+        Sat_Literal const first = literals[0];
+        Sat_Watcher const updated{watcher.clause, first};
+        if(first != watcher.blocker &&
+           get_value(solver, first) == value_true) {
+          watchers[kept] = updated;
+          kept += 1;
+          continue;
+        }
+
+        bool moved = false;
+        for(i64 k = 2; k < literals.size(); ++k) {
+          if(get_value(solver, literals[k]) != value_false) {
+            literals[1] = literals[k];
+            literals[k] = false_literal;
+            solver.watches[negate(literals[1])].push_back(updated);
+            moved = true;
+            break;
+          }
+        }
+        if(moved) {
+          continue;
+        }
+
+        watchers[kept] = updated;
+        kept += 1;
+        if(get_value(solver, first) == value_false) {
+          for(i += 1; i < watchers.size(); ++i) {
+            watchers[kept] = watchers[i];
+            kept += 1;
+          }
+          watchers.erase(watchers.begin() + kept, watchers.end());
+          solver.propagated = solver.trail.size();
+          return watcher.clause;
+        }
+        enqueue(solver, first, watcher.clause);
+      }
+      watchers.erase(watchers.begin() + kept, watchers.end());
+    }
+    return no_reason;
+  }
+
+  // is_redundant
+  //
+  // Whether a literal of a learnt clause is implied by the other literals,
+  // that is all the literals of its reason are in the clause or fixed.
+  //
+  [[nodiscard]] static bool is_redundant(Sat_Solver const& solver,
+                                         Sat_Literal const literal)
+  {
+    u32 const reason = solver.reasons[get_variable(literal)];
+    if(reason == no_reason) {
+      return false;
+    }
+
+    Array<Sat_Literal> const& literals = solver.clauses[reason].literals;
+    for(i64 i = 1; i < literals.size(); ++i) {
+      u32 const variable = get_variable(literals[i]);
+      if(!solver.seen[variable] && solver.levels[variable] > 0) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // analyze
+  //
+  // Derive the first UIP clause from a conflict. The asserting literal is
+  // placed first and a literal of the backjump level second.
+  //
+  static void analyze(Sat_Solver& solver, u32 conflict,
+                      Array<Sat_Literal>& learnt, i32& backjump_level)
+  {
+    learnt.clear();
+    learnt.push_back(no_literal);
+    i32 const level = get_decision_level(solver);
+    i64 pending = 0;
+    Sat_Literal implied = no_literal;
+    i64 index = solver.trail.size() - 1;
+    do {
+      Sat_Clause& clause = solver.clauses[conflict];
+      if(clause.learnt) {
+        bump_clause(solver, clause);
+      }
+
+      for(Sat_Literal const literal: clause.literals) {
+        u32 const variable = get_variable(literal);
+        if(literal == implied || solver.seen[variable] ||
+           solver.levels[variable] == 0) {
+          continue;
+        }
+
+        solver.seen[variable] = 1;
+        bump_variable(solver, variable);
+        if(solver.levels[variable] >= level) {
+          pending += 1;
+        } else {
+          learnt.push_back(literal);
+        }
+      }
+
+      while(!solver.seen[get_variable(solver.trail[index])]) {
+        index -= 1;
+      }
+      implied = solver.trail[index];
+      index -= 1;
+      conflict = solver.reasons[get_variable(implied)];
+      solver.seen[get_variable(implied)] = 0;
+      pending -= 1;
+    } while(pending > 0);
+    learnt[0] = negate(implied);
+
+    // The seen flags of the removed literals are cleared with the others.
+    i64 const count = learnt.size();
+    i64 kept = 1;
+    for(i64 i = 1; i < count; ++i) {
+      if(!is_redundant(solver, learnt[i])) {
+        Sat_Literal const literal = learnt[kept];
+        learnt[kept] = learnt[i];
+        learnt[i] = literal;
+        kept += 1;
+      }
+    }
+    for(Sat_Literal const literal: learnt) {
+      solver.seen[get_variable(literal)] = 0;
+    }
+    learnt.erase(learnt.begin() + kept, learnt.end());
+
+    backjump_level = 0;
+    for(i64 i = 1; i < learnt.size(); ++i) {
+      i32 const literal_level = solver.levels[get_variable(learnt[i])];
+      if(literal_level > backjump_level) {
+        backjump_level = literal_level;
+        Sat_Literal const literal = learnt[1];
+        learnt[1] = learnt[i];
+        learnt[i] = literal;
+      }
+    }
+  }
+
+  // reduce_learnt
+  //
+  // Delete the less active half of the learnt clauses that are not reasons
+  // of current assignments.
+  //
+  static void reduce_learnt(Sat_Solver& solver)
+  {
+    Array<u32> learnt;
+    for(i64 i = 0; i < solver.clauses.size(); ++i) {
+      Sat_Clause const& clause = solver.clauses[i];
+      if(clause.learnt && !clause.deleted && clause.literals.size() > 2) {
+        learnt.push_back(i);
+      }
+    }
+    anton::quick_sort(learnt.begin(), learnt.end(),
+                      [&solver](u32 const lhs, u32 const rhs) {
+                        return solver.clauses[lhs].activity <
+                               solver.clauses[rhs].activity;
+                      });
+
+    for(i64 i = 0; i < learnt.size() / 2; ++i) {
+      Sat_Clause& clause = solver.clauses[learnt[i]];
+      u32 const variable = get_variable(clause.literals[0]);
+      bool const locked = solver.reasons[variable] == learnt[i] &&
+                          get_value(solver, clause.literals[0]) == value_true;
+      if(locked) {
+        continue;
+      }
+
+      // Watchers of deleted clauses are dropped by propagate.
+      clause.deleted = true;
+      clause.literals = Array<Sat_Literal>();
+      solver.learnt_count -= 1;
+    }
+  }
+
+  [[nodiscard]] static Sat_Literal pick_branch(Sat_Solver& solver)
+  {
+    while(solver.heap.size() > 0) {
+      u32 const variable = pop_variable(solver);
+      if(solver.values[variable] == value_unassigned) {
+        return make_literal(variable, solver.phases[variable] != value_true);
+      }
+    }
+    return no_literal;
+  }
+
+  // get_luby
+  //
+  // Element of the Luby sequence 1, 1, 2, 1, 1, 2, 4, 1, ...
+  //
+  [[nodiscard]] static i64 get_luby(i64 index)
+  {
+    i64 size = 1;
+    i64 exponent = 0;
+    while(size < index + 1) {
+      exponent += 1;
+      size = 2 * size + 1;
+    }
+    while(size - 1 != index) {
+      size = (size - 1) >> 1;
+      exponent -= 1;
+      index = index % size;
+    }
+    return static_cast<i64>(1) << exponent;
+  }
+
+  [[nodiscard]] static Search_Result
+  search(Sat_Solver& solver, Slice<Sat_Literal const> const assumptions,
+         i64 const restart_conflicts, i64 const conflict_end,
+         Array<Sat_Literal>& learnt)
+  {
+    i64 conflicts = 0;
+    while(true) {
+      u32 const conflict = propagate(solver);
+      if(conflict != no_reason) {
+        solver.conflicts += 1;
+        conflicts += 1;
+        if(get_decision_level(solver) == 0) {
+          solver.inconsistent = true;
+          return Search_Result::e_unsatisfiable;
+        }
+
+        i32 backjump_level = 0;
+        analyze(solver, conflict, learnt, backjump_level);
+        cancel_until(solver, backjump_level);
+        if(learnt.size() == 1) {
+          enqueue(solver, learnt[0], no_reason);
+        } else {
+          u32 const index = solver.clauses.size();
+          Sat_Clause& clause = solver.clauses.emplace_back();
+          clause.literals = learnt;
+          clause.learnt = true;
+          attach_clause(solver, index);
+          bump_clause(solver, solver.clauses[index]);
+          solver.learnt_count += 1;
+          enqueue(solver, learnt[0], index);
+        }
+        solver.variable_increment /= variable_decay;
+        solver.clause_increment /= clause_decay;
+        continue;
+      }
+
+      if(conflict_end >= 0 && solver.conflicts >= conflict_end) {
+        cancel_until(solver, 0);
+        return Search_Result::e_limit;
+      } else if(conflicts >= restart_conflicts) {
+        cancel_until(solver, 0);
+        return Search_Result::e_restart;
+      }
+
+      if(solver.learnt_count - solver.trail.size() >= solver.learnt_limit) {
+        reduce_learnt(solver);
+      }
+
+      Sat_Literal next = no_literal;
+      while(get_decision_level(solver) < assumptions.size()) {
+        Sat_Literal const assumption = assumptions[get_decision_level(solver)];
+        u8 const value = get_value(solver, assumption);
+        if(value == value_true) {
+          // Satisfied assumptions open empty levels to keep the levels and
+          // the assumptions aligned.
+          solver.trail_limits.push_back(solver.trail.size());
+        } else if(value == value_false) {
+          cancel_until(solver, 0);
+          return Search_Result::e_unsatisfiable;
+        } else {
+          next = assumption;
+          break;
+        }
+      }
+
+      if(next == no_literal) {
+        next = pick_branch(solver);
+        if(next == no_literal) {
+          for(i64 i = 0; i < solver.values.size(); ++i) {
+            solver.model[i] = solver.values[i];
+          }
+          cancel_until(solver, 0);
+          return Search_Result::e_satisfiable;
+        }
+      }
+      solver.trail_limits.push_back(solver.trail.size());
+      enqueue(solver, next, no_reason);
+    }
+  }
+
+  void add_clause(Sat_Solver& solver, Slice<Sat_Literal const> const literals)
+  {
+    if(solver.inconsistent) {
+      return;
+    }
+
+    // Clauses are added at level 0, hence assigned literals are fixed.
+    Array<Sat_Literal> clause;
+    for(Sat_Literal const literal: literals) {
+      u8 const value = get_value(solver, literal);
+      if(value == value_true) {
+        return;
+      } else if(value == value_false) {
+        continue;
+      }
+
+      bool duplicate = false;
+      for(Sat_Literal const other: clause) {
+        if(other == negate(literal)) {
+          return;
+        }
+        duplicate = duplicate || other == literal;
+      }
+      if(!duplicate) {
+        clause.push_back(literal);
+      }
+    }
+
+    if(clause.size() == 0) {
+      solver.inconsistent = true;
+    } else if(clause.size() == 1) {
+      enqueue(solver, clause[0], no_reason);
+      if(propagate(solver) != no_reason) {
+        solver.inconsistent = true;
+      }
+    } else {
+      u32 const index = solver.clauses.size();
+      solver.clauses.emplace_back().literals = ANTON_MOV(clause);
+      attach_clause(solver, index);
+    }
+  }
+
+  Sat_Result solve(Sat_Solver& solver,
+                   Slice<Sat_Literal const> const assumptions,
+                   i64 const conflict_limit)
+  {
+    if(solver.inconsistent) {
+      return Sat_Result::e_unsatisfiable;
+    }
+
+    solver.learnt_limit = math::max(solver.learnt_limit,
+                                    solver.clauses.size() / 3 + 1000);
+    i64 const conflict_end =
+      conflict_limit >= 0 ? solver.conflicts + conflict_limit : -1;
+    Array<Sat_Literal> learnt;
+    for(i64 restart = 0;; ++restart) {
+      Search_Result const result =
+        search(solver, assumptions, get_luby(restart) * restart_interval,
+               conflict_end, learnt);
+      switch(result) {
+      case Search_Result::e_satisfiable:
+        return Sat_Result::e_satisfiable;
+      case Search_Result::e_unsatisfiable:
+        return Sat_Result::e_unsatisfiable;
+      case Search_Result::e_limit:
+        return Sat_Result::e_unknown;
+      case Search_Result::e_restart:
+        solver.learnt_limit += solver.learnt_limit / 10;
+        break;
+      }
+    }
+  }
+} // namespace nebula
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <anton/array.hpp>
+#include <anton/slice.hpp>
+
+#include <core/types.hpp>
+
+// Internal interface of the equivalence checker.
+
+namespace nebula {
+  /**
+   * @brief A variable or its negation, encoded as variable * 2 + negated.
+   */
+  using Sat_Literal = u32;
+
+  [[nodiscard]] constexpr Sat_Literal make_literal(u32 const variable,
+                                                   bool const negated)
+  {
+    return variable * 2 + negated;
+  }
+
+  [[nodiscard]] constexpr u32 get_variable(Sat_Literal const literal)
+  {
+    return literal >> 1;
+  }
+
+  [[nodiscard]] constexpr Sat_Literal negate(Sat_Literal const literal)
+  {
+    return literal ^ 1;
+  }
+
+  enum struct Sat_Result {
+    e_satisfiable,
+    e_unsatisfiable,
+    // The conflict limit has been reached.
+    e_unknown,
+  };
+
+  struct Sat_Clause {
+    Array<Sat_Literal> literals;
+    f32 activity = 0.0f;
+    bool learnt = false;
+    bool deleted = false;
+  };
+
+  struct Sat_Watcher {
+    u32 clause;
+    // A literal of the clause. The clause is satisfied if the blocker is
+    // true, in which case the clause is not visited.
+    Sat_Literal blocker;
+  };
+
+  /**
+   * @brief Conflict-driven clause learning SAT solver.
+   *
+   * Propagates with two watched literals, learns first UIP clauses, picks
+   * decisions by variable activity with saved phases and restarts by the
+   * Luby sequence. Learnt clauses of low activity are deleted periodically.
+   * Clauses may be added between calls to solve, which keeps the learnt
+   * clauses, hence the solver is incremental.
+   */
+  struct Sat_Solver {
+    Array<Sat_Clause> clauses;
+    // Watchers indexed by the negation of the watched literal, that is by
+    // the literal whose assignment makes the watched literal false.
+    Array<Array<Sat_Watcher>> watches;
+    // Per variable: 0 false, 1 true, 2 unassigned.
+    Array<u8> values;
+    Array<i32> levels;
+    Array<u32> reasons;
+    Array<u8> phases;
+    Array<f64> activities;
+    // Binary max-heap of the variables by activity and the positions of the
+    // variables in it, -1 for variables not in the heap.
+    Array<u32> heap;
+    Array<i32> heap_positions;
+    Array<Sat_Literal> trail;
+    // Positions in the trail where the decision levels start.
+    Array<i64> trail_limits;
+    i64 propagated = 0;
+    // Values of the variables in the last satisfying assignment.
+    Array<u8> model;
+    Array<u8> seen;
+    f64 variable_increment = 1.0;
+    f32 clause_increment = 1.0f;
+    i64 learnt_count = 0;
+    i64 learnt_limit = 0;
+    i64 conflicts = 0;
+    // Set once the clauses are unsatisfiable without assumptions.
+    bool inconsistent = false;
+  };
+
+  /**
+   * @brief Adds a new variable to a solver.
+   *
+   * @return The index of the variable.
+   */
+  [[nodiscard]] u32 add_variable(Sat_Solver& solver);
+
+  /**
+   * @brief Adds a clause to a solver.
+   *
+   * @param literals The literals of the clause. Their variables must have
+   * been added.
+   */
+  void add_clause(Sat_Solver& solver, Slice<Sat_Literal const> literals);
+
+  /**
+   * @brief Decides whether the clauses are satisfiable with the assumptions
+   * being true.
+   *
+   * @param assumptions Literals assumed to be true for this call only.
+   * @param conflict_limit The number of conflicts after which the search
+   * gives up. Negative for no limit.
+   * @return e_satisfiable with the assignment stored in Sat_Solver::model,
+   * e_unsatisfiable or e_unknown if the limit has been reached.
+   */
+  [[nodiscard]] Sat_Result solve(Sat_Solver& solver,
+                                 Slice<Sat_Literal const> assumptions,
+                                 i64 conflict_limit);
+} // namespace nebula
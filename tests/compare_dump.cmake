@@ -0,0 +1,35 @@
+# Runs a tool with the arguments following -- and compares the dump it writes
+# with an expected file.
+#
+#   cmake -DTOOL=<tool> -DOUTPUT=<dump> -DEXPECTED=<file>
+#         -P compare_dump.cmake -- <arguments>
+#
+# The tool must write the dump to the file given by --output.
+
+set(arguments)
+set(collect FALSE)
+math(EXPR last "${CMAKE_ARGC} - 1")
+foreach(i RANGE ${last})
+  if(collect)
+    list(APPEND arguments "${CMAKE_ARGV${i}}")
+  elseif("${CMAKE_ARGV${i}}" STREQUAL "--")
+    set(collect TRUE)
+  endif()
+endforeach()
+
+file(REMOVE "${OUTPUT}")
+execute_process(COMMAND "${TOOL}" ${arguments} --output "${OUTPUT}"
+                RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+  message(FATAL_ERROR "${TOOL} exited with ${result}")
+endif()
+
+execute_process(COMMAND "${CMAKE_COMMAND}" -E compare_files --ignore-eol
+                        "${OUTPUT}" "${EXPECTED}"
+                RESULT_VARIABLE different)
+if(NOT different EQUAL 0)
+  file(READ "${OUTPUT}" actual)
+  file(READ "${EXPECTED}" expected)
+  message(FATAL_ERROR "the dump differs from ${EXPECTED}\n"
+                      "expected:\n${expected}\nactual:\n${actual}")
+endif()